@@ -1,6 +1,12 @@
 #ifndef HADRON_CORE_HPP
 #define HADRON_CORE_HPP
 
+#include "core/cpu.hpp"
+#include "core/fixedtimestep.hpp"
+#include "core/mappedfile.hpp"
+#include "core/parallel.hpp"
 #include "core/precision.hpp"
+#include "core/profiler.hpp"
+#include "core/threadpool.hpp"
 
 #endif // HADRON_CORE_HPP
\ No newline at end of file
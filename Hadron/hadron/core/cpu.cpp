@@ -0,0 +1,89 @@
+#include "cpu.hpp"
+
+#if defined(HADRON_ARCH_X86)
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+namespace Hadron {
+	namespace {
+		#if defined(HADRON_ARCH_X86)
+		// Fills Regs with eax, ebx, ecx and edx for the given cpuid leaf
+		void cpuid(unsigned int Leaf, unsigned int Regs[4])
+		{
+		#if defined(_MSC_VER)
+			int r[4];
+			__cpuidex(r, (int)Leaf, 0);
+			for(int i = 0; i < 4; i++) Regs[i] = (unsigned int)r[i];
+		#else
+			Regs[0] = Regs[1] = Regs[2] = Regs[3] = 0;
+			__cpuid_count(Leaf, 0, Regs[0], Regs[1], Regs[2], Regs[3]);
+		#endif
+		}
+
+		// Reads the OS-enabled register state mask
+		unsigned long long xgetbv()
+		{
+		#if defined(_MSC_VER)
+			return _xgetbv(0);
+		#else
+			unsigned int eax, edx;
+			__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return ((unsigned long long)edx << 32) | eax;
+		#endif
+		}
+		#endif
+
+		SimdLevel detect()
+		{
+		#if defined(HADRON_ARCH_X86)
+			unsigned int regs[4];
+
+			cpuid(0, regs);
+			const unsigned int maxLeaf = regs[0];
+			if(maxLeaf < 1) return SIMD_SCALAR;
+
+			cpuid(1, regs);
+			const bool sse2 = (regs[3] & (1u << 26)) != 0;
+			const bool osxsave = (regs[2] & (1u << 27)) != 0;
+			const bool avx = (regs[2] & (1u << 28)) != 0;
+
+			if(!sse2) return SIMD_SCALAR;
+
+			// AVX needs the OS to be saving the YMM registers too
+			if(maxLeaf >= 7 && osxsave && avx && (xgetbv() & 0x6) == 0x6)
+			{
+				cpuid(7, regs);
+				if(regs[1] & (1u << 5)) return SIMD_AVX2;
+			}
+
+			return SIMD_SSE2;
+		#else
+			return SIMD_SCALAR;
+		#endif
+		}
+
+		// Widest level the kernels are allowed to use, see SetSimdLevel
+		SimdLevel cappedLevel = SIMD_AVX2;
+	}
+
+	SimdLevel GetSupportedSimdLevel()
+	{
+		static const SimdLevel supported = detect();
+		return supported;
+	}
+
+	SimdLevel GetSimdLevel()
+	{
+		const SimdLevel supported = GetSupportedSimdLevel();
+		return cappedLevel < supported ? cappedLevel : supported;
+	}
+
+	void SetSimdLevel(SimdLevel Level)
+	{
+		cappedLevel = Level;
+	}
+};
@@ -0,0 +1,32 @@
+#ifndef HADRON_CPU_HPP
+#define HADRON_CPU_HPP
+
+// Only x86 and x86-64 get the SSE2 / AVX2 code paths, everything else uses the scalar fallback
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define HADRON_ARCH_X86
+#endif
+
+namespace Hadron {
+	// Instruction sets the batched kernels can be dispatched to, from narrowest to widest
+	enum SimdLevel
+	{
+		SIMD_SCALAR = 0,
+		SIMD_SSE2,
+		SIMD_AVX2
+	};
+
+	// Returns the widest instruction set both the CPU and the OS support
+	// ^- Worked out once, the first time it's asked for
+	SimdLevel GetSupportedSimdLevel();
+
+	// Returns the instruction set the batched kernels will actually use
+	// ^- The supported level, unless it's been capped with SetSimdLevel
+	SimdLevel GetSimdLevel();
+
+	// Caps the instruction set used by the batched kernels
+	// ^- Useful for benchmarking or debugging against the scalar path
+	// ^- Asking for more than the CPU supports just gives you the supported level
+	void SetSimdLevel(SimdLevel Level);
+};
+
+#endif // HADRON_CPU_HPP
@@ -0,0 +1,81 @@
+#include <math.h>
+#include "fixedtimestep.hpp"
+
+namespace Hadron {
+	FixedTimestep::FixedTimestep():
+	step((real)(1.0 / 60.0)),
+	maxSteps(5),
+	accumulator((real)0.0),
+	droppedTime((real)0.0)
+	{ }
+
+	FixedTimestep::FixedTimestep(real Step, unsigned int MaxSteps):
+	step(Step),
+	maxSteps(MaxSteps),
+	accumulator((real)0.0),
+	droppedTime((real)0.0)
+	{ }
+
+	real FixedTimestep::GetStep() const
+	{
+		return step;
+	}
+
+	unsigned int FixedTimestep::GetMaxSteps() const
+	{
+		return maxSteps;
+	}
+
+	real FixedTimestep::GetDroppedTime() const
+	{
+		return droppedTime;
+	}
+
+	real FixedTimestep::GetAlpha() const
+	{
+		return accumulator / step;
+	}
+
+	void FixedTimestep::SetStep(real Step)
+	{
+		step = Step;
+		accumulator = (real)0.0;
+	}
+
+	void FixedTimestep::SetMaxSteps(unsigned int MaxSteps)
+	{
+		maxSteps = MaxSteps;
+	}
+
+	unsigned int FixedTimestep::Advance(real FrameTime)
+	{
+		if(FrameTime > (real)0.0) accumulator += FrameTime;
+
+		unsigned int steps = 0;
+		while(accumulator >= step && steps < maxSteps)
+		{
+			accumulator -= step;
+			steps++;
+		}
+
+		// Past the cap, so throw the rest of the whole steps away
+		// ^- Keeps the fraction left over, so the interpolation carries on smoothly
+		if(accumulator >= step)
+		{
+			const real dropped = (real)floor(accumulator / step) * step;
+			accumulator -= dropped;
+			droppedTime += dropped;
+
+			// Rounding can leave it a hair over
+			if(accumulator >= step) accumulator = (real)0.0;
+		}
+
+		return steps;
+	}
+
+	void FixedTimestep::Reset()
+	{
+		accumulator = (real)0.0;
+		droppedTime = (real)0.0;
+	}
+};
@@ -0,0 +1,62 @@
+#ifndef HADRON_FIXEDTIMESTEP_HPP
+#define HADRON_FIXEDTIMESTEP_HPP
+
+#include "precision.hpp"
+
+namespace Hadron {
+	// Turns variable frame times into a whole number of fixed size steps
+	// ^- Frame time builds up in an accumulator, and each frame runs however many full steps it holds
+	// ^- The number of catch up steps in one frame is capped, so a hitch drops time rather than making the
+	//    next frame even slower
+	// ^- Whatever's left over says how far between the last two steps the frame actually is, for interpolation
+	//
+	// Usage, once a frame:
+	//   unsigned int steps = stepper.Advance(frameTime);
+	//   for(unsigned int i = 0; i < steps; i++)
+	//   {
+	//       if(i == steps - 1) interpolation.Capture(world);
+	//       ... step the simulation by stepper.GetStep() ...
+	//   }
+	//   interpolation.Interpolate(world, stepper.GetAlpha());
+	class FixedTimestep
+	{
+	private:
+		real step;
+		unsigned int maxSteps;
+
+		// Time that's built up but not been stepped yet, always less than one step
+		real accumulator;
+
+		// Total time thrown away by the step cap
+		real droppedTime;
+
+	public:
+		// Default constructor, 60 steps a second with up to 5 catch up steps a frame
+		FixedTimestep();
+
+		// Constructs a stepper with the given step size and cap
+		FixedTimestep(real Step, unsigned int MaxSteps);
+
+		// Getters
+		real GetStep() const;
+		unsigned int GetMaxSteps() const;
+		real GetDroppedTime() const;
+
+		// How far the frame is between the previous step and the latest one, in [0, 1)
+		real GetAlpha() const;
+
+		// Setters
+		void SetStep(real Step);
+		void SetMaxSteps(unsigned int MaxSteps);
+
+		// Methods
+		// Adds a frame's worth of time and returns how many steps to run for it
+		// ^- Never returns more than the cap, anything beyond it is dropped
+		unsigned int Advance(real FrameTime);
+
+		// Empties the accumulator and zeroes the dropped time
+		void Reset();
+	};
+};
+
+#endif // HADRON_FIXEDTIMESTEP_HPP
@@ -0,0 +1,117 @@
+#include <stddef.h>
+#include "mappedfile.hpp"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace Hadron {
+	MappedFile::MappedFile():
+	data(NULL),
+	size(0),
+	file(NULL),
+	mapping(NULL)
+	{ }
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const char *Path)
+	{
+		Close();
+
+	#if defined(_WIN32)
+		HANDLE f = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(f == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER length;
+		if(!GetFileSizeEx(f, &length) || length.QuadPart <= 0)
+		{
+			CloseHandle(f);
+			return false;
+		}
+
+		HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(m == NULL)
+		{
+			CloseHandle(f);
+			return false;
+		}
+
+		void *view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+		if(view == NULL)
+		{
+			CloseHandle(m);
+			CloseHandle(f);
+			return false;
+		}
+
+		file = f;
+		mapping = m;
+		data = (const unsigned char *)view;
+		size = (unsigned long long)length.QuadPart;
+	#else
+		const int f = open(Path, O_RDONLY);
+		if(f < 0) return false;
+
+		struct stat info;
+		if(fstat(f, &info) != 0 || info.st_size <= 0)
+		{
+			close(f);
+			return false;
+		}
+
+		void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, f, 0);
+
+		// The mapping holds its own reference to the file
+		close(f);
+		if(view == MAP_FAILED) return false;
+
+		data = (const unsigned char *)view;
+		size = (unsigned long long)info.st_size;
+	#endif
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if(data == NULL) return;
+
+	#if defined(_WIN32)
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)mapping);
+		CloseHandle((HANDLE)file);
+	#else
+		munmap((void *)data, (size_t)size);
+	#endif
+
+		data = NULL;
+		size = 0;
+		file = NULL;
+		mapping = NULL;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return data != NULL;
+	}
+
+	const unsigned char *MappedFile::GetData() const
+	{
+		return data;
+	}
+
+	unsigned long long MappedFile::GetSize() const
+	{
+		return size;
+	}
+};
@@ -0,0 +1,41 @@
+#ifndef HADRON_MAPPEDFILE_HPP
+#define HADRON_MAPPEDFILE_HPP
+
+namespace Hadron {
+	// A whole file mapped read-only into memory
+	// ^- Pages are only read in from disk as they're first touched, so opening even a huge file is near instant
+	// ^- The mapping lasts until Close or the destructor, anything pointing into it is invalid after that
+	class MappedFile
+	{
+	private:
+		const unsigned char *data;
+		unsigned long long size;
+
+		// The OS's handles, void pointers so the header doesn't need any platform includes
+		void *file;
+		void *mapping;
+
+		// Not copyable
+		MappedFile(const MappedFile &);
+		MappedFile &operator=(const MappedFile &);
+
+	public:
+		// Default constructor
+		MappedFile();
+		~MappedFile();
+
+		// Maps the given file, closing anything that was already open
+		// ^- Returns false if it can't be opened or mapped, empty files included
+		bool Open(const char *Path);
+
+		// Unmaps the file
+		void Close();
+
+		// Getters
+		bool IsOpen() const;
+		const unsigned char *GetData() const;
+		unsigned long long GetSize() const;
+	};
+};
+
+#endif // HADRON_MAPPEDFILE_HPP
@@ -0,0 +1,42 @@
+#ifndef HADRON_PARALLEL_HPP
+#define HADRON_PARALLEL_HPP
+
+#include <vector>
+
+#include "threadpool.hpp"
+
+namespace Hadron {
+	// Splits [Begin, End) into contiguous chunks and calls Fn(ChunkBegin, ChunkEnd) for each on the pool
+	// ^- A few chunks per thread, so work stealing can even things out when some chunks are slower
+	// ^- Everything's finished by the time this returns
+	// ^- A NULL pool just calls Fn(Begin, End) on the calling thread
+	template<typename Function>
+	void ParallelFor(ThreadPool *Pool, unsigned int Begin, unsigned int End, Function Fn)
+	{
+		if(End <= Begin) return;
+
+		const unsigned int count = End - Begin;
+		unsigned int chunks = Pool ? Pool->GetThreadCount() * 4 : 1;
+		if(chunks > count) chunks = count;
+
+		if(chunks <= 1)
+		{
+			Fn(Begin, End);
+			return;
+		}
+
+		std::vector<ThreadPool::Task> tasks;
+		tasks.reserve(chunks);
+
+		for(unsigned int c = 0; c < chunks; c++)
+		{
+			const unsigned int chunkBegin = Begin + (unsigned int)((unsigned long long)count * c / chunks);
+			const unsigned int chunkEnd = Begin + (unsigned int)((unsigned long long)count * (c + 1) / chunks);
+			tasks.push_back([&Fn, chunkBegin, chunkEnd]() { Fn(chunkBegin, chunkEnd); });
+		}
+
+		Pool->Run(tasks);
+	}
+};
+
+#endif // HADRON_PARALLEL_HPP
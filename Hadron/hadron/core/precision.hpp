@@ -2,26 +2,53 @@
 #define HADRON_PRECISION_HPP
 
 #include <float.h>
+#include <math.h>
 
 namespace Hadron {
-// Change this 0 to a 1 to enable float precision instead of double
-#if 0
+// real is the default scalar, used by Particle, the force generators and everything else that isn't templated
+// ^- Define HADRON_FLOAT_PRECISION for the whole build to make it float instead of double
+// ^- The templated types (BasicParticleWorld and friends) can use either scalar in the same binary, whatever real is
+#ifdef HADRON_FLOAT_PRECISION
 	typedef float real;
 	#define real_pow powf
 	#define real_sin sinf
 	#define real_cos cosf
 	#define real_tan tanf
-	#define real_abs fabsf;
-	#define REAL_MAX FLT_MAX;
+	#define real_abs fabsf
+	#define REAL_MAX FLT_MAX
 #else
 	typedef double real;
 	#define real_pow pow
 	#define real_sin sin
 	#define real_cos cos
 	#define real_tan tan
-	#define real_abs(n)(abs((double)n))
-	#define REAL_MAX DBL_MAX;
+	#define real_abs fabs
+	#define REAL_MAX DBL_MAX
 #endif
+
+	// Limits and maths functions for each scalar, for code templated on it
+	template<typename T>
+	struct ScalarTraits;
+
+	template<>
+	struct ScalarTraits<float>
+	{
+		static float Max() { return FLT_MAX; }
+		static float Epsilon() { return FLT_EPSILON; }
+		static float Abs(float X) { return fabsf(X); }
+		static float Sqrt(float X) { return sqrtf(X); }
+		static float Pow(float X, float Y) { return powf(X, Y); }
+	};
+
+	template<>
+	struct ScalarTraits<double>
+	{
+		static double Max() { return DBL_MAX; }
+		static double Epsilon() { return DBL_EPSILON; }
+		static double Abs(double X) { return fabs(X); }
+		static double Sqrt(double X) { return sqrt(X); }
+		static double Pow(double X, double Y) { return pow(X, Y); }
+	};
 };
 
-#endif // HADRON_PRECISION_HPP
\ No newline at end of file
+#endif // HADRON_PRECISION_HPP
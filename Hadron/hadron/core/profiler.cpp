@@ -0,0 +1,412 @@
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include "profiler.hpp"
+
+namespace Hadron {
+	std::atomic<bool> profilingEnabled(false);
+
+	namespace {
+		struct Event
+		{
+			const char *name;
+			unsigned long long start;
+			unsigned long long end;
+		};
+
+		struct Count
+		{
+			const char *name;
+			unsigned long long value;
+			unsigned long long calls;
+		};
+
+		// What one thread's recorded since the last EndProfileFrame
+		// ^- Only its own thread adds to it, and only EndProfileFrame empties it, so neither needs a lock
+		struct ThreadLog
+		{
+			unsigned int id;
+			std::vector<Event> events;
+			std::vector<Count> counts;
+		};
+
+		// A scope's or counter's total over one frame
+		struct FrameStat
+		{
+			const char *name;
+			bool counter;
+			double value;
+			unsigned long long calls;
+		};
+
+		struct Frame
+		{
+			unsigned long long start;
+			unsigned long long end;
+			std::vector<FrameStat> stats;
+		};
+
+		struct CapturedEvent
+		{
+			const char *name;
+			unsigned int thread;
+			unsigned long long start;
+			unsigned long long end;
+		};
+
+		struct CapturedCount
+		{
+			const char *name;
+			unsigned long long time;
+			double value;
+		};
+
+		std::mutex lock;
+
+		// Every thread that's ever recorded anything, kept for the life of the program as threads can come
+		// and go between frames
+		std::vector<ThreadLog *> logs;
+		thread_local ThreadLog *threadLog = NULL;
+
+		std::deque<Frame> history;
+		unsigned int historyFrames = 120;
+		unsigned long long frameStart = 0;
+
+		bool capturing = false;
+		std::vector<CapturedEvent> capturedEvents;
+		std::vector<CapturedCount> capturedCounts;
+
+		ThreadLog *getLog()
+		{
+			if(threadLog == NULL)
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				threadLog = new ThreadLog();
+				threadLog->id = (unsigned int)logs.size();
+				logs.push_back(threadLog);
+			}
+
+			return threadLog;
+		}
+
+		// Adds to the stat with the same name, or starts a new one
+		// ^- Compared as strings, the same literal can end up at different addresses in different files
+		void addStat(std::vector<FrameStat> &Stats, const char *Name, bool Counter, double Value, unsigned long long Calls)
+		{
+			for(unsigned int i = 0; i < Stats.size(); i++)
+			{
+				if(Stats[i].counter == Counter && (Stats[i].name == Name || strcmp(Stats[i].name, Name) == 0))
+				{
+					Stats[i].value += Value;
+					Stats[i].calls += Calls;
+					return;
+				}
+			}
+
+			FrameStat stat;
+			stat.name = Name;
+			stat.counter = Counter;
+			stat.value = Value;
+			stat.calls = Calls;
+			Stats.push_back(stat);
+		}
+
+		// Scopes before counters, slowest scopes first and counters by name
+		struct StatOrder
+		{
+			bool operator()(const ProfileStat &A, const ProfileStat &B) const
+			{
+				if(A.counter != B.counter) return !A.counter;
+				if(!A.counter && A.average != B.average) return A.average > B.average;
+				return strcmp(A.name, B.name) < 0;
+			}
+		};
+
+		// Names go into the trace as JSON strings
+		void writeJsonString(FILE *File, const char *String)
+		{
+			fputc('"', File);
+			for(const char *c = String; *c != '\0'; c++)
+			{
+				if(*c == '"' || *c == '\\') fputc('\\', File);
+				if((unsigned char)*c < 0x20) fprintf(File, "\\u%04x", (unsigned int)(unsigned char)*c);
+				else fputc(*c, File);
+			}
+			fputc('"', File);
+		}
+	};
+
+	void SetProfilingEnabled(bool Enabled)
+	{
+		if(Enabled && !IsProfilingEnabled())
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			frameStart = GetProfileTime();
+		}
+
+		profilingEnabled.store(Enabled, std::memory_order_relaxed);
+	}
+
+	unsigned long long GetProfileTime()
+	{
+		static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+		return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	void AddProfileEvent(const char *Name, unsigned long long Start, unsigned long long End)
+	{
+		Event event;
+		event.name = Name;
+		event.start = Start;
+		event.end = End;
+
+		getLog()->events.push_back(event);
+	}
+
+	void AddProfileCount(const char *Name, unsigned long long Value)
+	{
+		std::vector<Count> &counts = getLog()->counts;
+		for(unsigned int i = 0; i < counts.size(); i++)
+		{
+			if(counts[i].name == Name)
+			{
+				counts[i].value += Value;
+				counts[i].calls++;
+				return;
+			}
+		}
+
+		Count count;
+		count.name = Name;
+		count.value = Value;
+		count.calls = 1;
+		counts.push_back(count);
+	}
+
+	void EndProfileFrame()
+	{
+		const unsigned long long now = GetProfileTime();
+		std::lock_guard<std::mutex> guard(lock);
+
+		if(!IsProfilingEnabled())
+		{
+			frameStart = now;
+			return;
+		}
+
+		Frame frame;
+		frame.start = frameStart;
+		frame.end = now;
+
+		for(unsigned int l = 0; l < logs.size(); l++)
+		{
+			ThreadLog &log = *logs[l];
+
+			for(unsigned int i = 0; i < log.events.size(); i++)
+			{
+				const Event &event = log.events[i];
+				addStat(frame.stats, event.name, false, (double)(event.end - event.start) * 1e-6, 1);
+
+				if(capturing)
+				{
+					CapturedEvent captured;
+					captured.name = event.name;
+					captured.thread = log.id;
+					captured.start = event.start;
+					captured.end = event.end;
+					capturedEvents.push_back(captured);
+				}
+			}
+
+			for(unsigned int i = 0; i < log.counts.size(); i++)
+			{
+				addStat(frame.stats, log.counts[i].name, true, (double)log.counts[i].value, log.counts[i].calls);
+			}
+
+			// Keeps their capacity, so a steady frame doesn't allocate
+			log.events.clear();
+			log.counts.clear();
+		}
+
+		// Counters go in once per frame, after the threads' counts are added together
+		for(unsigned int i = 0; capturing && i < frame.stats.size(); i++)
+		{
+			if(!frame.stats[i].counter) continue;
+
+			CapturedCount captured;
+			captured.name = frame.stats[i].name;
+			captured.time = now;
+			captured.value = frame.stats[i].value;
+			capturedCounts.push_back(captured);
+		}
+
+		history.push_back(frame);
+		while(history.size() > historyFrames) history.pop_front();
+
+		frameStart = now;
+	}
+
+	void SetProfileHistory(unsigned int Frames)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		historyFrames = Frames > 0 ? Frames : 1;
+		while(history.size() > historyFrames) history.pop_front();
+	}
+
+	void GetProfileSummary(std::vector<ProfileStat> &Out, double *FrameAverage, double *FrameMaximum)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		Out.clear();
+
+		double frameTotal = 0.0, frameMaximum = 0.0;
+		for(unsigned int f = 0; f < history.size(); f++)
+		{
+			const Frame &frame = history[f];
+
+			const double length = (double)(frame.end - frame.start) * 1e-6;
+			frameTotal += length;
+			frameMaximum = std::max(frameMaximum, length);
+
+			for(unsigned int s = 0; s < frame.stats.size(); s++)
+			{
+				const FrameStat &stat = frame.stats[s];
+
+				unsigned int i = 0;
+				while(i < Out.size() && (Out[i].counter != stat.counter || strcmp(Out[i].name, stat.name) != 0)) i++;
+
+				if(i == Out.size())
+				{
+					ProfileStat added;
+					added.name = stat.name;
+					added.counter = stat.counter;
+					added.average = 0.0;
+					added.maximum = 0.0;
+					added.calls = 0.0;
+					Out.push_back(added);
+				}
+
+				// Totals for now, divided down below
+				Out[i].average += stat.value;
+				Out[i].maximum = std::max(Out[i].maximum, stat.value);
+				Out[i].calls += (double)stat.calls;
+			}
+		}
+
+		// Frames a stat didn't show up in count as zeroes
+		const double frames = history.empty() ? 1.0 : (double)history.size();
+		for(unsigned int i = 0; i < Out.size(); i++)
+		{
+			Out[i].average /= frames;
+			Out[i].calls /= frames;
+		}
+
+		std::sort(Out.begin(), Out.end(), StatOrder());
+
+		if(FrameAverage != NULL) *FrameAverage = frameTotal / frames;
+		if(FrameMaximum != NULL) *FrameMaximum = frameMaximum;
+	}
+
+	void WriteProfileSummary(FILE *File)
+	{
+		std::vector<ProfileStat> stats;
+		double frameAverage, frameMaximum;
+		GetProfileSummary(stats, &frameAverage, &frameMaximum);
+
+		fprintf(File, "frame %.3f ms average, %.3f ms max\n", frameAverage, frameMaximum);
+		fprintf(File, "%-28s %12s %12s %10s %9s\n", "scope", "avg ms", "max ms", "calls", "% frame");
+
+		for(unsigned int i = 0; i < stats.size(); i++)
+		{
+			const ProfileStat &stat = stats[i];
+			if(stat.counter) continue;
+
+			const double share = frameAverage > 0.0 ? 100.0 * stat.average / frameAverage : 0.0;
+			fprintf(File, "%-28s %12.3f %12.3f %10.1f %9.1f\n", stat.name, stat.average, stat.maximum, stat.calls, share);
+		}
+
+		fprintf(File, "%-28s %12s %12s\n", "counter", "avg", "max");
+		for(unsigned int i = 0; i < stats.size(); i++)
+		{
+			const ProfileStat &stat = stats[i];
+			if(!stat.counter) continue;
+
+			fprintf(File, "%-28s %12.0f %12.0f\n", stat.name, stat.average, stat.maximum);
+		}
+	}
+
+	void StartProfileCapture()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		capturing = true;
+		capturedEvents.clear();
+		capturedCounts.clear();
+	}
+
+	void StopProfileCapture()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		capturing = false;
+	}
+
+	bool WriteChromeTrace(const char *Path)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		FILE *file = fopen(Path, "w");
+		if(file == NULL) return false;
+
+		// Timestamps are in microseconds
+		fprintf(file, "{\"traceEvents\":[\n");
+		fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Hadron\"}}");
+
+		for(unsigned int i = 0; i < logs.size(); i++)
+		{
+			fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+				logs[i]->id, logs[i]->id);
+		}
+
+		for(unsigned int i = 0; i < capturedEvents.size(); i++)
+		{
+			const CapturedEvent &event = capturedEvents[i];
+
+			fprintf(file, ",\n{\"name\":");
+			writeJsonString(file, event.name);
+			fprintf(file, ",\"cat\":\"hadron\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				(double)event.start * 1e-3, (double)(event.end - event.start) * 1e-3, event.thread);
+		}
+
+		for(unsigned int i = 0; i < capturedCounts.size(); i++)
+		{
+			const CapturedCount &count = capturedCounts[i];
+
+			fprintf(file, ",\n{\"name\":");
+			writeJsonString(file, count.name);
+			fprintf(file, ",\"cat\":\"hadron\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%.0f}}",
+				(double)count.time * 1e-3, count.value);
+		}
+
+		fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+		const bool ok = !ferror(file);
+		return (fclose(file) == 0) && ok;
+	}
+
+	void ClearProfile()
+	{
+		std::lock_guard<std::mutex> guard(lock);
+
+		history.clear();
+		capturedEvents.clear();
+		capturedCounts.clear();
+
+		for(unsigned int i = 0; i < logs.size(); i++)
+		{
+			logs[i]->events.clear();
+			logs[i]->counts.clear();
+		}
+	}
+};
@@ -0,0 +1,121 @@
+#ifndef HADRON_PROFILER_HPP
+#define HADRON_PROFILER_HPP
+
+#include <stdio.h>
+
+#include <atomic>
+#include <vector>
+
+// Define HADRON_NO_PROFILING to compile every profiling scope and counter out completely
+// ^- Otherwise they're compiled in but off until SetProfilingEnabled(true), costing a load and a branch each
+
+#if defined(HADRON_NO_PROFILING)
+	#define HADRON_PROFILE_SCOPE(Name)
+	#define HADRON_PROFILE_COUNT(Name, Value)
+#else
+	#define HADRON_PROFILE_JOIN2(A, B) A##B
+	#define HADRON_PROFILE_JOIN(A, B) HADRON_PROFILE_JOIN2(A, B)
+
+	// Times from here to the end of the enclosing block under Name
+	#define HADRON_PROFILE_SCOPE(Name) Hadron::ProfileScope HADRON_PROFILE_JOIN(hadronProfileScope, __LINE__)(Name)
+
+	// Adds Value to this frame's Name counter
+	// ^- Value's only evaluated when profiling's on, so it can be something that takes a little working out
+	#define HADRON_PROFILE_COUNT(Name, Value) \
+		do { if(Hadron::IsProfilingEnabled()) Hadron::AddProfileCount(Name, (unsigned long long)(Value)); } while(0)
+#endif
+
+namespace Hadron {
+	// The profiler's off to start with
+	// ^- Only switch it on or off between frames, a scope that's open while it changes is dropped
+	void SetProfilingEnabled(bool Enabled);
+
+	// Set by SetProfilingEnabled, only here so the check can be inlined
+	extern std::atomic<bool> profilingEnabled;
+
+	inline bool IsProfilingEnabled()
+	{
+		return profilingEnabled.load(std::memory_order_relaxed);
+	}
+
+	// Nanoseconds since the profiler was first used
+	unsigned long long GetProfileTime();
+
+	// Records a finished scope or a count on the calling thread
+	// ^- Names have to live for as long as the profiler does, string literals are the usual thing
+	// ^- Scopes and counters with the same name from different places are added together
+	void AddProfileEvent(const char *Name, unsigned long long Start, unsigned long long End);
+	void AddProfileCount(const char *Name, unsigned long long Value);
+
+	// Times the block it's declared in, see HADRON_PROFILE_SCOPE
+	class ProfileScope
+	{
+	private:
+		const char *name;
+		unsigned long long start;
+
+		// Not copyable
+		ProfileScope(const ProfileScope &);
+		ProfileScope &operator=(const ProfileScope &);
+
+	public:
+		explicit ProfileScope(const char *Name):
+		name(NULL),
+		start(0)
+		{
+			if(!IsProfilingEnabled()) return;
+
+			name = Name;
+			start = GetProfileTime();
+		}
+
+		~ProfileScope()
+		{
+			if(name != NULL && IsProfilingEnabled()) AddProfileEvent(name, start, GetProfileTime());
+		}
+	};
+
+	// One scope's or counter's figures over the summary's frames
+	struct ProfileStat
+	{
+		const char *name;
+		bool counter;
+
+		// Per frame, in milliseconds for scopes and as counted for counters
+		double average;
+		double maximum;
+
+		// Times the scope ran or the counter was added to, per frame
+		double calls;
+	};
+
+	// Closes off the current frame, adding it to the rolling summary
+	// ^- Call once per frame from the thread that steps the simulation, while nothing profiled is running on
+	//    any other thread (between steps, the pools have all finished by then)
+	void EndProfileFrame();
+
+	// Number of frames the rolling summary covers, 120 by default
+	void SetProfileHistory(unsigned int Frames);
+
+	// Fills Out with every scope and counter seen over the summary's frames, slowest scopes first then counters by name
+	// ^- FrameAverage and FrameMaximum get the frames' own lengths, in milliseconds
+	void GetProfileSummary(std::vector<ProfileStat> &Out, double *FrameAverage = NULL, double *FrameMaximum = NULL);
+
+	// Prints the summary as a table
+	void WriteProfileSummary(FILE *File);
+
+	// Starts keeping every scope and counter for WriteChromeTrace, dropping anything kept before
+	// ^- Off by default, as the events build up for as long as it's on
+	void StartProfileCapture();
+	void StopProfileCapture();
+
+	// Writes the captured events out as Chrome trace JSON, for chrome://tracing or Perfetto
+	// ^- Scopes come out as complete events on their thread, counters as counter events at the end of their frame
+	// ^- Returns false if the file can't be written
+	bool WriteChromeTrace(const char *Path);
+
+	// Drops the summary and any captured events
+	void ClearProfile();
+};
+
+#endif // HADRON_PROFILER_HPP
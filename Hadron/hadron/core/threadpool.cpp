@@ -0,0 +1,158 @@
+#include <utility>
+#include "threadpool.hpp"
+
+namespace Hadron {
+	namespace {
+		// The pool the current thread works for, and which of its queues is this thread's own
+		thread_local const ThreadPool *currentPool = NULL;
+		thread_local unsigned int currentQueue = 0;
+	}
+
+	ThreadPool::ThreadPool(unsigned int Threads):
+	queues(NULL),
+	queueCount(0),
+	queued(0),
+	quit(false)
+	{
+		if(Threads == 0) Threads = std::thread::hardware_concurrency();
+		if(Threads == 0) Threads = 1;
+
+		queueCount = Threads;
+		queues = new Queue[queueCount];
+
+		// The caller makes up the last thread, so one fewer worker
+		workers.reserve(Threads - 1);
+		for(unsigned int i = 1; i < Threads; i++)
+		{
+			workers.push_back(std::thread(&ThreadPool::workerMain, this, i));
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+			quit = true;
+		}
+		wake.notify_all();
+
+		for(unsigned int i = 0; i < workers.size(); i++)
+		{
+			workers[i].join();
+		}
+
+		delete[] queues;
+	}
+
+	unsigned int ThreadPool::GetThreadCount() const
+	{
+		return queueCount;
+	}
+
+	void ThreadPool::Run(std::vector<Task> &Tasks)
+	{
+		if(Tasks.empty()) return;
+
+		const unsigned int count = (unsigned int)Tasks.size();
+
+		// Nothing to share it out with
+		if(queueCount == 1)
+		{
+			for(unsigned int i = 0; i < count; i++) Tasks[i]();
+			return;
+		}
+
+		const unsigned int self = (currentPool == this) ? currentQueue : 0;
+		std::atomic<unsigned int> remaining(count);
+
+		// Count them in first, so a worker can never take a job it hasn't been told about yet
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+			queued += count;
+		}
+
+		// Deal the jobs out round robin, starting with our own queue
+		for(unsigned int i = 0; i < count; i++)
+		{
+			Job job;
+			job.task.swap(Tasks[i]);
+			job.remaining = &remaining;
+
+			Queue &q = queues[(self + i) % queueCount];
+			std::lock_guard<std::mutex> guard(q.lock);
+			q.jobs.push_back(std::move(job));
+		}
+
+		wake.notify_all();
+
+		// Help out until every job in the batch is done
+		// ^- This may well run jobs from other batches too, which is fine - they all need doing
+		while(remaining.load() > 0)
+		{
+			Job job;
+			if(takeJob(self, job)) runJob(job);
+			else std::this_thread::yield();
+		}
+	}
+
+	bool ThreadPool::takeJob(unsigned int Self, Job &Out)
+	{
+		// Newest first from our own queue, it's most likely still in cache
+		{
+			Queue &q = queues[Self];
+			std::lock_guard<std::mutex> guard(q.lock);
+			if(!q.jobs.empty())
+			{
+				Out = std::move(q.jobs.back());
+				q.jobs.pop_back();
+				queued--;
+				return true;
+			}
+		}
+
+		// Otherwise steal the oldest from someone else
+		for(unsigned int i = 1; i < queueCount; i++)
+		{
+			Queue &q = queues[(Self + i) % queueCount];
+			std::lock_guard<std::mutex> guard(q.lock);
+			if(!q.jobs.empty())
+			{
+				Out = std::move(q.jobs.front());
+				q.jobs.pop_front();
+				queued--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::runJob(Job &J)
+	{
+		J.task();
+
+		// Mustn't touch the batch after this, the thread waiting on it may return straight away
+		J.remaining->fetch_sub(1);
+	}
+
+	void ThreadPool::workerMain(unsigned int Index)
+	{
+		currentPool = this;
+		currentQueue = Index;
+
+		for(;;)
+		{
+			Job job;
+			if(takeJob(Index, job))
+			{
+				runJob(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> guard(sleepLock);
+			while(!quit && queued.load() == 0) wake.wait(guard);
+
+			if(quit && queued.load() == 0) return;
+		}
+	}
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef HADRON_THREADPOOL_HPP
+#define HADRON_THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Hadron {
+	// A fixed set of worker threads that share out batches of tasks by work stealing
+	// ^- Each thread has its own queue, works from the back of it and steals from the front of the others
+	//    when it runs dry, so uneven tasks still keep every thread busy
+	// ^- The thread calling Run joins in rather than sitting idle, which also makes nested Runs safe
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void()> Task;
+
+	private:
+		struct Job
+		{
+			Task task;
+
+			// Counts down as a batch's jobs finish
+			std::atomic<unsigned int> *remaining;
+		};
+
+		struct Queue
+		{
+			std::mutex lock;
+			std::deque<Job> jobs;
+		};
+
+		std::vector<std::thread> workers;
+
+		// One queue per worker, plus queue 0 for whoever calls Run from outside the pool
+		Queue *queues;
+		unsigned int queueCount;
+
+		// Jobs sitting in a queue somewhere, so idle workers know whether to sleep
+		std::atomic<unsigned int> queued;
+		std::mutex sleepLock;
+		std::condition_variable wake;
+		bool quit;
+
+		// Takes a job from the given thread's own queue, or steals one from another
+		bool takeJob(unsigned int Self, Job &Out);
+
+		// Runs a job and marks it as done
+		void runJob(Job &J);
+
+		void workerMain(unsigned int Index);
+
+		// Not copyable
+		ThreadPool(const ThreadPool &);
+		void operator=(const ThreadPool &);
+
+	public:
+		// Threads is the total number of threads that work on a Run, including the caller
+		// ^- 0 uses one per hardware thread
+		explicit ThreadPool(unsigned int Threads);
+		~ThreadPool();
+
+		// Getters
+		unsigned int GetThreadCount() const;
+
+		// Runs every task and waits until they've all finished
+		void Run(std::vector<Task> &Tasks);
+	};
+};
+
+#endif // HADRON_THREADPOOL_HPP
\ No newline at end of file
@@ -1,7 +1,22 @@
 #ifndef HADRON_ENTITY_HPP
 #define HADRON_ENTITY_HPP
 
+#include "hadron/entity/implicitspringsolver.hpp"
 #include "hadron/entity/particle.hpp"
+#include "hadron/entity/particleconstraintsolver.hpp"
+#include "hadron/entity/particlecontact.hpp"
+#include "hadron/entity/particlefluid.hpp"
+#include "hadron/entity/particleforcefield.hpp"
 #include "hadron/entity/particleforcegenerator.hpp"
+#include "hadron/entity/particlehashgrid.hpp"
+#include "hadron/entity/particleintegrator.hpp"
+#include "hadron/entity/particleinterpolation.hpp"
+#include "hadron/entity/particlemortonsort.hpp"
+#include "hadron/entity/particleoctree.hpp"
+#include "hadron/entity/particlepool.hpp"
+#include "hadron/entity/particlerecorder.hpp"
+#include "hadron/entity/particlesnapshot.hpp"
+#include "hadron/entity/particleworld.hpp"
+#include "hadron/entity/springnetwork.hpp"
 
 #endif // HADRON_ENTITY_HPP
\ No newline at end of file
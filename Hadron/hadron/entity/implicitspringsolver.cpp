@@ -0,0 +1,437 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "implicitspringsolver.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	namespace {
+		// Out = A * In for a 3x3 block
+		inline void blockMultiplyAdd(const real *A, const real *In, real *Out)
+		{
+			Out[0] += (A[0] * In[0]) + (A[1] * In[1]) + (A[2] * In[2]);
+			Out[1] += (A[3] * In[0]) + (A[4] * In[1]) + (A[5] * In[2]);
+			Out[2] += (A[6] * In[0]) + (A[7] * In[1]) + (A[8] * In[2]);
+		}
+
+		// Adds Scale * H to a block
+		inline void blockAdd(real *A, const real *H, real Scale)
+		{
+			for(unsigned int i = 0; i < 9; i++) A[i] += H[i] * Scale;
+		}
+
+		real dot(const std::vector<real> &A, const std::vector<real> &B)
+		{
+			real sum = (real)0.0;
+			for(unsigned int i = 0; i < A.size(); i++) sum += A[i] * B[i];
+			return sum;
+		}
+	}
+
+	ImplicitSpringSolver::ImplicitSpringSolver():
+	builtParticles(0),
+	builtSprings(0),
+	builtVersion(0),
+	built(false),
+	maxIterations(50),
+	tolerance((real)1e-6),
+	lastIterations(0),
+	lastResidual((real)0.0),
+	pool(NULL)
+	{ }
+
+	unsigned int ImplicitSpringSolver::GetMaxIterations() const
+	{
+		return maxIterations;
+	}
+
+	real ImplicitSpringSolver::GetTolerance() const
+	{
+		return tolerance;
+	}
+
+	unsigned int ImplicitSpringSolver::GetLastIterations() const
+	{
+		return lastIterations;
+	}
+
+	real ImplicitSpringSolver::GetLastResidual() const
+	{
+		return lastResidual;
+	}
+
+	void ImplicitSpringSolver::SetMaxIterations(unsigned int MaxIterations)
+	{
+		maxIterations = MaxIterations;
+	}
+
+	void ImplicitSpringSolver::SetTolerance(real Tolerance)
+	{
+		tolerance = Tolerance;
+	}
+
+	void ImplicitSpringSolver::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	void ImplicitSpringSolver::buildStructure(const SpringNetwork &Network, unsigned int ParticleCount)
+	{
+		if(built && builtParticles == ParticleCount && builtSprings == Network.GetCount() &&
+			builtVersion == Network.GetTopologyVersion()) return;
+
+		const unsigned int springs = Network.GetCount();
+
+		// Every particle's neighbours, itself included for the diagonal
+		std::vector<std::pair<unsigned int, unsigned int> > entries;
+		entries.reserve(ParticleCount + springs * 2);
+		for(unsigned int p = 0; p < ParticleCount; p++)
+		{
+			entries.push_back(std::make_pair(p, p));
+		}
+
+		for(unsigned int s = 0; s < springs; s++)
+		{
+			const unsigned int a = Network.GetParticleA(s), b = Network.GetParticleB(s);
+			if(a == b) continue;
+
+			entries.push_back(std::make_pair(a, b));
+			entries.push_back(std::make_pair(b, a));
+		}
+
+		// Sorted by row then column, with springs between the same two particles sharing their blocks
+		std::sort(entries.begin(), entries.end());
+		entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+		rowStart.assign(ParticleCount + 1, 0);
+		blockColumn.resize(entries.size());
+		for(unsigned int e = 0; e < entries.size(); e++)
+		{
+			rowStart[entries[e].first + 1]++;
+			blockColumn[e] = entries[e].second;
+		}
+
+		for(unsigned int p = 0; p < ParticleCount; p++)
+		{
+			rowStart[p + 1] += rowStart[p];
+		}
+
+		blocks.resize(entries.size());
+
+		// Looks up where the block for (Row, Column) ended up
+		struct Finder
+		{
+			const std::vector<unsigned int> &rowStart;
+			const std::vector<unsigned int> &blockColumn;
+
+			unsigned int operator()(unsigned int Row, unsigned int Column) const
+			{
+				return (unsigned int)(std::lower_bound(blockColumn.begin() + rowStart[Row], blockColumn.begin() + rowStart[Row + 1], Column) -
+					blockColumn.begin());
+			}
+		} find = { rowStart, blockColumn };
+
+		diagonalBlock.resize(ParticleCount);
+		for(unsigned int p = 0; p < ParticleCount; p++)
+		{
+			diagonalBlock[p] = find(p, p);
+		}
+
+		springBlocks.resize(springs * 4);
+		for(unsigned int s = 0; s < springs; s++)
+		{
+			const unsigned int a = Network.GetParticleA(s), b = Network.GetParticleB(s);
+			springBlocks[s * 4] = diagonalBlock[a];
+			springBlocks[s * 4 + 1] = diagonalBlock[b];
+			springBlocks[s * 4 + 2] = (a == b) ? diagonalBlock[a] : find(a, b);
+			springBlocks[s * 4 + 3] = (a == b) ? diagonalBlock[a] : find(b, a);
+		}
+
+		// Previous solution no longer lines up
+		deltaV.assign(ParticleCount * 3, (real)0.0);
+
+		builtParticles = ParticleCount;
+		builtSprings = springs;
+		builtVersion = Network.GetTopologyVersion();
+		built = true;
+	}
+
+	void ImplicitSpringSolver::assemble(const ParticleWorld &World, const SpringNetwork &Network, real dT)
+	{
+		const unsigned int count = World.GetCount();
+		const unsigned int springs = Network.GetCount();
+
+		const real *posX = World.GetPositionsX(), *posY = World.GetPositionsY(), *posZ = World.GetPositionsZ();
+		const real *velX = World.GetVelocitiesX(), *velY = World.GetVelocitiesY(), *velZ = World.GetVelocitiesZ();
+		const real *accX = World.GetAccelerationsX(), *accY = World.GetAccelerationsY(), *accZ = World.GetAccelerationsZ();
+		const real *forceX = World.GetForcesX(), *forceY = World.GetForcesY(), *forceZ = World.GetForcesZ();
+		const real *inverseMass = World.GetInverseMasses();
+		const unsigned char *alive = World.GetAliveFlags();
+		const unsigned char *asleep = World.GetSleepFlags();
+
+		// Anything heavier than this can't be told apart from infinite mass
+		const real maxMass = REAL_MAX;
+
+		fixed.resize(count);
+		rhs.resize(count * 3);
+
+		for(unsigned int b = 0; b < blocks.size(); b++)
+		{
+			for(unsigned int i = 0; i < 9; i++) blocks[b].m[i] = (real)0.0;
+		}
+
+		// Mass on the diagonal, and the explicit forces on the right
+		for(unsigned int p = 0; p < count; p++)
+		{
+			real *d = blocks[diagonalBlock[p]].m;
+			real *r = &rhs[p * 3];
+
+			fixed[p] = (!alive[p] || asleep[p] || inverseMass[p] <= (real)0.0 || inverseMass[p] * maxMass <= (real)1.0) ? 1 : 0;
+			if(fixed[p])
+			{
+				d[0] = d[4] = d[8] = (real)1.0;
+				r[0] = r[1] = r[2] = (real)0.0;
+				continue;
+			}
+
+			const real mass = (real)1.0 / inverseMass[p];
+			d[0] = d[4] = d[8] = mass;
+
+			r[0] = (forceX[p] + (accX[p] * mass)) * dT;
+			r[1] = (forceY[p] + (accY[p] * mass)) * dT;
+			r[2] = (forceZ[p] + (accZ[p] * mass)) * dT;
+		}
+
+		// Springs
+		for(unsigned int s = 0; s < springs; s++)
+		{
+			const unsigned int a = Network.GetParticleA(s), b = Network.GetParticleB(s);
+			if(a == b || !alive[a] || !alive[b]) continue;
+
+			const real dx = posX[a] - posX[b];
+			const real dy = posY[a] - posY[b];
+			const real dz = posZ[a] - posZ[b];
+			const real lengthSq = (dx * dx) + (dy * dy) + (dz * dz);
+			if(lengthSq <= (real)0.0) continue;
+
+			const real length = (real)sqrt(lengthSq);
+			const real n[3] = { dx / length, dy / length, dz / length };
+
+			const real k = Network.GetStiffness(s);
+			const real c = Network.GetDamping(s);
+			const real rest = Network.GetRestLength(s);
+
+			// Force on A, the same as SpringNetwork works it out
+			const real relative[3] = { velX[a] - velX[b], velY[a] - velY[b], velZ[a] - velZ[b] };
+			const real stretchRate = (relative[0] * n[0]) + (relative[1] * n[1]) + (relative[2] * n[2]);
+			const real magnitude = -((k * (length - rest)) + (c * stretchRate));
+
+			// Stiffness is k along the spring plus k * (1 - rest / length) across it
+			// ^- The sideways part goes negative when the spring's compressed, which would stop the matrix being
+			//    positive definite, so it's clamped to zero
+			real across = k * ((real)1.0 - (rest / length));
+			if(across < (real)0.0) across = (real)0.0;
+
+			// H = dT^2 * stiffness + dT * damping, which is -(dT^2 * df/dx + dT * df/dv) for the A end
+			real stiffness[9], h[9];
+			const real along = k - across;
+			for(unsigned int i = 0; i < 3; i++)
+			{
+				for(unsigned int j = 0; j < 3; j++)
+				{
+					const real outer = n[i] * n[j];
+					stiffness[i * 3 + j] = (along * outer) + ((i == j) ? across : (real)0.0);
+					h[i * 3 + j] = (stiffness[i * 3 + j] * dT * dT) + (c * outer * dT);
+				}
+			}
+
+			// dT * (f + dT * df/dx * v), df/dx * v being -stiffness * (vA - vB) for A
+			real stiffVelocity[3] = { (real)0.0, (real)0.0, (real)0.0 };
+			blockMultiplyAdd(stiffness, relative, stiffVelocity);
+
+			const real term[3] =
+			{
+				((n[0] * magnitude) - (stiffVelocity[0] * dT)) * dT,
+				((n[1] * magnitude) - (stiffVelocity[1] * dT)) * dT,
+				((n[2] * magnitude) - (stiffVelocity[2] * dT)) * dT
+			};
+
+			if(!fixed[a])
+			{
+				blockAdd(blocks[springBlocks[s * 4]].m, h, (real)1.0);
+				if(!fixed[b]) blockAdd(blocks[springBlocks[s * 4 + 2]].m, h, (real)-1.0);
+
+				rhs[a * 3] += term[0];
+				rhs[a * 3 + 1] += term[1];
+				rhs[a * 3 + 2] += term[2];
+			}
+
+			if(!fixed[b])
+			{
+				blockAdd(blocks[springBlocks[s * 4 + 1]].m, h, (real)1.0);
+				if(!fixed[a]) blockAdd(blocks[springBlocks[s * 4 + 3]].m, h, (real)-1.0);
+
+				rhs[b * 3] -= term[0];
+				rhs[b * 3 + 1] -= term[1];
+				rhs[b * 3 + 2] -= term[2];
+			}
+		}
+
+		// Invert the diagonal blocks for the preconditioner
+		inverseDiagonal.resize(count);
+		for(unsigned int p = 0; p < count; p++)
+		{
+			const real *m = blocks[diagonalBlock[p]].m;
+			real *inv = inverseDiagonal[p].m;
+
+			inv[0] = (m[4] * m[8]) - (m[5] * m[7]);
+			inv[1] = (m[2] * m[7]) - (m[1] * m[8]);
+			inv[2] = (m[1] * m[5]) - (m[2] * m[4]);
+			inv[3] = (m[5] * m[6]) - (m[3] * m[8]);
+			inv[4] = (m[0] * m[8]) - (m[2] * m[6]);
+			inv[5] = (m[2] * m[3]) - (m[0] * m[5]);
+			inv[6] = (m[3] * m[7]) - (m[4] * m[6]);
+			inv[7] = (m[1] * m[6]) - (m[0] * m[7]);
+			inv[8] = (m[0] * m[4]) - (m[1] * m[3]);
+
+			const real determinant = (m[0] * inv[0]) + (m[1] * inv[3]) + (m[2] * inv[6]);
+			const real scale = (real)1.0 / determinant;
+			for(unsigned int i = 0; i < 9; i++) inv[i] *= scale;
+		}
+	}
+
+	void ImplicitSpringSolver::multiply(const real *In, real *Out)
+	{
+		ParallelFor(pool, 0, builtParticles, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int p = Begin; p < End; p++)
+			{
+				real *out = Out + p * 3;
+				out[0] = out[1] = out[2] = (real)0.0;
+
+				for(unsigned int e = rowStart[p]; e < rowStart[p + 1]; e++)
+				{
+					blockMultiplyAdd(blocks[e].m, In + blockColumn[e] * 3, out);
+				}
+			}
+		});
+	}
+
+	void ImplicitSpringSolver::precondition(const real *In, real *Out) const
+	{
+		for(unsigned int p = 0; p < builtParticles; p++)
+		{
+			real *out = Out + p * 3;
+			out[0] = out[1] = out[2] = (real)0.0;
+			blockMultiplyAdd(inverseDiagonal[p].m, In + p * 3, out);
+		}
+	}
+
+	void ImplicitSpringSolver::solve()
+	{
+		const unsigned int size = builtParticles * 3;
+		residual.resize(size);
+		search.resize(size);
+		product.resize(size);
+		preconditioned.resize(size);
+
+		// Fixed particles never change velocity, however the last solve left them
+		for(unsigned int p = 0; p < builtParticles; p++)
+		{
+			if(fixed[p]) deltaV[p * 3] = deltaV[p * 3 + 1] = deltaV[p * 3 + 2] = (real)0.0;
+		}
+
+		// Start from the last step's answer, it's usually close
+		multiply(&deltaV[0], &product[0]);
+		for(unsigned int i = 0; i < size; i++) residual[i] = rhs[i] - product[i];
+
+		const real rhsSq = dot(rhs, rhs);
+		const real targetSq = tolerance * tolerance * rhsSq;
+
+		precondition(&residual[0], &preconditioned[0]);
+		search = preconditioned;
+		real rz = dot(residual, preconditioned);
+		real residualSq = dot(residual, residual);
+
+		lastIterations = 0;
+		while(lastIterations < maxIterations && residualSq > targetSq)
+		{
+			multiply(&search[0], &product[0]);
+
+			const real curvature = dot(search, product);
+			if(curvature <= (real)0.0) break;
+
+			const real alpha = rz / curvature;
+			for(unsigned int i = 0; i < size; i++)
+			{
+				deltaV[i] += search[i] * alpha;
+				residual[i] -= product[i] * alpha;
+			}
+
+			lastIterations++;
+			residualSq = dot(residual, residual);
+			if(residualSq <= targetSq) break;
+
+			precondition(&residual[0], &preconditioned[0]);
+			const real nextRz = dot(residual, preconditioned);
+			const real beta = nextRz / rz;
+			rz = nextRz;
+
+			for(unsigned int i = 0; i < size; i++)
+			{
+				search[i] = preconditioned[i] + (search[i] * beta);
+			}
+		}
+
+		lastResidual = (rhsSq > (real)0.0) ? (real)sqrt(residualSq / rhsSq) : (real)0.0;
+	}
+
+	void ImplicitSpringSolver::Step(ParticleWorld &World, const SpringNetwork &Network, real dT)
+	{
+		const unsigned int count = World.GetCount();
+		if(count == 0) return;
+
+		// The block matrix is indexed by the springs' ends, so they all have to be in the world
+		assert(Network.GetParticleSpan() <= count);
+		if(Network.GetParticleSpan() > count) return;
+
+		HADRON_PROFILE_SCOPE("implicit springs");
+		World.PrepareStep(dT);
+		Network.WakeConnected(World);
+		World.UpdateSleep(0, count, dT);
+		buildStructure(Network, count);
+
+		{
+			HADRON_PROFILE_SCOPE("implicit assemble");
+			assemble(World, Network, dT);
+		}
+
+		{
+			HADRON_PROFILE_SCOPE("implicit solve");
+			solve();
+		}
+
+		HADRON_PROFILE_COUNT("cg iterations", lastIterations);
+
+		real *posX = World.GetPositionsX(), *posY = World.GetPositionsY(), *posZ = World.GetPositionsZ();
+		real *velX = World.GetVelocitiesX(), *velY = World.GetVelocitiesY(), *velZ = World.GetVelocitiesZ();
+		const real *damping = World.GetDampingFactors();
+
+		// New velocity, then move with it
+		for(unsigned int p = 0; p < count; p++)
+		{
+			if(fixed[p]) continue;
+
+			velX[p] = (velX[p] + deltaV[p * 3]) * damping[p];
+			velY[p] = (velY[p] + deltaV[p * 3 + 1]) * damping[p];
+			velZ[p] = (velZ[p] + deltaV[p * 3 + 2]) * damping[p];
+
+			posX[p] += velX[p] * dT;
+			posY[p] += velY[p] * dT;
+			posZ[p] += velZ[p] * dT;
+		}
+
+		World.ClearForces();
+	}
+};
@@ -0,0 +1,110 @@
+#ifndef HADRON_IMPLICITSPRINGSOLVER_HPP
+#define HADRON_IMPLICITSPRINGSOLVER_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "particleworld.hpp"
+#include "springnetwork.hpp"
+
+namespace Hadron {
+	// Steps a ParticleWorld with backward Euler, treating a SpringNetwork's springs implicitly
+	// ^- Solves (M - dT * df/dv - dT^2 * df/dx) dv = dT * (f + dT * df/dx * v) for the change in velocity, then
+	//    moves everything with the new velocities
+	// ^- Stays stable with stiff springs at steps many times larger than explicit integration can manage, at the
+	//    cost of some numerical damping
+	// ^- The spring Jacobians go into a sparse block matrix, one 3x3 block per pair of connected particles, solved
+	//    with conjugate gradient preconditioned by the inverse of each diagonal block
+	// ^- The matrix's structure is only rebuilt when the network's springs or the world's size change
+	// ^- Every other force on the world (gravity, anything already applied) is treated explicitly
+	class ImplicitSpringSolver
+	{
+	private:
+		struct Block
+		{
+			real m[9];
+		};
+
+		// Block sparse matrix in CSR form, row p's blocks are blocks[rowStart[p], rowStart[p + 1]) in column order
+		std::vector<unsigned int> rowStart;
+		std::vector<unsigned int> blockColumn;
+		std::vector<Block> blocks;
+
+		// Where each spring's four blocks live, in the order AA, BB, AB, BA
+		std::vector<unsigned int> springBlocks;
+
+		// Index of each row's diagonal block
+		std::vector<unsigned int> diagonalBlock;
+
+		// What the structure was built for
+		unsigned int builtParticles;
+		unsigned int builtSprings;
+		unsigned int builtVersion;
+		bool built;
+
+		// Per particle, 3 reals each, interleaved x, y, z
+		std::vector<real> rhs;
+		std::vector<real> deltaV;
+		std::vector<real> residual, search, product, preconditioned;
+
+		// Inverted diagonal blocks
+		std::vector<Block> inverseDiagonal;
+
+		// Particles that don't move, so their velocity change is held at zero
+		std::vector<unsigned char> fixed;
+
+		unsigned int maxIterations;
+		real tolerance;
+
+		unsigned int lastIterations;
+		real lastResidual;
+
+		// Pool to run the matrix products on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Works out the block structure from the network
+		void buildStructure(const SpringNetwork &Network, unsigned int ParticleCount);
+
+		// Fills in the matrix and right hand side for a step of dT
+		void assemble(const ParticleWorld &World, const SpringNetwork &Network, real dT);
+
+		// Out = matrix * In
+		void multiply(const real *In, real *Out);
+
+		// Out = preconditioner * In
+		void precondition(const real *In, real *Out) const;
+
+		// Runs preconditioned conjugate gradient on deltaV, starting from whatever's in it
+		void solve();
+
+	public:
+		// Default constructor, with up to 50 iterations to a relative residual of 1e-6
+		ImplicitSpringSolver();
+
+		// Getters
+		unsigned int GetMaxIterations() const;
+		real GetTolerance() const;
+
+		// How the last solve went
+		unsigned int GetLastIterations() const;
+		real GetLastResidual() const;
+
+		// Setters
+		// ^- Tolerance is relative to the size of the right hand side
+		void SetMaxIterations(unsigned int MaxIterations);
+		void SetTolerance(real Tolerance);
+
+		// Sets the pool to run the matrix products on, NULL (the default) runs everything serially
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Integrates every particle in the world forward by dT
+		// ^- Replaces both Network.ApplyForces and World.Step, apply any other forces beforehand as usual
+		// ^- Dead, infinite mass and sleeping particles don't move, and springs with a dead end do nothing
+		// ^- Puts particles to sleep and wakes them up the same way World.Step does
+		// ^- Asserts, and does nothing at all in release builds, if a spring ends past the end of the world
+		void Step(ParticleWorld &World, const SpringNetwork &Network, real dT);
+	};
+};
+
+#endif // HADRON_IMPLICITSPRINGSOLVER_HPP
@@ -64,6 +64,16 @@ namespace Hadron {
 		return position.z;
 	}
 
+	const Vector3<real> &Particle::GetAcceleration() const
+	{
+		return acceleration;
+	}
+
+	const Vector3<real> &Particle::GetForceAccumulator() const
+	{
+		return forceAccum;
+	}
+
 	real Particle::GetMass() const
 	{
 		// Infinite mass
@@ -73,6 +83,16 @@ namespace Hadron {
 		return (real)1.0 / inverseMass;
 	}
 
+	real Particle::GetInverseMass() const
+	{
+		return inverseMass;
+	}
+
+	real Particle::GetDamping() const
+	{
+		return damping;
+	}
+
 	bool Particle::IsAlive() const
 	{
 		return alive;
@@ -166,6 +186,11 @@ namespace Hadron {
 		}
 	}
 
+	void Particle::SetDamping(real Damping)
+	{
+		damping = Damping;
+	}
+
 	void Particle::SetAlive(bool Alive)
 	{
 		alive = Alive;
@@ -189,4 +214,9 @@ namespace Hadron {
 	{
 		forceAccum += Vector3<real>(X, Y, Z);
 	}
+
+	void Particle::ClearAccumulator()
+	{
+		forceAccum.Clear();
+	}
 };
\ No newline at end of file
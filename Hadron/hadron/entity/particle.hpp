@@ -31,9 +31,6 @@ namespace Hadron {
 		// ^- Uses Newton-Euler integration
 		void integrate(real dT);
 
-		// Simply clears the force accumulator
-		void clearAccumulator();
-
 	public:
 		// Default constructor
 		Particle();
@@ -47,8 +44,12 @@ namespace Hadron {
 		real GetZ() const;
 
 		const Vector3<real> &GetVelocity() const;
+		const Vector3<real> &GetAcceleration() const;
+		const Vector3<real> &GetForceAccumulator() const;
 
 		real GetMass() const;
+		real GetInverseMass() const;
+		real GetDamping() const;
 
 		bool IsAlive() const;
 
@@ -73,6 +74,7 @@ namespace Hadron {
 		void SetAccelerationZ(real Z);
 
 		void SetMass(real Mass);
+		void SetDamping(real Damping);
 
 		void SetAlive(bool Alive);
 
@@ -83,6 +85,9 @@ namespace Hadron {
 		// Applies a force vector to the particle
 		void ApplyForce(const Vector3<real> &Force);
 		void ApplyForce(real X, real Y, real Z);
+
+		// Simply clears the force accumulator
+		void ClearAccumulator();
 	};
 };
 
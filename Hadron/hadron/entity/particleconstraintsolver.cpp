@@ -0,0 +1,488 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "particleconstraintsolver.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	namespace {
+		// Colours with fewer constraints than this are projected on the calling thread, as handing them out to the
+		// pool costs more than it saves
+		const unsigned int MIN_PARALLEL_COLOUR = 256;
+	};
+
+	ParticleConstraintSolver::ParticleConstraintSolver():
+	particleSpan(0),
+	coloursDirty(false),
+	iterations(10),
+	substeps(1),
+	lastSubstep((real)0.0),
+	pool(NULL)
+	{
+		colourStart.push_back(0);
+	}
+
+	unsigned int ParticleConstraintSolver::add(Type Kind, unsigned int A, unsigned int B, real RestLength, real Compliance)
+	{
+		type.push_back((unsigned char)Kind);
+		particleA.push_back(A);
+		particleB.push_back(B);
+		restLength.push_back(RestLength);
+		compliance.push_back(Compliance);
+		anchorX.push_back((real)0.0);
+		anchorY.push_back((real)0.0);
+		anchorZ.push_back((real)0.0);
+		lambda.push_back((real)0.0);
+
+		const unsigned int constraint = (unsigned int)type.size() - 1;
+		particleSpan = std::max(particleSpan, getSpan(constraint));
+		coloursDirty = true;
+
+		return constraint;
+	}
+
+	unsigned int ParticleConstraintSolver::getSpan(unsigned int Constraint) const
+	{
+		const unsigned int a = particleA[Constraint], b = particleB[Constraint];
+
+		// A missing particle anywhere but an anchor's other end can't be in any world
+		if(a == NO_PARTICLE) return NO_PARTICLE;
+		if(type[Constraint] == (unsigned char)CONSTRAINT_ANCHOR) return a + 1;
+		if(b == NO_PARTICLE) return NO_PARTICLE;
+
+		return std::max(a, b) + 1;
+	}
+
+	void ParticleConstraintSolver::updateSpan()
+	{
+		particleSpan = 0;
+		for(unsigned int c = 0; c < type.size(); c++)
+		{
+			particleSpan = std::max(particleSpan, getSpan(c));
+		}
+	}
+
+	unsigned int ParticleConstraintSolver::AddDistance(unsigned int A, unsigned int B, real RestLength, real Compliance)
+	{
+		return add(CONSTRAINT_DISTANCE, A, B, RestLength, Compliance);
+	}
+
+	unsigned int ParticleConstraintSolver::AddRod(unsigned int A, unsigned int B, real Length)
+	{
+		return AddDistance(A, B, Length, (real)0.0);
+	}
+
+	unsigned int ParticleConstraintSolver::AddCable(unsigned int A, unsigned int B, real MaxLength, real Compliance)
+	{
+		return add(CONSTRAINT_CABLE, A, B, MaxLength, Compliance);
+	}
+
+	unsigned int ParticleConstraintSolver::AddAnchor(unsigned int A, const Vector3<real> &Point, real RestLength, real Compliance)
+	{
+		const unsigned int constraint = add(CONSTRAINT_ANCHOR, A, NO_PARTICLE, RestLength, Compliance);
+		SetAnchor(constraint, Point);
+
+		return constraint;
+	}
+
+	void ParticleConstraintSolver::Remove(unsigned int Constraint)
+	{
+		const unsigned int last = (unsigned int)type.size() - 1;
+
+		// Only worth looking through the rest if this was the one that set the span
+		const bool spanned = getSpan(Constraint) == particleSpan;
+
+		type[Constraint] = type[last];
+		particleA[Constraint] = particleA[last];
+		particleB[Constraint] = particleB[last];
+		restLength[Constraint] = restLength[last];
+		compliance[Constraint] = compliance[last];
+		anchorX[Constraint] = anchorX[last];
+		anchorY[Constraint] = anchorY[last];
+		anchorZ[Constraint] = anchorZ[last];
+		lambda[Constraint] = lambda[last];
+
+		type.pop_back();
+		particleA.pop_back();
+		particleB.pop_back();
+		restLength.pop_back();
+		compliance.pop_back();
+		anchorX.pop_back();
+		anchorY.pop_back();
+		anchorZ.pop_back();
+		lambda.pop_back();
+
+		if(spanned) updateSpan();
+		coloursDirty = true;
+	}
+
+	void ParticleConstraintSolver::Clear()
+	{
+		type.clear();
+		particleA.clear();
+		particleB.clear();
+		restLength.clear();
+		compliance.clear();
+		anchorX.clear();
+		anchorY.clear();
+		anchorZ.clear();
+		lambda.clear();
+
+		particleSpan = 0;
+		coloursDirty = true;
+	}
+
+	unsigned int ParticleConstraintSolver::GetCount() const
+	{
+		return (unsigned int)type.size();
+	}
+
+	ParticleConstraintSolver::Type ParticleConstraintSolver::GetType(unsigned int Constraint) const
+	{
+		return (Type)type[Constraint];
+	}
+
+	unsigned int ParticleConstraintSolver::GetParticleA(unsigned int Constraint) const
+	{
+		return particleA[Constraint];
+	}
+
+	unsigned int ParticleConstraintSolver::GetParticleB(unsigned int Constraint) const
+	{
+		return particleB[Constraint];
+	}
+
+	real ParticleConstraintSolver::GetRestLength(unsigned int Constraint) const
+	{
+		return restLength[Constraint];
+	}
+
+	real ParticleConstraintSolver::GetCompliance(unsigned int Constraint) const
+	{
+		return compliance[Constraint];
+	}
+
+	Vector3<real> ParticleConstraintSolver::GetAnchor(unsigned int Constraint) const
+	{
+		return Vector3<real>(anchorX[Constraint], anchorY[Constraint], anchorZ[Constraint]);
+	}
+
+	real ParticleConstraintSolver::GetForce(unsigned int Constraint) const
+	{
+		if(lastSubstep <= (real)0.0) return (real)0.0;
+		return lambda[Constraint] / (lastSubstep * lastSubstep);
+	}
+
+	unsigned int ParticleConstraintSolver::GetIterations() const
+	{
+		return iterations;
+	}
+
+	unsigned int ParticleConstraintSolver::GetSubsteps() const
+	{
+		return substeps;
+	}
+
+	unsigned int ParticleConstraintSolver::GetParticleSpan() const
+	{
+		return particleSpan;
+	}
+
+	unsigned int ParticleConstraintSolver::GetColourCount()
+	{
+		if(coloursDirty) buildColours();
+		return (unsigned int)colourStart.size() - 1;
+	}
+
+	void ParticleConstraintSolver::SetRestLength(unsigned int Constraint, real RestLength)
+	{
+		restLength[Constraint] = RestLength;
+	}
+
+	void ParticleConstraintSolver::SetCompliance(unsigned int Constraint, real Compliance)
+	{
+		compliance[Constraint] = Compliance;
+	}
+
+	void ParticleConstraintSolver::SetAnchor(unsigned int Constraint, const Vector3<real> &Point)
+	{
+		anchorX[Constraint] = Point.x;
+		anchorY[Constraint] = Point.y;
+		anchorZ[Constraint] = Point.z;
+	}
+
+	void ParticleConstraintSolver::SetIterations(unsigned int Iterations)
+	{
+		iterations = Iterations;
+	}
+
+	void ParticleConstraintSolver::SetSubsteps(unsigned int Substeps)
+	{
+		substeps = std::max(Substeps, 1u);
+	}
+
+	void ParticleConstraintSolver::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	void ParticleConstraintSolver::buildColours()
+	{
+		HADRON_PROFILE_SCOPE("constraint colouring");
+
+		const unsigned int count = (unsigned int)type.size();
+		const unsigned int particles = particleSpan;
+
+		// Each particle keeps a mask of the colours already touching it, 64 at a time
+		// ^- Another 64 are only added if some particle runs out, which takes something very well connected
+		std::vector<std::vector<unsigned long long> > used;
+		std::vector<unsigned int> colour(count);
+		unsigned int colours = 0;
+
+		for(unsigned int c = 0; c < count; c++)
+		{
+			const unsigned int a = particleA[c], b = particleB[c];
+
+			for(unsigned int block = 0; ; block++)
+			{
+				if(block == used.size()) used.push_back(std::vector<unsigned long long>(particles, 0));
+
+				const unsigned long long taken = used[block][a] | ((b != NO_PARTICLE) ? used[block][b] : 0);
+				if(taken == ~0ull) continue;
+
+				unsigned int bit = 0;
+				while(taken & (1ull << bit)) bit++;
+
+				used[block][a] |= 1ull << bit;
+				if(b != NO_PARTICLE) used[block][b] |= 1ull << bit;
+
+				colour[c] = (block * 64) + bit;
+				colours = std::max(colours, colour[c] + 1);
+				break;
+			}
+		}
+
+		// Counting sort by colour, keeping each colour in the order the constraints were added
+		colourStart.assign(colours + 1, 0);
+		for(unsigned int c = 0; c < count; c++)
+		{
+			colourStart[colour[c] + 1]++;
+		}
+
+		for(unsigned int k = 0; k < colours; k++)
+		{
+			colourStart[k + 1] += colourStart[k];
+		}
+
+		colourOrder.resize(count);
+		std::vector<unsigned int> next(colourStart.begin(), colourStart.end() - 1);
+		for(unsigned int c = 0; c < count; c++)
+		{
+			colourOrder[next[colour[c]]++] = c;
+		}
+
+		coloursDirty = false;
+	}
+
+	void ParticleConstraintSolver::project(ParticleWorld &World, unsigned int Begin, unsigned int End, real dTSquared)
+	{
+		real *posX = World.GetPositionsX(), *posY = World.GetPositionsY(), *posZ = World.GetPositionsZ();
+		const unsigned char *alive = World.GetAliveFlags();
+
+		for(unsigned int k = Begin; k < End; k++)
+		{
+			const unsigned int c = colourOrder[k];
+			const unsigned int a = particleA[c], b = particleB[c];
+			const bool anchored = type[c] == (unsigned char)CONSTRAINT_ANCHOR;
+
+			if(!alive[a] || (!anchored && !alive[b])) continue;
+
+			// The other end, an anchor's a particle that can't move
+			const real otherX = anchored ? anchorX[c] : posX[b];
+			const real otherY = anchored ? anchorY[c] : posY[b];
+			const real otherZ = anchored ? anchorZ[c] : posZ[b];
+			const real weightA = weight[a];
+			const real weightB = anchored ? (real)0.0 : weight[b];
+
+			const real dx = posX[a] - otherX, dy = posY[a] - otherY, dz = posZ[a] - otherZ;
+			const real length = (real)sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+			// Sat right on top of each other, there's no direction to push them apart in
+			if(length <= (real)0.0) continue;
+
+			const real error = length - restLength[c];
+
+			// A slack cable does nothing
+			if(type[c] == (unsigned char)CONSTRAINT_CABLE && error <= (real)0.0) continue;
+
+			const real alpha = compliance[c] / dTSquared;
+			const real denominator = weightA + weightB + alpha;
+			if(denominator <= (real)0.0) continue;
+
+			const real delta = (-error - (alpha * lambda[c])) / denominator;
+			lambda[c] += delta;
+
+			const real scale = delta / length;
+			posX[a] += dx * scale * weightA;
+			posY[a] += dy * scale * weightA;
+			posZ[a] += dz * scale * weightA;
+
+			if(!anchored)
+			{
+				posX[b] -= dx * scale * weightB;
+				posY[b] -= dy * scale * weightB;
+				posZ[b] -= dz * scale * weightB;
+			}
+		}
+	}
+
+	void ParticleConstraintSolver::wakeConnected(ParticleWorld &World) const
+	{
+		if(World.GetSleepSteps() == 0) return;
+
+		const real *velX = World.GetVelocitiesX();
+		const real *velY = World.GetVelocitiesY();
+		const real *velZ = World.GetVelocitiesZ();
+		const unsigned char *alive = World.GetAliveFlags();
+		const unsigned char *asleep = World.GetSleepFlags();
+		const real speedSq = World.GetSleepSpeed() * World.GetSleepSpeed();
+
+		// Serial, as a particle can be woken from several constraints at once
+		for(unsigned int c = 0; c < type.size(); c++)
+		{
+			const unsigned int a = particleA[c];
+			const unsigned int b = particleB[c];
+			if(b == NO_PARTICLE || asleep[a] == asleep[b] || !alive[a] || !alive[b]) continue;
+
+			const unsigned int awake = asleep[a] ? b : a;
+			const real speed = (velX[awake] * velX[awake]) + (velY[awake] * velY[awake]) + (velZ[awake] * velZ[awake]);
+			if(speed > speedSq) World.Get(asleep[a] ? a : b).Wake();
+		}
+	}
+
+	void ParticleConstraintSolver::RemapParticles(const unsigned int *NewIndex, unsigned int Count)
+	{
+		// Same as Step, a particle outside the world is a bug somewhere else and remapping it would only hide it
+		assert(particleSpan <= Count);
+		if(particleSpan > Count) return;
+
+		const unsigned int count = (unsigned int)type.size();
+		for(unsigned int c = 0; c < count; c++)
+		{
+			particleA[c] = NewIndex[particleA[c]];
+
+			// Anchors have no second particle
+			if(particleB[c] != NO_PARTICLE) particleB[c] = NewIndex[particleB[c]];
+		}
+
+		updateSpan();
+	}
+
+	void ParticleConstraintSolver::Step(ParticleWorld &World, real dT)
+	{
+		const unsigned int count = World.GetCount();
+		if(count == 0) return;
+
+		// Colouring, projecting and waking all index the world with the constraints' particles
+		assert(particleSpan <= count);
+		if(particleSpan > count) return;
+
+		HADRON_PROFILE_SCOPE("constraint solve");
+
+		if(coloursDirty) buildColours();
+
+		const real substep = dT / (real)substeps;
+		World.PrepareStep(substep);
+		wakeConnected(World);
+		World.UpdateSleep(0, count, dT);
+
+		real *posX = World.GetPositionsX(), *posY = World.GetPositionsY(), *posZ = World.GetPositionsZ();
+		real *velX = World.GetVelocitiesX(), *velY = World.GetVelocitiesY(), *velZ = World.GetVelocitiesZ();
+		const real *accX = World.GetAccelerationsX(), *accY = World.GetAccelerationsY(), *accZ = World.GetAccelerationsZ();
+		const real *forceX = World.GetForcesX(), *forceY = World.GetForcesY(), *forceZ = World.GetForcesZ();
+		const real *inverseMass = World.GetInverseMasses();
+		const real *damping = World.GetDampingFactors();
+		const unsigned char *alive = World.GetAliveFlags();
+		const unsigned char *asleep = World.GetSleepFlags();
+
+		// Anything heavier than this can't be told apart from infinite mass
+		const real maxMass = REAL_MAX;
+
+		previousX.resize(count);
+		previousY.resize(count);
+		previousZ.resize(count);
+		weight.resize(count);
+
+		for(unsigned int p = 0; p < count; p++)
+		{
+			const bool fixed = !alive[p] || asleep[p] || inverseMass[p] <= (real)0.0 || inverseMass[p] * maxMass <= (real)1.0;
+			weight[p] = fixed ? (real)0.0 : inverseMass[p];
+		}
+
+		const unsigned int colours = (unsigned int)colourStart.size() - 1;
+		const real substepSquared = substep * substep;
+
+		for(unsigned int s = 0; s < substeps; s++)
+		{
+			// Predict where everything would go unconstrained
+			ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+			{
+				for(unsigned int p = Begin; p < End; p++)
+				{
+					previousX[p] = posX[p];
+					previousY[p] = posY[p];
+					previousZ[p] = posZ[p];
+					if(weight[p] <= (real)0.0) continue;
+
+					velX[p] += (accX[p] + (forceX[p] * weight[p])) * substep;
+					velY[p] += (accY[p] + (forceY[p] * weight[p])) * substep;
+					velZ[p] += (accZ[p] + (forceZ[p] * weight[p])) * substep;
+
+					posX[p] += velX[p] * substep;
+					posY[p] += velY[p] * substep;
+					posZ[p] += velZ[p] * substep;
+				}
+			});
+
+			std::fill(lambda.begin(), lambda.end(), (real)0.0);
+
+			{
+				HADRON_PROFILE_SCOPE("constraint project");
+
+				for(unsigned int i = 0; i < iterations; i++)
+				{
+					for(unsigned int k = 0; k < colours; k++)
+					{
+						const unsigned int first = colourStart[k], last = colourStart[k + 1];
+						ThreadPool *const colourPool = (last - first >= MIN_PARALLEL_COLOUR) ? pool : NULL;
+
+						ParallelFor(colourPool, first, last, [&](unsigned int Begin, unsigned int End)
+						{
+							project(World, Begin, End, substepSquared);
+						});
+					}
+				}
+			}
+
+			// Velocity is however far the projection left everything from where it started
+			const real inverseSubstep = (real)1.0 / substep;
+			ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+			{
+				for(unsigned int p = Begin; p < End; p++)
+				{
+					if(weight[p] <= (real)0.0) continue;
+
+					velX[p] = (posX[p] - previousX[p]) * inverseSubstep * damping[p];
+					velY[p] = (posY[p] - previousY[p]) * inverseSubstep * damping[p];
+					velZ[p] = (posZ[p] - previousZ[p]) * inverseSubstep * damping[p];
+				}
+			});
+		}
+
+		HADRON_PROFILE_COUNT("constraints projected", (unsigned long long)type.size() * iterations * substeps);
+
+		lastSubstep = substep;
+		World.ClearForces();
+	}
+};
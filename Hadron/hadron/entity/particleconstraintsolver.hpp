@@ -0,0 +1,167 @@
+#ifndef HADRON_PARTICLECONSTRAINTSOLVER_HPP
+#define HADRON_PARTICLECONSTRAINTSOLVER_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "../math/vector3.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// Steps a ParticleWorld with extended position based dynamics (XPBD), keeping particles at set distances
+	// ^- Predicts every particle's position from its velocity and forces, projects the constraints on the
+	//    predicted positions a fixed number of times, then takes the velocities from how far everything moved
+	// ^- Stable however stiff the constraints are, at any step size, and costs the same every step - rods that
+	//    would need tiny steps as springs can be stepped at the frame rate
+	// ^- Compliance is the inverse of stiffness, so 0 is perfectly rigid, and unlike a plain PBD stiffness it
+	//    doesn't change with the step size or the iteration count
+	// ^- Constraints are coloured so that no two of a colour share a particle, then each colour is projected in
+	//    parallel, one after the other (Gauss-Seidel between colours, and within one as nothing's shared)
+	// ^- Colours are only worked out again when constraints are added or removed
+	// ^- Register it as a remap listener on the world if the world's ever reordered
+	class ParticleConstraintSolver : public ParticleRemapListener
+	{
+	public:
+		enum Type
+		{
+			// Holds two particles at a distance, pushing and pulling
+			CONSTRAINT_DISTANCE = 0,
+
+			// Stops two particles getting further apart than a distance, but lets them come together
+			CONSTRAINT_CABLE,
+
+			// Holds a particle at a distance from a fixed point, 0 pins it there
+			CONSTRAINT_ANCHOR
+		};
+
+		static const unsigned int NO_PARTICLE = 0xFFFFFFFF;
+
+	private:
+		// Per constraint
+		std::vector<unsigned char> type;
+		std::vector<unsigned int> particleA, particleB;
+		std::vector<real> restLength;
+		std::vector<real> compliance;
+
+		// Only used by anchors
+		std::vector<real> anchorX, anchorY, anchorZ;
+
+		// One more than the highest particle index any constraint uses
+		unsigned int particleSpan;
+
+		// Accumulated Lagrange multipliers, reset every substep
+		std::vector<real> lambda;
+
+		// Constraints in colour order, the ones of colour c are colourOrder[colourStart[c], colourStart[c + 1])
+		std::vector<unsigned int> colourStart;
+		std::vector<unsigned int> colourOrder;
+
+		// Set when constraints are added or removed
+		bool coloursDirty;
+
+		// Positions at the start of the substep, and inverse masses with anything that can't move at 0
+		std::vector<real> previousX, previousY, previousZ;
+		std::vector<real> weight;
+
+		unsigned int iterations;
+		unsigned int substeps;
+
+		// Length of the last substep, to turn multipliers back into forces
+		real lastSubstep;
+
+		// Pool to project on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Adds a constraint of any type, keeping the span up to date
+		unsigned int add(Type Kind, unsigned int A, unsigned int B, real RestLength, real Compliance);
+
+		// Fewest particles a world needs to hold a constraint's particles, NO_PARTICLE if none could
+		unsigned int getSpan(unsigned int Constraint) const;
+
+		// Works the span out again from every constraint
+		void updateSpan();
+
+		// Greedily colours the constraints, in the order they were added
+		void buildColours();
+
+		// Projects constraints [Begin, End) of the colour order once
+		void project(ParticleWorld &World, unsigned int Begin, unsigned int End, real dTSquared);
+
+		// Wakes sleeping particles constrained to ones moving faster than the world's sleep speed
+		void wakeConnected(ParticleWorld &World) const;
+
+	public:
+		// Default constructor, with 10 iterations and 1 substep
+		ParticleConstraintSolver();
+
+		// Adds a constraint, returning its index
+		// ^- A rod is a distance constraint with no compliance
+		// ^- Every particle must be in the world the solver steps, see GetParticleSpan
+		unsigned int AddDistance(unsigned int A, unsigned int B, real RestLength, real Compliance);
+		unsigned int AddRod(unsigned int A, unsigned int B, real Length);
+		unsigned int AddCable(unsigned int A, unsigned int B, real MaxLength, real Compliance);
+		unsigned int AddAnchor(unsigned int A, const Vector3<real> &Point, real RestLength, real Compliance);
+
+		// Removes a constraint, moving the last one into its place
+		void Remove(unsigned int Constraint);
+
+		// Removes all constraints
+		void Clear();
+
+		// Getters
+		unsigned int GetCount() const;
+		Type GetType(unsigned int Constraint) const;
+		unsigned int GetParticleA(unsigned int Constraint) const;
+		unsigned int GetParticleB(unsigned int Constraint) const;
+		real GetRestLength(unsigned int Constraint) const;
+		real GetCompliance(unsigned int Constraint) const;
+		Vector3<real> GetAnchor(unsigned int Constraint) const;
+
+		// Force the constraint applied over the last substep, along the line from B (or the anchor) to A
+		// ^- Negative when it's pulling A towards B
+		real GetForce(unsigned int Constraint) const;
+
+		unsigned int GetIterations() const;
+		unsigned int GetSubsteps() const;
+
+		// Fewest particles a world needs for every constraint's particles to be in it, 0 with no constraints
+		unsigned int GetParticleSpan() const;
+
+		// Number of colours the constraints need, working them out if they're out of date
+		unsigned int GetColourCount();
+
+		// Setters
+		void SetRestLength(unsigned int Constraint, real RestLength);
+		void SetCompliance(unsigned int Constraint, real Compliance);
+
+		// Moves an anchor, say to drag something about
+		void SetAnchor(unsigned int Constraint, const Vector3<real> &Point);
+
+		// Iterations per substep, and substeps per Step
+		// ^- Substeps cost about as much as iterations and converge much better, so a few substeps of one or
+		//    two iterations usually beat one substep of many
+		void SetIterations(unsigned int Iterations);
+		void SetSubsteps(unsigned int Substeps);
+
+		// Sets the pool to project on, NULL (the default) runs everything on the calling thread
+		// ^- Each colour's constraints touch different particles, so they're projected in parallel with no
+		//    locking, and the colours always run in the same order so results don't depend on the thread count
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Points the constraints at their particles' new indices after the world's been reordered
+		// ^- Which constraints share a particle doesn't change, so neither do the colours
+		// ^- Every constraint's particles have to be among the Count, otherwise it asserts, and remaps nothing at all
+		//    in release builds
+		void RemapParticles(const unsigned int *NewIndex, unsigned int Count);
+
+		// Integrates every particle in the world forward by dT, satisfying the constraints as it goes
+		// ^- Replaces World.Step, apply any forces beforehand as usual
+		// ^- Dead, infinite mass and sleeping particles don't move, and constraints on a dead particle do nothing
+		// ^- Asserts, and does nothing at all in release builds, if a constraint's particle is past the end of the world
+		// ^- Puts particles to sleep and wakes them up the same way World.Step does
+		void Step(ParticleWorld &World, real dT);
+	};
+};
+
+#endif // HADRON_PARTICLECONSTRAINTSOLVER_HPP
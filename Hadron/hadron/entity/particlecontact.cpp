@@ -0,0 +1,399 @@
+#include <math.h>
+#include "particlecontact.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	void GeneratePlaneContacts(const ParticleWorld &World, const Vector3<real> &Normal, real Offset, real Radius,
+		real Restitution, std::vector<ParticleContact> &Contacts)
+	{
+		const unsigned int count = World.GetCount();
+		const real *posX = World.GetPositionsX();
+		const real *posY = World.GetPositionsY();
+		const real *posZ = World.GetPositionsZ();
+		const unsigned char *alive = World.GetAliveFlags();
+		const unsigned char *asleep = World.GetSleepFlags();
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			if(!alive[i] || asleep[i]) continue;
+
+			const real distance = (posX[i] * Normal.x) + (posY[i] * Normal.y) + (posZ[i] * Normal.z) - Offset;
+			if(distance >= Radius) continue;
+
+			ParticleContact contact;
+			contact.particle[0] = i;
+			contact.particle[1] = ParticleContact::NO_PARTICLE;
+			contact.normal = Normal;
+			contact.penetration = Radius - distance;
+			contact.restitution = Restitution;
+			Contacts.push_back(contact);
+		}
+	}
+
+	void GenerateSphereContacts(const ParticleWorld &World, const std::vector<ParticleHashGrid::Pair> &Pairs, real Radius,
+		real Restitution, std::vector<ParticleContact> &Contacts)
+	{
+		const real *posX = World.GetPositionsX();
+		const real *posY = World.GetPositionsY();
+		const real *posZ = World.GetPositionsZ();
+		const unsigned char *alive = World.GetAliveFlags();
+		const unsigned char *asleep = World.GetSleepFlags();
+
+		const real diameter = Radius * (real)2.0;
+
+		for(unsigned int p = 0; p < Pairs.size(); p++)
+		{
+			const unsigned int a = Pairs[p].a;
+			const unsigned int b = Pairs[p].b;
+			if(!alive[a] || !alive[b] || (asleep[a] && asleep[b])) continue;
+
+			const real dx = posX[a] - posX[b];
+			const real dy = posY[a] - posY[b];
+			const real dz = posZ[a] - posZ[b];
+			const real distanceSq = (dx * dx) + (dy * dy) + (dz * dz);
+			if(distanceSq >= diameter * diameter) continue;
+
+			ParticleContact contact;
+			contact.particle[0] = a;
+			contact.particle[1] = b;
+			contact.restitution = Restitution;
+
+			// Exactly on top of each other, so there's no direction to go on - just pick one
+			if(distanceSq <= (real)0.0)
+			{
+				contact.normal = Vector3<real>::UP;
+				contact.penetration = diameter;
+			}
+			else
+			{
+				const real distance = (real)sqrt(distanceSq);
+				contact.normal = Vector3<real>(dx, dy, dz) * ((real)1.0 / distance);
+				contact.penetration = diameter - distance;
+			}
+
+			Contacts.push_back(contact);
+		}
+	}
+
+	ParticleContactResolver::ParticleContactResolver():
+	velocityIterations(4),
+	positionIterations(4),
+	pool(NULL)
+	{ }
+
+	ParticleContactResolver::ParticleContactResolver(unsigned int VelocityIterations, unsigned int PositionIterations):
+	velocityIterations(VelocityIterations),
+	positionIterations(PositionIterations),
+	pool(NULL)
+	{ }
+
+	unsigned int ParticleContactResolver::GetVelocityIterations() const
+	{
+		return velocityIterations;
+	}
+
+	unsigned int ParticleContactResolver::GetPositionIterations() const
+	{
+		return positionIterations;
+	}
+
+	unsigned int ParticleContactResolver::GetIslandCount() const
+	{
+		return islandStart.empty() ? 0 : (unsigned int)islandStart.size() - 1;
+	}
+
+	void ParticleContactResolver::SetIterations(unsigned int VelocityIterations, unsigned int PositionIterations)
+	{
+		velocityIterations = VelocityIterations;
+		positionIterations = PositionIterations;
+	}
+
+	void ParticleContactResolver::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	unsigned int ParticleContactResolver::findRoot(unsigned int Particle)
+	{
+		while(parent[Particle] != Particle)
+		{
+			parent[Particle] = parent[parent[Particle]];
+			Particle = parent[Particle];
+		}
+
+		return Particle;
+	}
+
+	void ParticleContactResolver::buildIslands(const std::vector<ParticleContact> &Contacts, unsigned int ParticleCount)
+	{
+		const unsigned int count = (unsigned int)Contacts.size();
+
+		// Only the particles in contacts get touched, so there's nothing to clear between frames
+		if(parent.size() < ParticleCount)
+		{
+			parent.resize(ParticleCount);
+			island.resize(ParticleCount);
+			moveX.resize(ParticleCount);
+			moveY.resize(ParticleCount);
+			moveZ.resize(ParticleCount);
+		}
+
+		for(unsigned int c = 0; c < count; c++)
+		{
+			for(unsigned int k = 0; k < 2; k++)
+			{
+				const unsigned int p = Contacts[c].particle[k];
+				if(p == ParticleContact::NO_PARTICLE) continue;
+
+				parent[p] = p;
+				island[p] = NO_ISLAND;
+				moveX[p] = moveY[p] = moveZ[p] = (real)0.0;
+			}
+		}
+
+		// Join up both ends of every contact, static geometry doesn't link anything
+		for(unsigned int c = 0; c < count; c++)
+		{
+			const unsigned int b = Contacts[c].particle[1];
+			if(b == ParticleContact::NO_PARTICLE) continue;
+
+			const unsigned int rootA = findRoot(Contacts[c].particle[0]);
+			const unsigned int rootB = findRoot(b);
+
+			// Lower index wins, so the islands come out the same every time
+			if(rootA < rootB) parent[rootB] = rootA;
+			else if(rootB < rootA) parent[rootA] = rootB;
+		}
+
+		// Number the islands in the order they first show up, and count their contacts
+		islandStart.clear();
+		islandStart.push_back(0);
+
+		for(unsigned int c = 0; c < count; c++)
+		{
+			const unsigned int root = findRoot(Contacts[c].particle[0]);
+			if(island[root] == NO_ISLAND)
+			{
+				island[root] = (unsigned int)islandStart.size() - 1;
+				islandStart.push_back(0);
+			}
+
+			islandStart[island[root] + 1]++;
+		}
+
+		const unsigned int islands = (unsigned int)islandStart.size() - 1;
+		for(unsigned int i = 0; i < islands; i++)
+		{
+			islandStart[i + 1] += islandStart[i];
+		}
+
+		// Counting sort the contacts by island, keeping their order within each one
+		order.resize(count);
+		std::vector<unsigned int> next(islandStart.begin(), islandStart.end() - 1);
+		for(unsigned int c = 0; c < count; c++)
+		{
+			order[next[island[findRoot(Contacts[c].particle[0])]]++] = c;
+		}
+	}
+
+	void ParticleContactResolver::Resolve(ParticleWorld &World, const std::vector<ParticleContact> &Contacts, real dT)
+	{
+		if(Contacts.empty())
+		{
+			islandStart.clear();
+			return;
+		}
+
+		HADRON_PROFILE_SCOPE("contact resolve");
+		HADRON_PROFILE_COUNT("contacts", Contacts.size());
+
+		buildIslands(Contacts, World.GetCount());
+
+		ParallelFor(pool, 0, GetIslandCount(), [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				resolveIsland(World, Contacts, islandStart[i], islandStart[i + 1], dT);
+			}
+		});
+	}
+
+	void ParticleContactResolver::resolveIsland(ParticleWorld &World, const std::vector<ParticleContact> &Contacts,
+		unsigned int First, unsigned int Last, real dT)
+	{
+		real *posX = World.GetPositionsX();
+		real *posY = World.GetPositionsY();
+		real *posZ = World.GetPositionsZ();
+		real *velX = World.GetVelocitiesX();
+		real *velY = World.GetVelocitiesY();
+		real *velZ = World.GetVelocitiesZ();
+		const real *accX = World.GetAccelerationsX();
+		const real *accY = World.GetAccelerationsY();
+		const real *accZ = World.GetAccelerationsZ();
+		const real *inverseMass = World.GetInverseMasses();
+		const unsigned char *alive = World.GetAliveFlags();
+		const unsigned char *asleep = World.GetSleepFlags();
+
+		// Sleeping particles are held still, like static geometry, unless they've been hit hard enough to wake up
+		// ^- Otherwise anything resting on a sleeping particle would nudge it awake again every step
+		// ^- Only the speed the awake particle's closing at beyond what its acceleration built up over the last step
+		//    counts, for the same reason as below
+		if(World.GetSleepSteps() > 0)
+		{
+			const real wakeSpeed = World.GetSleepSpeed();
+
+			for(unsigned int o = First; o < Last; o++)
+			{
+				const ParticleContact &contact = Contacts[order[o]];
+				const unsigned int a = contact.particle[0];
+				const unsigned int b = contact.particle[1];
+
+				if(b == ParticleContact::NO_PARTICLE || asleep[a] == asleep[b]) continue;
+				if(!alive[a] || !alive[b]) continue;
+
+				// The normal points at a, so a closes against it and b along it
+				const unsigned int awake = asleep[a] ? b : a;
+				const real direction = (awake == a) ? (real)-1.0 : (real)1.0;
+				const Vector3<real> &n = contact.normal;
+
+				const real closing = direction * ((velX[awake] * n.x) + (velY[awake] * n.y) + (velZ[awake] * n.z));
+				real builtUp = direction * ((accX[awake] * n.x) + (accY[awake] * n.y) + (accZ[awake] * n.z)) * dT;
+				if(builtUp < (real)0.0) builtUp = (real)0.0;
+
+				if(closing - builtUp > wakeSpeed) World.Get(asleep[a] ? a : b).Wake();
+			}
+		}
+
+		// Velocity passes
+		for(unsigned int iteration = 0; iteration < velocityIterations; iteration++)
+		{
+			bool resolved = false;
+
+			for(unsigned int o = First; o < Last; o++)
+			{
+				const ParticleContact &contact = Contacts[order[o]];
+				const unsigned int a = contact.particle[0];
+				const unsigned int b = contact.particle[1];
+				const bool hasB = (b != ParticleContact::NO_PARTICLE);
+
+				if(!alive[a] || (hasB && !alive[b])) continue;
+
+				const real inverseMassA = asleep[a] ? (real)0.0 : inverseMass[a];
+				const real inverseMassB = (hasB && !asleep[b]) ? inverseMass[b] : (real)0.0;
+				const real totalInverseMass = inverseMassA + inverseMassB;
+				if(totalInverseMass <= (real)0.0) continue;
+
+				const Vector3<real> &n = contact.normal;
+
+				// Speed they're moving apart at
+				real relativeX = velX[a], relativeY = velY[a], relativeZ = velZ[a];
+				if(hasB)
+				{
+					relativeX -= velX[b];
+					relativeY -= velY[b];
+					relativeZ -= velZ[b];
+				}
+
+				const real separating = (relativeX * n.x) + (relativeY * n.y) + (relativeZ * n.z);
+				if(separating >= (real)0.0) continue;
+
+				real newSeparating = -separating * contact.restitution;
+
+				// Don't bounce back the speed that built up from acceleration over the last step alone
+				// ^- Otherwise resting contacts jitter
+				real accelerationX = accX[a], accelerationY = accY[a], accelerationZ = accZ[a];
+				if(hasB)
+				{
+					accelerationX -= accX[b];
+					accelerationY -= accY[b];
+					accelerationZ -= accZ[b];
+				}
+
+				const real accelerationSeparating = ((accelerationX * n.x) + (accelerationY * n.y) + (accelerationZ * n.z)) * dT;
+				if(accelerationSeparating < (real)0.0)
+				{
+					newSeparating += contact.restitution * accelerationSeparating;
+					if(newSeparating < (real)0.0) newSeparating = (real)0.0;
+				}
+
+				const real impulse = (newSeparating - separating) / totalInverseMass;
+
+				velX[a] += n.x * impulse * inverseMassA;
+				velY[a] += n.y * impulse * inverseMassA;
+				velZ[a] += n.z * impulse * inverseMassA;
+
+				if(hasB)
+				{
+					velX[b] -= n.x * impulse * inverseMassB;
+					velY[b] -= n.y * impulse * inverseMassB;
+					velZ[b] -= n.z * impulse * inverseMassB;
+				}
+
+				resolved = true;
+			}
+
+			// Everything's separating already
+			if(!resolved) break;
+		}
+
+		// Position passes
+		// ^- Each contact's penetration goes down by however far its particles have already been moved along its normal
+		for(unsigned int iteration = 0; iteration < positionIterations; iteration++)
+		{
+			bool resolved = false;
+
+			for(unsigned int o = First; o < Last; o++)
+			{
+				const ParticleContact &contact = Contacts[order[o]];
+				const unsigned int a = contact.particle[0];
+				const unsigned int b = contact.particle[1];
+				const bool hasB = (b != ParticleContact::NO_PARTICLE);
+
+				if(!alive[a] || (hasB && !alive[b])) continue;
+
+				const real inverseMassA = asleep[a] ? (real)0.0 : inverseMass[a];
+				const real inverseMassB = (hasB && !asleep[b]) ? inverseMass[b] : (real)0.0;
+				const real totalInverseMass = inverseMassA + inverseMassB;
+				if(totalInverseMass <= (real)0.0) continue;
+
+				const Vector3<real> &n = contact.normal;
+
+				real movedX = moveX[a], movedY = moveY[a], movedZ = moveZ[a];
+				if(hasB)
+				{
+					movedX -= moveX[b];
+					movedY -= moveY[b];
+					movedZ -= moveZ[b];
+				}
+
+				const real penetration = contact.penetration - ((movedX * n.x) + (movedY * n.y) + (movedZ * n.z));
+				if(penetration <= (real)0.0) continue;
+
+				// Heavier particles move less
+				const real scale = penetration / totalInverseMass;
+
+				const real shiftAX = n.x * scale * inverseMassA;
+				const real shiftAY = n.y * scale * inverseMassA;
+				const real shiftAZ = n.z * scale * inverseMassA;
+				posX[a] += shiftAX; moveX[a] += shiftAX;
+				posY[a] += shiftAY; moveY[a] += shiftAY;
+				posZ[a] += shiftAZ; moveZ[a] += shiftAZ;
+
+				if(hasB)
+				{
+					const real shiftBX = n.x * scale * inverseMassB;
+					const real shiftBY = n.y * scale * inverseMassB;
+					const real shiftBZ = n.z * scale * inverseMassB;
+					posX[b] -= shiftBX; moveX[b] -= shiftBX;
+					posY[b] -= shiftBY; moveY[b] -= shiftBY;
+					posZ[b] -= shiftBZ; moveZ[b] -= shiftBZ;
+				}
+
+				resolved = true;
+			}
+
+			if(!resolved) break;
+		}
+	}
+};
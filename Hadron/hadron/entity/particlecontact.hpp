@@ -0,0 +1,107 @@
+#ifndef HADRON_PARTICLECONTACT_HPP
+#define HADRON_PARTICLECONTACT_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "../math/vector3.hpp"
+#include "particlehashgrid.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// Two particles in a ParticleWorld touching, or one particle touching static geometry
+	struct ParticleContact
+	{
+		// The particles involved, by index in the world
+		// ^- The second is NO_PARTICLE for contacts with static geometry, the first must always be a particle
+		unsigned int particle[2];
+
+		// Direction the first particle is pushed in, unit length
+		Vector3<real> normal;
+
+		// How far the two are overlapping along the normal
+		real penetration;
+
+		// Fraction of the closing speed they separate with, 0 is a dead stop and 1 is perfectly bouncy
+		real restitution;
+
+		static const unsigned int NO_PARTICLE = 0xFFFFFFFF;
+	};
+
+	// Adds a contact for every live particle whose sphere of the given radius crosses the plane
+	// ^- The plane is every point p with p . Normal = Offset, and particles are kept on the side Normal points to
+	// ^- Sleeping particles are skipped, the resolver wouldn't move them anyway
+	void GeneratePlaneContacts(const ParticleWorld &World, const Vector3<real> &Normal, real Offset, real Radius,
+		real Restitution, std::vector<ParticleContact> &Contacts);
+
+	// Adds a contact for every broadphase pair whose spheres of the given radius overlap
+	// ^- Pairs with a dead particle, or with both particles asleep, are skipped
+	void GenerateSphereContacts(const ParticleWorld &World, const std::vector<ParticleHashGrid::Pair> &Pairs, real Radius,
+		real Restitution, std::vector<ParticleContact> &Contacts);
+
+	// Resolves a whole frame's worth of contacts in a ParticleWorld
+	// ^- Sweeps over every contact in turn rather than hunting for the worst one each time, so the cost is at most
+	//    the iteration counts times the number of contacts
+	// ^- Velocities are resolved first, then the remaining interpenetration is pushed apart
+	// ^- Contacts are split into islands that share no particles, and with a thread pool the islands are resolved
+	//    in parallel, each on one thread, so results don't depend on the thread count
+	// ^- Sleeping particles don't move, unless a particle hits them faster than the world's sleep speed, which
+	//    wakes them up
+	class ParticleContactResolver
+	{
+	private:
+		unsigned int velocityIterations;
+		unsigned int positionIterations;
+
+		// Pool to run islands on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Per particle, only valid for particles that are in a contact this frame
+		// ^- Union-find parent, island number, and how far it's been moved by the position passes
+		std::vector<unsigned int> parent;
+		std::vector<unsigned int> island;
+		std::vector<real> moveX, moveY, moveZ;
+
+		// Contact indices grouped by island, island i is order[islandStart[i], islandStart[i + 1])
+		std::vector<unsigned int> order;
+		std::vector<unsigned int> islandStart;
+
+		static const unsigned int NO_ISLAND = 0xFFFFFFFF;
+
+		// Finds the root of a particle's island, halving the path as it goes
+		unsigned int findRoot(unsigned int Particle);
+
+		// Groups the contacts into islands
+		void buildIslands(const std::vector<ParticleContact> &Contacts, unsigned int ParticleCount);
+
+		// Resolves the contacts order[First, Last), which must share no particles with any other island
+		void resolveIsland(ParticleWorld &World, const std::vector<ParticleContact> &Contacts,
+			unsigned int First, unsigned int Last, real dT);
+
+	public:
+		// Default constructor, with 4 velocity and 4 position iterations
+		ParticleContactResolver();
+
+		// Constructs a resolver with the given iteration budget
+		// ^- Each iteration is one sweep over every contact
+		ParticleContactResolver(unsigned int VelocityIterations, unsigned int PositionIterations);
+
+		// Getters
+		unsigned int GetVelocityIterations() const;
+		unsigned int GetPositionIterations() const;
+		unsigned int GetIslandCount() const;
+
+		// Setters
+		void SetIterations(unsigned int VelocityIterations, unsigned int PositionIterations);
+
+		// Sets the pool to resolve islands on, NULL (the default) runs everything on the calling thread
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Resolves the contacts, changing the velocities and positions of the particles in them
+		// ^- dT is the step the contacts were found after, used to stop resting contacts jittering
+		void Resolve(ParticleWorld &World, const std::vector<ParticleContact> &Contacts, real dT);
+	};
+};
+
+#endif // HADRON_PARTICLECONTACT_HPP
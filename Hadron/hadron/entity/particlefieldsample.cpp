@@ -0,0 +1,143 @@
+#include "../core/cpu.hpp"
+#include "particlefieldsample.hpp"
+#include "particlefieldsamplekernel.hpp"
+#include "../math/packet_sse2.hpp"
+
+namespace Hadron {
+	namespace {
+		template<typename T>
+		void sampleScalar(const ParticleFieldGrid<T> &G, const T *X, const T *Y, const T *Z, unsigned int Count, T *OutX,
+			T *OutY, T *OutZ)
+		{
+			const T maxX = (T)(G.sizeX - 1), maxY = (T)(G.sizeY - 1), maxZ = (T)(G.sizeZ - 1);
+			const size_t strideY = (size_t)G.sizeX * 3;
+			const size_t strideZ = (size_t)G.sizeX * G.sizeY * 3;
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				const T fx = (X[i] - G.originX) * G.inverseSpacing;
+				const T fy = (Y[i] - G.originY) * G.inverseSpacing;
+				const T fz = (Z[i] - G.originZ) * G.inverseSpacing;
+
+				// Written so NaNs land outside too
+				if(!(fx >= (T)0.0 && fx <= maxX && fy >= (T)0.0 && fy <= maxY && fz >= (T)0.0 && fz <= maxZ))
+				{
+					OutX[i] = OutY[i] = OutZ[i] = (T)0.0;
+					continue;
+				}
+
+				// Points on the far faces use the last cell, at a weight of 1
+				const unsigned int cellX = ((unsigned int)fx < G.sizeX - 2) ? (unsigned int)fx : G.sizeX - 2;
+				const unsigned int cellY = ((unsigned int)fy < G.sizeY - 2) ? (unsigned int)fy : G.sizeY - 2;
+				const unsigned int cellZ = ((unsigned int)fz < G.sizeZ - 2) ? (unsigned int)fz : G.sizeZ - 2;
+
+				const T tx = fx - (T)cellX;
+				const T ty = fy - (T)cellY;
+				const T tz = fz - (T)cellZ;
+
+				// The cell's eight corners, the pairs along x sit next to each other
+				const T *c000 = G.values + (cellX * 3) + (cellY * strideY) + (cellZ * strideZ);
+				const T *c010 = c000 + strideY;
+				const T *c001 = c000 + strideZ;
+				const T *c011 = c001 + strideY;
+
+				// Worked out into locals before anything's written, as the outputs could alias the grid as far as the
+				// compiler knows
+				T result[3];
+				for(unsigned int c = 0; c < 3; c++)
+				{
+					const T x00 = c000[c] + ((c000[c + 3] - c000[c]) * tx);
+					const T x10 = c010[c] + ((c010[c + 3] - c010[c]) * tx);
+					const T x01 = c001[c] + ((c001[c + 3] - c001[c]) * tx);
+					const T x11 = c011[c] + ((c011[c + 3] - c011[c]) * tx);
+
+					const T y0 = x00 + ((x10 - x00) * ty);
+					const T y1 = x01 + ((x11 - x01) * ty);
+
+					result[c] = y0 + ((y1 - y0) * tz);
+				}
+
+				OutX[i] = result[0];
+				OutY[i] = result[1];
+				OutZ[i] = result[2];
+			}
+		}
+
+		template<typename T>
+		void sampleDispatch(const ParticleFieldGrid<T> &G, const T *X, const T *Y, const T *Z, unsigned int Count, T *OutX,
+			T *OutY, T *OutZ)
+		{
+			// The packet kernels gather with 32 bit offsets
+			if((unsigned long long)G.sizeX * G.sizeY * G.sizeZ * 3 > 0x7FFFFFFFull)
+			{
+				SampleParticleFieldScalar(G, X, Y, Z, Count, OutX, OutY, OutZ);
+				return;
+			}
+
+			switch(GetSimdLevel())
+			{
+			case(SIMD_AVX2):
+				SampleParticleFieldAVX2(G, X, Y, Z, Count, OutX, OutY, OutZ);
+				break;
+
+			case(SIMD_SSE2):
+				SampleParticleFieldSSE2(G, X, Y, Z, Count, OutX, OutY, OutZ);
+				break;
+
+			default:
+				SampleParticleFieldScalar(G, X, Y, Z, Count, OutX, OutY, OutZ);
+			}
+		}
+	}
+
+	void SampleParticleField(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ)
+	{
+		sampleDispatch(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void SampleParticleField(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ)
+	{
+		sampleDispatch(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void SampleParticleFieldScalar(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ)
+	{
+		sampleScalar(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void SampleParticleFieldScalar(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ)
+	{
+		sampleScalar(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+#if defined(HADRON_ARCH_X86)
+	void SampleParticleFieldSSE2(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ)
+	{
+		SampleParticleFieldPackets<PacketSSE2f>(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void SampleParticleFieldSSE2(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ)
+	{
+		SampleParticleFieldPackets<PacketSSE2d>(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+#else
+	// No SSE2 here, GetSimdLevel never picks it but keep the symbols around anyway
+	void SampleParticleFieldSSE2(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ)
+	{
+		sampleScalar(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void SampleParticleFieldSSE2(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ)
+	{
+		sampleScalar(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+#endif
+};
@@ -0,0 +1,43 @@
+#ifndef HADRON_PARTICLEFIELDSAMPLE_HPP
+#define HADRON_PARTICLEFIELDSAMPLE_HPP
+
+#include "../core/precision.hpp"
+
+namespace Hadron {
+	// Everything the batched force field samplers need, as raw pointers
+	// ^- Three values per node, x fastest then y then z, the way ParticleForceField keeps them
+	// ^- Sizes are at least 2 along each axis
+	template<typename T>
+	struct ParticleFieldGrid
+	{
+		const T *values;
+		T originX, originY, originZ;
+		T inverseSpacing;
+		unsigned int sizeX, sizeY, sizeZ;
+	};
+
+	// Trilinearly interpolates the grid at Count points into OutX, OutY and OutZ, zero outside the grid
+	// ^- Dispatches to the widest kernel GetSimdLevel allows, which all give exactly the same answer
+	void SampleParticleField(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ);
+	void SampleParticleField(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ);
+
+	// The individual kernels
+	// ^- Only call the SSE2 and AVX2 ones directly if you've checked GetSupportedSimdLevel yourself
+	// ^- The packet kernels index the grid with 32 bit ints, so grids of more than 2^31 values need the scalar one
+	void SampleParticleFieldScalar(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ);
+	void SampleParticleFieldScalar(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ);
+	void SampleParticleFieldSSE2(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ);
+	void SampleParticleFieldSSE2(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ);
+	void SampleParticleFieldAVX2(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ);
+	void SampleParticleFieldAVX2(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ);
+};
+
+#endif // HADRON_PARTICLEFIELDSAMPLE_HPP
@@ -0,0 +1,46 @@
+// Everything in this file is built for AVX2, and is only ever called once cpu.hpp says the CPU can run it
+// ^- Same rules as particleintegrate_avx2.cpp, keep includes to the bare minimum and leave FMA off so the
+//    samples come out exactly like the SSE2 and scalar ones
+#if defined(__clang__)
+	#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC target("avx2")
+#endif
+
+#include "../core/cpu.hpp"
+#include "particlefieldsample.hpp"
+#include "particlefieldsamplekernel.hpp"
+#include "../math/packet_avx2.hpp"
+
+namespace Hadron {
+#if defined(HADRON_ARCH_X86)
+	void SampleParticleFieldAVX2(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ)
+	{
+		SampleParticleFieldPackets<PacketAVX2f>(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void SampleParticleFieldAVX2(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ)
+	{
+		SampleParticleFieldPackets<PacketAVX2d>(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+#else
+	// No AVX2 here, GetSimdLevel never picks it but keep the symbols around anyway
+	void SampleParticleFieldAVX2(const ParticleFieldGrid<float> &Grid, const float *X, const float *Y, const float *Z,
+		unsigned int Count, float *OutX, float *OutY, float *OutZ)
+	{
+		SampleParticleFieldScalar(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void SampleParticleFieldAVX2(const ParticleFieldGrid<double> &Grid, const double *X, const double *Y, const double *Z,
+		unsigned int Count, double *OutX, double *OutY, double *OutZ)
+	{
+		SampleParticleFieldScalar(Grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+#endif
+};
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+#endif
@@ -0,0 +1,99 @@
+#ifndef HADRON_PARTICLEFIELDSAMPLEKERNEL_HPP
+#define HADRON_PARTICLEFIELDSAMPLEKERNEL_HPP
+
+// The packet kernel shared by the SSE2 and AVX2 builds
+// ^- Only meant to be included by the kernel translation units themselves
+
+#include "particlefieldsample.hpp"
+#include "../math/vector3packet.hpp"
+
+namespace Hadron {
+	// Samples Count points a packet at a time, handing any leftover points to the scalar kernel
+	// ^- Points are first worked out a run at a time into where their cell starts in the grid and how far across it
+	//    they are, then each packet gathers its eight corners and blends them
+	// ^- Points outside the grid gather from the first cell and are masked to zero afterwards
+	template<typename P>
+	void SampleParticleFieldPackets(const ParticleFieldGrid<typename P::Scalar> &G, const typename P::Scalar *X,
+		const typename P::Scalar *Y, const typename P::Scalar *Z, unsigned int Count, typename P::Scalar *OutX,
+		typename P::Scalar *OutY, typename P::Scalar *OutZ)
+	{
+		typedef typename P::Scalar T;
+		typedef Vector3Packet<P> V;
+
+		// A whole number of packets, small enough for the scratch to stay on the stack
+		const unsigned int RUN = 64;
+		int offsets[RUN];
+		T weightX[RUN], weightY[RUN], weightZ[RUN];
+		unsigned char inside[RUN];
+
+		const T maxX = (T)(G.sizeX - 1), maxY = (T)(G.sizeY - 1), maxZ = (T)(G.sizeZ - 1);
+		const int strideY = (int)G.sizeX * 3;
+		const int strideZ = (int)(G.sizeX * G.sizeY) * 3;
+
+		// Where each of the other corners sits relative to the cell's first one
+		const T *c000 = G.values, *c100 = G.values + 3;
+		const T *c010 = c000 + strideY, *c110 = c100 + strideY;
+		const T *c001 = c000 + strideZ, *c101 = c100 + strideZ;
+		const T *c011 = c010 + strideZ, *c111 = c110 + strideZ;
+
+		const unsigned int packed = Count - (Count % P::WIDTH);
+		for(unsigned int first = 0; first < packed; first += RUN)
+		{
+			const unsigned int run = (packed - first < RUN) ? packed - first : RUN;
+
+			// Same sums as the scalar kernel, so both blend with the same weights
+			for(unsigned int j = 0; j < run; j++)
+			{
+				const T fx = (X[first + j] - G.originX) * G.inverseSpacing;
+				const T fy = (Y[first + j] - G.originY) * G.inverseSpacing;
+				const T fz = (Z[first + j] - G.originZ) * G.inverseSpacing;
+
+				inside[j] = (fx >= (T)0.0 && fx <= maxX && fy >= (T)0.0 && fy <= maxY && fz >= (T)0.0 && fz <= maxZ);
+				if(!inside[j])
+				{
+					offsets[j] = 0;
+					weightX[j] = weightY[j] = weightZ[j] = (T)0.0;
+					continue;
+				}
+
+				const unsigned int cellX = ((unsigned int)fx < G.sizeX - 2) ? (unsigned int)fx : G.sizeX - 2;
+				const unsigned int cellY = ((unsigned int)fy < G.sizeY - 2) ? (unsigned int)fy : G.sizeY - 2;
+				const unsigned int cellZ = ((unsigned int)fz < G.sizeZ - 2) ? (unsigned int)fz : G.sizeZ - 2;
+
+				weightX[j] = fx - (T)cellX;
+				weightY[j] = fy - (T)cellY;
+				weightZ[j] = fz - (T)cellZ;
+				offsets[j] = ((int)cellX * 3) + ((int)cellY * strideY) + ((int)cellZ * strideZ);
+			}
+
+			for(unsigned int j = 0; j < run; j += P::WIDTH)
+			{
+				const int *o = offsets + j;
+				const P tx = P::Load(weightX + j), ty = P::Load(weightY + j), tz = P::Load(weightZ + j);
+
+				const V v000 = V::Gather(c000, o);
+				const V x00 = v000 + ((V::Gather(c100, o) - v000) * tx);
+				const V v010 = V::Gather(c010, o);
+				const V x10 = v010 + ((V::Gather(c110, o) - v010) * tx);
+				const V v001 = V::Gather(c001, o);
+				const V x01 = v001 + ((V::Gather(c101, o) - v001) * tx);
+				const V v011 = V::Gather(c011, o);
+				const V x11 = v011 + ((V::Gather(c111, o) - v011) * tx);
+
+				const V y0 = x00 + ((x10 - x00) * ty);
+				const V y1 = x01 + ((x11 - x01) * ty);
+
+				V::Select(P::LoadFlags(inside + j), y0 + ((y1 - y0) * tz), V()).Store(OutX + first + j, OutY + first + j,
+					OutZ + first + j);
+			}
+		}
+
+		if(packed < Count)
+		{
+			SampleParticleFieldScalar(G, X + packed, Y + packed, Z + packed, Count - packed, OutX + packed, OutY + packed,
+				OutZ + packed);
+		}
+	}
+};
+
+#endif // HADRON_PARTICLEFIELDSAMPLEKERNEL_HPP
@@ -0,0 +1,290 @@
+#include <math.h>
+#include "particlefluid.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	namespace {
+		const real PI = (real)3.14159265358979323846;
+	};
+
+	ParticleFluid::ParticleFluid():
+	restDensity((real)1000.0),
+	stiffness((real)400.0),
+	viscosity((real)20.0),
+	particleMass((real)0.125),
+	pool(NULL)
+	{
+		SetRadius((real)0.1);
+	}
+
+	real ParticleFluid::GetRadius() const
+	{
+		return radius;
+	}
+
+	real ParticleFluid::GetRestDensity() const
+	{
+		return restDensity;
+	}
+
+	real ParticleFluid::GetStiffness() const
+	{
+		return stiffness;
+	}
+
+	real ParticleFluid::GetViscosity() const
+	{
+		return viscosity;
+	}
+
+	real ParticleFluid::GetParticleMass() const
+	{
+		return particleMass;
+	}
+
+	unsigned int ParticleFluid::GetNeighbourCount() const
+	{
+		return (unsigned int)neighbours.size();
+	}
+
+	real ParticleFluid::GetDensity(unsigned int Index) const
+	{
+		if(Index >= rank.size() || rank[Index] == NOT_IN_FLUID) return (real)0.0;
+		return density[rank[Index]];
+	}
+
+	real ParticleFluid::GetPressure(unsigned int Index) const
+	{
+		if(Index >= rank.size() || rank[Index] == NOT_IN_FLUID) return (real)0.0;
+		return pressure[rank[Index]];
+	}
+
+	void ParticleFluid::SetRadius(real Radius)
+	{
+		radius = Radius;
+
+		const real h3 = radius * radius * radius;
+		poly6 = (real)315.0 / ((real)64.0 * PI * h3 * h3 * h3);
+		spikyGradient = (real)45.0 / (PI * h3 * h3);
+		viscosityLaplacian = (real)45.0 / (PI * h3 * h3);
+
+		grid.SetCellSize(radius);
+	}
+
+	void ParticleFluid::SetRestDensity(real RestDensity)
+	{
+		restDensity = RestDensity;
+	}
+
+	void ParticleFluid::SetStiffness(real Stiffness)
+	{
+		stiffness = Stiffness;
+	}
+
+	void ParticleFluid::SetViscosity(real Viscosity)
+	{
+		viscosity = Viscosity;
+	}
+
+	void ParticleFluid::SetParticleMass(real ParticleMass)
+	{
+		particleMass = ParticleMass;
+	}
+
+	void ParticleFluid::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+		grid.SetThreadPool(Pool);
+	}
+
+	void ParticleFluid::evaluate(const real *X, const real *Y, const real *Z, const real *VX, const real *VY, const real *VZ,
+		const unsigned char *Alive, unsigned int Count)
+	{
+		grid.Build(X, Y, Z, Alive, Count);
+		grid.GetOrder(order);
+
+		const unsigned int count = (unsigned int)order.size();
+		rank.assign(Count, (unsigned int)NOT_IN_FLUID);
+		posX.resize(count);
+		posY.resize(count);
+		posZ.resize(count);
+		velX.resize(count);
+		velY.resize(count);
+		velZ.resize(count);
+		density.resize(count);
+		pressure.resize(count);
+		accelerationX.resize(count);
+		accelerationY.resize(count);
+		accelerationZ.resize(count);
+
+		// Copied into the grid's order, so the neighbours of a particle are mostly close by in memory
+		ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int s = Begin; s < End; s++)
+			{
+				const unsigned int i = order[s];
+				rank[i] = s;
+				posX[s] = X[i];
+				posY[s] = Y[i];
+				posZ[s] = Z[i];
+				velX[s] = VX[i];
+				velY[s] = VY[i];
+				velZ[s] = VZ[i];
+			}
+		});
+
+		grid.FindNeighbours(radius, neighbourStart, neighbours);
+		HADRON_PROFILE_COUNT("fluid neighbours", neighbours.size());
+
+		computeDensities();
+		computeAccelerations();
+	}
+
+	void ParticleFluid::computeDensities()
+	{
+		HADRON_PROFILE_SCOPE("fluid density");
+
+		const unsigned int count = (unsigned int)order.size();
+		if(count == 0) return;
+
+		const ParticleFluidArrays<real> arrays = getArrays();
+		ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+		{
+			SumFluidDensities(arrays, Begin, End);
+		});
+	}
+
+	void ParticleFluid::computeAccelerations()
+	{
+		HADRON_PROFILE_SCOPE("fluid forces");
+
+		const unsigned int count = (unsigned int)order.size();
+		if(count == 0) return;
+
+		const ParticleFluidArrays<real> arrays = getArrays();
+		ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+		{
+			SumFluidAccelerations(arrays, Begin, End);
+		});
+	}
+
+	ParticleFluidArrays<real> ParticleFluid::getArrays()
+	{
+		ParticleFluidArrays<real> a;
+		a.count = (unsigned int)order.size();
+		a.posX = &posX[0]; a.posY = &posY[0]; a.posZ = &posZ[0];
+		a.velX = &velX[0]; a.velY = &velY[0]; a.velZ = &velZ[0];
+
+		// A lone particle has no neighbours at all
+		a.neighbourStart = &neighbourStart[0];
+		a.neighbours = neighbours.empty() ? NULL : &neighbours[0];
+
+		a.density = &density[0]; a.pressure = &pressure[0];
+		a.accelerationX = &accelerationX[0]; a.accelerationY = &accelerationY[0]; a.accelerationZ = &accelerationZ[0];
+		a.radius = radius;
+		a.restDensity = restDensity;
+		a.stiffness = stiffness;
+		a.viscosity = viscosity;
+		a.particleMass = particleMass;
+		a.poly6 = poly6;
+		a.spikyGradient = spikyGradient;
+		a.viscosityLaplacian = viscosityLaplacian;
+
+		return a;
+	}
+
+	void ParticleFluid::ApplyForce(Particle *P, real dT)
+	{
+		ApplyForceBatch(&P, 1, dT);
+	}
+
+	void ParticleFluid::ApplyForceBatch(Particle *const *P, unsigned int Count, real dT)
+	{
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			std::unordered_map<const Particle *, unsigned int>::const_iterator found = preparedIndex.find(P[i]);
+			if(found == preparedIndex.end() || P[i]->GetInverseMass() <= (real)0.0) continue;
+
+			const unsigned int s = rank[found->second];
+			if(s == NOT_IN_FLUID) continue;
+
+			const real mass = P[i]->GetMass();
+			P[i]->ApplyForce(accelerationX[s] * mass, accelerationY[s] * mass, accelerationZ[s] * mass);
+		}
+	}
+
+	void ParticleFluid::Prepare(Particle *const *P, unsigned int Count)
+	{
+		HADRON_PROFILE_SCOPE("fluid");
+
+		batchX.resize(Count);
+		batchY.resize(Count);
+		batchZ.resize(Count);
+		batchVelX.resize(Count);
+		batchVelY.resize(Count);
+		batchVelZ.resize(Count);
+		batchAlive.resize(Count);
+
+		preparedIndex.clear();
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			const Vector3<real> &position = P[i]->GetPosition();
+			const Vector3<real> &velocity = P[i]->GetVelocity();
+			batchX[i] = position.x;
+			batchY[i] = position.y;
+			batchZ[i] = position.z;
+			batchVelX[i] = velocity.x;
+			batchVelY[i] = velocity.y;
+			batchVelZ[i] = velocity.z;
+			batchAlive[i] = P[i]->IsAlive() ? 1 : 0;
+			preparedIndex[P[i]] = i;
+		}
+
+		if(Count == 0)
+		{
+			order.clear();
+			rank.clear();
+			return;
+		}
+
+		evaluate(&batchX[0], &batchY[0], &batchZ[0], &batchVelX[0], &batchVelY[0], &batchVelZ[0], &batchAlive[0], Count);
+	}
+
+	const char *ParticleFluid::GetName() const
+	{
+		return "fluid";
+	}
+
+	void ParticleFluid::ApplyForces(ParticleWorld &World, real dT)
+	{
+		// Whatever Prepare worked out is about to be replaced
+		preparedIndex.clear();
+
+		const unsigned int count = World.GetCount();
+		if(count == 0) return;
+
+		HADRON_PROFILE_SCOPE("fluid");
+
+		evaluate(World.GetPositionsX(), World.GetPositionsY(), World.GetPositionsZ(), World.GetVelocitiesX(), World.GetVelocitiesY(),
+			World.GetVelocitiesZ(), World.GetAliveFlags(), count);
+
+		const real *inverseMass = World.GetInverseMasses();
+		real *forceX = World.GetForcesX(), *forceY = World.GetForcesY(), *forceZ = World.GetForcesZ();
+
+		// The order's a permutation, so every particle's written by exactly one thread
+		ParallelFor(pool, 0, (unsigned int)order.size(), [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int s = Begin; s < End; s++)
+			{
+				const unsigned int i = order[s];
+				if(inverseMass[i] <= (real)0.0) continue;
+
+				const real mass = (real)1.0 / inverseMass[i];
+				forceX[i] += accelerationX[s] * mass;
+				forceY[i] += accelerationY[s] * mass;
+				forceZ[i] += accelerationZ[s] * mass;
+			}
+		});
+	}
+};
@@ -0,0 +1,143 @@
+#ifndef HADRON_PARTICLEFLUID_HPP
+#define HADRON_PARTICLEFLUID_HPP
+
+#include <unordered_map>
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "particle.hpp"
+#include "particleforcegenerator.hpp"
+#include "particlefluidsum.hpp"
+#include "particlehashgrid.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// Smoothed particle hydrodynamics, pressure and viscosity forces between particles making up a liquid
+	// ^- Uses the usual kernels (poly6 for density, spiky for pressure, and the viscosity kernel's Laplacian),
+	//    with pressure proportional to how far the density is above rest, so it never pulls particles together
+	// ^- Every particle counts as ParticleMass in the sums, whatever its own mass, and the accelerations that
+	//    come out are turned into forces with each particle's own mass
+	// ^- Immovable particles take part like any other, which makes them handy for walls and obstacles
+	// ^- Neighbour lists are rebuilt from a hash grid every time forces are applied, in the grid's cell order,
+	//    then density and forces are each gathered per particle so no two threads write to the same one
+	// ^- Step with ParticleWorld::Step<SymplecticEuler> or another symplectic scheme, the liquid heats up and
+	//    flies apart under the plain Step's explicit Euler
+	// ^- For Particles, call Prepare with every particle of the liquid once a step, then register them in a
+	//    ParticleForceRegistry with this as their generator as usual - ApplyForce and ApplyForceBatch only hand out
+	//    what Prepare worked out, so the registry can split them up between threads or islands however it likes
+	class ParticleFluid : public ParticleForceGenerator
+	{
+	private:
+		// Smoothing radius, particles further apart than this don't interact
+		real radius;
+		real restDensity;
+		real stiffness;
+		real viscosity;
+		real particleMass;
+
+		// Kernel constants for the radius
+		real poly6;
+		real spikyGradient;
+		real viscosityLaplacian;
+
+		ParticleHashGrid grid;
+
+		// Particle indices in the grid's order, and each particle's place in it (or NOT_IN_FLUID)
+		std::vector<unsigned int> order;
+		std::vector<unsigned int> rank;
+
+		// Positions and velocities in the grid's order
+		std::vector<real> posX, posY, posZ;
+		std::vector<real> velX, velY, velZ;
+
+		// Neighbour lists from the grid, in its order, see ParticleHashGrid::FindNeighbours
+		std::vector<unsigned int> neighbourStart;
+		std::vector<unsigned int> neighbours;
+
+		// Per particle in the grid's order
+		std::vector<real> density;
+		std::vector<real> pressure;
+		std::vector<real> accelerationX, accelerationY, accelerationZ;
+
+		// Where each particle given to Prepare was in the list, so ApplyForceBatch can find its acceleration
+		std::unordered_map<const Particle *, unsigned int> preparedIndex;
+
+		// Copies of the particles' state given to Prepare
+		std::vector<real> batchX, batchY, batchZ;
+		std::vector<real> batchVelX, batchVelY, batchVelZ;
+		std::vector<unsigned char> batchAlive;
+
+		// Pool to run on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Works out every live particle's acceleration, in the grid's order
+		void evaluate(const real *X, const real *Y, const real *Z, const real *VX, const real *VY, const real *VZ,
+			const unsigned char *Alive, unsigned int Count);
+
+		// Density, pressure and acceleration sums, on the widest packet kernel the CPU has, see particlefluidsum.hpp
+		void computeDensities();
+		void computeAccelerations();
+
+		// Points the kernels at the arrays above, as they are now
+		ParticleFluidArrays<real> getArrays();
+
+		static const unsigned int NOT_IN_FLUID = 0xFFFFFFFF;
+
+	public:
+		// Default constructor, a liquid of water-like density with a smoothing radius of 0.1, for particles 0.05 apart
+		ParticleFluid();
+
+		// Getters
+		real GetRadius() const;
+		real GetRestDensity() const;
+		real GetStiffness() const;
+		real GetViscosity() const;
+		real GetParticleMass() const;
+
+		// Number of neighbour pairs found last time, each pair counted from both ends
+		unsigned int GetNeighbourCount() const;
+
+		// Density and pressure worked out for a particle last time, zero if it wasn't part of it
+		// ^- Index is the particle's index in the world, or in the list given to Prepare
+		real GetDensity(unsigned int Index) const;
+		real GetPressure(unsigned int Index) const;
+
+		// Setters
+		// ^- Radius is usually about twice the spacing between particles at rest
+		void SetRadius(real Radius);
+		void SetRestDensity(real RestDensity);
+
+		// Pressure per unit density above rest, the square of the speed of sound in the liquid
+		// ^- Stiffer liquids compress less but need smaller steps, roughly dT < 0.4 * Radius / sqrt(Stiffness)
+		void SetStiffness(real Stiffness);
+
+		// A good deal more than the real liquid's, as it's also what keeps the particles from jittering
+		void SetViscosity(real Viscosity);
+		void SetParticleMass(real ParticleMass);
+
+		// Sets the pool to run on, NULL (the default) runs everything on the calling thread
+		// ^- Each particle sums its neighbours in the same order however many threads there are, so the results
+		//    are bitwise identical
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Methods
+		// Works out the liquid's forces on every one of the Count particles, from where they are now
+		// ^- Call once a step, before the registry applies its forces, with every particle of the liquid at once
+		void Prepare(Particle *const *P, unsigned int Count);
+
+		// Adds the force Prepare worked out for each particle to it
+		// ^- Only reads what Prepare left, so it's safe to call from several threads at once on different particles
+		// ^- Particles that weren't given to Prepare, and ones that can't move, are left alone
+		// ^- Integrators that evaluate forces several times a step all get the forces from the start of it
+		void ApplyForce(Particle *P, real dT);
+		void ApplyForceBatch(Particle *const *P, unsigned int Count, real dT);
+		const char *GetName() const;
+
+		// Adds the liquid's forces to every live particle in the world
+		// ^- Works everything out again, replacing whatever Prepare last did
+		void ApplyForces(ParticleWorld &World, real dT);
+	};
+};
+
+#endif // HADRON_PARTICLEFLUID_HPP
@@ -0,0 +1,207 @@
+#include <math.h>
+#include <algorithm>
+#include "../core/cpu.hpp"
+#include "particlefluidsum.hpp"
+#include "particlefluidsumkernel.hpp"
+#include "../math/packet_sse2.hpp"
+
+namespace Hadron {
+	namespace {
+		template<typename T>
+		void densitiesScalar(const ParticleFluidArrays<T> &A, unsigned int Begin, unsigned int End)
+		{
+			const T radiusSq = A.radius * A.radius;
+			const T self = radiusSq * radiusSq * radiusSq;
+
+			for(unsigned int s = Begin; s < End; s++)
+			{
+				const T x = A.posX[s], y = A.posY[s], z = A.posZ[s];
+
+				// Every neighbour's within the radius already, so the loop's free of branches
+				T sum = self;
+				for(unsigned int n = A.neighbourStart[s]; n < A.neighbourStart[s + 1]; n++)
+				{
+					const unsigned int j = A.neighbours[n];
+					const T dx = x - A.posX[j], dy = y - A.posY[j], dz = z - A.posZ[j];
+					const T w = radiusSq - ((dx * dx) + (dy * dy) + (dz * dz));
+					sum += w * w * w;
+				}
+
+				A.density[s] = sum * A.particleMass * A.poly6;
+				A.pressure[s] = std::max(A.stiffness * (A.density[s] - A.restDensity), (T)0.0);
+			}
+		}
+
+		template<typename T>
+		void accelerationsScalar(const ParticleFluidArrays<T> &A, unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int s = Begin; s < End; s++)
+			{
+				const T x = A.posX[s], y = A.posY[s], z = A.posZ[s];
+				const T vx = A.velX[s], vy = A.velY[s], vz = A.velZ[s];
+				const T p = A.pressure[s];
+
+				T ax = (T)0.0, ay = (T)0.0, az = (T)0.0;
+				for(unsigned int n = A.neighbourStart[s]; n < A.neighbourStart[s + 1]; n++)
+				{
+					const unsigned int j = A.neighbours[n];
+					const T dx = x - A.posX[j], dy = y - A.posY[j], dz = z - A.posZ[j];
+					const T distanceSq = (dx * dx) + (dy * dy) + (dz * dz);
+					const T distance = (T)sqrt(distanceSq);
+					const T falloff = A.radius - distance;
+					const T inverseDensity = (T)1.0 / A.density[j];
+
+					// Particles sat exactly on top of each other have no direction to push apart in
+					const T inverseDistance = distance > (T)0.0 ? (T)1.0 / distance : (T)0.0;
+
+					// Pressure pushes along the line between them, viscosity drags the velocities together
+					const T push = (p + A.pressure[j]) * (T)0.5 * inverseDensity * A.spikyGradient * falloff * falloff *
+						inverseDistance;
+					const T drag = A.viscosity * inverseDensity * A.viscosityLaplacian * falloff;
+
+					ax += (dx * push) + ((A.velX[j] - vx) * drag);
+					ay += (dy * push) + ((A.velY[j] - vy) * drag);
+					az += (dz * push) + ((A.velZ[j] - vz) * drag);
+				}
+
+				// The sums are force per unit volume, so dividing by density gives acceleration
+				const T scale = A.particleMass / A.density[s];
+				A.accelerationX[s] = ax * scale;
+				A.accelerationY[s] = ay * scale;
+				A.accelerationZ[s] = az * scale;
+			}
+		}
+
+		template<typename T>
+		void densitiesDispatch(const ParticleFluidArrays<T> &A, unsigned int Begin, unsigned int End)
+		{
+			// The packet kernels gather with 32 bit indices
+			if(A.count > 0x7FFFFFFFu)
+			{
+				SumFluidDensitiesScalar(A, Begin, End);
+				return;
+			}
+
+			switch(GetSimdLevel())
+			{
+			case(SIMD_AVX2):
+				SumFluidDensitiesAVX2(A, Begin, End);
+				break;
+
+			case(SIMD_SSE2):
+				SumFluidDensitiesSSE2(A, Begin, End);
+				break;
+
+			default:
+				SumFluidDensitiesScalar(A, Begin, End);
+			}
+		}
+
+		template<typename T>
+		void accelerationsDispatch(const ParticleFluidArrays<T> &A, unsigned int Begin, unsigned int End)
+		{
+			if(A.count > 0x7FFFFFFFu)
+			{
+				SumFluidAccelerationsScalar(A, Begin, End);
+				return;
+			}
+
+			switch(GetSimdLevel())
+			{
+			case(SIMD_AVX2):
+				SumFluidAccelerationsAVX2(A, Begin, End);
+				break;
+
+			case(SIMD_SSE2):
+				SumFluidAccelerationsSSE2(A, Begin, End);
+				break;
+
+			default:
+				SumFluidAccelerationsScalar(A, Begin, End);
+			}
+		}
+	}
+
+	void SumFluidDensities(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		densitiesDispatch(Arrays, Begin, End);
+	}
+
+	void SumFluidDensities(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		densitiesDispatch(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerations(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		accelerationsDispatch(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerations(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		accelerationsDispatch(Arrays, Begin, End);
+	}
+
+	void SumFluidDensitiesScalar(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		densitiesScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidDensitiesScalar(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		densitiesScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsScalar(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		accelerationsScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsScalar(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		accelerationsScalar(Arrays, Begin, End);
+	}
+
+#if defined(HADRON_ARCH_X86)
+	void SumFluidDensitiesSSE2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidDensityPackets<PacketSSE2f>(Arrays, Begin, End);
+	}
+
+	void SumFluidDensitiesSSE2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidDensityPackets<PacketSSE2d>(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsSSE2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidAccelerationPackets<PacketSSE2f>(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsSSE2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidAccelerationPackets<PacketSSE2d>(Arrays, Begin, End);
+	}
+#else
+	// No SSE2 here, GetSimdLevel never picks it but keep the symbols around anyway
+	void SumFluidDensitiesSSE2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		densitiesScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidDensitiesSSE2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		densitiesScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsSSE2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		accelerationsScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsSSE2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		accelerationsScalar(Arrays, Begin, End);
+	}
+#endif
+};
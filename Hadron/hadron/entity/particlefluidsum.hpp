@@ -0,0 +1,61 @@
+#ifndef HADRON_PARTICLEFLUIDSUM_HPP
+#define HADRON_PARTICLEFLUIDSUM_HPP
+
+#include "../core/precision.hpp"
+
+namespace Hadron {
+	// Everything the batched fluid sums need, as raw pointers into ParticleFluid's arrays
+	// ^- Per particle arrays are in the hash grid's order, and the neighbours of particle s are
+	//    neighbours[neighbourStart[s]] up to neighbours[neighbourStart[s + 1]]
+	template<typename T>
+	struct ParticleFluidArrays
+	{
+		// Number of particles in each per particle array
+		unsigned int count;
+
+		const T *posX, *posY, *posZ;
+		const T *velX, *velY, *velZ;
+		const unsigned int *neighbourStart;
+		const unsigned int *neighbours;
+
+		// Written by the density sums, and read by the acceleration ones
+		T *density, *pressure;
+
+		T *accelerationX, *accelerationY, *accelerationZ;
+
+		T radius, restDensity, stiffness, viscosity, particleMass;
+
+		// Kernel constants for the radius
+		T poly6, spikyGradient, viscosityLaplacian;
+	};
+
+	// Works out the density and pressure of particles [Begin, End) from their neighbours
+	// ^- Dispatches to the widest kernel GetSimdLevel allows, which all give exactly the same answer
+	void SumFluidDensities(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidDensities(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+
+	// Works out the pressure and viscosity acceleration of particles [Begin, End)
+	// ^- Every particle's density has to have been summed first, not just the ones in the range
+	void SumFluidAccelerations(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidAccelerations(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+
+	// The individual kernels
+	// ^- Only call the SSE2 and AVX2 ones directly if you've checked GetSupportedSimdLevel yourself
+	// ^- The packet kernels gather with 32 bit ints, so the dispatch falls back on the scalar ones for fluids
+	//    of more than 2^31 particles
+	void SumFluidDensitiesScalar(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidDensitiesScalar(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidDensitiesSSE2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidDensitiesSSE2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidDensitiesAVX2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidDensitiesAVX2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+
+	void SumFluidAccelerationsScalar(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidAccelerationsScalar(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidAccelerationsSSE2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidAccelerationsSSE2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidAccelerationsAVX2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End);
+	void SumFluidAccelerationsAVX2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End);
+};
+
+#endif // HADRON_PARTICLEFLUIDSUM_HPP
@@ -0,0 +1,62 @@
+// Everything in this file is built for AVX2, and is only ever called once cpu.hpp says the CPU can run it
+// ^- Same rules as particleintegrate_avx2.cpp, keep includes to the bare minimum and leave FMA off so the
+//    sums come out exactly like the SSE2 and scalar ones
+#if defined(__clang__)
+	#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC target("avx2")
+#endif
+
+#include "../core/cpu.hpp"
+#include "particlefluidsum.hpp"
+#include "particlefluidsumkernel.hpp"
+#include "../math/packet_avx2.hpp"
+
+namespace Hadron {
+#if defined(HADRON_ARCH_X86)
+	void SumFluidDensitiesAVX2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidDensityPackets<PacketAVX2f>(Arrays, Begin, End);
+	}
+
+	void SumFluidDensitiesAVX2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidDensityPackets<PacketAVX2d>(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsAVX2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidAccelerationPackets<PacketAVX2f>(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsAVX2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidAccelerationPackets<PacketAVX2d>(Arrays, Begin, End);
+	}
+#else
+	// No AVX2 here, GetSimdLevel never picks it but keep the symbols around anyway
+	void SumFluidDensitiesAVX2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidDensitiesScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidDensitiesAVX2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidDensitiesScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsAVX2(const ParticleFluidArrays<float> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidAccelerationsScalar(Arrays, Begin, End);
+	}
+
+	void SumFluidAccelerationsAVX2(const ParticleFluidArrays<double> &Arrays, unsigned int Begin, unsigned int End)
+	{
+		SumFluidAccelerationsScalar(Arrays, Begin, End);
+	}
+#endif
+};
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+#endif
@@ -0,0 +1,136 @@
+#ifndef HADRON_PARTICLEFLUIDSUMKERNEL_HPP
+#define HADRON_PARTICLEFLUIDSUMKERNEL_HPP
+
+// The packet kernels shared by the SSE2 and AVX2 builds
+// ^- Only meant to be included by the kernel translation units themselves
+
+#include "particlefluidsum.hpp"
+#include "../math/vector3packet.hpp"
+
+namespace Hadron {
+	// Lines up the K-th neighbour of each of the WIDTH particles from First on, for gathering
+	// ^- Particles with fewer neighbours than that point at themselves, with their lane switched off in Active
+	template<typename P>
+	void GatherFluidNeighbours(const ParticleFluidArrays<typename P::Scalar> &A, unsigned int First, unsigned int K,
+		int *Index, unsigned char *Active)
+	{
+		for(unsigned int l = 0; l < P::WIDTH; l++)
+		{
+			const unsigned int n = A.neighbourStart[First + l] + K;
+			Active[l] = (n < A.neighbourStart[First + l + 1]);
+			Index[l] = Active[l] ? (int)A.neighbours[n] : (int)(First + l);
+		}
+	}
+
+	// Most neighbours any of the WIDTH particles from First on has
+	template<typename P>
+	unsigned int LongestFluidNeighbours(const ParticleFluidArrays<typename P::Scalar> &A, unsigned int First)
+	{
+		unsigned int longest = 0;
+		for(unsigned int l = 0; l < P::WIDTH; l++)
+		{
+			const unsigned int length = A.neighbourStart[First + l + 1] - A.neighbourStart[First + l];
+			longest = (length > longest) ? length : longest;
+		}
+
+		return longest;
+	}
+
+	// Sums the densities of WIDTH particles at a time, one per lane, handing any leftover particles to the scalar kernel
+	// ^- Each lane goes through its own particle's neighbours in order and adds them up the way the scalar kernel
+	//    does, so the sums come out the same bit for bit, the neighbours' positions are gathered
+	template<typename P>
+	void SumFluidDensityPackets(const ParticleFluidArrays<typename P::Scalar> &A, unsigned int Begin, unsigned int End)
+	{
+		typedef typename P::Scalar T;
+		typedef Vector3Packet<P> V;
+
+		const T radiusSq = A.radius * A.radius;
+		const P radiusSqPacket(radiusSq);
+
+		int index[P::WIDTH];
+		unsigned char active[P::WIDTH];
+		T sums[P::WIDTH];
+
+		unsigned int s = Begin;
+		for(; s + P::WIDTH <= End; s += P::WIDTH)
+		{
+			const V position = V::Load(A.posX + s, A.posY + s, A.posZ + s);
+			const unsigned int longest = LongestFluidNeighbours<P>(A, s);
+
+			P sum(radiusSq * radiusSq * radiusSq);
+			for(unsigned int k = 0; k < longest; k++)
+			{
+				GatherFluidNeighbours<P>(A, s, k, index, active);
+
+				const V d = position - V(P::Gather(A.posX, index), P::Gather(A.posY, index), P::Gather(A.posZ, index));
+				const P w = radiusSqPacket - d.LengthSquared();
+				sum = P::Select(P::LoadFlags(active), sum + ((w * w) * w), sum);
+			}
+
+			// Pressure's only a max away, not worth a packet of its own
+			sum.Store(sums);
+			for(unsigned int l = 0; l < P::WIDTH; l++)
+			{
+				A.density[s + l] = sums[l] * A.particleMass * A.poly6;
+				A.pressure[s + l] = (A.stiffness * (A.density[s + l] - A.restDensity) < (T)0.0) ? (T)0.0 :
+					A.stiffness * (A.density[s + l] - A.restDensity);
+			}
+		}
+
+		if(s < End) SumFluidDensitiesScalar(A, s, End);
+	}
+
+	// Sums the accelerations of WIDTH particles at a time, one per lane, handing any leftover particles to the scalar
+	// kernel
+	// ^- Same operations in the same order as the scalar kernel, so every path gives the same answer
+	template<typename P>
+	void SumFluidAccelerationPackets(const ParticleFluidArrays<typename P::Scalar> &A, unsigned int Begin, unsigned int End)
+	{
+		typedef typename P::Scalar T;
+		typedef Vector3Packet<P> V;
+
+		const P zero((T)0.0), one((T)1.0), half((T)0.5);
+		const P radius(A.radius), spikyGradient(A.spikyGradient);
+		const P viscosity(A.viscosity), viscosityLaplacian(A.viscosityLaplacian);
+
+		int index[P::WIDTH];
+		unsigned char active[P::WIDTH];
+
+		unsigned int s = Begin;
+		for(; s + P::WIDTH <= End; s += P::WIDTH)
+		{
+			const V position = V::Load(A.posX + s, A.posY + s, A.posZ + s);
+			const V velocity = V::Load(A.velX + s, A.velY + s, A.velZ + s);
+			const P pressure = P::Load(A.pressure + s);
+			const unsigned int longest = LongestFluidNeighbours<P>(A, s);
+
+			V acceleration;
+			for(unsigned int k = 0; k < longest; k++)
+			{
+				GatherFluidNeighbours<P>(A, s, k, index, active);
+
+				const V d = position - V(P::Gather(A.posX, index), P::Gather(A.posY, index), P::Gather(A.posZ, index));
+				const P distance = P::Sqrt(d.LengthSquared());
+				const P falloff = radius - distance;
+				const P inverseDensity = one / P::Gather(A.density, index);
+				const P inverseDistance = P::Select(P::Greater(distance, zero), one / distance, zero);
+
+				const P push = (pressure + P::Gather(A.pressure, index)) * half * inverseDensity * spikyGradient * falloff *
+					falloff * inverseDistance;
+				const P drag = viscosity * inverseDensity * viscosityLaplacian * falloff;
+
+				const V other(P::Gather(A.velX, index), P::Gather(A.velY, index), P::Gather(A.velZ, index));
+				acceleration = V::Select(P::LoadFlags(active), acceleration + ((d * push) + ((other - velocity) * drag)),
+					acceleration);
+			}
+
+			(acceleration * (P(A.particleMass) / P::Load(A.density + s))).Store(A.accelerationX + s, A.accelerationY + s,
+				A.accelerationZ + s);
+		}
+
+		if(s < End) SumFluidAccelerationsScalar(A, s, End);
+	}
+};
+
+#endif // HADRON_PARTICLEFLUIDSUMKERNEL_HPP
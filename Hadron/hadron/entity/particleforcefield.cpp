@@ -0,0 +1,458 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "particleforcefield.hpp"
+#include "particlefieldsample.hpp"
+#include "../core/mappedfile.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	namespace {
+		const char FIELD_MAGIC[8] = { 'H', 'D', 'R', 'N', 'F', 'F', 'L', 'D' };
+		const unsigned int FIELD_VERSION = 1;
+
+		// Written as a native unsigned int, reads back differently on the other byte order
+		const unsigned int FIELD_BYTE_ORDER = 0x01020304;
+
+		struct FieldHeader
+		{
+			char magic[8];
+			unsigned int version;
+			unsigned int byteOrder;
+			unsigned int elementSize;
+			unsigned int mode;
+			unsigned int sizeX, sizeY, sizeZ;
+			unsigned int reserved;
+			double originX, originY, originZ;
+			double spacing;
+			double drag;
+		};
+
+		// Particles are sampled this many at a time, on the stack
+		const unsigned int SAMPLE_BLOCK = 256;
+
+		// Node range covering [Min, Max] along one axis, false if it misses the grid altogether
+		bool nodeRange(real Min, real Max, real Origin, real InverseSpacing, unsigned int Size, unsigned int &First, unsigned int &Last)
+		{
+			const real first = (real)floor((Min - Origin) * InverseSpacing);
+			const real last = (real)ceil((Max - Origin) * InverseSpacing);
+			if(!(last >= (real)0.0) || !(first <= (real)(Size - 1)) || first > last) return false;
+
+			First = (first > (real)0.0) ? (unsigned int)first : 0;
+			Last = (last < (real)(Size - 1)) ? (unsigned int)last : Size - 1;
+			return true;
+		}
+	};
+
+	ParticleForceField::ParticleForceField():
+	mode(FIELD_ACCELERATION),
+	drag((real)0.0),
+	pool(NULL)
+	{
+		Resize(Vector3<real>::ZERO, (real)1.0, 2, 2, 2);
+	}
+
+	void ParticleForceField::Resize(const Vector3<real> &Origin, real Spacing, unsigned int SizeX, unsigned int SizeY, unsigned int SizeZ)
+	{
+		origin = Origin;
+		spacing = (Spacing > (real)0.0) ? Spacing : (real)1.0;
+		inverseSpacing = (real)1.0 / spacing;
+		sizeX = std::max(SizeX, 2u);
+		sizeY = std::max(SizeY, 2u);
+		sizeZ = std::max(SizeZ, 2u);
+
+		values.assign((size_t)sizeX * sizeY * sizeZ * 3, (real)0.0);
+
+		bricksX = (sizeX + BRICK - 1) / BRICK;
+		bricksY = (sizeY + BRICK - 1) / BRICK;
+		bricksZ = (sizeZ + BRICK - 1) / BRICK;
+		dirty.assign(bricksX * bricksY * bricksZ, 0);
+
+		MarkAllDirty();
+	}
+
+	const Vector3<real> &ParticleForceField::GetOrigin() const
+	{
+		return origin;
+	}
+
+	real ParticleForceField::GetSpacing() const
+	{
+		return spacing;
+	}
+
+	unsigned int ParticleForceField::GetSizeX() const
+	{
+		return sizeX;
+	}
+
+	unsigned int ParticleForceField::GetSizeY() const
+	{
+		return sizeY;
+	}
+
+	unsigned int ParticleForceField::GetSizeZ() const
+	{
+		return sizeZ;
+	}
+
+	ParticleForceField::Mode ParticleForceField::GetMode() const
+	{
+		return mode;
+	}
+
+	real ParticleForceField::GetDrag() const
+	{
+		return drag;
+	}
+
+	Vector3<real> ParticleForceField::GetValue(unsigned int X, unsigned int Y, unsigned int Z) const
+	{
+		const real *v = &values[(X + ((size_t)Y * sizeX) + ((size_t)Z * sizeX * sizeY)) * 3];
+		return Vector3<real>(v[0], v[1], v[2]);
+	}
+
+	const real *ParticleForceField::GetValues() const
+	{
+		return &values[0];
+	}
+
+	void ParticleForceField::SetMode(Mode FieldMode)
+	{
+		mode = FieldMode;
+	}
+
+	void ParticleForceField::SetDrag(real Drag)
+	{
+		drag = Drag;
+	}
+
+	void ParticleForceField::SetValue(unsigned int X, unsigned int Y, unsigned int Z, const Vector3<real> &Value)
+	{
+		real *v = &values[(X + ((size_t)Y * sizeX) + ((size_t)Z * sizeX * sizeY)) * 3];
+		v[0] = Value.x;
+		v[1] = Value.y;
+		v[2] = Value.z;
+	}
+
+	void ParticleForceField::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	void ParticleForceField::AddSource(ParticleForceGenerator *Source)
+	{
+		sources.push_back(Source);
+		MarkAllDirty();
+	}
+
+	void ParticleForceField::RemoveSource(ParticleForceGenerator *Source)
+	{
+		std::vector<ParticleForceGenerator *>::iterator i = std::find(sources.begin(), sources.end(), Source);
+		if(i == sources.end()) return;
+
+		sources.erase(i);
+		MarkAllDirty();
+	}
+
+	void ParticleForceField::ClearSources()
+	{
+		sources.clear();
+		MarkAllDirty();
+	}
+
+	void ParticleForceField::MarkDirty(const Vector3<real> &Min, const Vector3<real> &Max)
+	{
+		unsigned int firstX, lastX, firstY, lastY, firstZ, lastZ;
+		if(!nodeRange(Min.x, Max.x, origin.x, inverseSpacing, sizeX, firstX, lastX)) return;
+		if(!nodeRange(Min.y, Max.y, origin.y, inverseSpacing, sizeY, firstY, lastY)) return;
+		if(!nodeRange(Min.z, Max.z, origin.z, inverseSpacing, sizeZ, firstZ, lastZ)) return;
+
+		for(unsigned int z = firstZ / BRICK; z <= lastZ / BRICK; z++)
+		{
+			for(unsigned int y = firstY / BRICK; y <= lastY / BRICK; y++)
+			{
+				for(unsigned int x = firstX / BRICK; x <= lastX / BRICK; x++)
+				{
+					dirty[x + (y * bricksX) + (z * bricksX * bricksY)] = 1;
+				}
+			}
+		}
+	}
+
+	void ParticleForceField::MarkAllDirty()
+	{
+		std::fill(dirty.begin(), dirty.end(), (unsigned char)1);
+	}
+
+	void ParticleForceField::bakeBrick(unsigned int Brick)
+	{
+		const unsigned int brickX = Brick % bricksX;
+		const unsigned int brickY = (Brick / bricksX) % bricksY;
+		const unsigned int brickZ = Brick / (bricksX * bricksY);
+
+		const unsigned int endX = std::min((brickX + 1) * BRICK, sizeX);
+		const unsigned int endY = std::min((brickY + 1) * BRICK, sizeY);
+		const unsigned int endZ = std::min((brickZ + 1) * BRICK, sizeZ);
+
+		// Unit mass and at rest, so what's left in the accumulator is the positional part of the force per unit mass
+		Particle probe;
+		probe.SetMass((real)1.0);
+		probe.SetAlive(true);
+
+		for(unsigned int z = brickZ * BRICK; z < endZ; z++)
+		{
+			for(unsigned int y = brickY * BRICK; y < endY; y++)
+			{
+				for(unsigned int x = brickX * BRICK; x < endX; x++)
+				{
+					probe.SetPosition(origin.x + ((real)x * spacing), origin.y + ((real)y * spacing), origin.z + ((real)z * spacing));
+					probe.SetVelocity(Vector3<real>::ZERO);
+					probe.ClearAccumulator();
+
+					for(unsigned int s = 0; s < sources.size(); s++)
+					{
+						sources[s]->ApplyForce(&probe, (real)0.0);
+					}
+
+					SetValue(x, y, z, probe.GetForceAccumulator());
+				}
+			}
+		}
+	}
+
+	unsigned int ParticleForceField::Rebake()
+	{
+		dirtyList.clear();
+		for(unsigned int b = 0; b < dirty.size(); b++)
+		{
+			if(dirty[b]) dirtyList.push_back(b);
+		}
+
+		if(dirtyList.empty()) return 0;
+
+		HADRON_PROFILE_SCOPE("force field bake");
+
+		// Bricks don't share nodes, so they can all be baked at once
+		ParallelFor(pool, 0, (unsigned int)dirtyList.size(), [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				bakeBrick(dirtyList[i]);
+			}
+		});
+
+		unsigned int baked = 0;
+		for(unsigned int i = 0; i < dirtyList.size(); i++)
+		{
+			const unsigned int b = dirtyList[i];
+			const unsigned int x = b % bricksX, y = (b / bricksX) % bricksY, z = b / (bricksX * bricksY);
+
+			baked += (std::min((x + 1) * BRICK, sizeX) - (x * BRICK)) * (std::min((y + 1) * BRICK, sizeY) - (y * BRICK)) *
+				(std::min((z + 1) * BRICK, sizeZ) - (z * BRICK));
+			dirty[b] = 0;
+		}
+
+		HADRON_PROFILE_COUNT("force field nodes baked", baked);
+		return baked;
+	}
+
+	bool ParticleForceField::Save(const char *Path) const
+	{
+		FILE *file = fopen(Path, "wb");
+		if(file == NULL) return false;
+
+		FieldHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, FIELD_MAGIC, sizeof(FIELD_MAGIC));
+		header.version = FIELD_VERSION;
+		header.byteOrder = FIELD_BYTE_ORDER;
+		header.elementSize = sizeof(real);
+		header.mode = (unsigned int)mode;
+		header.sizeX = sizeX;
+		header.sizeY = sizeY;
+		header.sizeZ = sizeZ;
+		header.originX = (double)origin.x;
+		header.originY = (double)origin.y;
+		header.originZ = (double)origin.z;
+		header.spacing = (double)spacing;
+		header.drag = (double)drag;
+
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		ok = ok && fwrite(&values[0], sizeof(real), values.size(), file) == values.size();
+
+		return (fclose(file) == 0) && ok;
+	}
+
+	bool ParticleForceField::Load(const char *Path)
+	{
+		MappedFile file;
+		if(!file.Open(Path) || file.GetSize() < sizeof(FieldHeader)) return false;
+
+		FieldHeader header;
+		memcpy(&header, file.GetData(), sizeof(header));
+
+		bool ok = memcmp(header.magic, FIELD_MAGIC, sizeof(FIELD_MAGIC)) == 0;
+		ok = ok && header.version == FIELD_VERSION && header.byteOrder == FIELD_BYTE_ORDER;
+		ok = ok && (header.elementSize == sizeof(float) || header.elementSize == sizeof(double));
+		ok = ok && header.mode <= (unsigned int)FIELD_FORCE;
+		ok = ok && (real)header.spacing > (real)0.0 && (real)header.spacing <= REAL_MAX;
+		ok = ok && header.sizeX >= 2 && header.sizeY >= 2 && header.sizeZ >= 2;
+		if(!ok) return false;
+
+		// The nodes have to fill the rest of the file exactly
+		// ^- Worked up one axis at a time against what the file can hold, so sizes from a corrupt header can't
+		//    overflow on the way to an allocation
+		const unsigned long long nodeSize = 3ull * header.elementSize;
+		const unsigned long long bytes = file.GetSize() - sizeof(header);
+		if(bytes % nodeSize != 0) return false;
+
+		const unsigned long long nodes = bytes / nodeSize;
+		if(header.sizeX > nodes || header.sizeY > nodes / header.sizeX) return false;
+
+		const unsigned long long layer = (unsigned long long)header.sizeX * header.sizeY;
+		if(header.sizeZ > nodes / layer || layer * header.sizeZ != nodes) return false;
+
+		// It also has to fit in memory, which matters for 32 bit builds
+		if(nodes > (size_t)-1 / (3 * sizeof(real))) return false;
+
+		// Nothing can fail from here on
+		Resize(Vector3<real>((real)header.originX, (real)header.originY, (real)header.originZ), (real)header.spacing,
+			header.sizeX, header.sizeY, header.sizeZ);
+		mode = (Mode)header.mode;
+		drag = (real)header.drag;
+
+		const unsigned char *data = file.GetData() + sizeof(header);
+		for(size_t i = 0; i < values.size(); i++)
+		{
+			if(header.elementSize == sizeof(float))
+			{
+				float value;
+				memcpy(&value, data + (i * sizeof(float)), sizeof(float));
+				values[i] = (real)value;
+			}
+			else
+			{
+				double value;
+				memcpy(&value, data + (i * sizeof(double)), sizeof(double));
+				values[i] = (real)value;
+			}
+		}
+
+		// What was loaded is the field now, so there's nothing to bake until something's marked
+		std::fill(dirty.begin(), dirty.end(), (unsigned char)0);
+		return true;
+	}
+
+	void ParticleForceField::sampleBlock(const real *X, const real *Y, const real *Z, unsigned int Count, real *OutX, real *OutY,
+		real *OutZ) const
+	{
+		ParticleFieldGrid<real> grid;
+		grid.values = &values[0];
+		grid.originX = origin.x;
+		grid.originY = origin.y;
+		grid.originZ = origin.z;
+		grid.inverseSpacing = inverseSpacing;
+		grid.sizeX = sizeX;
+		grid.sizeY = sizeY;
+		grid.sizeZ = sizeZ;
+
+		SampleParticleField(grid, X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	Vector3<real> ParticleForceField::Sample(const Vector3<real> &Position) const
+	{
+		Vector3<real> out;
+		sampleBlock(&Position.x, &Position.y, &Position.z, 1, &out.x, &out.y, &out.z);
+
+		return out;
+	}
+
+	void ParticleForceField::Sample(const real *X, const real *Y, const real *Z, unsigned int Count, real *OutX, real *OutY, real *OutZ) const
+	{
+		sampleBlock(X, Y, Z, Count, OutX, OutY, OutZ);
+	}
+
+	void ParticleForceField::ApplyForce(Particle *P, real dT)
+	{
+		ApplyForceBatch(&P, 1, dT);
+	}
+
+	void ParticleForceField::ApplyForceBatch(Particle *const *P, unsigned int Count, real dT)
+	{
+		real x[SAMPLE_BLOCK], y[SAMPLE_BLOCK], z[SAMPLE_BLOCK];
+		real sampledX[SAMPLE_BLOCK], sampledY[SAMPLE_BLOCK], sampledZ[SAMPLE_BLOCK];
+
+		for(unsigned int first = 0; first < Count; first += SAMPLE_BLOCK)
+		{
+			const unsigned int count = std::min(Count - first, SAMPLE_BLOCK);
+
+			// Gather the positions so the whole block's sampled in one go
+			for(unsigned int i = 0; i < count; i++)
+			{
+				const Vector3<real> &position = P[first + i]->GetPosition();
+				x[i] = position.x;
+				y[i] = position.y;
+				z[i] = position.z;
+			}
+
+			sampleBlock(x, y, z, count, sampledX, sampledY, sampledZ);
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				Particle *p = P[first + i];
+				if(!p->IsAlive()) continue;
+
+				const real scale = (mode == FIELD_ACCELERATION) ? p->GetMass() : (real)1.0;
+				const Vector3<real> &velocity = p->GetVelocity();
+
+				p->ApplyForce((sampledX[i] * scale) - (velocity.x * drag), (sampledY[i] * scale) - (velocity.y * drag),
+					(sampledZ[i] * scale) - (velocity.z * drag));
+			}
+		}
+	}
+
+	const char *ParticleForceField::GetName() const
+	{
+		return "force field";
+	}
+
+	void ParticleForceField::ApplyForces(ParticleWorld &World, real dT)
+	{
+		const unsigned int count = World.GetCount();
+		if(count == 0) return;
+
+		HADRON_PROFILE_SCOPE("force field");
+
+		const real *posX = World.GetPositionsX(), *posY = World.GetPositionsY(), *posZ = World.GetPositionsZ();
+		const real *velX = World.GetVelocitiesX(), *velY = World.GetVelocitiesY(), *velZ = World.GetVelocitiesZ();
+		real *forceX = World.GetForcesX(), *forceY = World.GetForcesY(), *forceZ = World.GetForcesZ();
+		const real *inverseMass = World.GetInverseMasses();
+		const unsigned char *alive = World.GetAliveFlags();
+
+		// Each thread only touches its own particles' forces
+		ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+		{
+			real sampledX[SAMPLE_BLOCK], sampledY[SAMPLE_BLOCK], sampledZ[SAMPLE_BLOCK];
+
+			for(unsigned int first = Begin; first < End; first += SAMPLE_BLOCK)
+			{
+				const unsigned int block = std::min(End - first, SAMPLE_BLOCK);
+				sampleBlock(posX + first, posY + first, posZ + first, block, sampledX, sampledY, sampledZ);
+
+				for(unsigned int j = 0; j < block; j++)
+				{
+					const unsigned int i = first + j;
+					if(!alive[i] || inverseMass[i] <= (real)0.0) continue;
+
+					const real scale = (mode == FIELD_ACCELERATION) ? (real)1.0 / inverseMass[i] : (real)1.0;
+					forceX[i] += (sampledX[j] * scale) - (velX[i] * drag);
+					forceY[i] += (sampledY[j] * scale) - (velY[i] * drag);
+					forceZ[i] += (sampledZ[j] * scale) - (velZ[i] * drag);
+				}
+			}
+		});
+	}
+};
@@ -0,0 +1,141 @@
+#ifndef HADRON_PARTICLEFORCEFIELD_HPP
+#define HADRON_PARTICLEFORCEFIELD_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "../math/vector3.hpp"
+#include "particle.hpp"
+#include "particleforcegenerator.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// A force field baked onto a regular 3D grid, sampled with trilinear interpolation
+	// ^- Any number of source generators can be baked in, and sampling costs the same however many there were
+	// ^- Sources are baked by probing them with a particle of unit mass sat still at each grid node, so only the
+	//    part of their force that depends on position gets baked - SetDrag covers the usual velocity dependent part
+	// ^- Particles outside the grid get no force from it
+	// ^- Can be registered in a ParticleForceRegistry like any other generator, or applied to a whole
+	//    ParticleWorld in one go with ApplyForces
+	class ParticleForceField : public ParticleForceGenerator
+	{
+	public:
+		// How the baked vectors turn into forces
+		enum Mode
+		{
+			// Force is the field times the particle's mass, for sources that pull everything equally (gravity, attractors)
+			FIELD_ACCELERATION = 0,
+
+			// Force is the field as it is, whatever the particle's mass (wind pushing on equally sized debris)
+			FIELD_FORCE
+		};
+
+	private:
+		// Node (x, y, z) is at origin + (x, y, z) * spacing
+		Vector3<real> origin;
+		real spacing;
+		real inverseSpacing;
+		unsigned int sizeX, sizeY, sizeZ;
+
+		// Three values per node, x fastest then y then z, so the corners of a cell along x sit side by side
+		std::vector<real> values;
+
+		Mode mode;
+		real drag;
+
+		// Generators the field's baked from
+		std::vector<ParticleForceGenerator *> sources;
+
+		// Bricks of BRICK^3 nodes that need baking again
+		static const unsigned int BRICK = 8;
+		unsigned int bricksX, bricksY, bricksZ;
+		std::vector<unsigned char> dirty;
+		std::vector<unsigned int> dirtyList;
+
+		// Pool to bake and apply forces on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Bakes every source into the nodes of one brick
+		void bakeBrick(unsigned int Brick);
+
+		// Samples Count positions into OutX, OutY and OutZ, zero outside the grid
+		// ^- Runs on the widest packet kernel the CPU has, see particlefieldsample.hpp
+		void sampleBlock(const real *X, const real *Y, const real *Z, unsigned int Count, real *OutX, real *OutY,
+			real *OutZ) const;
+
+	public:
+		// Default constructor, an empty 2x2x2 grid of unit spacing at the origin
+		ParticleForceField();
+
+		// Sets the grid up as SizeX by SizeY by SizeZ nodes, Spacing apart from Origin, and zeroes it
+		// ^- Sizes are at least 2 along each axis, so every point inside has a whole cell around it
+		void Resize(const Vector3<real> &Origin, real Spacing, unsigned int SizeX, unsigned int SizeY, unsigned int SizeZ);
+
+		// Getters
+		const Vector3<real> &GetOrigin() const;
+		real GetSpacing() const;
+		unsigned int GetSizeX() const;
+		unsigned int GetSizeY() const;
+		unsigned int GetSizeZ() const;
+		Mode GetMode() const;
+		real GetDrag() const;
+
+		// Baked vector at a node
+		Vector3<real> GetValue(unsigned int X, unsigned int Y, unsigned int Z) const;
+
+		// Raw node values, 3 per node, see the layout above
+		const real *GetValues() const;
+
+		// Setters
+		void SetMode(Mode FieldMode);
+
+		// Adds -Drag * velocity on top of the baked force, for the linear drag the baking can't capture
+		// ^- So a wind source of the form k * (wind - v) bakes to k * wind, and SetDrag(k) puts the rest back
+		void SetDrag(real Drag);
+
+		// Overwrites a node's value, say for fields worked out some other way
+		void SetValue(unsigned int X, unsigned int Y, unsigned int Z, const Vector3<real> &Value);
+
+		// Sets the pool to bake and apply forces on, NULL (the default) runs everything on the calling thread
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Sources
+		// ^- Adding or removing one marks the whole grid dirty
+		void AddSource(ParticleForceGenerator *Source);
+		void RemoveSource(ParticleForceGenerator *Source);
+		void ClearSources();
+
+		// Marks the nodes inside the box as needing baking again, say after a source has moved
+		// ^- Whole bricks are rebaked, so the box gets rounded out to them
+		void MarkDirty(const Vector3<real> &Min, const Vector3<real> &Max);
+		void MarkAllDirty();
+
+		// Bakes the sources into every dirty brick, overwriting what was there
+		// ^- Returns the number of nodes baked
+		// ^- Sources are only read, so they just need their ApplyForce to be safe to call from several threads
+		unsigned int Rebake();
+
+		// Saves and loads the grid, its mode and its drag, but not its sources
+		// ^- Values are converted if the file was saved with a different precision
+		// ^- Return false if the file can't be written or isn't a force field, Load leaves the field as it was then
+		bool Save(const char *Path) const;
+		bool Load(const char *Path);
+
+		// Methods
+		// Trilinearly interpolated field at a point, zero outside the grid
+		Vector3<real> Sample(const Vector3<real> &Position) const;
+
+		// Samples Count points at once into OutX, OutY and OutZ
+		void Sample(const real *X, const real *Y, const real *Z, unsigned int Count, real *OutX, real *OutY, real *OutZ) const;
+
+		void ApplyForce(Particle *P, real dT);
+		void ApplyForceBatch(Particle *const *P, unsigned int Count, real dT);
+		const char *GetName() const;
+
+		// Applies the field to every live particle in the world, in blocks split over the pool
+		void ApplyForces(ParticleWorld &World, real dT);
+	};
+};
+
+#endif // HADRON_PARTICLEFORCEFIELD_HPP
@@ -1,41 +1,780 @@
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
 #include "particleforcegenerator.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
 
 namespace Hadron {
+	namespace {
+		// Times each run of groups whose generators share a name as one scope
+		// ^- Groups are sorted by type, so a thousand springs come out as one event rather than a thousand
+		class GroupProfileScope
+		{
+		private:
+			const char *name;
+			unsigned long long start;
+
+		public:
+			GroupProfileScope():
+			name(NULL),
+			start(0)
+			{ }
+
+			~GroupProfileScope()
+			{
+				if(name != NULL && IsProfilingEnabled()) AddProfileEvent(name, start, GetProfileTime());
+			}
+
+			void Enter(const ParticleForceGenerator *Generator)
+			{
+#if !defined(HADRON_NO_PROFILING)
+				if(!IsProfilingEnabled()) return;
+
+				const char *next = Generator->GetName();
+				if(next == name) return;
+
+				const unsigned long long now = GetProfileTime();
+				if(name != NULL) AddProfileEvent(name, start, now);
+
+				name = next;
+				start = now;
+#endif
+			}
+		};
+	};
+
+	void ParticleForceGenerator::ApplyForceBatch(Particle *const *P, unsigned int Count, real dT)
+	{
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			ApplyForce(P[i], dT);
+		}
+	}
+
+	const char *ParticleForceGenerator::GetName() const
+	{
+		return "force generator";
+	}
+
+	Particle *ParticleForceGenerator::GetLinkedParticle() const
+	{
+		return NULL;
+	}
+
+	real ParticleForceGenerator::GetLinkedStiffness() const
+	{
+		return (real)0.0;
+	}
+
+	ParticleForceRegistry::ParticleForceRegistry():
+	pool(NULL),
+	scheduleDirty(true),
+	scheduleChunks(0),
+	linksDirty(false),
+	islandsDirty(true),
+	substepGrowth((real)0.01),
+	substepTravel((real)0.0),
+	maxSubsteps(64)
+	{ }
+
 	void ParticleForceRegistry::Add(Particle *P, ParticleForceGenerator *ForceGen)
 	{
-		ParticleForceRegistration r;
-		r.particle = P;
-		r.forceGen = ForceGen;
-		
-		registrations.push_back(r);
+		std::pair<std::unordered_map<ParticleForceGenerator *, unsigned int>::iterator, bool> found =
+			groupIndex.insert(std::make_pair(ForceGen, (unsigned int)groups.size()));
+
+		// First time we've seen this generator
+		if(found.second)
+		{
+			groups.push_back(GeneratorGroup());
+			groups.back().forceGen = ForceGen;
+		}
+
+		groups[found.first->second].particles.push_back(P);
+		scheduleDirty = true;
+
+		if(!linksDirty) linkRegistration(P, ForceGen);
+		islandsDirty = true;
 	}
 
 	void ParticleForceRegistry::Remove(Particle *P, ParticleForceGenerator *ForceGen)
 	{
-		Registry::iterator i = registrations.begin();
+		std::unordered_map<ParticleForceGenerator *, unsigned int>::iterator g = groupIndex.find(ForceGen);
+		if(g == groupIndex.end()) return;
+
+		std::vector<Particle *> &list = groups[g->second].particles;
+		std::vector<Particle *>::iterator i = std::find(list.begin(), list.end(), P);
+		if(i == list.end()) return;
 
-		for(; i != registrations.end(); ++i)
+		list.erase(i);
+
+		// Drop the group altogether once it's empty
+		if(list.empty())
 		{
-			if(i->particle == P && i->forceGen == ForceGen)
+			groups.erase(groups.begin() + g->second);
+
+			groupIndex.clear();
+			for(unsigned int j = 0; j < groups.size(); j++)
 			{
-				registrations.erase(i);
-				break;
+				groupIndex[groups[j].forceGen] = j;
 			}
 		}
+
+		scheduleDirty = true;
+		linksDirty = true;
+		islandsDirty = true;
 	}
 
 	void ParticleForceRegistry::Clear()
 	{
-		registrations.clear();
+		groups.clear();
+		groupIndex.clear();
+		particles.clear();
+		scheduleDirty = true;
+
+		islandNode.clear();
+		islandParent.clear();
+		pendingLinks.clear();
+		linksDirty = false;
+		islandsDirty = true;
+
+		manualSubsteps.clear();
+	}
+
+	void ParticleForceRegistry::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	namespace {
+		// Orders (slot, particle) pairs by slot
+		struct SlotLess
+		{
+			bool operator()(const std::pair<unsigned int, Particle *> &A, const std::pair<unsigned int, Particle *> &B) const
+			{
+				return A.first < B.first;
+			}
+		};
+
+		// Orders generator groups by the generator's type
+		struct GroupTypeLess
+		{
+			template<typename Group>
+			bool operator()(const Group &A, const Group &B) const
+			{
+				return std::type_index(typeid(*A.forceGen)) < std::type_index(typeid(*B.forceGen));
+			}
+		};
+	}
+
+	void ParticleForceRegistry::buildSchedule()
+	{
+		if(!scheduleDirty) return;
+
+		// Same types together, keeping the order they were added in otherwise
+		std::stable_sort(groups.begin(), groups.end(), GroupTypeLess());
+
+		groupIndex.clear();
+		particles.clear();
+
+		// Give each particle a slot, in the order they first show up
+		std::unordered_map<Particle *, unsigned int> slotOf;
+		for(unsigned int g = 0; g < groups.size(); g++)
+		{
+			GeneratorGroup &group = groups[g];
+			groupIndex[group.forceGen] = g;
+
+			group.slots.resize(group.particles.size());
+			for(unsigned int i = 0; i < group.particles.size(); i++)
+			{
+				std::pair<std::unordered_map<Particle *, unsigned int>::iterator, bool> found =
+					slotOf.insert(std::make_pair(group.particles[i], (unsigned int)particles.size()));
+
+				if(found.second) particles.push_back(group.particles[i]);
+				group.slots[i] = found.first->second;
+			}
+
+			// Sort each group by slot, so any range of slots maps onto one contiguous run of the group
+			// ^- Only the order between different particles changes, so no particle's forces change
+			std::vector<std::pair<unsigned int, Particle *> > sorted(group.particles.size());
+			for(unsigned int i = 0; i < sorted.size(); i++)
+			{
+				sorted[i] = std::make_pair(group.slots[i], group.particles[i]);
+			}
+
+			std::stable_sort(sorted.begin(), sorted.end(), SlotLess());
+
+			for(unsigned int i = 0; i < sorted.size(); i++)
+			{
+				group.slots[i] = sorted[i].first;
+				group.particles[i] = sorted[i].second;
+			}
+		}
+
+		scheduleDirty = false;
+		scheduleChunks = 0;
+	}
+
+	void ParticleForceRegistry::buildChunks(unsigned int Chunks)
+	{
+		if(scheduleChunks == Chunks) return;
+
+		const unsigned int count = (unsigned int)particles.size();
+
+		// Chunk c is slots [count * c / Chunks, count * (c + 1) / Chunks), the same split as ParallelFor
+		std::vector<unsigned int> chunkOf(count);
+		for(unsigned int c = 0; c < Chunks; c++)
+		{
+			const unsigned int begin = (unsigned int)((unsigned long long)count * c / Chunks);
+			const unsigned int end = (unsigned int)((unsigned long long)count * (c + 1) / Chunks);
+			for(unsigned int s = begin; s < end; s++) chunkOf[s] = c;
+		}
+
+		// Each group's slots are sorted, so it breaks into one run per chunk it reaches
+		std::vector<std::vector<ChunkBatch> > perChunk(Chunks);
+		for(unsigned int g = 0; g < groups.size(); g++)
+		{
+			const std::vector<unsigned int> &slots = groups[g].slots;
+
+			unsigned int first = 0;
+			while(first < slots.size())
+			{
+				const unsigned int c = chunkOf[slots[first]];
+				const unsigned int end = (unsigned int)((unsigned long long)count * (c + 1) / Chunks);
+				const unsigned int last = (unsigned int)(std::lower_bound(slots.begin() + first, slots.end(), end) - slots.begin());
+
+				ChunkBatch batch;
+				batch.group = g;
+				batch.first = first;
+				batch.count = last - first;
+				perChunk[c].push_back(batch);
+
+				first = last;
+			}
+		}
+
+		// Groups were walked in order, so each chunk's batches are in group order too
+		chunkBatches.clear();
+		chunkBatchStart.assign(1, 0);
+		for(unsigned int c = 0; c < Chunks; c++)
+		{
+			chunkBatches.insert(chunkBatches.end(), perChunk[c].begin(), perChunk[c].end());
+			chunkBatchStart.push_back((unsigned int)chunkBatches.size());
+		}
+
+		scheduleChunks = Chunks;
+	}
+
+	unsigned int ParticleForceRegistry::islandNodeOf(Particle *P)
+	{
+		std::pair<std::unordered_map<Particle *, unsigned int>::iterator, bool> found =
+			islandNode.insert(std::make_pair(P, (unsigned int)islandParent.size()));
+
+		const unsigned int node = found.first->second;
+		if(!found.second) return node;
+
+		islandParent.push_back(node);
+
+		// Registrations that were linked to this particle before it was registered itself
+		typedef std::unordered_multimap<Particle *, Particle *>::iterator PendingIterator;
+		std::pair<PendingIterator, PendingIterator> pending = pendingLinks.equal_range(P);
+		for(PendingIterator i = pending.first; i != pending.second; ++i)
+		{
+			joinIslands(node, islandNode[i->second]);
+		}
+
+		pendingLinks.erase(pending.first, pending.second);
+		return node;
+	}
+
+	unsigned int ParticleForceRegistry::findIslandRoot(unsigned int Node)
+	{
+		while(islandParent[Node] != Node)
+		{
+			islandParent[Node] = islandParent[islandParent[Node]];
+			Node = islandParent[Node];
+		}
+
+		return Node;
+	}
+
+	void ParticleForceRegistry::joinIslands(unsigned int A, unsigned int B)
+	{
+		const unsigned int rootA = findIslandRoot(A);
+		const unsigned int rootB = findIslandRoot(B);
+
+		if(rootA < rootB) islandParent[rootB] = rootA;
+		else if(rootB < rootA) islandParent[rootA] = rootB;
+	}
+
+	void ParticleForceRegistry::linkRegistration(Particle *P, ParticleForceGenerator *ForceGen)
+	{
+		const unsigned int node = islandNodeOf(P);
+
+		Particle *linked = ForceGen->GetLinkedParticle();
+		if(linked == NULL || linked == P) return;
+
+		// Particles that aren't registered are never written to by the registry, so reading them doesn't tie
+		// islands together - that way every spring hanging off the same fixed anchor isn't one big island
+		std::unordered_map<Particle *, unsigned int>::iterator other = islandNode.find(linked);
+		if(other == islandNode.end()) pendingLinks.insert(std::make_pair(linked, P));
+		else joinIslands(node, other->second);
+	}
+
+	void ParticleForceRegistry::buildIslands()
+	{
+		buildSchedule();
+
+		if(linksDirty)
+		{
+			islandNode.clear();
+			islandParent.clear();
+			pendingLinks.clear();
+
+			for(unsigned int g = 0; g < groups.size(); g++)
+			{
+				for(unsigned int i = 0; i < groups[g].particles.size(); i++)
+				{
+					linkRegistration(groups[g].particles[i], groups[g].forceGen);
+				}
+			}
+
+			linksDirty = false;
+		}
+
+		if(!islandsDirty) return;
+
+		static const unsigned int NO_ISLAND = 0xFFFFFFFF;
+		const unsigned int count = (unsigned int)particles.size();
+
+		// Number the islands in the order their first particles show up, and count their particles
+		std::vector<unsigned int> islandOf(count);
+		std::vector<unsigned int> rootIsland(islandParent.size(), NO_ISLAND);
+
+		islandStart.clear();
+		islandStart.push_back(0);
+
+		for(unsigned int p = 0; p < count; p++)
+		{
+			const unsigned int root = findIslandRoot(islandNode[particles[p]]);
+			if(rootIsland[root] == NO_ISLAND)
+			{
+				rootIsland[root] = (unsigned int)islandStart.size() - 1;
+				islandStart.push_back(0);
+			}
+
+			islandOf[p] = rootIsland[root];
+			islandStart[islandOf[p] + 1]++;
+		}
+
+		const unsigned int islands = (unsigned int)islandStart.size() - 1;
+		for(unsigned int i = 0; i < islands; i++)
+		{
+			islandStart[i + 1] += islandStart[i];
+		}
+
+		islandParticles.resize(count);
+		std::vector<unsigned int> next(islandStart.begin(), islandStart.end() - 1);
+		for(unsigned int p = 0; p < count; p++)
+		{
+			islandParticles[next[islandOf[p]]++] = particles[p];
+		}
+
+		// Count each island's registrations and batches, a new batch starting whenever the group changes
+		std::vector<unsigned int> registrationStart(islands + 1, 0);
+		std::vector<unsigned int> lastGroup(islands, NO_ISLAND);
+		batchStart.assign(islands + 1, 0);
+
+		for(unsigned int g = 0; g < groups.size(); g++)
+		{
+			for(unsigned int i = 0; i < groups[g].slots.size(); i++)
+			{
+				const unsigned int island = islandOf[groups[g].slots[i]];
+				registrationStart[island + 1]++;
+
+				if(lastGroup[island] != g)
+				{
+					lastGroup[island] = g;
+					batchStart[island + 1]++;
+				}
+			}
+		}
+
+		for(unsigned int i = 0; i < islands; i++)
+		{
+			registrationStart[i + 1] += registrationStart[i];
+			batchStart[i + 1] += batchStart[i];
+		}
+
+		// Then lay them out, groups in order within each island so every particle's forces add up in the same
+		// order ApplyForces adds them in
+		islandRegistrations.resize(registrationStart[islands]);
+		islandBatches.resize(batchStart[islands]);
+
+		std::vector<unsigned int> nextRegistration(registrationStart.begin(), registrationStart.end() - 1);
+		std::vector<unsigned int> nextBatch(batchStart.begin(), batchStart.end() - 1);
+		lastGroup.assign(islands, NO_ISLAND);
+
+		for(unsigned int g = 0; g < groups.size(); g++)
+		{
+			for(unsigned int i = 0; i < groups[g].slots.size(); i++)
+			{
+				const unsigned int island = islandOf[groups[g].slots[i]];
+
+				if(lastGroup[island] != g)
+				{
+					lastGroup[island] = g;
+
+					IslandBatch &batch = islandBatches[nextBatch[island]++];
+					batch.group = g;
+					batch.first = nextRegistration[island];
+					batch.count = 0;
+				}
+
+				islandBatches[nextBatch[island] - 1].count++;
+				islandRegistrations[nextRegistration[island]++] = groups[g].particles[i];
+			}
+		}
+
+		// Manual substep counts, the most any particle in the island asked for
+		islandManualSubsteps.assign(islands, 0);
+		if(!manualSubsteps.empty())
+		{
+			for(unsigned int p = 0; p < count; p++)
+			{
+				std::unordered_map<Particle *, unsigned int>::const_iterator found = manualSubsteps.find(particles[p]);
+				if(found != manualSubsteps.end()) islandManualSubsteps[islandOf[p]] = std::max(islandManualSubsteps[islandOf[p]], found->second);
+			}
+		}
+
+		islandsDirty = false;
+	}
+
+	unsigned int ParticleForceRegistry::countRegistrations() const
+	{
+		unsigned int count = 0;
+		for(unsigned int g = 0; g < groups.size(); g++) count += (unsigned int)groups[g].particles.size();
+
+		return count;
 	}
 
 	void ParticleForceRegistry::ApplyForces(real dT)
 	{
-		Registry::iterator i = registrations.begin();
+		HADRON_PROFILE_SCOPE("registry apply forces");
+		buildSchedule();
+
+		HADRON_PROFILE_COUNT("registrations visited", countRegistrations());
+		HADRON_PROFILE_COUNT("generator groups", groups.size());
+
+		if(pool == NULL || pool->GetThreadCount() <= 1)
+		{
+			GroupProfileScope scope;
+			for(unsigned int g = 0; g < groups.size(); g++)
+			{
+				GeneratorGroup &group = groups[g];
+
+				scope.Enter(group.forceGen);
+				group.forceGen->ApplyForceBatch(&group.particles[0], (unsigned int)group.particles.size(), dT);
+			}
+
+			return;
+		}
+
+		// Each chunk of particle slots owns that part of every group
+		// ^- Groups still run in the same order, so each particle's forces add up exactly as they do serially
+		const unsigned int chunks = std::min(pool->GetThreadCount() * 4, (unsigned int)particles.size());
+		buildChunks(chunks);
+
+		ParallelFor(pool, 0, chunks, [&](unsigned int Begin, unsigned int End)
+		{
+			GroupProfileScope scope;
+			for(unsigned int b = chunkBatchStart[Begin]; b < chunkBatchStart[End]; b++)
+			{
+				const ChunkBatch &batch = chunkBatches[b];
+				GeneratorGroup &group = groups[batch.group];
+
+				scope.Enter(group.forceGen);
+				group.forceGen->ApplyForceBatch(&group.particles[batch.first], batch.count, dT);
+			}
+		});
+	}
+
+	void ParticleForceRegistry::Update(real dT)
+	{
+		HADRON_PROFILE_SCOPE("registry update");
+		buildSchedule();
+
+		HADRON_PROFILE_COUNT("particles integrated", particles.size());
+
+		ParallelFor(pool, 0, (unsigned int)particles.size(), [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int p = Begin; p < End; p++)
+			{
+				particles[p]->Update(dT);
+			}
+		});
+	}
+
+	unsigned int ParticleForceRegistry::GetIslandCount()
+	{
+		buildIslands();
+		return (unsigned int)islandStart.size() - 1;
+	}
+
+	unsigned int ParticleForceRegistry::GetIslandSize(unsigned int Island)
+	{
+		buildIslands();
+		return islandStart[Island + 1] - islandStart[Island];
+	}
+
+	Particle *const *ParticleForceRegistry::GetIslandParticles(unsigned int Island)
+	{
+		buildIslands();
+		return islandParticles.empty() ? NULL : &islandParticles[islandStart[Island]];
+	}
+
+	void ParticleForceRegistry::ApplyIslandForces(unsigned int Island, real dT)
+	{
+		buildIslands();
+
+		GroupProfileScope scope;
+		for(unsigned int b = batchStart[Island]; b < batchStart[Island + 1]; b++)
+		{
+			const IslandBatch &batch = islandBatches[b];
+			ParticleForceGenerator *forceGen = groups[batch.group].forceGen;
+
+			scope.Enter(forceGen);
+			forceGen->ApplyForceBatch(&islandRegistrations[batch.first], batch.count, dT);
+		}
+	}
+
+	void ParticleForceRegistry::UpdateIsland(unsigned int Island, real dT)
+	{
+		buildIslands();
+
+		for(unsigned int p = islandStart[Island]; p < islandStart[Island + 1]; p++)
+		{
+			islandParticles[p]->Update(dT);
+		}
+	}
+
+	void ParticleForceRegistry::SolveIslands(real dT)
+	{
+		HADRON_PROFILE_SCOPE("registry solve islands");
+		buildIslands();
+
+		const unsigned int islands = (unsigned int)islandStart.size() - 1;
+		HADRON_PROFILE_COUNT("islands", islands);
+		HADRON_PROFILE_COUNT("registrations visited", islandRegistrations.size());
+		HADRON_PROFILE_COUNT("particles integrated", islandParticles.size());
+
+		// Nothing's dirty now, so the islands aren't touched again from the threads
+		ParallelFor(pool, 0, islands, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				ApplyIslandForces(i, dT);
+				UpdateIsland(i, dT);
+			}
+		});
+	}
+
+	void ParticleForceRegistry::InvalidateIslands()
+	{
+		linksDirty = true;
+		islandsDirty = true;
+	}
 
-		for(; i != registrations.end(); ++i)
+	void ParticleForceRegistry::SetSubstepping(real MaxGrowth, real MaxTravel, unsigned int MaxSubsteps)
+	{
+		substepGrowth = MaxGrowth;
+		substepTravel = MaxTravel;
+		maxSubsteps = MaxSubsteps > 0 ? MaxSubsteps : 1;
+	}
+
+	void ParticleForceRegistry::SetSubsteps(Particle *P, unsigned int Substeps)
+	{
+		if(Substeps == 0) manualSubsteps.erase(P);
+		else manualSubsteps[P] = Substeps;
+
+		islandsDirty = true;
+	}
+
+	unsigned int ParticleForceRegistry::GetIslandSubsteps(unsigned int Island, real dT)
+	{
+		buildIslands();
+
+		// A link at w with damping d grows by (d^h * (1 + (w * h)^2))^(n / 2) over n substeps of h = dT / n, which
+		// is under e^((w * dT)^2 / 2n) * d^(dT / 2) - so keeping that under 1 + MaxGrowth needs
+		// n >= (w * dT)^2 / (2 * ln(1 + MaxGrowth) - dT * ln(d))
+		const double allowed = 2.0 * log(1.0 + (double)substepGrowth);
+
+		real substeps = (real)1.0;
+		for(unsigned int b = batchStart[Island]; b < batchStart[Island + 1]; b++)
 		{
-			i->forceGen->ApplyForce(i->particle, dT);
+			const IslandBatch &batch = islandBatches[b];
+			const ParticleForceGenerator *forceGen = groups[batch.group].forceGen;
+
+			const real stiffness = forceGen->GetLinkedStiffness();
+			if(stiffness <= (real)0.0) continue;
+
+			const Particle *linked = forceGen->GetLinkedParticle();
+			const real linkedInverseMass = (linked != NULL) ? linked->GetInverseMass() : (real)0.0;
+
+			for(unsigned int r = batch.first; r < batch.first + batch.count; r++)
+			{
+				const Particle *p = islandRegistrations[r];
+				const double frequencySq = (double)stiffness * (double)(p->GetInverseMass() + linkedInverseMass);
+				if(frequencySq <= 0.0) continue;
+
+				// No growth allowed and no damping to take it out, so no number of substeps is enough
+				const double damping = (p->GetDamping() > (real)0.0) ? (double)p->GetDamping() : 1e-30;
+				const double budget = allowed - ((double)dT * log(damping));
+				if(budget <= 0.0) return std::max(maxSubsteps, islandManualSubsteps[Island]);
+
+				substeps = std::max(substeps, (real)ceil(frequencySq * (double)dT * (double)dT / budget));
+			}
+		}
+
+		if(substepTravel > (real)0.0)
+		{
+			real speedSq = (real)0.0;
+			for(unsigned int p = islandStart[Island]; p < islandStart[Island + 1]; p++)
+			{
+				speedSq = std::max(speedSq, islandParticles[p]->GetVelocity().LengthSquared());
+			}
+
+			substeps = std::max(substeps, (real)ceil(dT * (real)sqrt(speedSq) / substepTravel));
+		}
+
+		const unsigned int automatic = (substeps < (real)maxSubsteps) ? (unsigned int)substeps : maxSubsteps;
+		return std::max(automatic, islandManualSubsteps[Island]);
+	}
+
+	void ParticleForceRegistry::SolveIslandsMultiRate(real dT)
+	{
+		HADRON_PROFILE_SCOPE("registry solve islands");
+		buildIslands();
+
+		const unsigned int islands = (unsigned int)islandStart.size() - 1;
+		HADRON_PROFILE_COUNT("islands", islands);
+
+		std::atomic<unsigned long long> integrated(0);
+
+		ParallelFor(pool, 0, islands, [&](unsigned int Begin, unsigned int End)
+		{
+			unsigned long long count = 0;
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				const unsigned int substeps = GetIslandSubsteps(i, dT);
+				const real substep = dT / (real)substeps;
+
+				for(unsigned int s = 0; s < substeps; s++)
+				{
+					ApplyIslandForces(i, substep);
+					UpdateIsland(i, substep);
+				}
+
+				count += (unsigned long long)substeps * (islandStart[i + 1] - islandStart[i]);
+			}
+
+			integrated += count;
+		});
+
+		HADRON_PROFILE_COUNT("particles integrated", integrated.load());
+	}
+
+	ParticleForceRegistry::IntegratorSystem::IntegratorSystem(ParticleForceRegistry &Registry, real DT):
+	registry(Registry),
+	dT(DT),
+	count(0)
+	{
+		registry.buildSchedule();
+		count = (unsigned int)registry.particles.size();
+		if(count == 0) return;
+
+		positions.resize(count * 3);
+		velocities.resize(count * 3);
+		forces.resize(count * 3);
+		damping.resize(count);
+		movable.resize(count);
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			const Particle *p = registry.particles[i];
+
+			positions[i] = p->GetPosition().x;
+			positions[count + i] = p->GetPosition().y;
+			positions[count * 2 + i] = p->GetPosition().z;
+
+			velocities[i] = p->GetVelocity().x;
+			velocities[count + i] = p->GetVelocity().y;
+			velocities[count * 2 + i] = p->GetVelocity().z;
+
+			forces[i] = p->GetForceAccumulator().x;
+			forces[count + i] = p->GetForceAccumulator().y;
+			forces[count * 2 + i] = p->GetForceAccumulator().z;
+
+			damping[i] = real_pow(p->GetDamping(), dT);
+			movable[i] = (p->IsAlive() && p->GetInverseMass() > (real)0.0) ? 1 : 0;
+		}
+	}
+
+	void ParticleForceRegistry::IntegratorSystem::scatter()
+	{
+		for(unsigned int i = 0; i < count; i++)
+		{
+			Particle *p = registry.particles[i];
+			p->SetPosition(positions[i], positions[count + i], positions[count * 2 + i]);
+			p->SetVelocity(velocities[i], velocities[count + i], velocities[count * 2 + i]);
+		}
+	}
+
+	void ParticleForceRegistry::IntegratorSystem::Evaluate(real *AccX, real *AccY, real *AccZ)
+	{
+		scatter();
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			Particle *p = registry.particles[i];
+			p->ClearAccumulator();
+			p->ApplyForce(forces[i], forces[count + i], forces[count * 2 + i]);
+		}
+
+		registry.ApplyForces(dT);
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			if(!movable[i])
+			{
+				AccX[i] = AccY[i] = AccZ[i] = (real)0.0;
+				continue;
+			}
+
+			const Particle *p = registry.particles[i];
+			const real inverseMass = p->GetInverseMass();
+			AccX[i] = p->GetAcceleration().x + (p->GetForceAccumulator().x * inverseMass);
+			AccY[i] = p->GetAcceleration().y + (p->GetForceAccumulator().y * inverseMass);
+			AccZ[i] = p->GetAcceleration().z + (p->GetForceAccumulator().z * inverseMass);
+		}
+	}
+
+	real *ParticleForceRegistry::IntegratorSystem::GetScratch(unsigned int Arrays)
+	{
+		scratch.resize(Arrays * count);
+		return &scratch[0];
+	}
+
+	void ParticleForceRegistry::IntegratorSystem::Commit()
+	{
+		scatter();
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			if(movable[i]) registry.particles[i]->ClearAccumulator();
 		}
 	}
 
@@ -65,6 +804,9 @@ namespace Hadron {
 		// Radius
 		real radiusSquared = (xDiff * xDiff) + (yDiff * yDiff) + (zDiff * zDiff);
 
+		// Sat right on top of the point, there's no direction to pull in
+		if(radiusSquared <= (real)0.0) return;
+
 		// F = -GMm / r^2
 		// + a little modification to make it game-suitable
 		real mass = P->GetMass();
@@ -73,6 +815,20 @@ namespace Hadron {
 		P->ApplyForce(xDiff * force, yDiff * force, zDiff * force);
 	}
 
+	void ParticleGravitation::ApplyForceBatch(Particle *const *P, unsigned int Count, real dT)
+	{
+		// Qualified, so it's a direct call the compiler can inline rather than a virtual one
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			ParticleGravitation::ApplyForce(P[i], dT);
+		}
+	}
+
+	const char *ParticleGravitation::GetName() const
+	{
+		return "gravitation";
+	}
+
 	ParticleDrag::ParticleDrag(real VelCoeff, real VelSqCoeff):
 	k1(VelCoeff),
 	k2(VelSqCoeff)
@@ -80,13 +836,27 @@ namespace Hadron {
 
 	void ParticleDrag::ApplyForce(Particle *P, real dT)
 	{
-		Vector3<real> force = P->GetVelocity();
+		// Direction and speed from one sqrt
+		real speed;
+		const Vector3<real> direction = P->GetVelocity().NormalisedAndLength(speed);
 
 		// Calculate total drag coefficient
-		real dragCoeff = force.Length();
-		dragCoeff = (k1 * dragCoeff) + (k2 * dragCoeff * dragCoeff);
+		const real dragCoeff = (k1 * speed) + (k2 * speed * speed);
+
+		P->ApplyForce(direction * -dragCoeff);
+	}
+
+	void ParticleDrag::ApplyForceBatch(Particle *const *P, unsigned int Count, real dT)
+	{
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			ParticleDrag::ApplyForce(P[i], dT);
+		}
+	}
 
-		P->ApplyForce(force.Normalised() * -dragCoeff);
+	const char *ParticleDrag::GetName() const
+	{
+		return "drag";
 	}
 
 	ParticleSpring::ParticleSpring():
@@ -121,12 +891,182 @@ namespace Hadron {
 		if(other == NULL) return;
 		else if(!P->IsAlive() || !other->IsAlive()) return;
 
-		// Spring's vector
-		Vector3<real> springVec = P->GetPosition() - other->GetPosition();
+		// Spring's direction and length
+		real length;
+		const Vector3<real> direction = (P->GetPosition() - other->GetPosition()).NormalisedAndLength(length);
 
 		// The force to apply
-		Vector3<real> force = springVec.Normalised() * (-k * (springVec.Length() - restLength));
+		P->ApplyForce(direction * (-k * (length - restLength)));
+	}
+
+	void ParticleSpring::ApplyForceBatch(Particle *const *P, unsigned int Count, real dT)
+	{
+		// Same other end for the whole batch, so only check it once
+		if(other == NULL || !other->IsAlive()) return;
+
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			ParticleSpring::ApplyForce(P[i], dT);
+		}
+	}
+
+	Particle *ParticleSpring::GetLinkedParticle() const
+	{
+		return other;
+	}
+
+	real ParticleSpring::GetLinkedStiffness() const
+	{
+		return k;
+	}
+
+	const char *ParticleSpring::GetName() const
+	{
+		return "spring";
+	}
+
+	NBodyGravitation::NBodyGravitation():
+	gravConstant((real)1.0),
+	theta((real)0.5),
+	softening((real)0.01),
+	pool(NULL)
+	{ }
+
+	NBodyGravitation::NBodyGravitation(real GravConstant, real Theta, real Softening):
+	gravConstant(GravConstant),
+	theta(Theta),
+	softening(Softening),
+	pool(NULL)
+	{ }
+
+	void NBodyGravitation::Add(Particle *P)
+	{
+		bodies.push_back(P);
+	}
+
+	void NBodyGravitation::Remove(Particle *P)
+	{
+		std::vector<Particle *>::iterator i = std::find(bodies.begin(), bodies.end(), P);
+		if(i != bodies.end()) bodies.erase(i);
+	}
 
-		P->ApplyForce(force);
+	void NBodyGravitation::Clear()
+	{
+		bodies.clear();
+		tree.Clear();
+	}
+
+	void NBodyGravitation::SetGravitationalConstant(real G)
+	{
+		gravConstant = G;
+	}
+
+	void NBodyGravitation::SetOpeningAngle(real Theta)
+	{
+		theta = Theta;
+	}
+
+	void NBodyGravitation::SetSoftening(real Softening)
+	{
+		softening = Softening;
+	}
+
+	void NBodyGravitation::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	void NBodyGravitation::gather()
+	{
+		const unsigned int count = (unsigned int)bodies.size();
+		posX.resize(count);
+		posY.resize(count);
+		posZ.resize(count);
+		mass.resize(count);
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			const Particle *p = bodies[i];
+			posX[i] = p->GetX();
+			posY[i] = p->GetY();
+			posZ[i] = p->GetZ();
+			mass[i] = (p->IsAlive() && p->GetInverseMass() > (real)0.0) ? p->GetMass() : (real)0.0;
+		}
+	}
+
+	void NBodyGravitation::BuildTree()
+	{
+		HADRON_PROFILE_SCOPE("n-body build tree");
+		gather();
+
+		if(bodies.empty()) tree.Clear();
+		else tree.Build(&posX[0], &posY[0], &posZ[0], &mass[0], (unsigned int)bodies.size(), pool);
+	}
+
+	void NBodyGravitation::ApplyForce(Particle *P, real dT)
+	{
+		if(!P->IsAlive() || P->GetInverseMass() <= (real)0.0) return;
+
+		Vector3<real> field = tree.GetField(P->GetX(), P->GetY(), P->GetZ(), ParticleOctree::NO_BODY, theta, softening * softening);
+		P->ApplyForce(field * (gravConstant * P->GetMass()));
+	}
+
+	const char *NBodyGravitation::GetName() const
+	{
+		return "n-body gravitation";
+	}
+
+	void NBodyGravitation::ApplyForces(real dT)
+	{
+		HADRON_PROFILE_SCOPE("n-body apply forces");
+		BuildTree();
+
+		// Each body only writes its own force accumulator, so the bodies can be split up freely
+		ParallelFor(pool, 0, (unsigned int)bodies.size(), [&](unsigned int Begin, unsigned int End)
+		{
+			const real softeningSq = softening * softening;
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				if(mass[i] <= (real)0.0) continue;
+
+				Vector3<real> field = tree.GetField(posX[i], posY[i], posZ[i], i, theta, softeningSq);
+				bodies[i]->ApplyForce(field * (gravConstant * mass[i]));
+			}
+		});
+	}
+
+	void NBodyGravitation::ApplyForcesBruteForce(real dT)
+	{
+		gather();
+
+		const unsigned int count = (unsigned int)bodies.size();
+		ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+		{
+			const real softeningSq = softening * softening;
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				if(mass[i] <= (real)0.0) continue;
+
+				real fx = (real)0.0, fy = (real)0.0, fz = (real)0.0;
+				for(unsigned int j = 0; j < count; j++)
+				{
+					if(j == i || mass[j] <= (real)0.0) continue;
+
+					const real dx = posX[j] - posX[i];
+					const real dy = posY[j] - posY[i];
+					const real dz = posZ[j] - posZ[i];
+					const real r2 = (dx * dx) + (dy * dy) + (dz * dz) + softeningSq;
+					if(r2 <= (real)0.0) continue;
+
+					const real s = mass[j] / (r2 * (real)sqrt(r2));
+					fx += dx * s;
+					fy += dy * s;
+					fz += dz * s;
+				}
+
+				const real scale = gravConstant * mass[i];
+				bodies[i]->ApplyForce(fx * scale, fy * scale, fz * scale);
+			}
+		});
 	}
 };
\ No newline at end of file
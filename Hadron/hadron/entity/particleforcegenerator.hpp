@@ -1,10 +1,14 @@
 #ifndef HADRON_PARTICLEFORCEGENERATOR_HPP
 #define HADRON_PARTICLEFORCEGENERATOR_HPP
 
-#include <list>
+#include <unordered_map>
+#include <vector>
 
 #include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
 #include "particle.hpp"
+#include "particleintegrator.hpp"
+#include "particleoctree.hpp"
 #include "../math/vector3.hpp"
 
 namespace Hadron {
@@ -13,26 +17,187 @@ namespace Hadron {
 	private:
 
 	public:
+		virtual ~ParticleForceGenerator() { }
+
 		// This method must be overridden
 		// It can use the ApplyForce function on the particle to do what it needs to
 		virtual void ApplyForce(Particle *P, real dT) = 0;
+
+		// Applies the force to Count particles in one go
+		// ^- The registry calls this once per generator with every particle registered to it, so overriding it
+		//    with a tight loop saves a virtual call per particle
+		// ^- By default it just calls ApplyForce on each of them
+		// ^- With a thread pool, the registry can call this from several threads at once on different particles
+		virtual void ApplyForceBatch(Particle *const *P, unsigned int Count, real dT);
+
+		// Name of the generator's type, the registry profiles each group under it
+		// ^- Should be a string literal or otherwise outlive the profiler
+		virtual const char *GetName() const;
+
+		// The other particle this generator reads when it applies its force, NULL (the default) for none
+		// ^- The registry joins each particle registered to it into the same island as this one, so generators
+		//    that read another particle's state must return it here for islands to be solved independently
+		virtual Particle *GetLinkedParticle() const;
+
+		// Stiffness of the link to GetLinkedParticle, force per unit of stretch, 0 (the default) for none
+		// ^- Used to work out how many substeps an island needs to stay stable, see SolveIslandsMultiRate
+		virtual real GetLinkedStiffness() const;
 	};
 
 	class ParticleForceRegistry
 	{
 	private:
-		// An entry in the registry
-		struct ParticleForceRegistration
+		// Every particle registered to one generator, stored contiguously
+		struct GeneratorGroup
 		{
-			Particle *particle;
 			ParticleForceGenerator *forceGen;
+			std::vector<Particle *> particles;
+
+			// Each particle's slot in the registry's particle list, kept in ascending order by buildSchedule
+			// ^- Lets the parallel path find the part of the group that belongs to a range of particles
+			std::vector<unsigned int> slots;
+		};
+
+		// Groups are kept sorted by generator type, so generators of the same type run back to back
+		std::vector<GeneratorGroup> groups;
+		std::unordered_map<ParticleForceGenerator *, unsigned int> groupIndex;
+
+		// Every registered particle once, in the order they first show up in the groups
+		std::vector<Particle *> particles;
+
+		// Pool to run ApplyForces and Update on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Set whenever the registrations change, so the groups get re-sorted and the slots worked out again
+		bool scheduleDirty;
+
+		// The part of one group that falls in a chunk of slots, group.particles[first, first + count)
+		struct ChunkBatch
+		{
+			unsigned int group;
+			unsigned int first;
+			unsigned int count;
 		};
 
-		// List of registrations
-		typedef std::list<ParticleForceRegistration> Registry;
-		Registry registrations;
+		// What the parallel ApplyForces runs, chunk c is chunkBatches[chunkBatchStart[c], chunkBatchStart[c + 1])
+		// ^- Laid out once per schedule, so each chunk only visits the groups it has particles in, rather than
+		//    searching every group every step
+		std::vector<ChunkBatch> chunkBatches;
+		std::vector<unsigned int> chunkBatchStart;
+
+		// Chunk count the batches were laid out for, 0 if they need doing again
+		unsigned int scheduleChunks;
+
+		// Sorts the groups and works out the particle list and slots, if anything's changed
+		void buildSchedule();
+
+		// Splits the groups up between Chunks even chunks of slots, if they aren't already
+		void buildChunks(unsigned int Chunks);
+
+		// Total registrations over every group, for profiling
+		unsigned int countRegistrations() const;
+
+		// Union-find over the registered particles, joined wherever a registration's generator links its particle
+		// to another registered particle
+		// ^- Links to particles that aren't registered yet wait in pendingLinks, keyed by the particle linked to
+		// ^- Adding only ever joins islands, so Add keeps this up to date as it goes, but removing can split them
+		//    and there's no undoing a union, so Remove and Clear set linksDirty to have it all worked out again
+		std::unordered_map<Particle *, unsigned int> islandNode;
+		std::vector<unsigned int> islandParent;
+		std::unordered_multimap<Particle *, Particle *> pendingLinks;
+		bool linksDirty;
+
+		// One generator's registrations within an island, islandRegistrations[first, first + count)
+		struct IslandBatch
+		{
+			unsigned int group;
+			unsigned int first;
+			unsigned int count;
+		};
+
+		// Each island's particles and batches, laid out by buildIslands
+		// ^- Island i is islandParticles[islandStart[i], islandStart[i + 1]), and its batches
+		//    islandBatches[batchStart[i], batchStart[i + 1]) in group order
+		std::vector<Particle *> islandParticles;
+		std::vector<unsigned int> islandStart;
+		std::vector<IslandBatch> islandBatches;
+		std::vector<unsigned int> batchStart;
+		std::vector<Particle *> islandRegistrations;
+		bool islandsDirty;
+
+		// Multi-rate stepping, see SetSubstepping
+		// ^- Manual counts are kept per particle, as island numbers don't last, and gathered per island by
+		//    buildIslands
+		real substepGrowth;
+		real substepTravel;
+		unsigned int maxSubsteps;
+		std::unordered_map<Particle *, unsigned int> manualSubsteps;
+		std::vector<unsigned int> islandManualSubsteps;
+
+		// Returns the particle's node, giving it one and joining up any links waiting on it if it's new
+		unsigned int islandNodeOf(Particle *P);
+
+		// Finds the root of a node's island, halving the path as it goes
+		unsigned int findIslandRoot(unsigned int Node);
+
+		// Joins two nodes' islands, the lower root winning so the result doesn't depend on the order
+		void joinIslands(unsigned int A, unsigned int B);
+
+		// Adds a registration to the union-find
+		void linkRegistration(Particle *P, ParticleForceGenerator *ForceGen);
+
+		// Works the islands out again if anything's changed since the last time
+		void buildIslands();
+
+		// Adapts the registry's particles to the integrator policies' System interface
+		// ^- Gathers their state into arrays to integrate, and puts it back on the particles whenever the forces
+		//    need evaluating and once the step's done
+		class IntegratorSystem
+		{
+		private:
+			ParticleForceRegistry &registry;
+			real dT;
+			unsigned int count;
+
+			// Positions, velocities and external forces, 3 arrays each
+			std::vector<real> positions, velocities, forces;
+			std::vector<real> damping;
+			std::vector<unsigned char> movable;
+			std::vector<real> scratch;
+
+			// Copies the positions and velocities back onto the particles
+			void scatter();
+
+		public:
+			typedef real Scalar;
+
+			IntegratorSystem(ParticleForceRegistry &Registry, real DT);
+
+			unsigned int GetCount() const { return count; }
+
+			real *GetPositionsX() { return &positions[0]; }
+			real *GetPositionsY() { return &positions[count]; }
+			real *GetPositionsZ() { return &positions[count * 2]; }
+			real *GetVelocitiesX() { return &velocities[0]; }
+			real *GetVelocitiesY() { return &velocities[count]; }
+			real *GetVelocitiesZ() { return &velocities[count * 2]; }
+
+			bool IsMovable(unsigned int Index) const { return movable[Index] != 0; }
+
+			void Evaluate(real *AccX, real *AccY, real *AccZ);
+
+			const real *GetDampingFactors() const { return &damping[0]; }
+
+			real *GetScratch(unsigned int Arrays);
+
+			// Puts the final state back on the particles and clears their forces
+			void Commit();
+		};
 
 	public:
+		// Default constructor
+		ParticleForceRegistry();
+
 		// Registers the given force generator and particle
 		void Add(Particle *P, ParticleForceGenerator *ForceGen);
 
@@ -42,8 +207,85 @@ namespace Hadron {
 		// Clears all registrations
 		void Clear();
 
+		// Sets the pool the registry runs on, NULL (the default) runs everything on the calling thread
+		// ^- Particles are split up between threads, so no two threads ever write to the same particle
+		// ^- Every particle still gets its forces in the same order as the serial path, so the results are
+		//    bitwise identical
+		// ^- Generators must only apply forces to the particles they're given - all the built in ones do
+		void SetThreadPool(ThreadPool *Pool);
+
 		// Makes all force generators apply their forces to their respective particles
+		// ^- One ApplyForceBatch call per generator, rather than a virtual call per registration
 		void ApplyForces(real dT);
+
+		// Updates every particle with at least one registration
+		void Update(real dT);
+
+		// Islands are groups of registered particles that no registration links to any particle outside the group
+		// ^- Particles are linked through their generators' GetLinkedParticle, so chains and meshes of
+		//    ParticleSprings each make one island, and a particle with no links is an island by itself
+		// ^- An island's forces and update only read and write its own particles, so islands can be solved in any
+		//    order or at the same time, with the same results as ApplyForces and Update
+		// ^- Islands are numbered in the order their first particles were registered, and renumbered whenever
+		//    the registrations change
+		unsigned int GetIslandCount();
+
+		// The particles in an island, GetIslandSize of them
+		unsigned int GetIslandSize(unsigned int Island);
+		Particle *const *GetIslandParticles(unsigned int Island);
+
+		// Applies the forces on, and updates, just the particles in one island
+		// ^- Lets callers skip islands that are at rest, or step distant ones less often
+		void ApplyIslandForces(unsigned int Island, real dT);
+		void UpdateIsland(unsigned int Island, real dT);
+
+		// Applies the forces and updates every island, each island on one thread of the pool
+		// ^- Same results as ApplyForces then Update, without the threads having to meet up in between
+		// ^- Only as parallel as the islands are even, a single island runs on a single thread
+		void SolveIslands(real dT);
+
+		// Has the islands worked out again from scratch before they're next used
+		// ^- Links are read when particles are registered, so call this after changing what a registered
+		//    generator links to, say with ParticleSpring::SetParentParticle
+		void InvalidateIslands();
+
+		// Sets how SolveIslandsMultiRate picks each island's substep count
+		// ^- Particle::Update's explicit Euler adds energy to a spring at any step size, a factor of 1 + (w * h)^2
+		//    per step of h for a link oscillating at w = sqrt(k * (1 / m1 + 1 / m2)), and only the particle's
+		//    damping takes it back out - so each island takes enough substeps that none of its links' oscillations
+		//    grow by more than MaxGrowth (a fraction) over a whole step, after damping
+		// ^- MaxTravel, if it's above 0, also stops the island's fastest particle going further than that in one
+		//    substep
+		// ^- No island takes more than MaxSubsteps, unless it's been set higher with SetSubsteps
+		// ^- 0.01, 0 and 64 by default
+		void SetSubstepping(real MaxGrowth, real MaxTravel, unsigned int MaxSubsteps);
+
+		// Sets the fewest substeps the particle's island takes, 0 (the default) leaves it to the automatic count
+		void SetSubsteps(Particle *P, unsigned int Substeps);
+
+		// Substeps the island would take for a step of dT, at least 1
+		unsigned int GetIslandSubsteps(unsigned int Island, real dT);
+
+		// Like SolveIslands, but each island's forces and update run as many times as its substep count says,
+		// with the step divided between them
+		// ^- So a few stiff chains among thousands of loose particles only substep the chains, and the cost
+		//    grows with the amount of stiff content rather than with the whole registry
+		// ^- Islands don't read each other's particles, so stepping them at different rates is the same as stepping
+		//    each one on its own
+		void SolveIslandsMultiRate(real dT);
+
+		// Integrates every registered particle forward by dT with the given integrator policy (see particleintegrator.hpp)
+		// ^- Replaces calling ApplyForces then Update, re-evaluating the registry's forces as often as the scheme needs
+		// ^- Forces already applied to the particles before the step are held constant through it
+		template<typename Integrator>
+		void Step(real dT)
+		{
+			IntegratorSystem system(*this, dT);
+			if(system.GetCount() == 0) return;
+
+			Integrator::Step(system, dT);
+			system.Commit();
+		}
 	};
 
 	/*-------------------------------------*\
@@ -59,6 +301,8 @@ namespace Hadron {
 		void SetGravityPosition(const Vector3<real> &Position);
 		void SetGravityPosition(real X, real Y, real Z);
 		void ApplyForce(Particle *P, real dT);
+		void ApplyForceBatch(Particle *const *P, unsigned int Count, real dT);
+		const char *GetName() const;
 	};
 
 	class ParticleDrag : public ParticleForceGenerator
@@ -70,6 +314,8 @@ namespace Hadron {
 	public:
 		ParticleDrag(real VelCoeff, real VelSqCoeff);
 		void ApplyForce(Particle *P, real dT);
+		void ApplyForceBatch(Particle *const *P, unsigned int Count, real dT);
+		const char *GetName() const;
 	};
 
 	class ParticleSpring : public ParticleForceGenerator
@@ -86,6 +332,69 @@ namespace Hadron {
 		void SetSpringConstant(real K);
 		void SetRestLength(real RestLength);
 		void ApplyForce(Particle *P, real dT);
+		void ApplyForceBatch(Particle *const *P, unsigned int Count, real dT);
+		const char *GetName() const;
+		Particle *GetLinkedParticle() const;
+		real GetLinkedStiffness() const;
+	};
+
+	// Mutual gravitation between every pair of bodies, approximated with a Barnes-Hut octree
+	// ^- O(N log N) per step rather than the O(N^2) of registering a generator per pair
+	// ^- Either call ApplyForces once a step, or call BuildTree once a step and register the bodies in a
+	//    ParticleForceRegistry with this as their generator as usual
+	class NBodyGravitation : public ParticleForceGenerator
+	{
+	private:
+		std::vector<Particle *> bodies;
+		ParticleOctree tree;
+
+		// Scratch copies of the bodies' positions and masses for building the tree
+		std::vector<real> posX, posY, posZ, mass;
+
+		real gravConstant;
+		real theta;
+		real softening;
+		ThreadPool *pool;
+
+		// Gathers the bodies' positions and masses into the scratch arrays
+		// ^- Dead and infinite mass bodies get a mass of 0, so they neither pull nor get pulled
+		void gather();
+
+	public:
+		NBodyGravitation();
+		NBodyGravitation(real GravConstant, real Theta, real Softening);
+
+		// Adds and removes bodies from the simulation
+		void Add(Particle *P);
+		void Remove(Particle *P);
+		void Clear();
+
+		// Scales every force, F = G * m1 * m2 / r^2
+		void SetGravitationalConstant(real G);
+
+		// Opening angle, a node is only treated as one body if its width / distance < Theta
+		// ^- 0 gives the exact answer, ~0.5 is the usual trade-off, bigger is faster and rougher
+		void SetOpeningAngle(real Theta);
+
+		// Softening length, stops the force blowing up as two bodies get very close
+		void SetSoftening(real Softening);
+
+		// Pool used to build the tree and work out forces, NULL does it all on the calling thread
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Rebuilds the octree from the bodies' current positions
+		void BuildTree();
+
+		// Applies the force from the last built tree to the given particle
+		void ApplyForce(Particle *P, real dT);
+		const char *GetName() const;
+
+		// Rebuilds the tree and applies forces to every body
+		void ApplyForces(real dT);
+
+		// Applies exact forces to every body by summing over every pair
+		// ^- O(N^2), only meant as a reference to check the tree's accuracy against
+		void ApplyForcesBruteForce(real dT);
 	};
 };
 
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include "particlehashgrid.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	ParticleHashGrid::ParticleHashGrid():
+	cellSize((real)1.0),
+	inverseCellSize((real)1.0),
+	tableMask(0),
+	pool(NULL)
+	{ }
+
+	ParticleHashGrid::ParticleHashGrid(real CellSize):
+	cellSize(CellSize),
+	inverseCellSize((real)1.0 / CellSize),
+	tableMask(0),
+	pool(NULL)
+	{ }
+
+	real ParticleHashGrid::GetCellSize() const
+	{
+		return cellSize;
+	}
+
+	unsigned int ParticleHashGrid::GetCount() const
+	{
+		return (unsigned int)entries.size();
+	}
+
+	void ParticleHashGrid::SetCellSize(real CellSize)
+	{
+		cellSize = CellSize;
+		inverseCellSize = (real)1.0 / CellSize;
+	}
+
+	void ParticleHashGrid::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	void ParticleHashGrid::Clear()
+	{
+		tableMask = 0;
+		bucketStart.clear();
+		bucketOf.clear();
+		entries.clear();
+	}
+
+	void ParticleHashGrid::GetOrder(std::vector<unsigned int> &Order) const
+	{
+		Order.resize(entries.size());
+		for(unsigned int e = 0; e < entries.size(); e++)
+		{
+			Order[e] = entries[e].index;
+		}
+	}
+
+	void ParticleHashGrid::Build(const ParticleWorld &World)
+	{
+		Build(World.GetPositionsX(), World.GetPositionsY(), World.GetPositionsZ(), World.GetAliveFlags(), World.GetCount());
+	}
+
+	void ParticleHashGrid::Build(const real *X, const real *Y, const real *Z, const unsigned char *Alive, unsigned int Count)
+	{
+		HADRON_PROFILE_SCOPE("hash grid build");
+
+		// Around a bucket per particle keeps collisions down without the table falling out of cache
+		unsigned int tableSize = 64;
+		while(tableSize < Count && tableSize < 0x80000000u) tableSize <<= 1;
+		tableMask = tableSize - 1;
+
+		// Hashing is the expensive part, and every particle's independent
+		bucketOf.resize(Count);
+		ParallelFor(pool, 0, Count, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				if(Alive != NULL && !Alive[i])
+				{
+					bucketOf[i] = NOT_IN_GRID;
+					continue;
+				}
+
+				bucketOf[i] = hashCell(cellCoordinate(X[i]), cellCoordinate(Y[i]), cellCoordinate(Z[i]));
+			}
+		});
+
+		// Counting sort into buckets
+		// ^- Serial, so the entries in each bucket always come out in index order
+		bucketStart.assign(tableSize + 1, 0);
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			if(bucketOf[i] != NOT_IN_GRID) bucketStart[bucketOf[i] + 1]++;
+		}
+
+		for(unsigned int h = 0; h < tableSize; h++)
+		{
+			bucketStart[h + 1] += bucketStart[h];
+		}
+
+		entries.resize(bucketStart[tableSize]);
+
+		// Walk the offsets forward as each bucket fills, then shift them back afterwards
+		// ^- Reads the particles in order and writes each entry in one go, rather than gathering from all over
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			if(bucketOf[i] == NOT_IN_GRID) continue;
+
+			Entry &entry = entries[bucketStart[bucketOf[i]]++];
+			entry.x = X[i];
+			entry.y = Y[i];
+			entry.z = Z[i];
+			entry.index = i;
+		}
+
+		for(unsigned int h = tableSize; h > 0; h--)
+		{
+			bucketStart[h] = bucketStart[h - 1];
+		}
+		bucketStart[0] = 0;
+	}
+
+	unsigned int ParticleHashGrid::gatherBuckets(real X, real Y, real Z, real Radius, unsigned int *Buckets) const
+	{
+		return gatherBox(cellCoordinate(X - Radius), cellCoordinate(Y - Radius), cellCoordinate(Z - Radius),
+			cellCoordinate(X + Radius), cellCoordinate(Y + Radius), cellCoordinate(Z + Radius), Buckets);
+	}
+
+	unsigned int ParticleHashGrid::gatherCellBuckets(int X, int Y, int Z, int Reach, unsigned int *Buckets) const
+	{
+		return gatherBox(X - Reach, Y - Reach, Z - Reach, X + Reach, Y + Reach, Z + Reach, Buckets);
+	}
+
+	unsigned int ParticleHashGrid::queryCapacity(real Radius) const
+	{
+		// The box spans at most ceil(2 * Radius / cellSize) + 1 cells a side, and one more covers rounding
+		const double span = ceil(2.0 * (double)Radius * (double)inverseCellSize) + 2.0;
+		const double cells = span * span * span;
+
+		return (cells < (double)tableMask + 1.0) ? (unsigned int)cells : tableMask + 1;
+	}
+
+	unsigned int ParticleHashGrid::cellCapacity(int Reach) const
+	{
+		const double span = 2.0 * (double)Reach + 1.0;
+		const double cells = span * span * span;
+
+		return (cells < (double)tableMask + 1.0) ? (unsigned int)cells : tableMask + 1;
+	}
+
+	unsigned int ParticleHashGrid::gatherBox(int MinX, int MinY, int MinZ, int MaxX, int MaxY, int MaxZ, unsigned int *Buckets) const
+	{
+		const double cells = ((double)MaxX - MinX + 1.0) * ((double)MaxY - MinY + 1.0) * ((double)MaxZ - MinZ + 1.0);
+
+		// Wider than the table, so every bucket's in it at least once
+		if(cells >= (double)tableMask + 1.0)
+		{
+			for(unsigned int h = 0; h <= tableMask; h++) Buckets[h] = h;
+			return tableMask + 1;
+		}
+
+		unsigned int count = 0;
+		for(int z = MinZ; z <= MaxZ; z++)
+		{
+			for(int y = MinY; y <= MaxY; y++)
+			{
+				for(int x = MinX; x <= MaxX; x++)
+				{
+					Buckets[count++] = hashCell(x, y, z);
+				}
+			}
+		}
+
+		std::sort(Buckets, Buckets + count);
+		return (unsigned int)(std::unique(Buckets, Buckets + count) - Buckets);
+	}
+
+	void ParticleHashGrid::FindPairs(real Radius, std::vector<Pair> &Pairs)
+	{
+		HADRON_PROFILE_SCOPE("hash grid find pairs");
+		Pairs.clear();
+
+		const unsigned int count = (unsigned int)entries.size();
+		if(count == 0) return;
+
+		// Split the entries into a fixed number of chunks, each with its own output
+		// ^- Concatenated in chunk order afterwards, so the pairs come out the same however they were run
+		const unsigned int chunks = pool ? std::min(pool->GetThreadCount() * 4, count) : 1;
+		chunkPairs.resize(chunks);
+
+		ParallelFor(pool, 0, chunks, [&](unsigned int ChunkBegin, unsigned int ChunkEnd)
+		{
+			for(unsigned int c = ChunkBegin; c < ChunkEnd; c++)
+			{
+				std::vector<Pair> &out = chunkPairs[c];
+				out.clear();
+
+				const unsigned int begin = (unsigned int)((unsigned long long)count * c / chunks);
+				const unsigned int end = (unsigned int)((unsigned long long)count * (c + 1) / chunks);
+
+				for(unsigned int e = begin; e < end; e++)
+				{
+					const Entry &entry = entries[e];
+					const unsigned int a = entry.index;
+
+					Query(entry.x, entry.y, entry.z, Radius, [&](unsigned int B, real)
+					{
+						// Only the lower index reports the pair
+						if(a < B)
+						{
+							Pair p;
+							p.a = a;
+							p.b = B;
+							out.push_back(p);
+						}
+					});
+				}
+			}
+		});
+
+		size_t total = 0;
+		for(unsigned int c = 0; c < chunks; c++) total += chunkPairs[c].size();
+
+		Pairs.reserve(total);
+		for(unsigned int c = 0; c < chunks; c++)
+		{
+			Pairs.insert(Pairs.end(), chunkPairs[c].begin(), chunkPairs[c].end());
+		}
+	}
+
+	void ParticleHashGrid::FindNeighbours(real Radius, std::vector<unsigned int> &Start, std::vector<unsigned int> &Neighbours)
+	{
+		HADRON_PROFILE_SCOPE("hash grid find neighbours");
+
+		const unsigned int count = (unsigned int)entries.size();
+		Start.assign(count + 1, 0);
+		Neighbours.clear();
+		if(count == 0) return;
+
+		const real radiusSq = Radius * Radius;
+		const int reach = std::max((int)ceil(Radius * inverseCellSize), 0);
+
+		// Same chunking as FindPairs, each chunk's lists are laid end to end in chunk order afterwards
+		const unsigned int chunks = pool ? std::min(pool->GetThreadCount() * 4, count) : 1;
+		chunkNeighbours.resize(chunks);
+
+		ParallelFor(pool, 0, chunks, [&](unsigned int ChunkBegin, unsigned int ChunkEnd)
+		{
+			for(unsigned int c = ChunkBegin; c < ChunkEnd; c++)
+			{
+				std::vector<unsigned int> &out = chunkNeighbours[c];
+				out.clear();
+
+				const unsigned int begin = (unsigned int)((unsigned long long)count * c / chunks);
+				const unsigned int end = (unsigned int)((unsigned long long)count * (c + 1) / chunks);
+
+				// Entries in a cell are next to each other, so the buckets only change when the cell does
+				std::vector<unsigned int> buckets(cellCapacity(reach));
+				unsigned int bucketCount = 0;
+				int lastX = 0, lastY = 0, lastZ = 0;
+
+				for(unsigned int e = begin; e < end; e++)
+				{
+					const Entry &entry = entries[e];
+					const int x = cellCoordinate(entry.x), y = cellCoordinate(entry.y), z = cellCoordinate(entry.z);
+
+					if(e == begin || x != lastX || y != lastY || z != lastZ)
+					{
+						bucketCount = gatherCellBuckets(x, y, z, reach, &buckets[0]);
+						lastX = x;
+						lastY = y;
+						lastZ = z;
+					}
+
+					// Only around one candidate in six is close enough, so every candidate's written and only
+					// the ones that are kept move the end along, rather than branching on each
+					unsigned int candidates = 0;
+					for(unsigned int b = 0; b < bucketCount; b++)
+					{
+						candidates += bucketStart[buckets[b] + 1] - bucketStart[buckets[b]];
+					}
+
+					const size_t first = out.size();
+					out.resize(first + candidates);
+					unsigned int found = 0;
+
+					for(unsigned int b = 0; b < bucketCount; b++)
+					{
+						for(unsigned int f = bucketStart[buckets[b]]; f < bucketStart[buckets[b] + 1]; f++)
+						{
+							const real dx = entries[f].x - entry.x;
+							const real dy = entries[f].y - entry.y;
+							const real dz = entries[f].z - entry.z;
+
+							out[first + found] = f;
+							found += (f != e && (dx * dx) + (dy * dy) + (dz * dz) <= radiusSq) ? 1 : 0;
+						}
+					}
+
+					out.resize(first + found);
+					Start[e + 1] = found;
+				}
+			}
+		});
+
+		for(unsigned int e = 0; e < count; e++)
+		{
+			Start[e + 1] += Start[e];
+		}
+
+		Neighbours.resize(Start[count]);
+
+		ParallelFor(pool, 0, chunks, [&](unsigned int ChunkBegin, unsigned int ChunkEnd)
+		{
+			for(unsigned int c = ChunkBegin; c < ChunkEnd; c++)
+			{
+				const unsigned int begin = (unsigned int)((unsigned long long)count * c / chunks);
+				if(!chunkNeighbours[c].empty())
+				{
+					std::copy(chunkNeighbours[c].begin(), chunkNeighbours[c].end(), Neighbours.begin() + Start[begin]);
+				}
+			}
+		});
+	}
+};
@@ -0,0 +1,178 @@
+#ifndef HADRON_PARTICLEHASHGRID_HPP
+#define HADRON_PARTICLEHASHGRID_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// A uniform grid over a set of particles, hashed into a fixed size table so it covers unbounded space
+	// ^- Rebuilt from scratch every step with a counting sort, so there are no per-cell allocations
+	// ^- Finds everything within a radius of a point, or every pair of particles within a radius of each other
+	// ^- Particles are referred to by the index they were passed to Build with
+	class ParticleHashGrid
+	{
+	public:
+		// Two particles close enough to interact, a is always less than b
+		struct Pair
+		{
+			unsigned int a, b;
+		};
+
+	private:
+		real cellSize;
+		real inverseCellSize;
+
+		// Table size is a power of two, so hashes wrap with a mask
+		unsigned int tableMask;
+
+		// The entries in bucket h are [bucketStart[h], bucketStart[h + 1])
+		std::vector<unsigned int> bucketStart;
+
+		// Bucket of each particle passed to Build, or NOT_IN_GRID
+		std::vector<unsigned int> bucketOf;
+
+		// A particle's position and index, kept together so a query touches one cache line per particle
+		struct Entry
+		{
+			real x, y, z;
+			unsigned int index;
+		};
+
+		// In bucket order, so each bucket is a linear read
+		std::vector<Entry> entries;
+
+		// Pool to run on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Pairs and neighbours found by each chunk, stitched together in order afterwards
+		std::vector<std::vector<Pair> > chunkPairs;
+		std::vector<std::vector<unsigned int> > chunkNeighbours;
+
+		// Cell coordinate along one axis
+		// ^- Rounds towards minus infinity without calling floor, which is most of the cost of a build otherwise
+		int cellCoordinate(real Value) const
+		{
+			const real scaled = Value * inverseCellSize;
+			const int truncated = (int)scaled;
+			return (scaled < (real)truncated) ? truncated - 1 : truncated;
+		}
+
+		// Bucket for a cell
+		unsigned int hashCell(int X, int Y, int Z) const
+		{
+			return (((unsigned int)X * 73856093u) ^ ((unsigned int)Y * 19349663u) ^ ((unsigned int)Z * 83492791u)) & tableMask;
+		}
+
+		// Collects the distinct buckets overlapping the box Radius around (X, Y, Z)
+		// ^- Different cells can hash into the same bucket, so this stops a bucket being visited twice
+		// ^- A box with more cells than the table has buckets just takes every bucket
+		// ^- Returns how many were written to Buckets, which must have room for queryCapacity(Radius)
+		unsigned int gatherBuckets(real X, real Y, real Z, real Radius, unsigned int *Buckets) const;
+
+		// Same, but for the cells up to Reach cells away from cell (X, Y, Z), so it covers any point in that cell
+		// ^- Buckets must have room for cellCapacity(Reach)
+		unsigned int gatherCellBuckets(int X, int Y, int Z, int Reach, unsigned int *Buckets) const;
+
+		// Most buckets the gathers above can write for a radius or a reach
+		unsigned int queryCapacity(real Radius) const;
+		unsigned int cellCapacity(int Reach) const;
+
+		// Buckets for a box of cells, or every bucket if there are fewer of them than cells in the box
+		unsigned int gatherBox(int MinX, int MinY, int MinZ, int MaxX, int MaxY, int MaxZ, unsigned int *Buckets) const;
+
+		static const unsigned int NOT_IN_GRID = 0xFFFFFFFF;
+
+	public:
+		// Default constructor, with a cell size of 1
+		ParticleHashGrid();
+
+		// Constructs a grid with the given cell size
+		// ^- Queries are fastest when the cell size is about the same as the query radius
+		ParticleHashGrid(real CellSize);
+
+		// Getters
+		real GetCellSize() const;
+		unsigned int GetCount() const;
+
+		// Setters
+		// ^- Only takes effect on the next Build
+		void SetCellSize(real CellSize);
+
+		// Sets the pool to build and find pairs on, NULL (the default) runs everything serially
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Rebuilds the grid over Count particles
+		// ^- Particles with a zero alive flag are left out, pass NULL to include everything
+		void Build(const real *X, const real *Y, const real *Z, const unsigned char *Alive, unsigned int Count);
+
+		// Rebuilds the grid over every live particle in the world
+		void Build(const ParticleWorld &World);
+
+		// Empties the grid
+		void Clear();
+
+		// Fills Order with the index of every particle in the grid, in bucket order
+		// ^- Particles in the same cell come out next to each other, so working through them in this order
+		//    keeps neighbours close together in memory
+		void GetOrder(std::vector<unsigned int> &Order) const;
+
+		// Calls Fn(Index, DistanceSquared) for every particle within Radius of (X, Y, Z)
+		// ^- Any radius works, but ones wider than MAX_QUERY_CELLS cell sizes allocate, and visit a lot of buckets
+		template<typename Function>
+		void Query(real X, real Y, real Z, real Radius, Function Fn) const
+		{
+			if(entries.empty()) return;
+
+			unsigned int stackBuckets[MAX_QUERY_BUCKETS];
+			std::vector<unsigned int> wideBuckets;
+			unsigned int *buckets = stackBuckets;
+
+			const unsigned int capacity = queryCapacity(Radius);
+			if(capacity > MAX_QUERY_BUCKETS)
+			{
+				wideBuckets.resize(capacity);
+				buckets = &wideBuckets[0];
+			}
+
+			const unsigned int count = gatherBuckets(X, Y, Z, Radius, buckets);
+			const real radiusSq = Radius * Radius;
+
+			for(unsigned int b = 0; b < count; b++)
+			{
+				for(unsigned int e = bucketStart[buckets[b]]; e < bucketStart[buckets[b] + 1]; e++)
+				{
+					const Entry &entry = entries[e];
+					const real dx = entry.x - X;
+					const real dy = entry.y - Y;
+					const real dz = entry.z - Z;
+					const real distanceSq = (dx * dx) + (dy * dy) + (dz * dz);
+
+					if(distanceSq <= radiusSq) Fn(entry.index, distanceSq);
+				}
+			}
+		}
+
+		// Finds every pair of particles in the grid within Radius of each other
+		// ^- Each pair comes out once, and always in the same order whatever the thread count
+		// ^- Any radius works, though it's fastest around the cell size, see Query
+		void FindPairs(real Radius, std::vector<Pair> &Pairs);
+
+		// Finds every particle's neighbours within Radius, as CSR lists in the order GetOrder gives
+		// ^- The neighbours of the e'th particle in that order are Neighbours[Start[e], Start[e + 1]), given as
+		//    places in that same order, and never include the particle itself
+		// ^- Particles in the same cell share one bucket lookup, which is most of the cost of a query otherwise
+		// ^- Each list always comes out in the same order whatever the thread count
+		// ^- Any radius works, though it's fastest around the cell size
+		void FindNeighbours(real Radius, std::vector<unsigned int> &Start, std::vector<unsigned int> &Neighbours);
+
+		// Widest query that gathers its buckets on the stack, in cells either side of the centre
+		// ^- Another cell a side allows for the box not lining up with the cells
+		static const int MAX_QUERY_CELLS = 2;
+		static const unsigned int MAX_QUERY_BUCKETS = (2 * MAX_QUERY_CELLS + 2) * (2 * MAX_QUERY_CELLS + 2) * (2 * MAX_QUERY_CELLS + 2);
+	};
+};
+
+#endif // HADRON_PARTICLEHASHGRID_HPP
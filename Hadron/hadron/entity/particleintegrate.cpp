@@ -0,0 +1,105 @@
+#include "../core/cpu.hpp"
+#include "particleintegrate.hpp"
+#include "particleintegratekernel.hpp"
+#include "../math/packet_sse2.hpp"
+
+namespace Hadron {
+	namespace {
+		template<typename T, typename F>
+		void integrateScalar(const ParticleIntegrateArrays<T, F> &A, unsigned int Count, T dT)
+		{
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				// Dead particles and infinite masses don't move
+				if(!A.alive[i] || A.inverseMass[i] <= (T)0.0) continue;
+
+				// Update the linear position
+				A.posX[i] = A.posX[i] + A.velX[i] * dT;
+				A.posY[i] = A.posY[i] + A.velY[i] * dT;
+				A.posZ[i] = A.posZ[i] + A.velZ[i] * dT;
+
+				// Work out acceleration from forces on the particle, update velocity and add on drag
+				// ^- With wider forces this is all done in F and rounded back to T once
+				A.velX[i] = (T)((A.velX[i] + (A.accX[i] + A.forceX[i] * A.inverseMass[i]) * dT) * A.dampingFactor[i]);
+				A.velY[i] = (T)((A.velY[i] + (A.accY[i] + A.forceY[i] * A.inverseMass[i]) * dT) * A.dampingFactor[i]);
+				A.velZ[i] = (T)((A.velZ[i] + (A.accZ[i] + A.forceZ[i] * A.inverseMass[i]) * dT) * A.dampingFactor[i]);
+
+				// Clear forces
+				A.forceX[i] = (F)0.0;
+				A.forceY[i] = (F)0.0;
+				A.forceZ[i] = (F)0.0;
+			}
+		}
+
+		template<typename T>
+		void integrateDispatch(const ParticleIntegrateArrays<T> &A, unsigned int Count, T dT)
+		{
+			switch(GetSimdLevel())
+			{
+			case(SIMD_AVX2):
+				IntegrateParticlesAVX2(A, Count, dT);
+				break;
+
+			case(SIMD_SSE2):
+				IntegrateParticlesSSE2(A, Count, dT);
+				break;
+
+			default:
+				IntegrateParticlesScalar(A, Count, dT);
+			}
+		}
+	}
+
+	void IntegrateParticles(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT)
+	{
+		integrateDispatch(Arrays, Count, dT);
+	}
+
+	void IntegrateParticles(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT)
+	{
+		integrateDispatch(Arrays, Count, dT);
+	}
+
+	void IntegrateParticles(const ParticleIntegrateArrays<float, double> &Arrays, unsigned int Count, float dT)
+	{
+		integrateScalar(Arrays, Count, dT);
+	}
+
+	void IntegrateParticlesScalar(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT)
+	{
+		integrateScalar(Arrays, Count, dT);
+	}
+
+	void IntegrateParticlesScalar(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT)
+	{
+		integrateScalar(Arrays, Count, dT);
+	}
+
+	void IntegrateParticlesScalar(const ParticleIntegrateArrays<float, double> &Arrays, unsigned int Count, float dT)
+	{
+		integrateScalar(Arrays, Count, dT);
+	}
+
+#if defined(HADRON_ARCH_X86)
+	void IntegrateParticlesSSE2(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT)
+	{
+		IntegrateParticlePackets<PacketSSE2f>(Arrays, Count, dT);
+	}
+
+	void IntegrateParticlesSSE2(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT)
+	{
+		IntegrateParticlePackets<PacketSSE2d>(Arrays, Count, dT);
+	}
+#else
+	// No SSE2 here, GetSimdLevel never picks it but keep the symbols around anyway
+	void IntegrateParticlesSSE2(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT)
+	{
+		integrateScalar(Arrays, Count, dT);
+	}
+
+	void IntegrateParticlesSSE2(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT)
+	{
+		integrateScalar(Arrays, Count, dT);
+	}
+#endif
+};
@@ -0,0 +1,45 @@
+#ifndef HADRON_PARTICLEINTEGRATE_HPP
+#define HADRON_PARTICLEINTEGRATE_HPP
+
+#include "../core/precision.hpp"
+
+namespace Hadron {
+	// Everything the batched integrate kernels need, as raw structure of arrays pointers
+	// ^- Every pointer points at the first particle to integrate
+	// ^- T is the storage scalar and F the one forces are accumulated in, which can be wider
+	template<typename T, typename F = T>
+	struct ParticleIntegrateArrays
+	{
+		T *posX, *posY, *posZ;
+		T *velX, *velY, *velZ;
+		const T *accX, *accY, *accZ;
+		F *forceX, *forceY, *forceZ;
+
+		// damping^dT, worked out up front so the kernels don't need a pow per particle
+		const T *dampingFactor;
+
+		const T *inverseMass;
+		const unsigned char *alive;
+	};
+
+	// Integrates Count particles forward by dT, the same way Particle::integrate does
+	// ^- Dispatches to the widest kernel GetSimdLevel allows
+	void IntegrateParticles(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT);
+	void IntegrateParticles(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT);
+
+	// Mixed precision, float state with double forces
+	// ^- Always runs the scalar kernel, the velocity update's done in double and rounded once at the end
+	void IntegrateParticles(const ParticleIntegrateArrays<float, double> &Arrays, unsigned int Count, float dT);
+
+	// The individual kernels
+	// ^- Only call the SSE2 and AVX2 ones directly if you've checked GetSupportedSimdLevel yourself
+	void IntegrateParticlesScalar(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT);
+	void IntegrateParticlesScalar(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT);
+	void IntegrateParticlesScalar(const ParticleIntegrateArrays<float, double> &Arrays, unsigned int Count, float dT);
+	void IntegrateParticlesSSE2(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT);
+	void IntegrateParticlesSSE2(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT);
+	void IntegrateParticlesAVX2(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT);
+	void IntegrateParticlesAVX2(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT);
+};
+
+#endif // HADRON_PARTICLEINTEGRATE_HPP
@@ -0,0 +1,43 @@
+// Everything in this file is built for AVX2, and is only ever called once cpu.hpp says the CPU can run it
+// ^- Keep includes down to the bare minimum - any inline function defined in a header pulled in here
+//    could get compiled with AVX2 and then picked by the linker for code that runs everywhere
+// ^- FMA is left off on purpose, so this kernel rounds exactly like the SSE2 and scalar ones
+#if defined(__clang__)
+	#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+	#pragma GCC target("avx2")
+#endif
+
+#include "../core/cpu.hpp"
+#include "particleintegrate.hpp"
+#include "particleintegratekernel.hpp"
+#include "../math/packet_avx2.hpp"
+
+namespace Hadron {
+#if defined(HADRON_ARCH_X86)
+	void IntegrateParticlesAVX2(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT)
+	{
+		IntegrateParticlePackets<PacketAVX2f>(Arrays, Count, dT);
+	}
+
+	void IntegrateParticlesAVX2(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT)
+	{
+		IntegrateParticlePackets<PacketAVX2d>(Arrays, Count, dT);
+	}
+#else
+	// No AVX2 here, GetSimdLevel never picks it but keep the symbols around anyway
+	void IntegrateParticlesAVX2(const ParticleIntegrateArrays<float> &Arrays, unsigned int Count, float dT)
+	{
+		IntegrateParticlesScalar(Arrays, Count, dT);
+	}
+
+	void IntegrateParticlesAVX2(const ParticleIntegrateArrays<double> &Arrays, unsigned int Count, double dT)
+	{
+		IntegrateParticlesScalar(Arrays, Count, dT);
+	}
+#endif
+};
+
+#if defined(__clang__)
+	#pragma clang attribute pop
+#endif
@@ -0,0 +1,58 @@
+#ifndef HADRON_PARTICLEINTEGRATEKERNEL_HPP
+#define HADRON_PARTICLEINTEGRATEKERNEL_HPP
+
+// The packet kernel shared by the SSE2 and AVX2 builds
+// ^- Only meant to be included by the kernel translation units themselves
+
+#include "particleintegrate.hpp"
+#include "../math/vector3packet.hpp"
+
+namespace Hadron {
+	// Integrates Count particles a packet at a time, handing any leftover particles to the scalar kernel
+	// ^- Particles that are dead or have infinite mass are masked off rather than branched around
+	template<typename P>
+	void IntegrateParticlePackets(const ParticleIntegrateArrays<typename P::Scalar> &A, unsigned int Count, typename P::Scalar dT)
+	{
+		typedef typename P::Scalar T;
+		typedef Vector3Packet<P> V;
+
+		const P step(dT);
+		const P zero((T)0);
+
+		unsigned int i = 0;
+		for(; i + P::WIDTH <= Count; i += P::WIDTH)
+		{
+			const P invMass = P::Load(A.inverseMass + i);
+			const P moving = P::And(P::LoadFlags(A.alive + i), P::Greater(invMass, zero));
+
+			const V pos = V::Load(A.posX + i, A.posY + i, A.posZ + i);
+			const V vel = V::Load(A.velX + i, A.velY + i, A.velZ + i);
+			const V acc = V::Load(A.accX + i, A.accY + i, A.accZ + i);
+			const V force = V::Load(A.forceX + i, A.forceY + i, A.forceZ + i);
+
+			// Same operations in the same order as the scalar kernel, so every path gives the same answer
+			const V newPos = pos + vel * step;
+			const V newVel = (vel + (acc + force * invMass) * step) * P::Load(A.dampingFactor + i);
+
+			V::Select(moving, newPos, pos).Store(A.posX + i, A.posY + i, A.posZ + i);
+			V::Select(moving, newVel, vel).Store(A.velX + i, A.velY + i, A.velZ + i);
+			V::Select(moving, V(), force).Store(A.forceX + i, A.forceY + i, A.forceZ + i);
+		}
+
+		if(i < Count)
+		{
+			ParticleIntegrateArrays<T> tail = A;
+			tail.posX += i; tail.posY += i; tail.posZ += i;
+			tail.velX += i; tail.velY += i; tail.velZ += i;
+			tail.accX += i; tail.accY += i; tail.accZ += i;
+			tail.forceX += i; tail.forceY += i; tail.forceZ += i;
+			tail.dampingFactor += i;
+			tail.inverseMass += i;
+			tail.alive += i;
+
+			IntegrateParticlesScalar(tail, Count - i, dT);
+		}
+	}
+};
+
+#endif // HADRON_PARTICLEINTEGRATEKERNEL_HPP
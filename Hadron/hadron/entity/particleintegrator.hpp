@@ -0,0 +1,225 @@
+#ifndef HADRON_PARTICLEINTEGRATOR_HPP
+#define HADRON_PARTICLEINTEGRATOR_HPP
+
+#include "../core/precision.hpp"
+
+namespace Hadron {
+	// Integrator policies, for ParticleWorld::Step<Integrator> and ParticleForceRegistry::Step<Integrator>
+	// ^- Each one is a struct with a static Step(System, dT), picked at compile time so there's no dispatch per particle
+	// ^- A System is whatever's being stepped, and provides:
+	//      typedef Scalar - the scalar type the state is stored in
+	//      unsigned int GetCount()
+	//      Scalar *GetPositionsX/Y/Z(), Scalar *GetVelocitiesX/Y/Z()
+	//      bool IsMovable(i) - false for dead and infinite mass particles, which are left alone
+	//      void Evaluate(AccX, AccY, AccZ) - recomputes every force at the current positions and velocities,
+	//                                         and writes out the resulting accelerations
+	//      const Scalar *GetDampingFactors() - damping^dT per particle
+	//      Scalar *GetScratch(Arrays) - Arrays * GetCount() Scalars of scratch space
+	// ^- Every scheme applies damping to the velocity at the end of the step, the same as Particle does
+
+	// Position with the old velocity, then velocity with the old acceleration
+	// ^- What Particle::Update has always done, first order and not symplectic, so orbits slowly spiral out
+	// ^- One force evaluation per step
+	struct ExplicitEuler
+	{
+		static const unsigned int EVALUATIONS = 1;
+
+		template<typename System>
+		static void Step(System &S, typename System::Scalar dT)
+		{
+			typedef typename System::Scalar T;
+
+			const unsigned int count = S.GetCount();
+			T *scratch = S.GetScratch(3);
+			T *accX = scratch, *accY = scratch + count, *accZ = scratch + count * 2;
+
+			S.Evaluate(accX, accY, accZ);
+
+			T *posX = S.GetPositionsX(), *posY = S.GetPositionsY(), *posZ = S.GetPositionsZ();
+			T *velX = S.GetVelocitiesX(), *velY = S.GetVelocitiesY(), *velZ = S.GetVelocitiesZ();
+			const T *damping = S.GetDampingFactors();
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(!S.IsMovable(i)) continue;
+
+				posX[i] += velX[i] * dT;
+				posY[i] += velY[i] * dT;
+				posZ[i] += velZ[i] * dT;
+
+				velX[i] = (velX[i] + (accX[i] * dT)) * damping[i];
+				velY[i] = (velY[i] + (accY[i] * dT)) * damping[i];
+				velZ[i] = (velZ[i] + (accZ[i] * dT)) * damping[i];
+			}
+		}
+	};
+
+	// Velocity first, then position with the new velocity
+	// ^- Same cost as ExplicitEuler but symplectic, so energy wobbles about rather than drifting off
+	// ^- One force evaluation per step
+	struct SymplecticEuler
+	{
+		static const unsigned int EVALUATIONS = 1;
+
+		template<typename System>
+		static void Step(System &S, typename System::Scalar dT)
+		{
+			typedef typename System::Scalar T;
+
+			const unsigned int count = S.GetCount();
+			T *scratch = S.GetScratch(3);
+			T *accX = scratch, *accY = scratch + count, *accZ = scratch + count * 2;
+
+			S.Evaluate(accX, accY, accZ);
+
+			T *posX = S.GetPositionsX(), *posY = S.GetPositionsY(), *posZ = S.GetPositionsZ();
+			T *velX = S.GetVelocitiesX(), *velY = S.GetVelocitiesY(), *velZ = S.GetVelocitiesZ();
+			const T *damping = S.GetDampingFactors();
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(!S.IsMovable(i)) continue;
+
+				velX[i] = (velX[i] + (accX[i] * dT)) * damping[i];
+				velY[i] = (velY[i] + (accY[i] * dT)) * damping[i];
+				velZ[i] = (velZ[i] + (accZ[i] * dT)) * damping[i];
+
+				posX[i] += velX[i] * dT;
+				posY[i] += velY[i] * dT;
+				posZ[i] += velZ[i] * dT;
+			}
+		}
+	};
+
+	// Velocity Verlet, second order and symplectic
+	// ^- Two force evaluations per step, as forces are recomputed from scratch rather than carried over from the
+	//    last step - something else may well have changed them in between
+	// ^- The second evaluation sees the new positions with the old velocities, so velocity dependent forces like
+	//    drag are only first order
+	struct VelocityVerlet
+	{
+		static const unsigned int EVALUATIONS = 2;
+
+		template<typename System>
+		static void Step(System &S, typename System::Scalar dT)
+		{
+			typedef typename System::Scalar T;
+
+			const unsigned int count = S.GetCount();
+			T *scratch = S.GetScratch(6);
+			T *accX = scratch, *accY = scratch + count, *accZ = scratch + count * 2;
+			T *nextX = scratch + count * 3, *nextY = scratch + count * 4, *nextZ = scratch + count * 5;
+
+			T *posX = S.GetPositionsX(), *posY = S.GetPositionsY(), *posZ = S.GetPositionsZ();
+			T *velX = S.GetVelocitiesX(), *velY = S.GetVelocitiesY(), *velZ = S.GetVelocitiesZ();
+
+			S.Evaluate(accX, accY, accZ);
+
+			const T halfSq = (T)0.5 * dT * dT;
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(!S.IsMovable(i)) continue;
+
+				posX[i] += (velX[i] * dT) + (accX[i] * halfSq);
+				posY[i] += (velY[i] * dT) + (accY[i] * halfSq);
+				posZ[i] += (velZ[i] * dT) + (accZ[i] * halfSq);
+			}
+
+			S.Evaluate(nextX, nextY, nextZ);
+
+			const T half = (T)0.5 * dT;
+			const T *damping = S.GetDampingFactors();
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(!S.IsMovable(i)) continue;
+
+				velX[i] = (velX[i] + ((accX[i] + nextX[i]) * half)) * damping[i];
+				velY[i] = (velY[i] + ((accY[i] + nextY[i]) * half)) * damping[i];
+				velZ[i] = (velZ[i] + ((accZ[i] + nextZ[i]) * half)) * damping[i];
+			}
+		}
+	};
+
+	// Classic fourth order Runge-Kutta
+	// ^- Four force evaluations per step, each at a trial state, so it's by far the most accurate for smooth forces
+	//    but costs four times as much and isn't symplectic
+	struct RungeKutta4
+	{
+		static const unsigned int EVALUATIONS = 4;
+
+		template<typename System>
+		static void Step(System &S, typename System::Scalar dT)
+		{
+			typedef typename System::Scalar T;
+
+			const unsigned int count = S.GetCount();
+
+			// Start state, weighted sums of the slopes, and the acceleration from the latest evaluation
+			T *scratch = S.GetScratch(15);
+			T *startPX = scratch, *startPY = scratch + count, *startPZ = scratch + count * 2;
+			T *startVX = scratch + count * 3, *startVY = scratch + count * 4, *startVZ = scratch + count * 5;
+			T *sumPX = scratch + count * 6, *sumPY = scratch + count * 7, *sumPZ = scratch + count * 8;
+			T *sumVX = scratch + count * 9, *sumVY = scratch + count * 10, *sumVZ = scratch + count * 11;
+			T *accX = scratch + count * 12, *accY = scratch + count * 13, *accZ = scratch + count * 14;
+
+			T *posX = S.GetPositionsX(), *posY = S.GetPositionsY(), *posZ = S.GetPositionsZ();
+			T *velX = S.GetVelocitiesX(), *velY = S.GetVelocitiesY(), *velZ = S.GetVelocitiesZ();
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				startPX[i] = posX[i]; startPY[i] = posY[i]; startPZ[i] = posZ[i];
+				startVX[i] = velX[i]; startVY[i] = velY[i]; startVZ[i] = velZ[i];
+				sumPX[i] = sumPY[i] = sumPZ[i] = (T)0.0;
+				sumVX[i] = sumVY[i] = sumVZ[i] = (T)0.0;
+			}
+
+			// Each stage's slope is weighted 1, 2, 2, 1, and the next trial state is half, half then a whole step on
+			const T WEIGHTS[4] = { (T)1.0, (T)2.0, (T)2.0, (T)1.0 };
+			const T OFFSETS[3] = { (T)0.5, (T)0.5, (T)1.0 };
+
+			for(unsigned int stage = 0; stage < 4; stage++)
+			{
+				S.Evaluate(accX, accY, accZ);
+
+				const T weight = WEIGHTS[stage];
+				const T offset = (stage < 3) ? OFFSETS[stage] * dT : (T)0.0;
+
+				for(unsigned int i = 0; i < count; i++)
+				{
+					if(!S.IsMovable(i)) continue;
+
+					// Position's slope is the velocity, velocity's is the acceleration
+					sumPX[i] += velX[i] * weight; sumPY[i] += velY[i] * weight; sumPZ[i] += velZ[i] * weight;
+					sumVX[i] += accX[i] * weight; sumVY[i] += accY[i] * weight; sumVZ[i] += accZ[i] * weight;
+
+					if(stage == 3) continue;
+
+					const T slopeVX = velX[i], slopeVY = velY[i], slopeVZ = velZ[i];
+					velX[i] = startVX[i] + (accX[i] * offset);
+					velY[i] = startVY[i] + (accY[i] * offset);
+					velZ[i] = startVZ[i] + (accZ[i] * offset);
+					posX[i] = startPX[i] + (slopeVX * offset);
+					posY[i] = startPY[i] + (slopeVY * offset);
+					posZ[i] = startPZ[i] + (slopeVZ * offset);
+				}
+			}
+
+			const T sixth = dT / (T)6.0;
+			const T *damping = S.GetDampingFactors();
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(!S.IsMovable(i)) continue;
+
+				posX[i] = startPX[i] + (sumPX[i] * sixth);
+				posY[i] = startPY[i] + (sumPY[i] * sixth);
+				posZ[i] = startPZ[i] + (sumPZ[i] * sixth);
+
+				velX[i] = (startVX[i] + (sumVX[i] * sixth)) * damping[i];
+				velY[i] = (startVY[i] + (sumVY[i] * sixth)) * damping[i];
+				velZ[i] = (startVZ[i] + (sumVZ[i] * sixth)) * damping[i];
+			}
+		}
+	};
+};
+
+#endif // HADRON_PARTICLEINTEGRATOR_HPP
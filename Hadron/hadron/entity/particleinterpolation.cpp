@@ -0,0 +1,132 @@
+#include "particleinterpolation.hpp"
+
+namespace Hadron {
+	ParticleInterpolation::ParticleInterpolation()
+	{ }
+
+	void ParticleInterpolation::resize(unsigned int Count)
+	{
+		blendedX.resize(Count);
+		blendedY.resize(Count);
+		blendedZ.resize(Count);
+	}
+
+	void ParticleInterpolation::Capture(const ParticleWorld &World)
+	{
+		const unsigned int count = World.GetCount();
+		previousX.assign(World.GetPositionsX(), World.GetPositionsX() + count);
+		previousY.assign(World.GetPositionsY(), World.GetPositionsY() + count);
+		previousZ.assign(World.GetPositionsZ(), World.GetPositionsZ() + count);
+	}
+
+	void ParticleInterpolation::Capture(Particle *const *P, unsigned int Count)
+	{
+		previousX.resize(Count);
+		previousY.resize(Count);
+		previousZ.resize(Count);
+
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			previousX[i] = P[i]->GetX();
+			previousY[i] = P[i]->GetY();
+			previousZ[i] = P[i]->GetZ();
+		}
+	}
+
+	void ParticleInterpolation::Interpolate(const ParticleWorld &World, real Alpha)
+	{
+		const unsigned int count = World.GetCount();
+		const unsigned int captured = ((unsigned int)previousX.size() < count) ? (unsigned int)previousX.size() : count;
+		const real *posX = World.GetPositionsX();
+		const real *posY = World.GetPositionsY();
+		const real *posZ = World.GetPositionsZ();
+
+		resize(count);
+
+		for(unsigned int i = 0; i < captured; i++)
+		{
+			blendedX[i] = previousX[i] + ((posX[i] - previousX[i]) * Alpha);
+			blendedY[i] = previousY[i] + ((posY[i] - previousY[i]) * Alpha);
+			blendedZ[i] = previousZ[i] + ((posZ[i] - previousZ[i]) * Alpha);
+		}
+
+		for(unsigned int i = captured; i < count; i++)
+		{
+			blendedX[i] = posX[i];
+			blendedY[i] = posY[i];
+			blendedZ[i] = posZ[i];
+		}
+	}
+
+	void ParticleInterpolation::Interpolate(Particle *const *P, unsigned int Count, real Alpha)
+	{
+		const unsigned int captured = ((unsigned int)previousX.size() < Count) ? (unsigned int)previousX.size() : Count;
+
+		resize(Count);
+
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			const real x = P[i]->GetX(), y = P[i]->GetY(), z = P[i]->GetZ();
+
+			if(i < captured)
+			{
+				blendedX[i] = previousX[i] + ((x - previousX[i]) * Alpha);
+				blendedY[i] = previousY[i] + ((y - previousY[i]) * Alpha);
+				blendedZ[i] = previousZ[i] + ((z - previousZ[i]) * Alpha);
+			}
+			else
+			{
+				blendedX[i] = x;
+				blendedY[i] = y;
+				blendedZ[i] = z;
+			}
+		}
+	}
+
+	void ParticleInterpolation::Clear()
+	{
+		previousX.clear();
+		previousY.clear();
+		previousZ.clear();
+		blendedX.clear();
+		blendedY.clear();
+		blendedZ.clear();
+	}
+
+	void ParticleInterpolation::RemapParticles(const unsigned int *NewIndex, unsigned int Count)
+	{
+		if(previousX.size() != Count)
+		{
+			Clear();
+			return;
+		}
+
+		std::vector<real> *fields[3] = { &previousX, &previousY, &previousZ };
+		for(unsigned int f = 0; f < 3; f++)
+		{
+			std::vector<real> &field = *fields[f];
+			remapped.resize(Count);
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				remapped[NewIndex[i]] = field[i];
+			}
+
+			field.swap(remapped);
+		}
+	}
+
+	unsigned int ParticleInterpolation::GetCount() const
+	{
+		return (unsigned int)blendedX.size();
+	}
+
+	Vector3<real> ParticleInterpolation::GetPosition(unsigned int Index) const
+	{
+		return Vector3<real>(blendedX[Index], blendedY[Index], blendedZ[Index]);
+	}
+
+	const real *ParticleInterpolation::GetPositionsX() const { return blendedX.empty() ? NULL : &blendedX[0]; }
+	const real *ParticleInterpolation::GetPositionsY() const { return blendedY.empty() ? NULL : &blendedY[0]; }
+	const real *ParticleInterpolation::GetPositionsZ() const { return blendedZ.empty() ? NULL : &blendedZ[0]; }
+};
@@ -0,0 +1,61 @@
+#ifndef HADRON_PARTICLEINTERPOLATION_HPP
+#define HADRON_PARTICLEINTERPOLATION_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../math/vector3.hpp"
+#include "particle.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// Blends particle positions between the last two fixed steps, for rendering
+	// ^- Capture the positions just before the last step of a frame, then Interpolate with the stepper's alpha
+	// ^- Works on either a ParticleWorld or a list of Particles, as long as the same one is used for both calls
+	// ^- Particles added since the last capture just use their current position
+	// ^- Register it as a remap listener on the world if the world's reordered between a capture and an interpolation
+	class ParticleInterpolation : public ParticleRemapListener
+	{
+	private:
+		// Positions as of the last capture
+		std::vector<real> previousX, previousY, previousZ;
+
+		// Positions from the last interpolation
+		std::vector<real> blendedX, blendedY, blendedZ;
+
+		// Sizes the blended arrays for Count particles
+		void resize(unsigned int Count);
+
+		// Scratch for RemapParticles
+		std::vector<real> remapped;
+
+	public:
+		// Default constructor
+		ParticleInterpolation();
+
+		// Remembers where every particle is now
+		void Capture(const ParticleWorld &World);
+		void Capture(Particle *const *P, unsigned int Count);
+
+		// Works out positions Alpha of the way from the captured ones to the current ones
+		void Interpolate(const ParticleWorld &World, real Alpha);
+		void Interpolate(Particle *const *P, unsigned int Count, real Alpha);
+
+		// Forgets the captured positions
+		void Clear();
+
+		// Moves the captured positions to their particles' new indices after the world's been reordered
+		// ^- If particles were added since the capture it's forgotten instead, and the next frame isn't blended
+		void RemapParticles(const unsigned int *NewIndex, unsigned int Count);
+
+		// Getters
+		// ^- Only valid after Interpolate
+		unsigned int GetCount() const;
+		Vector3<real> GetPosition(unsigned int Index) const;
+		const real *GetPositionsX() const;
+		const real *GetPositionsY() const;
+		const real *GetPositionsZ() const;
+	};
+};
+
+#endif // HADRON_PARTICLEINTERPOLATION_HPP
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include "particlemortonsort.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	namespace {
+		// Cells a side of the bounding box, as a power of 2, so three coordinates interleave into 30 bits
+		const unsigned int CELL_BITS = 10;
+		const unsigned int CELLS = 1u << CELL_BITS;
+
+		// Above every live particle's key
+		const unsigned int DEAD_KEY = 1u << (CELL_BITS * 3);
+
+		// 3 passes of 11 bits covers the 31 bits a key can use, with a pass's counts small enough to stay in cache
+		const unsigned int DIGIT_BITS = 11;
+		const unsigned int RADIX = 1u << DIGIT_BITS;
+		const unsigned int PASSES = 3;
+
+		// Spreads the low 10 bits of V out with two zero bits between each, ready to interleave
+		unsigned int spreadBits(unsigned int V)
+		{
+			V &= CELLS - 1;
+			V = (V | (V << 16)) & 0x030000FF;
+			V = (V | (V << 8)) & 0x0300F00F;
+			V = (V | (V << 4)) & 0x030C30C3;
+			V = (V | (V << 2)) & 0x09249249;
+			return V;
+		}
+
+		// Which cell a coordinate falls in, clamped so rounding can't push the far edge out of the box
+		unsigned int cellOf(real Coordinate, real Min, real Scale)
+		{
+			const real cell = (Coordinate - Min) * Scale;
+			if(cell <= (real)0.0) return 0;
+			if(cell >= (real)(CELLS - 1)) return CELLS - 1;
+			return (unsigned int)cell;
+		}
+
+		// A few chunks per thread like ParallelFor, but numbered, so each chunk can keep its own counts
+		unsigned int chunkCount(ThreadPool *Pool, unsigned int Count)
+		{
+			const unsigned int chunks = Pool ? Pool->GetThreadCount() * 4 : 1;
+			return std::max(std::min(chunks, Count), 1u);
+		}
+
+		unsigned int chunkStart(unsigned int Count, unsigned int Chunks, unsigned int Chunk)
+		{
+			return (unsigned int)((unsigned long long)Count * Chunk / Chunks);
+		}
+	};
+
+	ParticleMortonSort::ParticleMortonSort():
+	interval(64),
+	stepsSinceSort(0),
+	sortCount(0),
+	pool(NULL)
+	{ }
+
+	unsigned int ParticleMortonSort::GetInterval() const
+	{
+		return interval;
+	}
+
+	unsigned int ParticleMortonSort::GetSortCount() const
+	{
+		return sortCount;
+	}
+
+	const unsigned int *ParticleMortonSort::GetOrder() const
+	{
+		return order.empty() ? NULL : &order[0];
+	}
+
+	void ParticleMortonSort::SetInterval(unsigned int Steps)
+	{
+		interval = Steps;
+	}
+
+	void ParticleMortonSort::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	void ParticleMortonSort::computeKeys(const ParticleWorld &World)
+	{
+		const unsigned int count = World.GetCount();
+		const real *posX = World.GetPositionsX(), *posY = World.GetPositionsY(), *posZ = World.GetPositionsZ();
+		const unsigned char *alive = World.GetAliveFlags();
+
+		// Bounding box of the live particles, a chunk at a time then put together
+		const unsigned int chunks = chunkCount(pool, count);
+		bounds.resize(chunks * 6);
+
+		ParallelFor(pool, 0, chunks, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int c = Begin; c < End; c++)
+			{
+				real minX = REAL_MAX, minY = REAL_MAX, minZ = REAL_MAX;
+				real maxX = -REAL_MAX, maxY = -REAL_MAX, maxZ = -REAL_MAX;
+
+				for(unsigned int i = chunkStart(count, chunks, c); i < chunkStart(count, chunks, c + 1); i++)
+				{
+					if(!alive[i]) continue;
+
+					minX = std::min(minX, posX[i]); maxX = std::max(maxX, posX[i]);
+					minY = std::min(minY, posY[i]); maxY = std::max(maxY, posY[i]);
+					minZ = std::min(minZ, posZ[i]); maxZ = std::max(maxZ, posZ[i]);
+				}
+
+				real *box = &bounds[c * 6];
+				box[0] = minX; box[1] = minY; box[2] = minZ;
+				box[3] = maxX; box[4] = maxY; box[5] = maxZ;
+			}
+		});
+
+		real minX = REAL_MAX, minY = REAL_MAX, minZ = REAL_MAX;
+		real maxX = -REAL_MAX, maxY = -REAL_MAX, maxZ = -REAL_MAX;
+		for(unsigned int c = 0; c < chunks; c++)
+		{
+			const real *box = &bounds[c * 6];
+			minX = std::min(minX, box[0]); minY = std::min(minY, box[1]); minZ = std::min(minZ, box[2]);
+			maxX = std::max(maxX, box[3]); maxY = std::max(maxY, box[4]); maxZ = std::max(maxZ, box[5]);
+		}
+
+		// Cells are cubes, so the curve's just as fine along every axis
+		const real extent = std::max(std::max(maxX - minX, maxY - minY), maxZ - minZ);
+		const real scale = (extent > (real)0.0) ? (real)CELLS / extent : (real)0.0;
+
+		ParallelFor(pool, 0, count, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				order[i] = i;
+
+				if(!alive[i])
+				{
+					keys[i] = DEAD_KEY;
+					continue;
+				}
+
+				keys[i] = spreadBits(cellOf(posX[i], minX, scale)) | (spreadBits(cellOf(posY[i], minY, scale)) << 1) |
+					(spreadBits(cellOf(posZ[i], minZ, scale)) << 2);
+			}
+		});
+	}
+
+	void ParticleMortonSort::radixSort()
+	{
+		const unsigned int count = (unsigned int)order.size();
+		const unsigned int chunks = chunkCount(pool, count);
+
+		keysScratch.resize(count);
+		orderScratch.resize(count);
+		histogram.resize(chunks * RADIX);
+
+		for(unsigned int pass = 0; pass < PASSES; pass++)
+		{
+			const unsigned int shift = pass * DIGIT_BITS;
+
+			ParallelFor(pool, 0, chunks, [&](unsigned int Begin, unsigned int End)
+			{
+				for(unsigned int c = Begin; c < End; c++)
+				{
+					unsigned int *counts = &histogram[c * RADIX];
+					std::fill(counts, counts + RADIX, 0u);
+
+					for(unsigned int i = chunkStart(count, chunks, c); i < chunkStart(count, chunks, c + 1); i++)
+					{
+						counts[(keys[i] >> shift) & (RADIX - 1)]++;
+					}
+				}
+			});
+
+			// Nothing to do if every key has the same digit, which is usual for the top one with smaller worlds
+			const unsigned int first = (keys[0] >> shift) & (RADIX - 1);
+			unsigned int same = 0;
+			for(unsigned int c = 0; c < chunks; c++)
+			{
+				same += histogram[c * RADIX + first];
+			}
+
+			if(same == count) continue;
+
+			// Digit by digit, then chunk by chunk within a digit, so each chunk's keys go after the ones from the
+			// chunks before it and the sort stays stable
+			unsigned int offset = 0;
+			for(unsigned int d = 0; d < RADIX; d++)
+			{
+				for(unsigned int c = 0; c < chunks; c++)
+				{
+					const unsigned int n = histogram[c * RADIX + d];
+					histogram[c * RADIX + d] = offset;
+					offset += n;
+				}
+			}
+
+			ParallelFor(pool, 0, chunks, [&](unsigned int Begin, unsigned int End)
+			{
+				for(unsigned int c = Begin; c < End; c++)
+				{
+					unsigned int *next = &histogram[c * RADIX];
+
+					for(unsigned int i = chunkStart(count, chunks, c); i < chunkStart(count, chunks, c + 1); i++)
+					{
+						const unsigned int slot = next[(keys[i] >> shift) & (RADIX - 1)]++;
+						keysScratch[slot] = keys[i];
+						orderScratch[slot] = order[i];
+					}
+				}
+			});
+
+			keys.swap(keysScratch);
+			order.swap(orderScratch);
+		}
+	}
+
+	bool ParticleMortonSort::Sort(ParticleWorld &World)
+	{
+		stepsSinceSort = 0;
+
+		const unsigned int count = World.GetCount();
+		if(count < 2) return false;
+
+		HADRON_PROFILE_SCOPE("morton sort");
+
+		keys.resize(count);
+		order.resize(count);
+
+		computeKeys(World);
+		radixSort();
+
+		// A world that's barely moved since the last sort often comes out exactly the same, and then there's no
+		// need to touch it or any of its listeners
+		unsigned int i = 0;
+		while(i < count && order[i] == i) i++;
+		if(i == count) return false;
+
+		World.Reorder(&order[0], pool);
+		sortCount++;
+
+		return true;
+	}
+
+	bool ParticleMortonSort::Update(ParticleWorld &World)
+	{
+		if(interval == 0) return false;
+		if(++stepsSinceSort < interval) return false;
+
+		return Sort(World);
+	}
+};
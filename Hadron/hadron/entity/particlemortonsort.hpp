@@ -0,0 +1,77 @@
+#ifndef HADRON_PARTICLEMORTONSORT_HPP
+#define HADRON_PARTICLEMORTONSORT_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// Sorts a ParticleWorld's particles along a Morton (Z-order) curve, so particles close in space are close in memory
+	// ^- Springs, constraints, neighbour lists and contacts all read pairs of nearby particles, and once the world's
+	//    sorted those reads mostly land on cache lines that were just loaded
+	// ^- The live particles' bounding box is cut into 1024 cells a side, each particle gets its cell's interleaved
+	//    coordinate bits as a key, and the keys are radix sorted, with dead particles going to the end
+	// ^- The radix sort's stable, so particles in the same cell keep their order and what comes out only depends
+	//    on the positions, not on the thread count
+	// ^- Anything holding indices into the world must be registered with World.AddRemapListener to follow along
+	// ^- Particles only drift out of order slowly, so it's meant to be run every so often rather than every step
+	class ParticleMortonSort
+	{
+	private:
+		// Keys and particle indices, sorted back and forth between the two halves of each pair
+		std::vector<unsigned int> keys, keysScratch;
+		std::vector<unsigned int> order, orderScratch;
+
+		// Per chunk digit counts for one radix pass, turned into where each chunk's digits start
+		std::vector<unsigned int> histogram;
+
+		// Per chunk bounding boxes, 6 reals each
+		std::vector<real> bounds;
+
+		// Steps between sorts, and steps since the last one
+		unsigned int interval;
+		unsigned int stepsSinceSort;
+
+		// Sorts that actually moved particles
+		unsigned int sortCount;
+
+		// Pool to sort on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Works out every particle's key
+		void computeKeys(const ParticleWorld &World);
+
+		// Stable sorts order by keys, one radix digit at a time
+		void radixSort();
+
+	public:
+		// Default constructor, sorting every 64 steps
+		ParticleMortonSort();
+
+		// Getters
+		unsigned int GetInterval() const;
+		unsigned int GetSortCount() const;
+
+		// Where each particle came from in the last sort, particle GetOrder()[i] moved to index i
+		const unsigned int *GetOrder() const;
+
+		// Setters
+		// ^- How many Update calls to wait between sorts, 0 never sorts from Update
+		void SetInterval(unsigned int Steps);
+
+		// Sets the pool to sort on, NULL (the default) runs everything on the calling thread
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Sorts the world now
+		// ^- Returns false, without touching the world, if it was already in order
+		bool Sort(ParticleWorld &World);
+
+		// Call once a step, sorts the world every Interval calls
+		// ^- Returns true when it reordered the world
+		bool Update(ParticleWorld &World);
+	};
+};
+
+#endif // HADRON_PARTICLEMORTONSORT_HPP
@@ -0,0 +1,321 @@
+#include <math.h>
+#include <algorithm>
+#include "particleoctree.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	namespace {
+		// Predicates for splitting bodies either side of a plane
+		struct Below
+		{
+			const real *axis;
+			real split;
+
+			Below(const real *Axis, real Split): axis(Axis), split(Split) { }
+			bool operator()(unsigned int Body) const { return axis[Body] < split; }
+		};
+	}
+
+	ParticleOctree::ParticleOctree()
+	{ }
+
+	void ParticleOctree::Clear()
+	{
+		nodes.clear();
+		bodyX.clear();
+		bodyY.clear();
+		bodyZ.clear();
+		bodyMass.clear();
+		order.clear();
+	}
+
+	unsigned int ParticleOctree::GetNodeCount() const
+	{
+		return (unsigned int)nodes.size();
+	}
+
+	unsigned int ParticleOctree::GetBodyCount() const
+	{
+		return (unsigned int)order.size();
+	}
+
+	void ParticleOctree::Build(const real *X, const real *Y, const real *Z, const real *Mass, unsigned int Count, ThreadPool *Pool)
+	{
+		HADRON_PROFILE_SCOPE("octree build");
+		Clear();
+
+		// Massless bodies don't pull on anything
+		order.reserve(Count);
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			if(Mass[i] > (real)0.0) order.push_back(i);
+		}
+
+		const unsigned int bodies = (unsigned int)order.size();
+		if(bodies == 0) return;
+
+		// Bounding cube
+		real minX = X[order[0]], minY = Y[order[0]], minZ = Z[order[0]];
+		real maxX = minX, maxY = minY, maxZ = minZ;
+		for(unsigned int i = 1; i < bodies; i++)
+		{
+			const unsigned int b = order[i];
+			minX = std::min(minX, X[b]); maxX = std::max(maxX, X[b]);
+			minY = std::min(minY, Y[b]); maxY = std::max(maxY, Y[b]);
+			minZ = std::min(minZ, Z[b]); maxZ = std::max(maxZ, Z[b]);
+		}
+
+		const real cx = (minX + maxX) * (real)0.5;
+		const real cy = (minY + maxY) * (real)0.5;
+		const real cz = (minZ + maxZ) * (real)0.5;
+
+		// Pad it out a touch so nothing sits exactly on the boundary
+		real half = std::max(maxX - minX, std::max(maxY - minY, maxZ - minZ)) * (real)0.5;
+		half = half * (real)1.001 + (real)1e-6;
+
+		nodes.resize(1);
+
+		// Not worth the threads for small trees
+		if(Pool == NULL || Pool->GetThreadCount() <= 1 || bodies < 4096)
+		{
+			buildNode(nodes, 0, 0, bodies, X, Y, Z, Mass, cx, cy, cz, half, 0);
+		}
+		else
+		{
+			// Split the root here, then build each octant's subtree on its own thread into its own list
+			unsigned int childFirst[8], childCount[8];
+			partition(0, bodies, X, Y, Z, cx, cy, cz, childFirst, childCount);
+
+			NodeList subtrees[8];
+			const real q = half * (real)0.5;
+
+			ParallelFor(Pool, 0, 8, [&](unsigned int Begin, unsigned int End)
+			{
+				for(unsigned int k = Begin; k < End; k++)
+				{
+					subtrees[k].resize(1);
+					buildNode(subtrees[k], 0, childFirst[k], childCount[k], X, Y, Z, Mass,
+						cx + ((k & 1) ? q : -q), cy + ((k & 2) ? q : -q), cz + ((k & 4) ? q : -q), q, 1);
+				}
+			});
+
+			// Stitch them together
+			// ^- The 8 subtree roots become nodes 1-8, and the rest of each subtree follows on after
+			unsigned int offset[8];
+			unsigned int total = 9;
+			for(unsigned int k = 0; k < 8; k++)
+			{
+				offset[k] = total;
+				total += (unsigned int)subtrees[k].size() - 1;
+			}
+
+			nodes.resize(total);
+
+			Node &root = nodes[0];
+			root.firstChild = 1;
+			root.first = 0;
+			root.count = bodies;
+			root.size = half * (real)2.0;
+			root.mass = root.comX = root.comY = root.comZ = (real)0.0;
+
+			for(unsigned int k = 0; k < 8; k++)
+			{
+				const NodeList &sub = subtrees[k];
+				for(unsigned int j = 0; j < sub.size(); j++)
+				{
+					Node n = sub[j];
+
+					// Local index j > 0 lands at offset + j - 1
+					if(n.firstChild) n.firstChild = offset[k] + n.firstChild - 1;
+
+					nodes[j == 0 ? 1 + k : offset[k] + j - 1] = n;
+				}
+
+				root.mass += sub[0].mass;
+				root.comX += sub[0].comX * sub[0].mass;
+				root.comY += sub[0].comY * sub[0].mass;
+				root.comZ += sub[0].comZ * sub[0].mass;
+			}
+
+			root.comX /= root.mass;
+			root.comY /= root.mass;
+			root.comZ /= root.mass;
+		}
+
+		// Copy the bodies out in tree order, so walking a leaf is a linear read
+		bodyX.resize(bodies);
+		bodyY.resize(bodies);
+		bodyZ.resize(bodies);
+		bodyMass.resize(bodies);
+		for(unsigned int i = 0; i < bodies; i++)
+		{
+			const unsigned int b = order[i];
+			bodyX[i] = X[b];
+			bodyY[i] = Y[b];
+			bodyZ[i] = Z[b];
+			bodyMass[i] = Mass[b];
+		}
+	}
+
+	void ParticleOctree::partition(unsigned int First, unsigned int Count, const real *X, const real *Y, const real *Z,
+		real Cx, real Cy, real Cz, unsigned int ChildFirst[8], unsigned int ChildCount[8])
+	{
+		// Octant k has bit 0 set for x >= Cx, bit 1 for y >= Cy and bit 2 for z >= Cz
+		// ^- Splitting on z, then y, then x leaves the octants in order 0 to 7
+		unsigned int *begin = &order[0] + First;
+		unsigned int *end = begin + Count;
+
+		unsigned int *zSplit = std::partition(begin, end, Below(Z, Cz));
+
+		unsigned int *ySplit[2];
+		ySplit[0] = std::partition(begin, zSplit, Below(Y, Cy));
+		ySplit[1] = std::partition(zSplit, end, Below(Y, Cy));
+
+		unsigned int *bounds[9];
+		bounds[0] = begin;
+		bounds[1] = std::partition(begin, ySplit[0], Below(X, Cx));
+		bounds[2] = ySplit[0];
+		bounds[3] = std::partition(ySplit[0], zSplit, Below(X, Cx));
+		bounds[4] = zSplit;
+		bounds[5] = std::partition(zSplit, ySplit[1], Below(X, Cx));
+		bounds[6] = ySplit[1];
+		bounds[7] = std::partition(ySplit[1], end, Below(X, Cx));
+		bounds[8] = end;
+
+		for(unsigned int k = 0; k < 8; k++)
+		{
+			ChildFirst[k] = First + (unsigned int)(bounds[k] - begin);
+			ChildCount[k] = (unsigned int)(bounds[k + 1] - bounds[k]);
+		}
+	}
+
+	void ParticleOctree::buildNode(NodeList &Nodes, unsigned int Index, unsigned int First, unsigned int Count,
+		const real *X, const real *Y, const real *Z, const real *Mass,
+		real Cx, real Cy, real Cz, real Half, unsigned int Depth)
+	{
+		real mass = (real)0.0, comX = (real)0.0, comY = (real)0.0, comZ = (real)0.0;
+		unsigned int firstChild = 0;
+
+		if(Count <= LEAF_SIZE || Depth >= MAX_DEPTH)
+		{
+			// Leaf, sum the bodies up directly
+			for(unsigned int i = First; i < First + Count; i++)
+			{
+				const unsigned int b = order[i];
+				mass += Mass[b];
+				comX += X[b] * Mass[b];
+				comY += Y[b] * Mass[b];
+				comZ += Z[b] * Mass[b];
+			}
+		}
+		else
+		{
+			unsigned int childFirst[8], childCount[8];
+			partition(First, Count, X, Y, Z, Cx, Cy, Cz, childFirst, childCount);
+
+			// Children always come in a contiguous block of 8
+			// ^- Nodes can reallocate while they're built, so only hang on to indices
+			firstChild = (unsigned int)Nodes.size();
+			Nodes.resize(Nodes.size() + 8);
+
+			const real q = Half * (real)0.5;
+			for(unsigned int k = 0; k < 8; k++)
+			{
+				buildNode(Nodes, firstChild + k, childFirst[k], childCount[k], X, Y, Z, Mass,
+					Cx + ((k & 1) ? q : -q), Cy + ((k & 2) ? q : -q), Cz + ((k & 4) ? q : -q), q, Depth + 1);
+
+				const Node &child = Nodes[firstChild + k];
+				mass += child.mass;
+				comX += child.comX * child.mass;
+				comY += child.comY * child.mass;
+				comZ += child.comZ * child.mass;
+			}
+		}
+
+		Node &n = Nodes[Index];
+		n.mass = mass;
+		n.size = Half * (real)2.0;
+		n.firstChild = firstChild;
+		n.first = First;
+		n.count = Count;
+
+		if(mass > (real)0.0)
+		{
+			n.comX = comX / mass;
+			n.comY = comY / mass;
+			n.comZ = comZ / mass;
+		}
+		else
+		{
+			n.comX = Cx;
+			n.comY = Cy;
+			n.comZ = Cz;
+		}
+	}
+
+	Vector3<real> ParticleOctree::GetField(real X, real Y, real Z, unsigned int Self, real Theta, real SofteningSq) const
+	{
+		real fx = (real)0.0, fy = (real)0.0, fz = (real)0.0;
+		if(nodes.empty()) return Vector3<real>(fx, fy, fz);
+
+		const real thetaSq = Theta * Theta;
+
+		// Every level pushes at most 8 nodes
+		unsigned int stack[8 * (MAX_DEPTH + 2)];
+		unsigned int top = 0;
+		stack[top++] = 0;
+
+		while(top > 0)
+		{
+			const Node &n = nodes[stack[--top]];
+			if(n.mass <= (real)0.0) continue;
+
+			if(n.firstChild == 0)
+			{
+				// Leaf, do its bodies directly
+				for(unsigned int i = n.first; i < n.first + n.count; i++)
+				{
+					if(order[i] == Self) continue;
+
+					const real dx = bodyX[i] - X;
+					const real dy = bodyY[i] - Y;
+					const real dz = bodyZ[i] - Z;
+					const real r2 = (dx * dx) + (dy * dy) + (dz * dz) + SofteningSq;
+					if(r2 <= (real)0.0) continue;
+
+					const real s = bodyMass[i] / (r2 * (real)sqrt(r2));
+					fx += dx * s;
+					fy += dy * s;
+					fz += dz * s;
+				}
+
+				continue;
+			}
+
+			const real dx = n.comX - X;
+			const real dy = n.comY - Y;
+			const real dz = n.comZ - Z;
+			const real d2 = (dx * dx) + (dy * dy) + (dz * dz);
+
+			if(n.size * n.size < thetaSq * d2)
+			{
+				// Far enough away to treat as one body
+				const real r2 = d2 + SofteningSq;
+				const real s = n.mass / (r2 * (real)sqrt(r2));
+				fx += dx * s;
+				fy += dy * s;
+				fz += dz * s;
+			}
+			else
+			{
+				for(unsigned int k = 0; k < 8; k++)
+				{
+					stack[top++] = n.firstChild + k;
+				}
+			}
+		}
+
+		return Vector3<real>(fx, fy, fz);
+	}
+};
\ No newline at end of file
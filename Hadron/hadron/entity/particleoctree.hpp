@@ -0,0 +1,88 @@
+#ifndef HADRON_PARTICLEOCTREE_HPP
+#define HADRON_PARTICLEOCTREE_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "../math/vector3.hpp"
+
+namespace Hadron {
+	// A Barnes-Hut octree over a set of point masses
+	// ^- Each node keeps the total mass and centre of mass of everything below it, so a whole distant
+	//    cluster can stand in for all of its bodies at once
+	// ^- Bodies are referred to by the index they were passed to Build with
+	class ParticleOctree
+	{
+	private:
+		struct Node
+		{
+			// Centre of mass and total mass of everything in the node
+			real comX, comY, comZ, mass;
+
+			// Width of the node's cube
+			real size;
+
+			// Index of the first of 8 children, or 0 for a leaf
+			unsigned int firstChild;
+
+			// Range of bodies in the sorted arrays, only used by leaves
+			unsigned int first, count;
+		};
+
+		typedef std::vector<Node> NodeList;
+
+		// Leaves hold up to this many bodies
+		static const unsigned int LEAF_SIZE = 8;
+
+		// Bodies that are (nearly) on top of each other stop splitting here
+		static const unsigned int MAX_DEPTH = 32;
+
+		// Node 0 is the root
+		NodeList nodes;
+
+		// Body positions and masses, in tree order so each leaf's bodies sit next to each other
+		std::vector<real> bodyX, bodyY, bodyZ, bodyMass;
+
+		// Maps tree order back to the index the body was passed in with
+		std::vector<unsigned int> order;
+
+		// Builds the subtree for the bodies in order[First, First + Count) into Nodes[Index]
+		// ^- Cx, Cy, Cz and Half describe the node's cube
+		void buildNode(NodeList &Nodes, unsigned int Index, unsigned int First, unsigned int Count,
+			const real *X, const real *Y, const real *Z, const real *Mass,
+			real Cx, real Cy, real Cz, real Half, unsigned int Depth);
+
+		// Splits order[First, First + Count) into the 8 octants around (Cx, Cy, Cz)
+		// ^- Fills in where each octant's bodies start and how many there are
+		void partition(unsigned int First, unsigned int Count, const real *X, const real *Y, const real *Z,
+			real Cx, real Cy, real Cz, unsigned int ChildFirst[8], unsigned int ChildCount[8]);
+
+	public:
+		// Default constructor
+		ParticleOctree();
+
+		// Rebuilds the tree over Count bodies
+		// ^- Bodies with zero mass are left out
+		// ^- With a pool, the root's 8 subtrees are built in parallel
+		void Build(const real *X, const real *Y, const real *Z, const real *Mass, unsigned int Count, ThreadPool *Pool);
+
+		// Empties the tree
+		void Clear();
+
+		// Getters
+		unsigned int GetNodeCount() const;
+		unsigned int GetBodyCount() const;
+
+		// Returns sum(m * d / (|d|^2 + SofteningSq)^1.5) over the tree, where d runs from (X, Y, Z) to each body
+		// ^- Multiply by G * mass to get the gravitational force on a body at (X, Y, Z)
+		// ^- Nodes narrower than Theta times their distance are treated as a single body at their centre of mass
+		// ^- Self is the index of the body sitting at (X, Y, Z), so it doesn't attract itself
+		//    Pass NO_BODY if the point isn't one of the tree's bodies
+		Vector3<real> GetField(real X, real Y, real Z, unsigned int Self, real Theta, real SofteningSq) const;
+
+		static const unsigned int NO_BODY = 0xFFFFFFFF;
+	};
+};
+
+#endif // HADRON_PARTICLEOCTREE_HPP
\ No newline at end of file
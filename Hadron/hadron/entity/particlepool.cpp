@@ -0,0 +1,149 @@
+#include "particlepool.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	const unsigned int ParticlePool::NOT_LIVE;
+
+	ParticlePool::ParticlePool(unsigned int Capacity):
+	storage(Capacity),
+	livePosition(Capacity, NOT_LIVE),
+	pool(NULL)
+	{
+		live.reserve(Capacity);
+
+		// Lowest slots get handed out first
+		freeSlots.reserve(Capacity);
+		for(unsigned int i = Capacity; i > 0; i--)
+		{
+			freeSlots.push_back(i - 1);
+		}
+	}
+
+	unsigned int ParticlePool::GetCapacity() const
+	{
+		return (unsigned int)storage.size();
+	}
+
+	unsigned int ParticlePool::GetLiveCount() const
+	{
+		return (unsigned int)live.size();
+	}
+
+	Particle *const *ParticlePool::GetLive() const
+	{
+		return live.empty() ? NULL : &live[0];
+	}
+
+	bool ParticlePool::IsLive(const Particle *P) const
+	{
+		if(storage.empty() || P < &storage[0] || P >= &storage[0] + storage.size()) return false;
+
+		return livePosition[P - &storage[0]] != NOT_LIVE;
+	}
+
+	void ParticlePool::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	Particle *ParticlePool::Spawn()
+	{
+		if(freeSlots.empty()) return NULL;
+
+		const unsigned int slot = freeSlots.back();
+		freeSlots.pop_back();
+
+		Particle &p = storage[slot];
+		p = Particle();
+		p.SetAlive(true);
+
+		livePosition[slot] = (unsigned int)live.size();
+		live.push_back(&p);
+
+		return &p;
+	}
+
+	unsigned int ParticlePool::Spawn(unsigned int Count, Particle **Out)
+	{
+		if(Count > freeSlots.size()) Count = (unsigned int)freeSlots.size();
+
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			Particle *p = Spawn();
+			if(Out != NULL) Out[i] = p;
+		}
+
+		return Count;
+	}
+
+	void ParticlePool::kill(unsigned int Slot)
+	{
+		const unsigned int position = livePosition[Slot];
+
+		// Move the last live particle into the gap
+		Particle *last = live.back();
+		live[position] = last;
+		livePosition[last - &storage[0]] = position;
+		live.pop_back();
+
+		livePosition[Slot] = NOT_LIVE;
+		storage[Slot].SetAlive(false);
+		freeSlots.push_back(Slot);
+	}
+
+	void ParticlePool::Kill(Particle *P)
+	{
+		if(!IsLive(P)) return;
+
+		kill((unsigned int)(P - &storage[0]));
+	}
+
+	void ParticlePool::Kill(Particle *const *P, unsigned int Count)
+	{
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			Kill(P[i]);
+		}
+	}
+
+	void ParticlePool::Clear()
+	{
+		for(unsigned int i = 0; i < live.size(); i++)
+		{
+			const unsigned int slot = (unsigned int)(live[i] - &storage[0]);
+			livePosition[slot] = NOT_LIVE;
+			live[i]->SetAlive(false);
+		}
+
+		live.clear();
+
+		freeSlots.clear();
+		for(unsigned int i = (unsigned int)storage.size(); i > 0; i--)
+		{
+			freeSlots.push_back(i - 1);
+		}
+	}
+
+	void ParticlePool::ApplyForce(ParticleForceGenerator &ForceGen, real dT)
+	{
+		if(live.empty()) return;
+
+		HADRON_PROFILE_SCOPE(ForceGen.GetName());
+		ForceGen.ApplyForceBatch(&live[0], (unsigned int)live.size(), dT);
+	}
+
+	void ParticlePool::Update(real dT)
+	{
+		HADRON_PROFILE_SCOPE("pool update");
+		HADRON_PROFILE_COUNT("particles integrated", live.size());
+
+		ParallelFor(pool, 0, (unsigned int)live.size(), [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				live[i]->Update(dT);
+			}
+		});
+	}
+};
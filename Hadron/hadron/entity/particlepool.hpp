@@ -0,0 +1,103 @@
+#ifndef HADRON_PARTICLEPOOL_HPP
+#define HADRON_PARTICLEPOOL_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "particle.hpp"
+#include "particleforcegenerator.hpp"
+
+namespace Hadron {
+	// A fixed number of Particles, with the live ones kept in a dense list
+	// ^- Spawning and killing are both O(1), killing swaps the last live particle into the gap
+	// ^- Only live particles are ever visited, so the cost scales with how many are alive rather than the capacity
+	// ^- Particles never move in memory, so pointers to them (in a registry, say) stay valid for the pool's lifetime,
+	//    but the order of the live list changes whenever one is killed
+	class ParticlePool
+	{
+	private:
+		std::vector<Particle> storage;
+
+		// Pointers to the live particles, densely packed
+		std::vector<Particle *> live;
+
+		// Where each storage slot sits in the live list, or NOT_LIVE
+		std::vector<unsigned int> livePosition;
+
+		// Slots that are free to spawn into, used from the back
+		std::vector<unsigned int> freeSlots;
+
+		// Pool to run Update on, NULL runs everything serially
+		ThreadPool *pool;
+
+		static const unsigned int NOT_LIVE = 0xFFFFFFFF;
+
+		// Removes the particle in the given slot from the live list
+		void kill(unsigned int Slot);
+
+	public:
+		// Creates a pool with room for Capacity particles
+		ParticlePool(unsigned int Capacity);
+
+		// Getters
+		unsigned int GetCapacity() const;
+		unsigned int GetLiveCount() const;
+
+		// The live particles, GetLiveCount() of them
+		// ^- Only valid until the next spawn or kill
+		Particle *const *GetLive() const;
+
+		// Checks if a particle belongs to this pool and is currently live
+		bool IsLive(const Particle *P) const;
+
+		// Sets the pool to update on, NULL (the default) runs everything on the calling thread
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Spawns a particle, set up the same way as a default constructed Particle but alive
+		// ^- Returns NULL if the pool's full
+		Particle *Spawn();
+
+		// Spawns up to Count particles, writing them out to Out if it isn't NULL
+		// ^- Returns how many were spawned
+		unsigned int Spawn(unsigned int Count, Particle **Out);
+
+		// Kills a live particle, which must belong to this pool
+		void Kill(Particle *P);
+
+		// Kills Count live particles
+		void Kill(Particle *const *P, unsigned int Count);
+
+		// Kills every live particle that Condition(const Particle &) returns true for
+		// ^- Returns how many were killed
+		template<typename Predicate>
+		unsigned int KillIf(Predicate Condition)
+		{
+			unsigned int killed = 0;
+
+			// Backwards, so the particle swapped into a gap has already been checked
+			for(unsigned int i = (unsigned int)live.size(); i > 0; i--)
+			{
+				Particle *p = live[i - 1];
+				if(Condition(*p))
+				{
+					kill((unsigned int)(p - &storage[0]));
+					killed++;
+				}
+			}
+
+			return killed;
+		}
+
+		// Kills everything
+		void Clear();
+
+		// Has a force generator apply its force to every live particle, in one batch
+		void ApplyForce(ParticleForceGenerator &ForceGen, real dT);
+
+		// Updates every live particle
+		void Update(real dT);
+	};
+};
+
+#endif // HADRON_PARTICLEPOOL_HPP
@@ -0,0 +1,709 @@
+#include <string.h>
+#include "particlerecorder.hpp"
+
+namespace Hadron {
+	/*-----------------------------------------------*\
+	|* File layout                                   *|
+	\*-----------------------------------------------*/
+
+	namespace {
+		const char RECORDING_MAGIC[8] = { 'H', 'D', 'R', 'N', 'T', 'R', 'A', 'J' };
+		const char INDEX_MAGIC[8] = { 'H', 'D', 'R', 'N', 'T', 'I', 'D', 'X' };
+		const unsigned int CHUNK_MAGIC = 0x4B4E4843;
+		const unsigned int RECORDING_VERSION = 1;
+
+		// Written as a native unsigned int, reads back differently on the other byte order
+		const unsigned int RECORDING_BYTE_ORDER = 0x01020304;
+
+		// Position then velocity, X Y Z, and only the positions get the straight line prediction
+		const unsigned int COMPONENTS = 6;
+		const unsigned int PREDICTED_COMPONENTS = 3;
+
+		// Quantised values are clamped to +-2^60, so predictions and residuals can't overflow
+		const double QUANTISE_LIMIT = 1152921504606846976.0;
+
+		// Longest a zigzagged residual can be as a varint
+		const unsigned int MAX_VARINT_BYTES = 10;
+
+		struct RecordingHeader
+		{
+			char magic[8];
+			unsigned int version;
+			unsigned int byteOrder;
+			unsigned int particleCount;
+			unsigned int framesPerChunk;
+			double positionStep;
+			double velocityStep;
+			unsigned char padding[24];
+		};
+
+		struct ChunkHeader
+		{
+			unsigned int magic;
+			unsigned int frameCount;
+			unsigned long long firstFrame;
+			unsigned long long size;
+		};
+
+		struct IndexEntry
+		{
+			unsigned long long firstFrame;
+			unsigned long long offset;
+		};
+
+		// Last thing in a closed recording
+		struct RecordingFooter
+		{
+			unsigned long long indexOffset;
+			unsigned long long chunkCount;
+			unsigned long long frameCount;
+			char magic[8];
+		};
+
+		// Rounds to the nearest step, halves rounding up
+		// ^- Truncates and corrects rather than calling floor, which is a library call without SSE4.1
+		long long quantise(double Value, double InverseStep)
+		{
+			const double scaled = (Value * InverseStep) + 0.5;
+			if(!(scaled > -QUANTISE_LIMIT && scaled < QUANTISE_LIMIT))
+			{
+				if(scaled != scaled) return 0;
+				return scaled > 0.0 ? (long long)QUANTISE_LIMIT : -(long long)QUANTISE_LIMIT;
+			}
+
+			const long long truncated = (long long)scaled;
+			return truncated - ((double)truncated > scaled ? 1 : 0);
+		}
+
+		// Small residuals of either sign become small unsigned numbers
+		unsigned long long zigzag(long long Value)
+		{
+			return ((unsigned long long)Value << 1) ^ (unsigned long long)(Value >> 63);
+		}
+
+		long long unzigzag(unsigned long long Value)
+		{
+			return (long long)(Value >> 1) ^ -(long long)(Value & 1);
+		}
+
+		// Seven bits a byte, top bit set on all but the last
+		unsigned char *putVarint(unsigned char *Out, unsigned long long Value)
+		{
+			while(Value >= 0x80)
+			{
+				*Out++ = (unsigned char)(Value | 0x80);
+				Value >>= 7;
+			}
+
+			*Out++ = (unsigned char)Value;
+			return Out;
+		}
+
+		// Returns NULL if it runs off the end
+		const unsigned char *getVarint(const unsigned char *In, const unsigned char *End, unsigned long long &Value)
+		{
+			Value = 0;
+			for(unsigned int shift = 0; shift < 64 && In < End; shift += 7)
+			{
+				const unsigned char byte = *In++;
+				Value |= (unsigned long long)(byte & 0x7F) << shift;
+				if(!(byte & 0x80)) return In;
+			}
+
+			return NULL;
+		}
+
+		// How a value's predicted from the ones before it
+		enum Prediction
+		{
+			PREDICT_NONE,		// First frame of a chunk, stored as is
+			PREDICT_LAST,		// Same as last frame
+			PREDICT_LINEAR		// Carries on in a straight line from the last two frames
+		};
+
+		// Positions get the straight line once there are two frames to go on, velocities never do
+		// ^- Before is NULL for components that aren't predicted
+		Prediction choosePrediction(const long long *Before, unsigned int ChunkFrame)
+		{
+			if(ChunkFrame == 0) return PREDICT_NONE;
+			if(Before == NULL || ChunkFrame == 1) return PREDICT_LAST;
+			return PREDICT_LINEAR;
+		}
+
+		// Kind is a template parameter so each loop's compiled without the branch
+		template<Prediction Kind, typename S>
+		unsigned char *encodeValues(unsigned char *Out, const S *Source, unsigned int Count, double InverseStep,
+			long long *Last, long long *Before)
+		{
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				const long long value = quantise((double)Source[i], InverseStep);
+				const long long predicted = Kind == PREDICT_NONE ? 0 : Kind == PREDICT_LAST ? Last[i] : (2 * Last[i]) - Before[i];
+				Out = putVarint(Out, zigzag(value - predicted));
+
+				if(Before != NULL) Before[i] = Last[i];
+				Last[i] = value;
+			}
+
+			return Out;
+		}
+
+		template<typename S>
+		unsigned char *encodeComponent(unsigned char *Out, const S *Source, unsigned int Count, double InverseStep,
+			long long *Last, long long *Before, unsigned int ChunkFrame)
+		{
+			switch(choosePrediction(Before, ChunkFrame))
+			{
+			case PREDICT_NONE: return encodeValues<PREDICT_NONE>(Out, Source, Count, InverseStep, Last, Before);
+			case PREDICT_LAST: return encodeValues<PREDICT_LAST>(Out, Source, Count, InverseStep, Last, Before);
+			default: return encodeValues<PREDICT_LINEAR>(Out, Source, Count, InverseStep, Last, Before);
+			}
+		}
+
+		template<Prediction Kind>
+		const unsigned char *decodeValues(const unsigned char *In, const unsigned char *End, unsigned int Count,
+			long long *Last, long long *Before)
+		{
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				unsigned long long residual;
+				In = getVarint(In, End, residual);
+				if(In == NULL) return NULL;
+
+				const long long predicted = Kind == PREDICT_NONE ? 0 : Kind == PREDICT_LAST ? Last[i] : (2 * Last[i]) - Before[i];
+				const long long value = unzigzag(residual) + predicted;
+
+				if(Before != NULL) Before[i] = Last[i];
+				Last[i] = value;
+			}
+
+			return In;
+		}
+
+		const unsigned char *decodeComponent(const unsigned char *In, const unsigned char *End, unsigned int Count,
+			long long *Last, long long *Before, unsigned int ChunkFrame)
+		{
+			switch(choosePrediction(Before, ChunkFrame))
+			{
+			case PREDICT_NONE: return decodeValues<PREDICT_NONE>(In, End, Count, Last, Before);
+			case PREDICT_LAST: return decodeValues<PREDICT_LAST>(In, End, Count, Last, Before);
+			default: return decodeValues<PREDICT_LINEAR>(In, End, Count, Last, Before);
+			}
+		}
+	};
+
+	/*-----------------------------------------------*\
+	|* ParticleRecorder                              *|
+	\*-----------------------------------------------*/
+
+	ParticleRecorder::ParticleRecorder():
+	positionStep(0.0),
+	velocityStep(0.0),
+	framesPerChunk(0),
+	particleCount(0),
+	elementSize(0),
+	recorded(0),
+	written(0),
+	stalls(0),
+	closing(false),
+	file(NULL),
+	failed(false),
+	fileOffset(0),
+	chunkBytes(0),
+	chunkFrames(0),
+	chunkFirst(0)
+	{ }
+
+	ParticleRecorder::~ParticleRecorder()
+	{
+		Close();
+	}
+
+	bool ParticleRecorder::Open(const char *Path, real PositionStep, real VelocityStep, unsigned int FramesPerChunk,
+		unsigned int BufferFrames)
+	{
+		Close();
+
+		file = fopen(Path, "wb");
+		if(file == NULL) return false;
+
+		positionStep = (double)PositionStep;
+		velocityStep = (double)VelocityStep;
+		framesPerChunk = FramesPerChunk > 0 ? FramesPerChunk : 1;
+
+		particleCount = 0;
+		elementSize = 0;
+		slots.assign(BufferFrames > 0 ? BufferFrames : 1, std::vector<unsigned char>());
+		recorded = 0;
+		written = 0;
+		stalls = 0;
+		closing = false;
+
+		failed = false;
+		fileOffset = 0;
+		chunkBytes = 0;
+		chunkFrames = 0;
+		chunkFirst = 0;
+		chunkOffsets.clear();
+		chunkFirstFrames.clear();
+
+		writer = std::thread(&ParticleRecorder::writerMain, this);
+		return true;
+	}
+
+	bool ParticleRecorder::Close()
+	{
+		if(!writer.joinable()) return true;
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			closing = true;
+		}
+		frameReady.notify_one();
+		writer.join();
+
+		// Hand the buffers back
+		std::vector<std::vector<unsigned char> >().swap(slots);
+		std::vector<long long>().swap(previous);
+		std::vector<long long>().swap(beforePrevious);
+		std::vector<unsigned char>().swap(chunk);
+
+		return !failed;
+	}
+
+	bool ParticleRecorder::IsOpen() const
+	{
+		return writer.joinable();
+	}
+
+	unsigned int ParticleRecorder::GetFrameCount() const
+	{
+		return (unsigned int)recorded;
+	}
+
+	unsigned int ParticleRecorder::GetStallCount() const
+	{
+		return stalls;
+	}
+
+	template<typename T, typename F>
+	bool ParticleRecorder::Record(const BasicParticleWorld<T, F> &World)
+	{
+		if(!writer.joinable()) return false;
+
+		const unsigned int count = World.GetCount();
+		const size_t arrayBytes = (size_t)count * sizeof(T);
+
+		// The writer only looks at these once it's been told about the first frame
+		if(recorded == 0)
+		{
+			particleCount = count;
+			elementSize = sizeof(T);
+			for(unsigned int i = 0; i < slots.size(); i++) slots[i].resize(arrayBytes * COMPONENTS);
+		}
+		else if(count != particleCount || sizeof(T) != elementSize)
+		{
+			return false;
+		}
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			if(recorded - written >= slots.size())
+			{
+				stalls++;
+				slotFree.wait(guard, [this]() { return recorded - written < slots.size(); });
+			}
+		}
+
+		// Nothing else touches the slot until the writer's told about it
+		if(arrayBytes > 0)
+		{
+			unsigned char *slot = &slots[recorded % slots.size()][0];
+			memcpy(slot, World.GetPositionsX(), arrayBytes);
+			memcpy(slot + arrayBytes, World.GetPositionsY(), arrayBytes);
+			memcpy(slot + (arrayBytes * 2), World.GetPositionsZ(), arrayBytes);
+			memcpy(slot + (arrayBytes * 3), World.GetVelocitiesX(), arrayBytes);
+			memcpy(slot + (arrayBytes * 4), World.GetVelocitiesY(), arrayBytes);
+			memcpy(slot + (arrayBytes * 5), World.GetVelocitiesZ(), arrayBytes);
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			recorded++;
+		}
+		frameReady.notify_one();
+
+		return true;
+	}
+
+	void ParticleRecorder::writerMain()
+	{
+		for(;;)
+		{
+			unsigned long long frame;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				frameReady.wait(guard, [this]() { return recorded > written || closing; });
+				if(recorded == written) break;
+
+				frame = written;
+			}
+
+			// Frames still get consumed after a failed write, so Record never blocks on a dead writer
+			if(!failed)
+			{
+				const std::vector<unsigned char> &slot = slots[frame % slots.size()];
+				encodeFrame(slot.empty() ? NULL : &slot[0]);
+			}
+
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				written++;
+			}
+			slotFree.notify_one();
+		}
+
+		if(fileOffset == 0) writeHeader();
+		flushChunk();
+
+		// Index and footer, so readers can seek without walking the chunks
+		RecordingFooter footer;
+		memset(&footer, 0, sizeof(footer));
+		footer.indexOffset = fileOffset;
+		footer.chunkCount = chunkOffsets.size();
+		footer.frameCount = written;
+		memcpy(footer.magic, INDEX_MAGIC, sizeof(footer.magic));
+
+		std::vector<IndexEntry> index(chunkOffsets.size());
+		for(unsigned int i = 0; i < index.size(); i++)
+		{
+			index[i].firstFrame = chunkFirstFrames[i];
+			index[i].offset = chunkOffsets[i];
+		}
+
+		if(!index.empty()) write(&index[0], index.size() * sizeof(IndexEntry));
+		write(&footer, sizeof(footer));
+
+		if(fclose(file) != 0) failed = true;
+		file = NULL;
+	}
+
+	void ParticleRecorder::writeHeader()
+	{
+		RecordingHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+		header.version = RECORDING_VERSION;
+		header.byteOrder = RECORDING_BYTE_ORDER;
+		header.particleCount = particleCount;
+		header.framesPerChunk = framesPerChunk;
+		header.positionStep = positionStep;
+		header.velocityStep = velocityStep;
+
+		write(&header, sizeof(header));
+	}
+
+	void ParticleRecorder::encodeFrame(const unsigned char *Frame)
+	{
+		if(fileOffset == 0)
+		{
+			writeHeader();
+			previous.assign((size_t)particleCount * COMPONENTS, 0);
+			beforePrevious.assign((size_t)particleCount * PREDICTED_COMPONENTS, 0);
+		}
+
+		if(chunkFrames == 0) chunkFirst = written;
+
+		// Room for the worst case, the buffer only ever grows so this doesn't clear anything after the first chunks
+		const size_t needed = chunkBytes + ((size_t)particleCount * COMPONENTS * MAX_VARINT_BYTES) + 1;
+		if(chunk.size() < needed) chunk.resize(needed);
+		unsigned char *out = &chunk[chunkBytes];
+
+		const size_t arrayBytes = (size_t)particleCount * elementSize;
+		for(unsigned int c = 0; c < COMPONENTS && particleCount > 0; c++)
+		{
+			const double inverse = 1.0 / (c < PREDICTED_COMPONENTS ? positionStep : velocityStep);
+			long long *last = &previous[(size_t)c * particleCount];
+			long long *before = c < PREDICTED_COMPONENTS ? &beforePrevious[(size_t)c * particleCount] : NULL;
+
+			if(elementSize == sizeof(float))
+			{
+				out = encodeComponent(out, (const float *)(Frame + (c * arrayBytes)), particleCount, inverse, last, before, chunkFrames);
+			}
+			else
+			{
+				out = encodeComponent(out, (const double *)(Frame + (c * arrayBytes)), particleCount, inverse, last, before, chunkFrames);
+			}
+		}
+
+		chunkBytes = out - &chunk[0];
+		chunkFrames++;
+
+		if(chunkFrames == framesPerChunk) flushChunk();
+	}
+
+	void ParticleRecorder::flushChunk()
+	{
+		if(chunkFrames == 0) return;
+
+		ChunkHeader header;
+		header.magic = CHUNK_MAGIC;
+		header.frameCount = chunkFrames;
+		header.firstFrame = chunkFirst;
+		header.size = chunkBytes;
+
+		chunkOffsets.push_back(fileOffset);
+		chunkFirstFrames.push_back(chunkFirst);
+
+		write(&header, sizeof(header));
+		if(chunkBytes > 0) write(&chunk[0], chunkBytes);
+
+		chunkBytes = 0;
+		chunkFrames = 0;
+	}
+
+	void ParticleRecorder::write(const void *Data, unsigned long long Size)
+	{
+		if(!failed && fwrite(Data, 1, (size_t)Size, file) != Size) failed = true;
+		fileOffset += Size;
+	}
+
+	/*-----------------------------------------------*\
+	|* ParticleRecording                             *|
+	\*-----------------------------------------------*/
+
+	ParticleRecording::ParticleRecording():
+	particleCount(0),
+	frameCount(0),
+	positionStep(0.0),
+	velocityStep(0.0),
+	decodedChunk(~0u),
+	nextFrame(0),
+	cursor(NULL)
+	{ }
+
+	bool ParticleRecording::Open(const char *Path)
+	{
+		Close();
+		if(!file.Open(Path)) return false;
+
+		const unsigned char *data = file.GetData();
+		const unsigned long long size = file.GetSize();
+
+		RecordingHeader header;
+		if(size < sizeof(header))
+		{
+			Close();
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		if(memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 || header.version != RECORDING_VERSION ||
+			header.byteOrder != RECORDING_BYTE_ORDER)
+		{
+			Close();
+			return false;
+		}
+
+		particleCount = header.particleCount;
+		positionStep = header.positionStep;
+		velocityStep = header.velocityStep;
+
+		// Use the index if there's a good one
+		RecordingFooter footer;
+		bool indexed = false;
+		if(size >= sizeof(header) + sizeof(footer))
+		{
+			memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+
+			const unsigned long long indexEnd = size - sizeof(footer);
+			indexed = memcmp(footer.magic, INDEX_MAGIC, sizeof(footer.magic)) == 0 && footer.indexOffset >= sizeof(header) &&
+				footer.indexOffset <= indexEnd && footer.chunkCount == (indexEnd - footer.indexOffset) / sizeof(IndexEntry);
+
+			unsigned long long frames = 0;
+			for(unsigned long long i = 0; indexed && i < footer.chunkCount; i++)
+			{
+				IndexEntry entry;
+				memcpy(&entry, data + footer.indexOffset + (i * sizeof(IndexEntry)), sizeof(entry));
+
+				Chunk c;
+				indexed = entry.firstFrame == frames && readChunk(entry.offset, frames, c);
+				if(indexed)
+				{
+					chunks.push_back(c);
+					frames += c.frameCount;
+				}
+			}
+
+			indexed = indexed && frames == footer.frameCount;
+		}
+
+		// Otherwise find the chunks by walking from one to the next, stopping at the first incomplete one
+		if(!indexed)
+		{
+			chunks.clear();
+
+			unsigned long long offset = sizeof(header);
+			unsigned long long frames = 0;
+			Chunk c;
+			while(readChunk(offset, frames, c))
+			{
+				chunks.push_back(c);
+				frames += c.frameCount;
+				offset = c.end - data;
+			}
+		}
+
+		frameCount = chunks.empty() ? 0 : chunks.back().firstFrame + chunks.back().frameCount;
+		current.assign((size_t)particleCount * COMPONENTS, 0);
+		previous.assign((size_t)particleCount * PREDICTED_COMPONENTS, 0);
+
+		return true;
+	}
+
+	void ParticleRecording::Close()
+	{
+		file.Close();
+		chunks.clear();
+
+		particleCount = 0;
+		frameCount = 0;
+		positionStep = 0.0;
+		velocityStep = 0.0;
+
+		std::vector<long long>().swap(current);
+		std::vector<long long>().swap(previous);
+		decodedChunk = ~0u;
+		nextFrame = 0;
+		cursor = NULL;
+	}
+
+	bool ParticleRecording::IsOpen() const
+	{
+		return file.IsOpen();
+	}
+
+	unsigned int ParticleRecording::GetParticleCount() const
+	{
+		return particleCount;
+	}
+
+	unsigned int ParticleRecording::GetFrameCount() const
+	{
+		return (unsigned int)frameCount;
+	}
+
+	unsigned int ParticleRecording::GetChunkCount() const
+	{
+		return (unsigned int)chunks.size();
+	}
+
+	real ParticleRecording::GetPositionStep() const
+	{
+		return (real)positionStep;
+	}
+
+	real ParticleRecording::GetVelocityStep() const
+	{
+		return (real)velocityStep;
+	}
+
+	bool ParticleRecording::readChunk(unsigned long long Offset, unsigned long long FirstFrame, Chunk &Out) const
+	{
+		const unsigned long long size = file.GetSize();
+		if(Offset > size || size - Offset < sizeof(ChunkHeader)) return false;
+
+		ChunkHeader header;
+		memcpy(&header, file.GetData() + Offset, sizeof(header));
+
+		const unsigned long long available = size - Offset - sizeof(header);
+		if(header.magic != CHUNK_MAGIC || header.frameCount == 0 || header.firstFrame != FirstFrame || header.size > available)
+		{
+			return false;
+		}
+
+		Out.firstFrame = header.firstFrame;
+		Out.frameCount = header.frameCount;
+		Out.data = file.GetData() + Offset + sizeof(header);
+		Out.end = Out.data + header.size;
+		return true;
+	}
+
+	bool ParticleRecording::decodeTo(unsigned long long Frame)
+	{
+		if(Frame >= frameCount) return false;
+
+		// Last chunk starting at or before the frame
+		unsigned int first = 0, last = (unsigned int)chunks.size();
+		while(last - first > 1)
+		{
+			const unsigned int middle = (first + last) / 2;
+			if(chunks[middle].firstFrame <= Frame) first = middle;
+			else last = middle;
+		}
+
+		const Chunk &c = chunks[first];
+
+		// Carry on from the last frame decoded if we can
+		if(decodedChunk != first || nextFrame > Frame + 1)
+		{
+			decodedChunk = first;
+			nextFrame = c.firstFrame;
+			cursor = c.data;
+		}
+
+		while(nextFrame <= Frame)
+		{
+			const unsigned int chunkFrame = (unsigned int)(nextFrame - c.firstFrame);
+			for(unsigned int component = 0; component < COMPONENTS && particleCount > 0; component++)
+			{
+				long long *values = &current[(size_t)component * particleCount];
+				long long *before = component < PREDICTED_COMPONENTS ? &previous[(size_t)component * particleCount] : NULL;
+
+				cursor = decodeComponent(cursor, c.end, particleCount, values, before, chunkFrame);
+				if(cursor == NULL)
+				{
+					decodedChunk = ~0u;
+					return false;
+				}
+			}
+
+			nextFrame++;
+		}
+
+		return true;
+	}
+
+	template<typename T, typename F>
+	bool ParticleRecording::ReadFrame(unsigned int Frame, BasicParticleWorld<T, F> &World)
+	{
+		if(!decodeTo(Frame)) return false;
+
+		if(World.GetCount() != particleCount) World.Resize(particleCount);
+		if(particleCount == 0) return true;
+
+		T *const outputs[COMPONENTS] = {
+			World.GetPositionsX(), World.GetPositionsY(), World.GetPositionsZ(),
+			World.GetVelocitiesX(), World.GetVelocitiesY(), World.GetVelocitiesZ()
+		};
+
+		for(unsigned int c = 0; c < COMPONENTS; c++)
+		{
+			const double step = c < PREDICTED_COMPONENTS ? positionStep : velocityStep;
+			const long long *values = &current[(size_t)c * particleCount];
+			T *output = outputs[c];
+
+			for(unsigned int i = 0; i < particleCount; i++) output[i] = (T)((double)values[i] * step);
+		}
+
+		return true;
+	}
+
+	template bool ParticleRecorder::Record(const BasicParticleWorld<float> &World);
+	template bool ParticleRecorder::Record(const BasicParticleWorld<double> &World);
+	template bool ParticleRecorder::Record(const BasicParticleWorld<float, double> &World);
+
+	template bool ParticleRecording::ReadFrame(unsigned int Frame, BasicParticleWorld<float> &World);
+	template bool ParticleRecording::ReadFrame(unsigned int Frame, BasicParticleWorld<double> &World);
+	template bool ParticleRecording::ReadFrame(unsigned int Frame, BasicParticleWorld<float, double> &World);
+};
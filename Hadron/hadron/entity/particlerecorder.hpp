@@ -0,0 +1,180 @@
+#ifndef HADRON_PARTICLERECORDER_HPP
+#define HADRON_PARTICLERECORDER_HPP
+
+#include <stdio.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../core/mappedfile.hpp"
+#include "../core/precision.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// Streams every recorded frame's positions and velocities to a file, compressed
+	// ^- Values are quantised to a fixed step, so the error's at most half the step and never builds up
+	// ^- Each frame's stored as the difference from the last one, positions from where they'd be if they kept
+	//    moving in a straight line, which for smooth motion is usually a byte or two per value
+	// ^- Frames are grouped into chunks that each start from absolute values, so a reader can jump to any chunk
+	//    without decoding everything before it
+	// ^- Record only copies the frame into a ring buffer, the compression and writing happen on a background
+	//    thread, and Record only waits if that thread falls a whole buffer behind
+	// ^- The particle count is fixed by the first frame
+	class ParticleRecorder
+	{
+	private:
+		// Quantisation and chunking
+		double positionStep;
+		double velocityStep;
+		unsigned int framesPerChunk;
+
+		// Set by the first frame
+		unsigned int particleCount;
+		unsigned int elementSize;
+
+		// Ring of raw frames, each 6 arrays of particleCount values (position then velocity, X Y Z)
+		// ^- Frame n lives in slot n % slots.size()
+		std::vector<std::vector<unsigned char> > slots;
+		unsigned long long recorded;
+		unsigned long long written;
+		unsigned int stalls;
+
+		std::mutex lock;
+		std::condition_variable frameReady;
+		std::condition_variable slotFree;
+		bool closing;
+		std::thread writer;
+
+		// Only touched by the writer thread from here down
+		FILE *file;
+		bool failed;
+		unsigned long long fileOffset;
+
+		// Quantised values of the last two frames, for the deltas and predictions
+		std::vector<long long> previous;
+		std::vector<long long> beforePrevious;
+
+		// The chunk being built up, the first chunkBytes of the buffer
+		std::vector<unsigned char> chunk;
+		size_t chunkBytes;
+		unsigned int chunkFrames;
+		unsigned long long chunkFirst;
+
+		// Where each chunk starts
+		std::vector<unsigned long long> chunkOffsets;
+		std::vector<unsigned long long> chunkFirstFrames;
+
+		void writerMain();
+
+		// Writes the file header, once the first frame's fixed the particle count
+		void writeHeader();
+
+		// Compresses a frame onto the end of the current chunk
+		void encodeFrame(const unsigned char *Frame);
+
+		// Writes out the current chunk, if it has any frames
+		void flushChunk();
+
+		// fwrite that remembers if anything failed
+		void write(const void *Data, unsigned long long Size);
+
+		// Not copyable
+		ParticleRecorder(const ParticleRecorder &);
+		ParticleRecorder &operator=(const ParticleRecorder &);
+
+	public:
+		// Default constructor
+		ParticleRecorder();
+		~ParticleRecorder();
+
+		// Starts recording to Path, closing any recording already open
+		// ^- PositionStep and VelocityStep are the quantisation steps, in world units
+		// ^- BufferFrames is how many frames Record can get ahead of the writer
+		// ^- Returns false if the file can't be created
+		bool Open(const char *Path, real PositionStep, real VelocityStep, unsigned int FramesPerChunk = 64,
+			unsigned int BufferFrames = 4);
+
+		// Finishes writing every recorded frame and the chunk index
+		// ^- Returns false if anything couldn't be written
+		bool Close();
+
+		// Getters
+		bool IsOpen() const;
+		unsigned int GetFrameCount() const;
+
+		// Number of times Record had to wait for the writer to free up a slot
+		unsigned int GetStallCount() const;
+
+		// Methods
+		// Queues the world's current positions and velocities as the next frame
+		// ^- Returns false if nothing's open or the world's particle count has changed since the first frame
+		template<typename T, typename F>
+		bool Record(const BasicParticleWorld<T, F> &World);
+	};
+
+	// Reads back recordings made by ParticleRecorder
+	// ^- The file's mapped rather than read, and frames are decoded on demand
+	// ^- Reading frames in order decodes just one frame each, any other frame decodes from the start of its chunk
+	// ^- Recordings that weren't closed properly (say the program crashed) are still readable up to the last
+	//    complete chunk, the chunks are found by walking the file when the index is missing
+	class ParticleRecording
+	{
+	private:
+		struct Chunk
+		{
+			unsigned long long firstFrame;
+			unsigned int frameCount;
+			const unsigned char *data;
+			const unsigned char *end;
+		};
+
+		MappedFile file;
+		std::vector<Chunk> chunks;
+
+		unsigned int particleCount;
+		unsigned long long frameCount;
+		double positionStep;
+		double velocityStep;
+
+		// Decoder state, the quantised values of the last decoded frame and the one before it
+		// ^- The cursor points at frame nextFrame of chunk decodedChunk
+		std::vector<long long> current;
+		std::vector<long long> previous;
+		unsigned int decodedChunk;
+		unsigned long long nextFrame;
+		const unsigned char *cursor;
+
+		// Reads the chunk header at the given offset, returning false if any of it's out of bounds
+		bool readChunk(unsigned long long Offset, unsigned long long FirstFrame, Chunk &Out) const;
+
+		// Decodes frames up to and including Frame, returning false if the data's corrupt
+		bool decodeTo(unsigned long long Frame);
+
+	public:
+		// Default constructor
+		ParticleRecording();
+
+		// Maps the recording at Path, returning false if it isn't one
+		bool Open(const char *Path);
+		void Close();
+
+		// Getters
+		bool IsOpen() const;
+		unsigned int GetParticleCount() const;
+		unsigned int GetFrameCount() const;
+		unsigned int GetChunkCount() const;
+		real GetPositionStep() const;
+		real GetVelocityStep() const;
+
+		// Methods
+		// Sets the world's positions and velocities to those of the given frame, resizing it if need be
+		// ^- Everything else about the particles is left as it was
+		// ^- Returns false if the frame's out of range or couldn't be decoded
+		template<typename T, typename F>
+		bool ReadFrame(unsigned int Frame, BasicParticleWorld<T, F> &World);
+	};
+};
+
+#endif // HADRON_PARTICLERECORDER_HPP
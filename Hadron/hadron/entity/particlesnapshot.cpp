@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <string.h>
+#include "particlesnapshot.hpp"
+
+namespace Hadron {
+	/*-----------------------------------------------*\
+	|* File layout                                   *|
+	\*-----------------------------------------------*/
+
+	namespace {
+		const char SNAPSHOT_MAGIC[8] = { 'H', 'D', 'R', 'N', 'S', 'N', 'A', 'P' };
+
+		// Written as a native unsigned int, reads back differently on the other byte order
+		const unsigned int SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+		// Every block starts on a cache line
+		const unsigned long long SNAPSHOT_ALIGNMENT = 64;
+
+		struct SnapshotHeader
+		{
+			char magic[8];
+			unsigned int version;
+			unsigned int byteOrder;
+			unsigned int blockCount;
+			unsigned int reserved;
+			unsigned long long fileSize;
+			unsigned char padding[32];
+		};
+
+		// Follows the header, one per block
+		struct SnapshotTableEntry
+		{
+			unsigned int id;
+			unsigned int elementSize;
+			unsigned long long count;
+			unsigned long long offset;
+			unsigned long long reserved;
+		};
+
+		unsigned long long alignOffset(unsigned long long Offset)
+		{
+			return (Offset + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1);
+		}
+	};
+
+	/*-----------------------------------------------*\
+	|* ParticleSnapshotWriter                        *|
+	\*-----------------------------------------------*/
+
+	ParticleSnapshotWriter::ParticleSnapshotWriter()
+	{ }
+
+	void ParticleSnapshotWriter::AddBlock(unsigned int Id, unsigned int ElementSize, unsigned long long Count, const void *Data)
+	{
+		Block block;
+		block.id = Id;
+		block.elementSize = ElementSize;
+		block.count = Count;
+		block.data = Data;
+
+		for(unsigned int i = 0; i < blocks.size(); i++)
+		{
+			if(blocks[i].id == Id)
+			{
+				blocks[i] = block;
+				return;
+			}
+		}
+
+		blocks.push_back(block);
+	}
+
+	template<typename T, typename F>
+	void ParticleSnapshotWriter::AddWorld(const BasicParticleWorld<T, F> &World)
+	{
+		const unsigned long long count = World.GetCount();
+
+		AddBlock(SNAPSHOT_BLOCK_POSITION_X, sizeof(T), count, World.GetPositionsX());
+		AddBlock(SNAPSHOT_BLOCK_POSITION_Y, sizeof(T), count, World.GetPositionsY());
+		AddBlock(SNAPSHOT_BLOCK_POSITION_Z, sizeof(T), count, World.GetPositionsZ());
+		AddBlock(SNAPSHOT_BLOCK_VELOCITY_X, sizeof(T), count, World.GetVelocitiesX());
+		AddBlock(SNAPSHOT_BLOCK_VELOCITY_Y, sizeof(T), count, World.GetVelocitiesY());
+		AddBlock(SNAPSHOT_BLOCK_VELOCITY_Z, sizeof(T), count, World.GetVelocitiesZ());
+		AddBlock(SNAPSHOT_BLOCK_ACCELERATION_X, sizeof(T), count, World.GetAccelerationsX());
+		AddBlock(SNAPSHOT_BLOCK_ACCELERATION_Y, sizeof(T), count, World.GetAccelerationsY());
+		AddBlock(SNAPSHOT_BLOCK_ACCELERATION_Z, sizeof(T), count, World.GetAccelerationsZ());
+		AddBlock(SNAPSHOT_BLOCK_FORCE_X, sizeof(F), count, World.GetForcesX());
+		AddBlock(SNAPSHOT_BLOCK_FORCE_Y, sizeof(F), count, World.GetForcesY());
+		AddBlock(SNAPSHOT_BLOCK_FORCE_Z, sizeof(F), count, World.GetForcesZ());
+		AddBlock(SNAPSHOT_BLOCK_DAMPING, sizeof(T), count, World.GetDampings());
+		AddBlock(SNAPSHOT_BLOCK_INVERSE_MASS, sizeof(T), count, World.GetInverseMasses());
+		AddBlock(SNAPSHOT_BLOCK_ALIVE, sizeof(unsigned char), count, World.GetAliveFlags());
+	}
+
+	void ParticleSnapshotWriter::AddSprings(const SpringNetwork &Network)
+	{
+		const unsigned long long count = Network.GetCount();
+
+		AddBlock(SNAPSHOT_BLOCK_SPRING_A, sizeof(unsigned int), count, Network.GetParticlesA());
+		AddBlock(SNAPSHOT_BLOCK_SPRING_B, sizeof(unsigned int), count, Network.GetParticlesB());
+		AddBlock(SNAPSHOT_BLOCK_SPRING_STIFFNESS, sizeof(real), count, Network.GetStiffnesses());
+		AddBlock(SNAPSHOT_BLOCK_SPRING_REST_LENGTH, sizeof(real), count, Network.GetRestLengths());
+		AddBlock(SNAPSHOT_BLOCK_SPRING_DAMPING, sizeof(real), count, Network.GetDampings());
+	}
+
+	void ParticleSnapshotWriter::Clear()
+	{
+		blocks.clear();
+	}
+
+	bool ParticleSnapshotWriter::Write(const char *Path) const
+	{
+		// Lay the blocks out after the table
+		std::vector<SnapshotTableEntry> table(blocks.size());
+		unsigned long long offset = alignOffset(sizeof(SnapshotHeader) + (table.size() * sizeof(SnapshotTableEntry)));
+
+		for(unsigned int i = 0; i < blocks.size(); i++)
+		{
+			table[i].id = blocks[i].id;
+			table[i].elementSize = blocks[i].elementSize;
+			table[i].count = blocks[i].count;
+			table[i].offset = offset;
+			table[i].reserved = 0;
+
+			offset = alignOffset(offset + (blocks[i].count * blocks[i].elementSize));
+		}
+
+		SnapshotHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+		header.version = ParticleSnapshot::VERSION;
+		header.byteOrder = SNAPSHOT_BYTE_ORDER;
+		header.blockCount = (unsigned int)blocks.size();
+		header.fileSize = offset;
+
+		FILE *file = fopen(Path, "wb");
+		if(file == NULL) return false;
+
+		const unsigned char padding[SNAPSHOT_ALIGNMENT] = { 0 };
+		unsigned long long written = 0;
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		written += sizeof(header);
+
+		if(ok && !table.empty())
+		{
+			ok = fwrite(&table[0], sizeof(SnapshotTableEntry), table.size(), file) == table.size();
+			written += table.size() * sizeof(SnapshotTableEntry);
+		}
+
+		for(unsigned int i = 0; ok && i < blocks.size(); i++)
+		{
+			const unsigned long long gap = table[i].offset - written;
+			ok = gap == 0 || fwrite(padding, 1, (size_t)gap, file) == gap;
+
+			const unsigned long long bytes = blocks[i].count * blocks[i].elementSize;
+			ok = ok && (bytes == 0 || fwrite(blocks[i].data, 1, (size_t)bytes, file) == bytes);
+			written = table[i].offset + bytes;
+		}
+
+		// Pad the last block out too, so the file's size matches the header
+		if(ok && header.fileSize > written)
+		{
+			ok = fwrite(padding, 1, (size_t)(header.fileSize - written), file) == header.fileSize - written;
+		}
+
+		if(fclose(file) != 0) ok = false;
+		return ok;
+	}
+
+	/*-----------------------------------------------*\
+	|* ParticleSnapshot                              *|
+	\*-----------------------------------------------*/
+
+	const unsigned int ParticleSnapshot::VERSION = 1;
+
+	ParticleSnapshot::ParticleSnapshot()
+	{ }
+
+	template<typename T, typename F>
+	bool ParticleSnapshot::Save(const char *Path, const BasicParticleWorld<T, F> &World, const SpringNetwork *Network)
+	{
+		ParticleSnapshotWriter writer;
+		writer.AddWorld(World);
+		if(Network != NULL) writer.AddSprings(*Network);
+
+		return writer.Write(Path);
+	}
+
+	bool ParticleSnapshot::Open(const char *Path)
+	{
+		Close();
+		if(!file.Open(Path)) return false;
+
+		const unsigned char *data = file.GetData();
+		const unsigned long long size = file.GetSize();
+
+		SnapshotHeader header;
+		if(size < sizeof(header))
+		{
+			Close();
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		if(memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION ||
+			header.byteOrder != SNAPSHOT_BYTE_ORDER || header.fileSize > size ||
+			header.blockCount > (size - sizeof(header)) / sizeof(SnapshotTableEntry))
+		{
+			Close();
+			return false;
+		}
+
+		blocks.resize(header.blockCount);
+		for(unsigned int i = 0; i < header.blockCount; i++)
+		{
+			SnapshotTableEntry entry;
+			memcpy(&entry, data + sizeof(header) + (i * sizeof(SnapshotTableEntry)), sizeof(entry));
+
+			// Everything has to lie inside the file, checked so a huge count can't overflow the end
+			if(entry.offset > size || entry.elementSize == 0 || entry.count > (size - entry.offset) / entry.elementSize)
+			{
+				Close();
+				return false;
+			}
+
+			blocks[i].id = entry.id;
+			blocks[i].elementSize = entry.elementSize;
+			blocks[i].count = entry.count;
+			blocks[i].data = data + entry.offset;
+		}
+
+		return true;
+	}
+
+	void ParticleSnapshot::Close()
+	{
+		blocks.clear();
+		file.Close();
+	}
+
+	bool ParticleSnapshot::IsOpen() const
+	{
+		return file.IsOpen();
+	}
+
+	unsigned int ParticleSnapshot::GetParticleCount() const
+	{
+		const Block *block = findBlock(SNAPSHOT_BLOCK_POSITION_X);
+		return block == NULL ? 0 : (unsigned int)block->count;
+	}
+
+	unsigned int ParticleSnapshot::GetSpringCount() const
+	{
+		const Block *block = findBlock(SNAPSHOT_BLOCK_SPRING_A);
+		return block == NULL ? 0 : (unsigned int)block->count;
+	}
+
+	unsigned int ParticleSnapshot::GetBlockCount() const
+	{
+		return (unsigned int)blocks.size();
+	}
+
+	unsigned int ParticleSnapshot::GetBlockId(unsigned int Index) const
+	{
+		return blocks[Index].id;
+	}
+
+	const void *ParticleSnapshot::GetBlock(unsigned int Id, unsigned long long *Count, unsigned int *ElementSize) const
+	{
+		const Block *block = findBlock(Id);
+		if(block == NULL) return NULL;
+
+		if(Count != NULL) *Count = block->count;
+		if(ElementSize != NULL) *ElementSize = block->elementSize;
+		return block->data;
+	}
+
+	const ParticleSnapshot::Block *ParticleSnapshot::findBlock(unsigned int Id) const
+	{
+		for(unsigned int i = 0; i < blocks.size(); i++)
+		{
+			if(blocks[i].id == Id) return &blocks[i];
+		}
+
+		return NULL;
+	}
+
+	template<typename T>
+	bool ParticleSnapshot::copyScalars(unsigned int Id, unsigned long long Count, T *Destination) const
+	{
+		const Block *block = findBlock(Id);
+		if(block == NULL || block->count != Count) return false;
+
+		if(block->elementSize == sizeof(T))
+		{
+			if(Count > 0) memcpy(Destination, block->data, (size_t)(Count * sizeof(T)));
+			return true;
+		}
+
+		// Saved at the other precision
+		if(block->elementSize == sizeof(float))
+		{
+			const float *source = (const float *)block->data;
+			for(unsigned long long i = 0; i < Count; i++) Destination[i] = (T)source[i];
+			return true;
+		}
+
+		if(block->elementSize == sizeof(double))
+		{
+			const double *source = (const double *)block->data;
+			for(unsigned long long i = 0; i < Count; i++) Destination[i] = (T)source[i];
+			return true;
+		}
+
+		return false;
+	}
+
+	template<typename T, typename F>
+	bool ParticleSnapshot::Restore(BasicParticleWorld<T, F> &World, SpringNetwork *Network) const
+	{
+		// Check everything first, so a bad snapshot doesn't leave the world half restored
+		const Block *positions = findBlock(SNAPSHOT_BLOCK_POSITION_X);
+		if(positions == NULL) return false;
+
+		// World indices are unsigned ints
+		const unsigned long long count = positions->count;
+		if(count > 0xFFFFFFFFull) return false;
+
+		for(unsigned int id = SNAPSHOT_BLOCK_POSITION_X; id <= SNAPSHOT_BLOCK_ALIVE; id++)
+		{
+			const Block *block = findBlock(id);
+			if(block == NULL) continue;
+
+			const bool scalar = block->elementSize == sizeof(float) || block->elementSize == sizeof(double);
+			const bool valid = id == SNAPSHOT_BLOCK_ALIVE ? block->elementSize == sizeof(unsigned char) : scalar;
+			if(block->count != count || !valid) return false;
+		}
+
+		const Block *springs = Network != NULL ? findBlock(SNAPSHOT_BLOCK_SPRING_A) : NULL;
+		if(springs != NULL)
+		{
+			for(unsigned int id = SNAPSHOT_BLOCK_SPRING_A; id <= SNAPSHOT_BLOCK_SPRING_DAMPING; id++)
+			{
+				const Block *block = findBlock(id);
+				const bool index = id == SNAPSHOT_BLOCK_SPRING_A || id == SNAPSHOT_BLOCK_SPRING_B;
+				const unsigned int size = block == NULL ? 0 : block->elementSize;
+				const bool valid = index ? size == sizeof(unsigned int) : size == sizeof(float) || size == sizeof(double);
+				if(block == NULL || block->count != springs->count || !valid) return false;
+			}
+
+			if(springs->count > 0xFFFFFFFFull) return false;
+
+			// Every spring has to end on a restored particle, or the network would read and write past the world
+			const unsigned int *a = (const unsigned int *)springs->data;
+			const unsigned int *b = (const unsigned int *)findBlock(SNAPSHOT_BLOCK_SPRING_B)->data;
+			for(unsigned long long s = 0; s < springs->count; s++)
+			{
+				if(a[s] >= count || b[s] >= count) return false;
+			}
+		}
+
+		// Cleared first so anything that wasn't saved comes out at the defaults
+		World.Clear();
+		World.Resize((unsigned int)count);
+
+		copyScalars(SNAPSHOT_BLOCK_POSITION_X, count, World.GetPositionsX());
+		copyScalars(SNAPSHOT_BLOCK_POSITION_Y, count, World.GetPositionsY());
+		copyScalars(SNAPSHOT_BLOCK_POSITION_Z, count, World.GetPositionsZ());
+		copyScalars(SNAPSHOT_BLOCK_VELOCITY_X, count, World.GetVelocitiesX());
+		copyScalars(SNAPSHOT_BLOCK_VELOCITY_Y, count, World.GetVelocitiesY());
+		copyScalars(SNAPSHOT_BLOCK_VELOCITY_Z, count, World.GetVelocitiesZ());
+		copyScalars(SNAPSHOT_BLOCK_ACCELERATION_X, count, World.GetAccelerationsX());
+		copyScalars(SNAPSHOT_BLOCK_ACCELERATION_Y, count, World.GetAccelerationsY());
+		copyScalars(SNAPSHOT_BLOCK_ACCELERATION_Z, count, World.GetAccelerationsZ());
+		copyScalars(SNAPSHOT_BLOCK_FORCE_X, count, World.GetForcesX());
+		copyScalars(SNAPSHOT_BLOCK_FORCE_Y, count, World.GetForcesY());
+		copyScalars(SNAPSHOT_BLOCK_FORCE_Z, count, World.GetForcesZ());
+
+		// The rest only have bulk setters, the damping one working the factors out again
+		std::vector<T> scratch((size_t)count);
+		if(count > 0 && copyScalars(SNAPSHOT_BLOCK_DAMPING, count, &scratch[0])) World.SetDampings(&scratch[0]);
+		if(count > 0 && copyScalars(SNAPSHOT_BLOCK_INVERSE_MASS, count, &scratch[0])) World.SetInverseMasses(&scratch[0]);
+
+		const Block *alive = findBlock(SNAPSHOT_BLOCK_ALIVE);
+		if(alive != NULL && count > 0) World.SetAliveFlags(alive->data);
+
+		if(springs != NULL)
+		{
+			const unsigned long long springCount = springs->count;
+			std::vector<real> stiffness((size_t)springCount), restLength((size_t)springCount), damping((size_t)springCount);
+
+			if(springCount > 0)
+			{
+				copyScalars(SNAPSHOT_BLOCK_SPRING_STIFFNESS, springCount, &stiffness[0]);
+				copyScalars(SNAPSHOT_BLOCK_SPRING_REST_LENGTH, springCount, &restLength[0]);
+				copyScalars(SNAPSHOT_BLOCK_SPRING_DAMPING, springCount, &damping[0]);
+
+				Network->Assign((unsigned int)springCount, (const unsigned int *)springs->data,
+					(const unsigned int *)findBlock(SNAPSHOT_BLOCK_SPRING_B)->data, &stiffness[0], &restLength[0], &damping[0]);
+			}
+			else
+			{
+				Network->Clear();
+			}
+		}
+
+		return true;
+	}
+
+	template void ParticleSnapshotWriter::AddWorld(const BasicParticleWorld<float> &World);
+	template void ParticleSnapshotWriter::AddWorld(const BasicParticleWorld<double> &World);
+	template void ParticleSnapshotWriter::AddWorld(const BasicParticleWorld<float, double> &World);
+
+	template bool ParticleSnapshot::Save(const char *Path, const BasicParticleWorld<float> &World, const SpringNetwork *Network);
+	template bool ParticleSnapshot::Save(const char *Path, const BasicParticleWorld<double> &World, const SpringNetwork *Network);
+	template bool ParticleSnapshot::Save(const char *Path, const BasicParticleWorld<float, double> &World, const SpringNetwork *Network);
+
+	template bool ParticleSnapshot::Restore(BasicParticleWorld<float> &World, SpringNetwork *Network) const;
+	template bool ParticleSnapshot::Restore(BasicParticleWorld<double> &World, SpringNetwork *Network) const;
+	template bool ParticleSnapshot::Restore(BasicParticleWorld<float, double> &World, SpringNetwork *Network) const;
+};
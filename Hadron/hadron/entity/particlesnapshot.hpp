@@ -0,0 +1,155 @@
+#ifndef HADRON_PARTICLESNAPSHOT_HPP
+#define HADRON_PARTICLESNAPSHOT_HPP
+
+#include <vector>
+
+#include "../core/mappedfile.hpp"
+#include "../core/precision.hpp"
+#include "particleworld.hpp"
+#include "springnetwork.hpp"
+
+namespace Hadron {
+	// Block ids used in snapshot files
+	// ^- Ids from SNAPSHOT_BLOCK_USER up are free for applications to store their own data alongside the world
+	enum SnapshotBlock
+	{
+		SNAPSHOT_BLOCK_POSITION_X = 1,
+		SNAPSHOT_BLOCK_POSITION_Y,
+		SNAPSHOT_BLOCK_POSITION_Z,
+		SNAPSHOT_BLOCK_VELOCITY_X,
+		SNAPSHOT_BLOCK_VELOCITY_Y,
+		SNAPSHOT_BLOCK_VELOCITY_Z,
+		SNAPSHOT_BLOCK_ACCELERATION_X,
+		SNAPSHOT_BLOCK_ACCELERATION_Y,
+		SNAPSHOT_BLOCK_ACCELERATION_Z,
+		SNAPSHOT_BLOCK_FORCE_X,
+		SNAPSHOT_BLOCK_FORCE_Y,
+		SNAPSHOT_BLOCK_FORCE_Z,
+		SNAPSHOT_BLOCK_DAMPING,
+		SNAPSHOT_BLOCK_INVERSE_MASS,
+		SNAPSHOT_BLOCK_ALIVE,
+
+		SNAPSHOT_BLOCK_SPRING_A = 32,
+		SNAPSHOT_BLOCK_SPRING_B,
+		SNAPSHOT_BLOCK_SPRING_STIFFNESS,
+		SNAPSHOT_BLOCK_SPRING_REST_LENGTH,
+		SNAPSHOT_BLOCK_SPRING_DAMPING,
+
+		SNAPSHOT_BLOCK_USER = 0x10000
+	};
+
+	// Writes snapshot files
+	// ^- A snapshot is a small header and block table followed by each block's raw array, 64 byte aligned, so a
+	//    reader can map the file and point straight at the data
+	// ^- Blocks are only referenced until Write, nothing's copied, so the arrays mustn't change in between
+	// ^- Files are in the machine's own byte order, readers on the other endianness reject them
+	class ParticleSnapshotWriter
+	{
+	private:
+		struct Block
+		{
+			unsigned int id;
+			unsigned int elementSize;
+			unsigned long long count;
+			const void *data;
+		};
+
+		std::vector<Block> blocks;
+
+	public:
+		// Default constructor
+		ParticleSnapshotWriter();
+
+		// Adds a block of Count elements, each ElementSize bytes
+		// ^- Adding an id that's already there replaces it
+		void AddBlock(unsigned int Id, unsigned int ElementSize, unsigned long long Count, const void *Data);
+
+		// Adds every per-particle array of the world
+		template<typename T, typename F>
+		void AddWorld(const BasicParticleWorld<T, F> &World);
+
+		// Adds the springs and their constants
+		void AddSprings(const SpringNetwork &Network);
+
+		// Removes every block
+		void Clear();
+
+		// Writes the snapshot out, returning false if the file couldn't be written
+		// ^- Each block goes out in a single fwrite, so it's bounded by disk bandwidth rather than formatting
+		bool Write(const char *Path) const;
+	};
+
+	// A snapshot file mapped into memory
+	// ^- Opening only reads the header and block table, block data is paged in as it's touched
+	// ^- GetBlock points straight into the mapping, so anything that just reads the state (a renderer, an
+	//    analysis pass) can use it with no copying at all, Restore is one memcpy per array
+	class ParticleSnapshot
+	{
+	private:
+		struct Block
+		{
+			unsigned int id;
+			unsigned int elementSize;
+			unsigned long long count;
+			const unsigned char *data;
+		};
+
+		MappedFile file;
+		std::vector<Block> blocks;
+
+		// Finds a block, NULL if it's not in the snapshot
+		const Block *findBlock(unsigned int Id) const;
+
+		// Copies a block of floats or doubles into Destination, converting to T if need be
+		// ^- Returns false if the block's missing or the wrong length
+		template<typename T>
+		bool copyScalars(unsigned int Id, unsigned long long Count, T *Destination) const;
+
+	public:
+		// Current file format version
+		static const unsigned int VERSION;
+
+		// Default constructor
+		ParticleSnapshot();
+
+		// Saves the world, and the springs if there are any, to Path
+		template<typename T, typename F>
+		static bool Save(const char *Path, const BasicParticleWorld<T, F> &World, const SpringNetwork *Network = NULL);
+
+		// Maps the snapshot at Path, closing anything already open
+		// ^- Returns false if it can't be mapped, isn't a snapshot, is a version or byte order we can't read, or
+		//    any of its blocks run past the end of the file
+		bool Open(const char *Path);
+
+		// Unmaps the snapshot, invalidating any block pointers
+		void Close();
+
+		// Getters
+		bool IsOpen() const;
+
+		// Number of particles, the length of the position blocks
+		unsigned int GetParticleCount() const;
+
+		// Number of springs, 0 if none were saved
+		unsigned int GetSpringCount() const;
+
+		unsigned int GetBlockCount() const;
+		unsigned int GetBlockId(unsigned int Index) const;
+
+		// Returns a pointer to the block's data in the mapping, NULL if it isn't there
+		// ^- Count and ElementSize are filled in when they're not NULL
+		const void *GetBlock(unsigned int Id, unsigned long long *Count = NULL, unsigned int *ElementSize = NULL) const;
+
+		// Methods
+		// Loads the snapshot into World, resizing it to match
+		// ^- Scalars are converted if the world's precision differs from the one that was saved
+		// ^- Blocks that weren't saved are left at the values Add gives new particles
+		// ^- Springs are only restored if Network isn't NULL
+		// ^- Returns false, leaving World and Network as they were, if the snapshot doesn't hold a valid world, say
+		//    with more particles than a world can index or springs ending on particles it doesn't have
+		template<typename T, typename F>
+		bool Restore(BasicParticleWorld<T, F> &World, SpringNetwork *Network = NULL) const;
+	};
+};
+
+#endif // HADRON_PARTICLESNAPSHOT_HPP
@@ -0,0 +1,806 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "particleworld.hpp"
+#include "../core/parallel.hpp"
+
+namespace Hadron {
+	namespace {
+		// Field[i] = old Field[Order[i]], going through Scratch and swapping so nothing's allocated once it's warm
+		template<typename V>
+		void permute(std::vector<V> &Field, std::vector<V> &Scratch, const unsigned int *Order, ThreadPool *Pool)
+		{
+			const unsigned int count = (unsigned int)Field.size();
+			Scratch.resize(count);
+
+			ParallelFor(Pool, 0, count, [&](unsigned int Begin, unsigned int End)
+			{
+				for(unsigned int i = Begin; i < End; i++)
+				{
+					Scratch[i] = Field[Order[i]];
+				}
+			});
+
+			Field.swap(Scratch);
+		}
+	};
+
+	/*-------------------------------------*\
+	|* ParticleView                        *|
+	\*-------------------------------------*/
+	template<typename T, typename F>
+	BasicParticleWorld<T, F>::ParticleView::ParticleView(BasicParticleWorld *World, unsigned int Index):
+	world(World),
+	index(Index)
+	{ }
+
+	template<typename T, typename F>
+	unsigned int BasicParticleWorld<T, F>::ParticleView::GetIndex() const
+	{
+		return index;
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::ParticleView::GetKineticEnergy() const
+	{
+		return IsAlive() ? (T)(0.5 * (1.0 / world->inverseMass[index]) * GetVelocity().LengthSquared()) : (T)0.0;
+	}
+
+	template<typename T, typename F>
+	Vector3<T> BasicParticleWorld<T, F>::ParticleView::GetPosition() const
+	{
+		return Vector3<T>(world->posX[index], world->posY[index], world->posZ[index]);
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::ParticleView::GetX() const
+	{
+		return world->posX[index];
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::ParticleView::GetY() const
+	{
+		return world->posY[index];
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::ParticleView::GetZ() const
+	{
+		return world->posZ[index];
+	}
+
+	template<typename T, typename F>
+	Vector3<T> BasicParticleWorld<T, F>::ParticleView::GetVelocity() const
+	{
+		return Vector3<T>(world->velX[index], world->velY[index], world->velZ[index]);
+	}
+
+	template<typename T, typename F>
+	Vector3<T> BasicParticleWorld<T, F>::ParticleView::GetAcceleration() const
+	{
+		return Vector3<T>(world->accX[index], world->accY[index], world->accZ[index]);
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::ParticleView::GetMass() const
+	{
+		// Infinite mass
+		if(world->inverseMass[index] == 0)
+			return ScalarTraits<T>::Max();
+
+		return (T)1.0 / world->inverseMass[index];
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::ParticleView::GetInverseMass() const
+	{
+		return world->inverseMass[index];
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::ParticleView::GetDamping() const
+	{
+		return world->damping[index];
+	}
+
+	template<typename T, typename F>
+	bool BasicParticleWorld<T, F>::ParticleView::IsAlive() const
+	{
+		return world->alive[index] != 0;
+	}
+
+	template<typename T, typename F>
+	bool BasicParticleWorld<T, F>::ParticleView::IsAwake() const
+	{
+		return world->asleep[index] == 0;
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetPosition(const Vector3<T> &Position)
+	{
+		SetPosition(Position.x, Position.y, Position.z);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetPosition(T X, T Y, T Z)
+	{
+		world->posX[index] = X;
+		world->posY[index] = Y;
+		world->posZ[index] = Z;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetX(T X)
+	{
+		world->posX[index] = X;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetY(T Y)
+	{
+		world->posY[index] = Y;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetZ(T Z)
+	{
+		world->posZ[index] = Z;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetVelocity(const Vector3<T> &Velocity)
+	{
+		SetVelocity(Velocity.x, Velocity.y, Velocity.z);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetVelocity(T X, T Y, T Z)
+	{
+		world->velX[index] = X;
+		world->velY[index] = Y;
+		world->velZ[index] = Z;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetVelocityX(T X)
+	{
+		world->velX[index] = X;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetVelocityY(T Y)
+	{
+		world->velY[index] = Y;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetVelocityZ(T Z)
+	{
+		world->velZ[index] = Z;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetAcceleration(const Vector3<T> &Acceleration)
+	{
+		SetAcceleration(Acceleration.x, Acceleration.y, Acceleration.z);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetAcceleration(T X, T Y, T Z)
+	{
+		world->accX[index] = X;
+		world->accY[index] = Y;
+		world->accZ[index] = Z;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetMass(T Mass)
+	{
+		if(Mass <= (T)0.0)
+		{
+			// Don't have zero mass, just have very, very low
+			world->inverseMass[index] = (T)1.0 / ScalarTraits<T>::Max();
+		}
+		else
+		{
+			world->inverseMass[index] = (T)1.0 / ScalarTraits<T>::Abs(Mass);
+		}
+
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetDamping(T Damping)
+	{
+		world->damping[index] = Damping;
+		world->dampingFactor[index] = ScalarTraits<T>::Pow(Damping, world->dampingStep);
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::SetAlive(bool Alive)
+	{
+		world->alive[index] = Alive ? 1 : 0;
+		Wake();
+
+		// Just in case
+		if(Alive)
+		{
+			world->forceX[index] = (F)0.0;
+			world->forceY[index] = (F)0.0;
+			world->forceZ[index] = (F)0.0;
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::ApplyForce(const Vector3<F> &Force)
+	{
+		ApplyForce(Force.x, Force.y, Force.z);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::ApplyForce(F X, F Y, F Z)
+	{
+		world->forceX[index] += X;
+		world->forceY[index] += Y;
+		world->forceZ[index] += Z;
+		Wake();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ParticleView::Wake()
+	{
+		world->asleep[index] = 0;
+		world->restSteps[index] = 0;
+	}
+
+	/*-------------------------------------*\
+	|* BasicParticleWorld                  *|
+	\*-------------------------------------*/
+	template<typename T, typename F>
+	BasicParticleWorld<T, F>::BasicParticleWorld():
+	dampingStep((T)0.0),
+	sleepSpeed((T)0.0),
+	sleepAcceleration((T)0.0),
+	sleepSteps(0)
+	{ }
+
+	template<typename T, typename F>
+	unsigned int BasicParticleWorld<T, F>::Add()
+	{
+		posX.push_back((T)0.0);
+		posY.push_back((T)0.0);
+		posZ.push_back((T)0.0);
+
+		velX.push_back((T)0.0);
+		velY.push_back((T)0.0);
+		velZ.push_back((T)0.0);
+
+		accX.push_back(Vector3<T>::GRAVITY.x);
+		accY.push_back(Vector3<T>::GRAVITY.y);
+		accZ.push_back(Vector3<T>::GRAVITY.z);
+
+		forceX.push_back((F)0.0);
+		forceY.push_back((F)0.0);
+		forceZ.push_back((F)0.0);
+
+		damping.push_back((T)0.9999);
+		dampingFactor.push_back(ScalarTraits<T>::Pow((T)0.9999, dampingStep));
+		inverseMass.push_back((T)1.0);
+		alive.push_back(0);
+
+		restSteps.push_back(0);
+		asleep.push_back(0);
+		sleepForceX.push_back((F)0.0);
+		sleepForceY.push_back((F)0.0);
+		sleepForceZ.push_back((F)0.0);
+
+		return (unsigned int)alive.size() - 1;
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::Reserve(unsigned int Count)
+	{
+		posX.reserve(Count); posY.reserve(Count); posZ.reserve(Count);
+		velX.reserve(Count); velY.reserve(Count); velZ.reserve(Count);
+		accX.reserve(Count); accY.reserve(Count); accZ.reserve(Count);
+		forceX.reserve(Count); forceY.reserve(Count); forceZ.reserve(Count);
+		damping.reserve(Count);
+		dampingFactor.reserve(Count);
+		inverseMass.reserve(Count);
+		alive.reserve(Count);
+		restSteps.reserve(Count);
+		asleep.reserve(Count);
+		sleepForceX.reserve(Count); sleepForceY.reserve(Count); sleepForceZ.reserve(Count);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::Resize(unsigned int Count)
+	{
+		// Whole array resizes rather than Adds, so growing by millions of particles is one fill per field
+		posX.resize(Count, (T)0.0); posY.resize(Count, (T)0.0); posZ.resize(Count, (T)0.0);
+		velX.resize(Count, (T)0.0); velY.resize(Count, (T)0.0); velZ.resize(Count, (T)0.0);
+		accX.resize(Count, Vector3<T>::GRAVITY.x);
+		accY.resize(Count, Vector3<T>::GRAVITY.y);
+		accZ.resize(Count, Vector3<T>::GRAVITY.z);
+		forceX.resize(Count, (F)0.0); forceY.resize(Count, (F)0.0); forceZ.resize(Count, (F)0.0);
+		damping.resize(Count, (T)0.9999);
+		dampingFactor.resize(Count, ScalarTraits<T>::Pow((T)0.9999, dampingStep));
+		inverseMass.resize(Count, (T)1.0);
+		alive.resize(Count, 0);
+		restSteps.resize(Count, 0);
+		asleep.resize(Count, 0);
+		sleepForceX.resize(Count, (F)0.0); sleepForceY.resize(Count, (F)0.0); sleepForceZ.resize(Count, (F)0.0);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::Clear()
+	{
+		posX.clear(); posY.clear(); posZ.clear();
+		velX.clear(); velY.clear(); velZ.clear();
+		accX.clear(); accY.clear(); accZ.clear();
+		forceX.clear(); forceY.clear(); forceZ.clear();
+		damping.clear();
+		dampingFactor.clear();
+		inverseMass.clear();
+		alive.clear();
+		restSteps.clear();
+		asleep.clear();
+		sleepForceX.clear(); sleepForceY.clear(); sleepForceZ.clear();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::Reorder(const unsigned int *Order, ThreadPool *Pool)
+	{
+		const unsigned int count = GetCount();
+		if(count == 0) return;
+
+		HADRON_PROFILE_SCOPE("world reorder");
+
+		permute(posX, reorderScalars, Order, Pool);
+		permute(posY, reorderScalars, Order, Pool);
+		permute(posZ, reorderScalars, Order, Pool);
+		permute(velX, reorderScalars, Order, Pool);
+		permute(velY, reorderScalars, Order, Pool);
+		permute(velZ, reorderScalars, Order, Pool);
+		permute(accX, reorderScalars, Order, Pool);
+		permute(accY, reorderScalars, Order, Pool);
+		permute(accZ, reorderScalars, Order, Pool);
+		permute(forceX, reorderForces, Order, Pool);
+		permute(forceY, reorderForces, Order, Pool);
+		permute(forceZ, reorderForces, Order, Pool);
+		permute(damping, reorderScalars, Order, Pool);
+		permute(dampingFactor, reorderScalars, Order, Pool);
+		permute(inverseMass, reorderScalars, Order, Pool);
+		permute(alive, reorderFlags, Order, Pool);
+		permute(restSteps, reorderCounts, Order, Pool);
+		permute(asleep, reorderFlags, Order, Pool);
+		permute(sleepForceX, reorderForces, Order, Pool);
+		permute(sleepForceY, reorderForces, Order, Pool);
+		permute(sleepForceZ, reorderForces, Order, Pool);
+
+		if(remapListeners.empty()) return;
+
+		// Listeners want to know where each particle went, rather than where each one came from
+		reorderIndices.resize(count);
+		ParallelFor(Pool, 0, count, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int i = Begin; i < End; i++)
+			{
+				reorderIndices[Order[i]] = i;
+			}
+		});
+
+		for(unsigned int l = 0; l < remapListeners.size(); l++)
+		{
+			remapListeners[l]->RemapParticles(&reorderIndices[0], count);
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::AddRemapListener(ParticleRemapListener *Listener)
+	{
+		if(std::find(remapListeners.begin(), remapListeners.end(), Listener) == remapListeners.end())
+			remapListeners.push_back(Listener);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::RemoveRemapListener(ParticleRemapListener *Listener)
+	{
+		remapListeners.erase(std::remove(remapListeners.begin(), remapListeners.end(), Listener), remapListeners.end());
+	}
+
+	template<typename T, typename F>
+	unsigned int BasicParticleWorld<T, F>::GetCount() const
+	{
+		return (unsigned int)alive.size();
+	}
+
+	template<typename T, typename F>
+	typename BasicParticleWorld<T, F>::ParticleView BasicParticleWorld<T, F>::Get(unsigned int Index)
+	{
+		return ParticleView(this, Index);
+	}
+
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetPositionsX() { return posX.empty() ? NULL : &posX[0]; }
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetPositionsY() { return posY.empty() ? NULL : &posY[0]; }
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetPositionsZ() { return posZ.empty() ? NULL : &posZ[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetPositionsX() const { return posX.empty() ? NULL : &posX[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetPositionsY() const { return posY.empty() ? NULL : &posY[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetPositionsZ() const { return posZ.empty() ? NULL : &posZ[0]; }
+
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetVelocitiesX() { return velX.empty() ? NULL : &velX[0]; }
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetVelocitiesY() { return velY.empty() ? NULL : &velY[0]; }
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetVelocitiesZ() { return velZ.empty() ? NULL : &velZ[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetVelocitiesX() const { return velX.empty() ? NULL : &velX[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetVelocitiesY() const { return velY.empty() ? NULL : &velY[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetVelocitiesZ() const { return velZ.empty() ? NULL : &velZ[0]; }
+
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetAccelerationsX() { return accX.empty() ? NULL : &accX[0]; }
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetAccelerationsY() { return accY.empty() ? NULL : &accY[0]; }
+	template<typename T, typename F>
+	T *BasicParticleWorld<T, F>::GetAccelerationsZ() { return accZ.empty() ? NULL : &accZ[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetAccelerationsX() const { return accX.empty() ? NULL : &accX[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetAccelerationsY() const { return accY.empty() ? NULL : &accY[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetAccelerationsZ() const { return accZ.empty() ? NULL : &accZ[0]; }
+
+	template<typename T, typename F>
+	F *BasicParticleWorld<T, F>::GetForcesX() { return forceX.empty() ? NULL : &forceX[0]; }
+	template<typename T, typename F>
+	F *BasicParticleWorld<T, F>::GetForcesY() { return forceY.empty() ? NULL : &forceY[0]; }
+	template<typename T, typename F>
+	F *BasicParticleWorld<T, F>::GetForcesZ() { return forceZ.empty() ? NULL : &forceZ[0]; }
+	template<typename T, typename F>
+	const F *BasicParticleWorld<T, F>::GetForcesX() const { return forceX.empty() ? NULL : &forceX[0]; }
+	template<typename T, typename F>
+	const F *BasicParticleWorld<T, F>::GetForcesY() const { return forceY.empty() ? NULL : &forceY[0]; }
+	template<typename T, typename F>
+	const F *BasicParticleWorld<T, F>::GetForcesZ() const { return forceZ.empty() ? NULL : &forceZ[0]; }
+
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetInverseMasses() const { return inverseMass.empty() ? NULL : &inverseMass[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetDampings() const { return damping.empty() ? NULL : &damping[0]; }
+	template<typename T, typename F>
+	const T *BasicParticleWorld<T, F>::GetDampingFactors() const { return dampingFactor.empty() ? NULL : &dampingFactor[0]; }
+	template<typename T, typename F>
+	const unsigned char *BasicParticleWorld<T, F>::GetAliveFlags() const { return alive.empty() ? NULL : &alive[0]; }
+	template<typename T, typename F>
+	const unsigned char *BasicParticleWorld<T, F>::GetSleepFlags() const { return asleep.empty() ? NULL : &asleep[0]; }
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::GetSleepSpeed() const
+	{
+		return sleepSpeed;
+	}
+
+	template<typename T, typename F>
+	T BasicParticleWorld<T, F>::GetSleepAcceleration() const
+	{
+		return sleepAcceleration;
+	}
+
+	template<typename T, typename F>
+	unsigned int BasicParticleWorld<T, F>::GetSleepSteps() const
+	{
+		return sleepSteps;
+	}
+
+	template<typename T, typename F>
+	unsigned int BasicParticleWorld<T, F>::GetSleepingCount() const
+	{
+		unsigned int sleeping = 0;
+		for(unsigned int i = 0; i < asleep.size(); i++)
+		{
+			sleeping += asleep[i];
+		}
+
+		return sleeping;
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::SetInverseMasses(const T *InverseMasses)
+	{
+		if(!inverseMass.empty()) memcpy(&inverseMass[0], InverseMasses, inverseMass.size() * sizeof(T));
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::SetDampings(const T *Dampings)
+	{
+		if(damping.empty()) return;
+
+		memcpy(&damping[0], Dampings, damping.size() * sizeof(T));
+		for(unsigned int i = 0; i < damping.size(); i++)
+		{
+			dampingFactor[i] = ScalarTraits<T>::Pow(damping[i], dampingStep);
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::SetAliveFlags(const unsigned char *Alive)
+	{
+		if(!alive.empty()) memcpy(&alive[0], Alive, alive.size());
+		WakeAll();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::SetSleepThresholds(T Speed, T Acceleration, unsigned int Steps)
+	{
+		sleepSpeed = Speed;
+		sleepAcceleration = Acceleration;
+		sleepSteps = Steps;
+
+		if(Steps == 0) WakeAll();
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::WakeAll()
+	{
+		const unsigned int count = GetCount();
+		for(unsigned int i = 0; i < count; i++)
+		{
+			asleep[i] = 0;
+			restSteps[i] = 0;
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::ClearForces()
+	{
+		const unsigned int count = GetCount();
+		for(unsigned int i = 0; i < count; i++)
+		{
+			forceX[i] = (F)0.0;
+			forceY[i] = (F)0.0;
+			forceZ[i] = (F)0.0;
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::PrepareStep(T dT)
+	{
+		if(dT == dampingStep) return;
+
+		const unsigned int count = GetCount();
+		for(unsigned int i = 0; i < count; i++)
+		{
+			dampingFactor[i] = ScalarTraits<T>::Pow(damping[i], dT);
+		}
+
+		dampingStep = dT;
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::Step(T dT)
+	{
+		HADRON_PROFILE_SCOPE("world integrate");
+
+		PrepareStep(dT);
+		integrate(0, GetCount(), dT);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::Step(unsigned int Begin, unsigned int End, T dT)
+	{
+		if(End > GetCount()) End = GetCount();
+		if(Begin >= End) return;
+
+		HADRON_PROFILE_SCOPE("world integrate");
+
+		integrate(Begin, End, dT);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::saveExternalForces()
+	{
+		const unsigned int count = GetCount();
+		externalForces.resize(count * 3);
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			externalForces[i] = forceX[i];
+			externalForces[count + i] = forceY[i];
+			externalForces[count * 2 + i] = forceZ[i];
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::restoreExternalForces()
+	{
+		const unsigned int count = GetCount();
+		for(unsigned int i = 0; i < count; i++)
+		{
+			forceX[i] = externalForces[i];
+			forceY[i] = externalForces[count + i];
+			forceZ[i] = externalForces[count * 2 + i];
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::getAccelerations(T *AccX, T *AccY, T *AccZ) const
+	{
+		const unsigned int count = GetCount();
+		for(unsigned int i = 0; i < count; i++)
+		{
+			if(!alive[i] || asleep[i] || inverseMass[i] <= (T)0.0)
+			{
+				AccX[i] = AccY[i] = AccZ[i] = (T)0.0;
+				continue;
+			}
+
+			AccX[i] = (T)(accX[i] + (forceX[i] * inverseMass[i]));
+			AccY[i] = (T)(accY[i] + (forceY[i] * inverseMass[i]));
+			AccZ[i] = (T)(accZ[i] + (forceZ[i] * inverseMass[i]));
+		}
+	}
+
+	template<typename T, typename F>
+	ParticleIntegrateArrays<T, F> BasicParticleWorld<T, F>::getIntegrateArrays(unsigned int First)
+	{
+		ParticleIntegrateArrays<T, F> a;
+		a.posX = &posX[First]; a.posY = &posY[First]; a.posZ = &posZ[First];
+		a.velX = &velX[First]; a.velY = &velY[First]; a.velZ = &velZ[First];
+		a.accX = &accX[First]; a.accY = &accY[First]; a.accZ = &accZ[First];
+		a.forceX = &forceX[First]; a.forceY = &forceY[First]; a.forceZ = &forceZ[First];
+		a.dampingFactor = &dampingFactor[First];
+		a.inverseMass = &inverseMass[First];
+		a.alive = &alive[First];
+
+		return a;
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::UpdateSleep(unsigned int Begin, unsigned int End, T dT)
+	{
+		if(sleepSteps == 0) return;
+		if(End > GetCount()) End = GetCount();
+
+		const T speedSq = sleepSpeed * sleepSpeed;
+		const F accelerationSq = (F)sleepAcceleration * (F)sleepAcceleration;
+		const F stepSq = (F)dT * (F)dT;
+
+		for(unsigned int i = Begin; i < End; i++)
+		{
+			if(!alive[i] || inverseMass[i] <= (T)0.0) continue;
+
+			const T velocitySq = (velX[i] * velX[i]) + (velY[i] * velY[i]) + (velZ[i] * velZ[i]);
+
+			if(asleep[i])
+			{
+				// Compared as accelerations, so one threshold does for every mass
+				const F changeX = (forceX[i] - sleepForceX[i]) * inverseMass[i];
+				const F changeY = (forceY[i] - sleepForceY[i]) * inverseMass[i];
+				const F changeZ = (forceZ[i] - sleepForceZ[i]) * inverseMass[i];
+				const F changeSq = (changeX * changeX) + (changeY * changeY) + (changeZ * changeZ);
+
+				if(velocitySq <= speedSq && changeSq <= accelerationSq)
+				{
+					// Still asleep, so nothing's going to clear its forces for it
+					forceX[i] = forceY[i] = forceZ[i] = (F)0.0;
+					continue;
+				}
+
+				asleep[i] = 0;
+				restSteps[i] = 0;
+				continue;
+			}
+
+			// Speed one step's acceleration could have built up doesn't count against resting either, as a particle
+			// sitting on something picks that up every step the contact doesn't happen to be found
+			const F totalX = (F)accX[i] + (forceX[i] * inverseMass[i]);
+			const F totalY = (F)accY[i] + (forceY[i] * inverseMass[i]);
+			const F totalZ = (F)accZ[i] + (forceZ[i] * inverseMass[i]);
+			const F allowanceSq = ((totalX * totalX) + (totalY * totalY) + (totalZ * totalZ)) * stepSq;
+
+			if((F)velocitySq > (F)speedSq + allowanceSq)
+			{
+				restSteps[i] = 0;
+				continue;
+			}
+
+			if(++restSteps[i] < sleepSteps) continue;
+
+			asleep[i] = 1;
+			velX[i] = velY[i] = velZ[i] = (T)0.0;
+
+			sleepForceX[i] = forceX[i];
+			sleepForceY[i] = forceY[i];
+			sleepForceZ[i] = forceZ[i];
+			forceX[i] = forceY[i] = forceZ[i] = (F)0.0;
+		}
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::integrate(unsigned int Begin, unsigned int End, T dT)
+	{
+		if(sleepSteps == 0)
+		{
+			HADRON_PROFILE_COUNT("particles integrated", End - Begin);
+			integrateRange(Begin, End, dT);
+			return;
+		}
+
+		UpdateSleep(Begin, End, dT);
+
+		// Integrate each run of awake particles in one go, so the kernels still get long runs when most are awake
+		unsigned int integrated = 0;
+		unsigned int first = Begin;
+		while(first < End)
+		{
+			while(first < End && asleep[first]) first++;
+
+			unsigned int last = first;
+			while(last < End && !asleep[last]) last++;
+
+			integrateRange(first, last, dT);
+			integrated += last - first;
+			first = last;
+		}
+
+		HADRON_PROFILE_COUNT("particles integrated", integrated);
+		HADRON_PROFILE_COUNT("particles asleep", (End - Begin) - integrated);
+	}
+
+	template<typename T, typename F>
+	void BasicParticleWorld<T, F>::integrateRange(unsigned int Begin, unsigned int End, T dT)
+	{
+		if(Begin >= End) return;
+
+		if(dT == dampingStep)
+		{
+			IntegrateParticles(getIntegrateArrays(Begin), End - Begin, dT);
+			return;
+		}
+
+		// The cached damping factors are for a different step
+		// ^- Work them out a block at a time on the stack instead, as other threads may be stepping other ranges
+		const unsigned int BLOCK = 256;
+		T factors[BLOCK];
+
+		for(unsigned int first = Begin; first < End; first += BLOCK)
+		{
+			const unsigned int count = (End - first < BLOCK) ? End - first : BLOCK;
+			for(unsigned int i = 0; i < count; i++)
+			{
+				factors[i] = ScalarTraits<T>::Pow(damping[first + i], dT);
+			}
+
+			ParticleIntegrateArrays<T, F> a = getIntegrateArrays(first);
+			a.dampingFactor = factors;
+
+			IntegrateParticles(a, count, dT);
+		}
+	}
+
+	// The instantiations behind the typedefs in particleworld.hpp
+	template class BasicParticleWorld<float>;
+	template class BasicParticleWorld<double>;
+	template class BasicParticleWorld<float, double>;
+};
\ No newline at end of file
@@ -0,0 +1,376 @@
+#ifndef HADRON_PARTICLEWORLD_HPP
+#define HADRON_PARTICLEWORLD_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/profiler.hpp"
+#include "../core/threadpool.hpp"
+#include "../math/vector3.hpp"
+#include "particleintegrate.hpp"
+#include "particleintegrator.hpp"
+
+namespace Hadron {
+	// Anything holding particle indices into a world, that needs telling when the world moves its particles around
+	// ^- See BasicParticleWorld::Reorder, register with AddRemapListener
+	class ParticleRemapListener
+	{
+	public:
+		virtual ~ParticleRemapListener() { }
+
+		// NewIndex[i] is where particle i has moved to, for each of the world's Count particles
+		virtual void RemapParticles(const unsigned int *NewIndex, unsigned int Count) = 0;
+	};
+
+	// Stores a whole set of particles as a structure of arrays
+	// ^- Each field lives in its own contiguous array, so a step only streams through the data it actually touches
+	// ^- Particles are referred to by index, which stays valid until the world is cleared or reordered
+	// ^- T is the scalar the particles' state is stored in, F the one forces are accumulated in
+	//    float state with double forces halves the memory a step streams through, while sums of many small forces
+	//    still don't lose precision
+	// ^- Instantiated for <float>, <double> and <float, double>, see the typedefs below
+	template<typename T, typename F = T>
+	class BasicParticleWorld
+	{
+	private:
+		// Same fields as Particle, just split out per component
+		std::vector<T> posX, posY, posZ;
+		std::vector<T> velX, velY, velZ;
+		std::vector<T> accX, accY, accZ;
+		std::vector<F> forceX, forceY, forceZ;
+		std::vector<T> damping;
+		std::vector<T> inverseMass;
+		std::vector<unsigned char> alive;
+
+		// damping^dampingStep for each particle
+		// ^- Saves a pow per particle per step, as long as the time step doesn't keep changing
+		std::vector<T> dampingFactor;
+		T dampingStep;
+
+		// Sleeping, see SetSleepThresholds
+		// ^- restSteps is how many steps in a row each particle's been slower than sleepSpeed, and sleepForce the
+		//    force that was on each sleeping particle when it dropped off
+		std::vector<unsigned int> restSteps;
+		std::vector<unsigned char> asleep;
+		std::vector<F> sleepForceX, sleepForceY, sleepForceZ;
+		T sleepSpeed;
+		T sleepAcceleration;
+		unsigned int sleepSteps;
+
+		// Fills in the kernel arrays, starting at the given particle
+		ParticleIntegrateArrays<T, F> getIntegrateArrays(unsigned int First);
+
+		// Integrates the awake particles in [Begin, End) forward in time
+		// ^- Same Newton-Euler scheme as Particle::integrate, run through the widest SIMD kernel available
+		void integrate(unsigned int Begin, unsigned int End, T dT);
+
+		// Integrates every particle in [Begin, End), asleep or not
+		void integrateRange(unsigned int Begin, unsigned int End, T dT);
+
+		// Forces applied before a Step<Integrator>, held constant through it, and scratch space for the integrator
+		std::vector<F> externalForces;
+		std::vector<T> integratorScratch;
+
+		// Saves the current forces as the step's external forces
+		void saveExternalForces();
+
+		// Resets the forces to the external ones
+		void restoreExternalForces();
+
+		// Works out every particle's acceleration from its forces, zero for ones that can't move
+		void getAccelerations(T *AccX, T *AccY, T *AccZ) const;
+
+		// Adapts the world to the integrator policies' System interface
+		template<typename Forces>
+		class IntegratorSystem;
+
+		// Told whenever Reorder moves particles
+		std::vector<ParticleRemapListener *> remapListeners;
+
+		// Scratch for Reorder, each field is gathered into one of these then swapped with it
+		std::vector<T> reorderScalars;
+		std::vector<F> reorderForces;
+		std::vector<unsigned int> reorderCounts;
+		std::vector<unsigned char> reorderFlags;
+		std::vector<unsigned int> reorderIndices;
+
+	public:
+		// The scalars the world was instantiated with
+		typedef T Scalar;
+		typedef F ForceScalar;
+
+		// A thin view onto a single particle in the world
+		// ^- Mirrors the Particle interface so code can be moved between the two easily
+		// ^- Only valid for as long as the world isn't resized
+		class ParticleView
+		{
+		private:
+			BasicParticleWorld *world;
+			unsigned int index;
+
+		public:
+			ParticleView(BasicParticleWorld *World, unsigned int Index);
+
+			// Getters
+			unsigned int GetIndex() const;
+
+			T GetKineticEnergy() const;
+
+			Vector3<T> GetPosition() const;
+			T GetX() const;
+			T GetY() const;
+			T GetZ() const;
+
+			Vector3<T> GetVelocity() const;
+			Vector3<T> GetAcceleration() const;
+
+			T GetMass() const;
+			T GetInverseMass() const;
+			T GetDamping() const;
+
+			bool IsAlive() const;
+			bool IsAwake() const;
+
+			// Setters
+			// ^- Every one of them wakes the particle up
+			void SetPosition(const Vector3<T> &Position);
+			void SetPosition(T X, T Y, T Z);
+			void SetX(T X);
+			void SetY(T Y);
+			void SetZ(T Z);
+
+			void SetVelocity(const Vector3<T> &Velocity);
+			void SetVelocity(T X, T Y, T Z);
+			void SetVelocityX(T X);
+			void SetVelocityY(T Y);
+			void SetVelocityZ(T Z);
+
+			void SetAcceleration(const Vector3<T> &Acceleration);
+			void SetAcceleration(T X, T Y, T Z);
+
+			void SetMass(T Mass);
+			void SetDamping(T Damping);
+
+			void SetAlive(bool Alive);
+
+			// Methods
+			// ^- ApplyForce wakes the particle up, forces added through the raw arrays only do if they're big enough
+			void ApplyForce(const Vector3<F> &Force);
+			void ApplyForce(F X, F Y, F Z);
+
+			void Wake();
+		};
+
+		// Default constructor
+		BasicParticleWorld();
+
+		// Adds a new particle, set up the same way as a default constructed Particle
+		// ^- Returns the index of the new particle
+		unsigned int Add();
+
+		// Reserves storage for Count particles, so adding them doesn't reallocate
+		void Reserve(unsigned int Count);
+
+		// Grows or shrinks the world to Count particles, new ones set up the same way as Add does
+		void Resize(unsigned int Count);
+
+		// Removes all particles
+		void Clear();
+
+		// Moves particles about so that particle Order[i] ends up at index i, carrying all of its state with it
+		// ^- Order must hold every index in [0, GetCount()) exactly once
+		// ^- Every remap listener is told where each particle went, anything else holding indices (contacts, a
+		//    ParticleFluid's last densities) is out of date until it's worked out again
+		// ^- Meant for sorting particles so ones that are close in space are close in memory, see ParticleMortonSort
+		// ^- The fields are gathered on the pool if there is one, NULL does it all on the calling thread
+		void Reorder(const unsigned int *Order, ThreadPool *Pool = NULL);
+
+		// Adds and removes objects to tell when Reorder moves particles
+		// ^- SpringNetwork, ParticleConstraintSolver and ParticleInterpolation are all listeners
+		// ^- Listeners aren't owned, and must be removed before they're destroyed if the world outlives them
+		void AddRemapListener(ParticleRemapListener *Listener);
+		void RemoveRemapListener(ParticleRemapListener *Listener);
+
+		// Getters
+		unsigned int GetCount() const;
+
+		ParticleView Get(unsigned int Index);
+
+		// Raw access to the per-particle arrays, for batched code working over the whole world
+		T *GetPositionsX();
+		T *GetPositionsY();
+		T *GetPositionsZ();
+		const T *GetPositionsX() const;
+		const T *GetPositionsY() const;
+		const T *GetPositionsZ() const;
+
+		T *GetVelocitiesX();
+		T *GetVelocitiesY();
+		T *GetVelocitiesZ();
+		const T *GetVelocitiesX() const;
+		const T *GetVelocitiesY() const;
+		const T *GetVelocitiesZ() const;
+
+		T *GetAccelerationsX();
+		T *GetAccelerationsY();
+		T *GetAccelerationsZ();
+		const T *GetAccelerationsX() const;
+		const T *GetAccelerationsY() const;
+		const T *GetAccelerationsZ() const;
+
+		F *GetForcesX();
+		F *GetForcesY();
+		F *GetForcesZ();
+		const F *GetForcesX() const;
+		const F *GetForcesY() const;
+		const F *GetForcesZ() const;
+
+		const T *GetInverseMasses() const;
+		const T *GetDampings() const;
+
+		// damping^dT for each particle, as of the last PrepareStep(dT)
+		const T *GetDampingFactors() const;
+		const unsigned char *GetAliveFlags() const;
+
+		// Non-zero for particles that are asleep
+		const unsigned char *GetSleepFlags() const;
+
+		T GetSleepSpeed() const;
+		T GetSleepAcceleration() const;
+		unsigned int GetSleepSteps() const;
+
+		// Number of particles that are asleep, counted up each time
+		unsigned int GetSleepingCount() const;
+
+		// Bulk setters, each copies in GetCount() values
+		// ^- For restoring a whole world at once, ParticleView's setters are the way to change single particles
+		// ^- SetDampings works the damping factors out again as well
+		void SetInverseMasses(const T *InverseMasses);
+		void SetDampings(const T *Dampings);
+		void SetAliveFlags(const unsigned char *Alive);
+
+		// Lets particles that have come to rest fall asleep, so steps skip them until something disturbs them
+		// ^- A particle falls asleep once it's been slower than Speed for Steps steps in a row, and its velocity's
+		//    zeroed when it does - on top of Speed it's allowed whatever its acceleration could add in one step
+		// ^- It wakes up when it's moving faster than Speed again, say from a contact or a write to the velocity
+		//    arrays, or when the force on it changes from what it was when it fell asleep by more than Mass *
+		//    Acceleration, say from a spring whose other end has started moving
+		// ^- Steps of 0, the default, turns sleeping off and wakes everything up
+		// ^- Dead and infinite mass particles never sleep
+		// ^- Only the world's own particles can sleep, standalone Particles (driven through a ParticleForceRegistry
+		//    or a ParticlePool) are always integrated, a scene has to be moved into a world to sleep
+		void SetSleepThresholds(T Speed, T Acceleration, unsigned int Steps);
+
+		// Wakes every particle up
+		void WakeAll();
+
+		// Methods
+		// Clears the force accumulators of every particle
+		void ClearForces();
+
+		// Works out the per-particle damping factors for a step of dT
+		// ^- Step(dT) does this itself, only call it before stepping ranges of the world from several threads
+		// ^- Ranged steps with a different dT still work, they just have to do the pow themselves
+		void PrepareStep(T dT);
+
+		// Puts particles in [Begin, End) to sleep and wakes them up, as every step does before integrating
+		// ^- Only for code that integrates the world itself, it clears the forces on the particles that stay asleep
+		void UpdateSleep(unsigned int Begin, unsigned int End, T dT);
+
+		// Integrates every awake particle forward by dT
+		void Step(T dT);
+
+		// Integrates only the particles in [Begin, End)
+		// ^- Lets callers split a step up between threads
+		void Step(unsigned int Begin, unsigned int End, T dT);
+
+		// Integrates every particle forward by dT with the given integrator policy (see particleintegrator.hpp)
+		// ^- ApplyForces(World) is called each time the integrator needs the forces, and should apply every force
+		//    that depends on the particles' state - some schemes call it several times at trial states
+		// ^- Forces already applied before the step are treated as external and held constant through it
+		// ^- Step<ExplicitEuler> gives the same results as applying the forces and calling Step(dT)
+		// ^- Sleeping particles are held where they are, and only the external forces can wake them up
+		template<typename Integrator, typename Forces>
+		void Step(T dT, Forces ApplyForces);
+	};
+
+	template<typename T, typename F>
+	template<typename Forces>
+	class BasicParticleWorld<T, F>::IntegratorSystem
+	{
+	private:
+		BasicParticleWorld &world;
+		Forces &applyForces;
+
+	public:
+		typedef T Scalar;
+
+		IntegratorSystem(BasicParticleWorld &World, Forces &ApplyForces):
+		world(World),
+		applyForces(ApplyForces)
+		{ }
+
+		unsigned int GetCount() const { return world.GetCount(); }
+
+		T *GetPositionsX() { return world.GetPositionsX(); }
+		T *GetPositionsY() { return world.GetPositionsY(); }
+		T *GetPositionsZ() { return world.GetPositionsZ(); }
+		T *GetVelocitiesX() { return world.GetVelocitiesX(); }
+		T *GetVelocitiesY() { return world.GetVelocitiesY(); }
+		T *GetVelocitiesZ() { return world.GetVelocitiesZ(); }
+
+		bool IsMovable(unsigned int Index) const
+		{
+			return world.alive[Index] && !world.asleep[Index] && world.inverseMass[Index] > (T)0.0;
+		}
+
+		void Evaluate(T *AccX, T *AccY, T *AccZ)
+		{
+			world.restoreExternalForces();
+			applyForces(world);
+			world.getAccelerations(AccX, AccY, AccZ);
+		}
+
+		const T *GetDampingFactors() const
+		{
+			return &world.dampingFactor[0];
+		}
+
+		T *GetScratch(unsigned int Arrays)
+		{
+			world.integratorScratch.resize(Arrays * world.GetCount());
+			return &world.integratorScratch[0];
+		}
+	};
+
+	template<typename T, typename F>
+	template<typename Integrator, typename Forces>
+	void BasicParticleWorld<T, F>::Step(T dT, Forces ApplyForces)
+	{
+		HADRON_PROFILE_SCOPE("world step");
+		if(GetCount() == 0) return;
+
+		PrepareStep(dT);
+		UpdateSleep(0, GetCount(), dT);
+		saveExternalForces();
+
+		HADRON_PROFILE_COUNT("particles integrated", GetCount() - GetSleepingCount());
+
+		IntegratorSystem<Forces> system(*this, ApplyForces);
+		Integrator::Step(system, dT);
+
+		ClearForces();
+	}
+
+	// The default world, in whatever precision real is
+	typedef BasicParticleWorld<real> ParticleWorld;
+
+	// Fixed precision worlds, usable side by side whatever real is
+	typedef BasicParticleWorld<float> ParticleWorldFloat;
+	typedef BasicParticleWorld<double> ParticleWorldDouble;
+
+	// Float positions, velocities and masses, with forces accumulated in double
+	typedef BasicParticleWorld<float, double> ParticleWorldMixed;
+};
+
+#endif // HADRON_PARTICLEWORLD_HPP
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+#include "springnetwork.hpp"
+#include "../core/parallel.hpp"
+#include "../core/profiler.hpp"
+
+namespace Hadron {
+	SpringNetwork::SpringNetwork():
+	particleSpan(0),
+	adjacencyParticles(0),
+	adjacencyDirty(true),
+	topologyVersion(0),
+	pool(NULL)
+	{ }
+
+	unsigned int SpringNetwork::Add(unsigned int A, unsigned int B, real Stiffness, real RestLength, real Damping)
+	{
+		particleA.push_back(A);
+		particleB.push_back(B);
+		stiffness.push_back(Stiffness);
+		restLength.push_back(RestLength);
+		damping.push_back(Damping);
+
+		particleSpan = std::max(particleSpan, std::max(A, B) + 1);
+		adjacencyDirty = true;
+		topologyVersion++;
+
+		return (unsigned int)particleA.size() - 1;
+	}
+
+	void SpringNetwork::Reserve(unsigned int Count)
+	{
+		particleA.reserve(Count);
+		particleB.reserve(Count);
+		stiffness.reserve(Count);
+		restLength.reserve(Count);
+		damping.reserve(Count);
+	}
+
+	void SpringNetwork::Clear()
+	{
+		particleA.clear();
+		particleB.clear();
+		stiffness.clear();
+		restLength.clear();
+		damping.clear();
+		forceX.clear();
+		forceY.clear();
+		forceZ.clear();
+		adjacencyStart.clear();
+		adjacency.clear();
+
+		particleSpan = 0;
+		adjacencyParticles = 0;
+		adjacencyDirty = true;
+		topologyVersion++;
+	}
+
+	void SpringNetwork::Assign(unsigned int Count, const unsigned int *A, const unsigned int *B, const real *Stiffness,
+		const real *RestLength, const real *Damping)
+	{
+		Clear();
+
+		particleA.assign(A, A + Count);
+		particleB.assign(B, B + Count);
+		stiffness.assign(Stiffness, Stiffness + Count);
+		restLength.assign(RestLength, RestLength + Count);
+		damping.assign(Damping, Damping + Count);
+
+		for(unsigned int s = 0; s < Count; s++)
+		{
+			particleSpan = std::max(particleSpan, std::max(A[s], B[s]) + 1);
+		}
+	}
+
+	unsigned int SpringNetwork::GetCount() const
+	{
+		return (unsigned int)particleA.size();
+	}
+
+	unsigned int SpringNetwork::GetParticleA(unsigned int Spring) const
+	{
+		return particleA[Spring];
+	}
+
+	unsigned int SpringNetwork::GetParticleB(unsigned int Spring) const
+	{
+		return particleB[Spring];
+	}
+
+	real SpringNetwork::GetStiffness(unsigned int Spring) const
+	{
+		return stiffness[Spring];
+	}
+
+	real SpringNetwork::GetRestLength(unsigned int Spring) const
+	{
+		return restLength[Spring];
+	}
+
+	real SpringNetwork::GetDamping(unsigned int Spring) const
+	{
+		return damping[Spring];
+	}
+
+	const unsigned int *SpringNetwork::GetParticlesA() const { return particleA.empty() ? NULL : &particleA[0]; }
+	const unsigned int *SpringNetwork::GetParticlesB() const { return particleB.empty() ? NULL : &particleB[0]; }
+	const real *SpringNetwork::GetStiffnesses() const { return stiffness.empty() ? NULL : &stiffness[0]; }
+	const real *SpringNetwork::GetRestLengths() const { return restLength.empty() ? NULL : &restLength[0]; }
+	const real *SpringNetwork::GetDampings() const { return damping.empty() ? NULL : &damping[0]; }
+
+	unsigned int SpringNetwork::GetParticleSpan() const
+	{
+		return particleSpan;
+	}
+
+	unsigned int SpringNetwork::GetTopologyVersion() const
+	{
+		return topologyVersion;
+	}
+
+	void SpringNetwork::SetStiffness(unsigned int Spring, real Stiffness)
+	{
+		stiffness[Spring] = Stiffness;
+	}
+
+	void SpringNetwork::SetRestLength(unsigned int Spring, real RestLength)
+	{
+		restLength[Spring] = RestLength;
+	}
+
+	void SpringNetwork::SetDamping(unsigned int Spring, real Damping)
+	{
+		damping[Spring] = Damping;
+	}
+
+	void SpringNetwork::SetThreadPool(ThreadPool *Pool)
+	{
+		pool = Pool;
+	}
+
+	void SpringNetwork::buildAdjacency(unsigned int ParticleCount)
+	{
+		if(!adjacencyDirty && adjacencyParticles == ParticleCount) return;
+
+		const unsigned int springs = (unsigned int)particleA.size();
+
+		// Count the springs on each particle, then turn the counts into offsets
+		adjacencyStart.assign(ParticleCount + 1, 0);
+		for(unsigned int s = 0; s < springs; s++)
+		{
+			adjacencyStart[particleA[s] + 1]++;
+			adjacencyStart[particleB[s] + 1]++;
+		}
+
+		for(unsigned int p = 0; p < ParticleCount; p++)
+		{
+			adjacencyStart[p + 1] += adjacencyStart[p];
+		}
+
+		// Fill them in, in spring order
+		adjacency.resize(springs * 2);
+		std::vector<unsigned int> next(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for(unsigned int s = 0; s < springs; s++)
+		{
+			adjacency[next[particleA[s]]++] = s << 1;
+			adjacency[next[particleB[s]]++] = (s << 1) | 1;
+		}
+
+		forceX.resize(springs);
+		forceY.resize(springs);
+		forceZ.resize(springs);
+
+		adjacencyParticles = ParticleCount;
+		adjacencyDirty = false;
+	}
+
+	void SpringNetwork::ApplyForces(ParticleWorld &World, real dT)
+	{
+		const unsigned int springs = (unsigned int)particleA.size();
+		if(springs == 0) return;
+
+		// The adjacency and every spring below index the world with the ends
+		assert(particleSpan <= World.GetCount());
+		if(particleSpan > World.GetCount()) return;
+
+		HADRON_PROFILE_SCOPE("spring network");
+		HADRON_PROFILE_COUNT("springs", springs);
+
+		buildAdjacency(World.GetCount());
+		WakeConnected(World);
+
+		const real *posX = World.GetPositionsX();
+		const real *posY = World.GetPositionsY();
+		const real *posZ = World.GetPositionsZ();
+		const real *velX = World.GetVelocitiesX();
+		const real *velY = World.GetVelocitiesY();
+		const real *velZ = World.GetVelocitiesZ();
+		const unsigned char *alive = World.GetAliveFlags();
+
+		// Work out each spring once
+		ParallelFor(pool, 0, springs, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int s = Begin; s < End; s++)
+			{
+				const unsigned int a = particleA[s];
+				const unsigned int b = particleB[s];
+
+				const real dx = posX[a] - posX[b];
+				const real dy = posY[a] - posY[b];
+				const real dz = posZ[a] - posZ[b];
+				const real lengthSq = (dx * dx) + (dy * dy) + (dz * dz);
+
+				if(!alive[a] || !alive[b] || lengthSq <= (real)0.0)
+				{
+					forceX[s] = forceY[s] = forceZ[s] = (real)0.0;
+					continue;
+				}
+
+				// One square root per spring, the direction reuses it
+				const real length = (real)sqrt(lengthSq);
+				const real inverseLength = (real)1.0 / length;
+				const real nx = dx * inverseLength;
+				const real ny = dy * inverseLength;
+				const real nz = dz * inverseLength;
+
+				// Rate the spring's stretching at
+				const real stretchRate = ((velX[a] - velX[b]) * nx) + ((velY[a] - velY[b]) * ny) + ((velZ[a] - velZ[b]) * nz);
+
+				const real magnitude = -((stiffness[s] * (length - restLength[s])) + (damping[s] * stretchRate));
+				forceX[s] = nx * magnitude;
+				forceY[s] = ny * magnitude;
+				forceZ[s] = nz * magnitude;
+			}
+		});
+
+		real *accumX = World.GetForcesX();
+		real *accumY = World.GetForcesY();
+		real *accumZ = World.GetForcesZ();
+
+		// Then have each particle gather the forces from its springs
+		ParallelFor(pool, 0, adjacencyParticles, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int p = Begin; p < End; p++)
+			{
+				const unsigned int first = adjacencyStart[p];
+				const unsigned int last = adjacencyStart[p + 1];
+				if(first == last) continue;
+
+				real fx = (real)0.0, fy = (real)0.0, fz = (real)0.0;
+				for(unsigned int i = first; i < last; i++)
+				{
+					const unsigned int s = adjacency[i] >> 1;
+					if(adjacency[i] & 1)
+					{
+						fx -= forceX[s];
+						fy -= forceY[s];
+						fz -= forceZ[s];
+					}
+					else
+					{
+						fx += forceX[s];
+						fy += forceY[s];
+						fz += forceZ[s];
+					}
+				}
+
+				accumX[p] += fx;
+				accumY[p] += fy;
+				accumZ[p] += fz;
+			}
+		});
+	}
+
+	void SpringNetwork::RemapParticles(const unsigned int *NewIndex, unsigned int Count)
+	{
+		// An end the world doesn't have means the springs and the world have gone out of step, so nothing's remapped
+		assert(particleSpan <= Count);
+		if(particleSpan > Count) return;
+
+		const unsigned int springs = (unsigned int)particleA.size();
+		ParallelFor(pool, 0, springs, [&](unsigned int Begin, unsigned int End)
+		{
+			for(unsigned int s = Begin; s < End; s++)
+			{
+				particleA[s] = NewIndex[particleA[s]];
+				particleB[s] = NewIndex[particleB[s]];
+			}
+		});
+
+		particleSpan = 0;
+		for(unsigned int s = 0; s < springs; s++)
+		{
+			particleSpan = std::max(particleSpan, std::max(particleA[s], particleB[s]) + 1);
+		}
+
+		adjacencyDirty = true;
+		topologyVersion++;
+	}
+
+	void SpringNetwork::WakeConnected(ParticleWorld &World) const
+	{
+		if(World.GetSleepSteps() == 0 || particleSpan > World.GetCount()) return;
+
+		const real *velX = World.GetVelocitiesX();
+		const real *velY = World.GetVelocitiesY();
+		const real *velZ = World.GetVelocitiesZ();
+		const unsigned char *alive = World.GetAliveFlags();
+		const unsigned char *asleep = World.GetSleepFlags();
+		const real speedSq = World.GetSleepSpeed() * World.GetSleepSpeed();
+
+		// Serial, as a particle can be woken from several of its springs at once, but it's only a couple of
+		// loads per spring
+		const unsigned int springs = (unsigned int)particleA.size();
+		for(unsigned int s = 0; s < springs; s++)
+		{
+			const unsigned int a = particleA[s];
+			const unsigned int b = particleB[s];
+			if(asleep[a] == asleep[b] || !alive[a] || !alive[b]) continue;
+
+			const unsigned int awake = asleep[a] ? b : a;
+			const real speed = (velX[awake] * velX[awake]) + (velY[awake] * velY[awake]) + (velZ[awake] * velZ[awake]);
+			if(speed > speedSq) World.Get(asleep[a] ? a : b).Wake();
+		}
+	}
+};
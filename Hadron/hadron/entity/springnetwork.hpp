@@ -0,0 +1,120 @@
+#ifndef HADRON_SPRINGNETWORK_HPP
+#define HADRON_SPRINGNETWORK_HPP
+
+#include <vector>
+
+#include "../core/precision.hpp"
+#include "../core/threadpool.hpp"
+#include "particleworld.hpp"
+
+namespace Hadron {
+	// A whole network of damped springs between particles in a ParticleWorld
+	// ^- Springs are index pairs with their constants in flat arrays, rather than a generator object per end
+	// ^- Each spring is worked out once and pushes both of its ends, equal and opposite
+	// ^- Meant for cloth and soft bodies, where there can be hundreds of thousands of them
+	// ^- Register it as a remap listener on the world if the world's ever reordered
+	class SpringNetwork : public ParticleRemapListener
+	{
+	private:
+		// Per spring
+		std::vector<unsigned int> particleA, particleB;
+		std::vector<real> stiffness;
+		std::vector<real> restLength;
+		std::vector<real> damping;
+
+		// Force on each spring's A end from the last ApplyForces, B gets the opposite
+		std::vector<real> forceX, forceY, forceZ;
+
+		// CSR adjacency, the springs touching particle p are adjacency[adjacencyStart[p], adjacencyStart[p + 1])
+		// ^- Each entry is the spring index shifted up by one, with the low bit set if p is the B end
+		std::vector<unsigned int> adjacencyStart;
+		std::vector<unsigned int> adjacency;
+
+		// One more than the highest particle index any spring uses
+		unsigned int particleSpan;
+
+		// Particle count the adjacency was built for
+		unsigned int adjacencyParticles;
+		bool adjacencyDirty;
+
+		// Goes up every time springs are added or cleared
+		unsigned int topologyVersion;
+
+		// Pool to run on, NULL runs everything serially
+		ThreadPool *pool;
+
+		// Rebuilds the adjacency if springs have been added or the world has grown
+		void buildAdjacency(unsigned int ParticleCount);
+
+	public:
+		// Default constructor
+		SpringNetwork();
+
+		// Adds a spring between particles A and B, returning its index
+		// ^- Stiffness is the spring constant, Damping resists the ends moving apart or together
+		// ^- Both ends must be particles in the world the network's used with, see GetParticleSpan
+		unsigned int Add(unsigned int A, unsigned int B, real Stiffness, real RestLength, real Damping);
+
+		// Reserves storage for Count springs
+		void Reserve(unsigned int Count);
+
+		// Removes all springs
+		void Clear();
+
+		// Replaces every spring with Count springs copied from the given arrays, as Add would lay them out
+		// ^- Same as Add, every end must be a particle in the world
+		void Assign(unsigned int Count, const unsigned int *A, const unsigned int *B, const real *Stiffness,
+			const real *RestLength, const real *Damping);
+
+		// Getters
+		unsigned int GetCount() const;
+		unsigned int GetParticleA(unsigned int Spring) const;
+		unsigned int GetParticleB(unsigned int Spring) const;
+		real GetStiffness(unsigned int Spring) const;
+		real GetRestLength(unsigned int Spring) const;
+		real GetDamping(unsigned int Spring) const;
+
+		// Raw access to the per-spring arrays, NULL when there aren't any springs
+		const unsigned int *GetParticlesA() const;
+		const unsigned int *GetParticlesB() const;
+		const real *GetStiffnesses() const;
+		const real *GetRestLengths() const;
+		const real *GetDampings() const;
+
+		// Fewest particles a world needs for every spring's ends to be in it, 0 with no springs
+		unsigned int GetParticleSpan() const;
+
+		// Changes whenever springs are added or removed, so solvers know to rebuild anything built from them
+		unsigned int GetTopologyVersion() const;
+
+		// Setters
+		void SetStiffness(unsigned int Spring, real Stiffness);
+		void SetRestLength(unsigned int Spring, real RestLength);
+		void SetDamping(unsigned int Spring, real Damping);
+
+		// Sets the pool to run on, NULL (the default) runs everything on the calling thread
+		// ^- Springs are worked out in parallel, then each particle gathers its springs' forces through the
+		//    adjacency, so no two threads ever write to the same particle
+		// ^- Each particle always sums its springs in the same order, so the results are bitwise identical
+		//    however many threads there are
+		void SetThreadPool(ThreadPool *Pool);
+
+		// Adds every spring's force to the world's force accumulators
+		// ^- Springs with a dead end, or with both ends in the same place, do nothing
+		// ^- Asserts, and does nothing at all in release builds, if a spring ends past the end of the world
+		// ^- Wakes sleeping particles up first, see WakeConnected
+		void ApplyForces(ParticleWorld &World, real dT);
+
+		// Points the springs at their particles' new indices after the world's been reordered
+		// ^- Spring indices don't change, but the topology version does, as anything built per particle is stale
+		// ^- Asserts if a spring ends at or past Count, and leaves every spring as it was in release builds
+		void RemapParticles(const unsigned int *NewIndex, unsigned int Count);
+
+		// Wakes every sleeping particle with a spring to a particle moving faster than the world's sleep speed
+		// ^- So a connected group only settles once all of it has, and starts moving again as a whole
+		// ^- Does nothing if a spring ends past the end of the world, like ApplyForces
+		void WakeConnected(ParticleWorld &World) const;
+	};
+};
+
+#endif // HADRON_SPRINGNETWORK_HPP
@@ -1,6 +1,10 @@
 #ifndef HADRON_MATH_HPP
 #define HADRON_MATH_HPP
 
+#include "math/packet_sse2.hpp"
+#include "math/scalar.hpp"
 #include "math/vector3.hpp"
+#include "math/vector3packet.hpp"
+#include "math/vector4.hpp"
 
 #endif // HADRON_MATH_HPP
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef HADRON_PACKET_AVX2_HPP
+#define HADRON_PACKET_AVX2_HPP
+
+// Only include this from translation units built for AVX2
+// ^- Anything inline that ends up in here gets compiled with AVX2 enabled, and mustn't leak out to code
+//    that runs on older CPUs - see particleintegrate_avx2.cpp
+
+#include "../core/cpu.hpp"
+
+#if defined(HADRON_ARCH_X86)
+
+#include <string.h>
+#include <immintrin.h>
+
+#include "vector3packet.hpp"
+
+namespace Hadron {
+	// 8 floats in one AVX register
+	class PacketAVX2f
+	{
+	public:
+		typedef float Scalar;
+		enum { WIDTH = 8 };
+
+		__m256 v;
+
+		// Constructors
+		PacketAVX2f() { }
+		PacketAVX2f(__m256 V): v(V) { }
+		explicit PacketAVX2f(float S): v(_mm256_set1_ps(S)) { }
+
+		// Loading and storing, neither needs to be aligned
+		static PacketAVX2f Load(const float *P) { return _mm256_loadu_ps(P); }
+		void Store(float *P) const { _mm256_storeu_ps(P, v); }
+
+		// Builds a lane mask from WIDTH bytes, lanes are set where the byte is non-zero
+		static PacketAVX2f LoadFlags(const unsigned char *P)
+		{
+			const __m256i wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)P));
+			return _mm256_castsi256_ps(_mm256_cmpgt_epi32(wide, _mm256_setzero_si256()));
+		}
+
+		// Loads lane i from Base[Indices[i]], for WIDTH indices
+		static PacketAVX2f Gather(const float *Base, const int *Indices)
+		{
+			return _mm256_i32gather_ps(Base, _mm256_loadu_si256((const __m256i *)Indices), sizeof(float));
+		}
+
+		// Operator overloads
+		PacketAVX2f operator+(const PacketAVX2f &P) const { return _mm256_add_ps(v, P.v); }
+		PacketAVX2f operator-(const PacketAVX2f &P) const { return _mm256_sub_ps(v, P.v); }
+		PacketAVX2f operator*(const PacketAVX2f &P) const { return _mm256_mul_ps(v, P.v); }
+		PacketAVX2f operator/(const PacketAVX2f &P) const { return _mm256_div_ps(v, P.v); }
+
+		void operator+=(const PacketAVX2f &P) { v = _mm256_add_ps(v, P.v); }
+		void operator-=(const PacketAVX2f &P) { v = _mm256_sub_ps(v, P.v); }
+		void operator*=(const PacketAVX2f &P) { v = _mm256_mul_ps(v, P.v); }
+		void operator/=(const PacketAVX2f &P) { v = _mm256_div_ps(v, P.v); }
+
+		// Lane-wise helpers
+		static PacketAVX2f Sqrt(const PacketAVX2f &P) { return _mm256_sqrt_ps(P.v); }
+		static PacketAVX2f Greater(const PacketAVX2f &A, const PacketAVX2f &B) { return _mm256_cmp_ps(A.v, B.v, _CMP_GT_OQ); }
+		static PacketAVX2f And(const PacketAVX2f &A, const PacketAVX2f &B) { return _mm256_and_ps(A.v, B.v); }
+
+		// Picks A where Mask is set, B everywhere else
+		static PacketAVX2f Select(const PacketAVX2f &Mask, const PacketAVX2f &A, const PacketAVX2f &B)
+		{
+			return _mm256_blendv_ps(B.v, A.v, Mask.v);
+		}
+	};
+
+	// 4 doubles in one AVX register
+	class PacketAVX2d
+	{
+	public:
+		typedef double Scalar;
+		enum { WIDTH = 4 };
+
+		__m256d v;
+
+		// Constructors
+		PacketAVX2d() { }
+		PacketAVX2d(__m256d V): v(V) { }
+		explicit PacketAVX2d(double S): v(_mm256_set1_pd(S)) { }
+
+		// Loading and storing, neither needs to be aligned
+		static PacketAVX2d Load(const double *P) { return _mm256_loadu_pd(P); }
+		void Store(double *P) const { _mm256_storeu_pd(P, v); }
+
+		// Builds a lane mask from WIDTH bytes, lanes are set where the byte is non-zero
+		static PacketAVX2d LoadFlags(const unsigned char *P)
+		{
+			int bytes;
+			memcpy(&bytes, P, sizeof(bytes));
+
+			const __m256i wide = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(bytes));
+			return _mm256_castsi256_pd(_mm256_cmpgt_epi64(wide, _mm256_setzero_si256()));
+		}
+
+		// Loads lane i from Base[Indices[i]], for WIDTH indices
+		// ^- The masked form with every lane on, as GCC warns about the undefined register the plain one starts from
+		static PacketAVX2d Gather(const double *Base, const int *Indices)
+		{
+			const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+			return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), Base, _mm_loadu_si128((const __m128i *)Indices), all,
+				sizeof(double));
+		}
+
+		// Operator overloads
+		PacketAVX2d operator+(const PacketAVX2d &P) const { return _mm256_add_pd(v, P.v); }
+		PacketAVX2d operator-(const PacketAVX2d &P) const { return _mm256_sub_pd(v, P.v); }
+		PacketAVX2d operator*(const PacketAVX2d &P) const { return _mm256_mul_pd(v, P.v); }
+		PacketAVX2d operator/(const PacketAVX2d &P) const { return _mm256_div_pd(v, P.v); }
+
+		void operator+=(const PacketAVX2d &P) { v = _mm256_add_pd(v, P.v); }
+		void operator-=(const PacketAVX2d &P) { v = _mm256_sub_pd(v, P.v); }
+		void operator*=(const PacketAVX2d &P) { v = _mm256_mul_pd(v, P.v); }
+		void operator/=(const PacketAVX2d &P) { v = _mm256_div_pd(v, P.v); }
+
+		// Lane-wise helpers
+		static PacketAVX2d Sqrt(const PacketAVX2d &P) { return _mm256_sqrt_pd(P.v); }
+		static PacketAVX2d Greater(const PacketAVX2d &A, const PacketAVX2d &B) { return _mm256_cmp_pd(A.v, B.v, _CMP_GT_OQ); }
+		static PacketAVX2d And(const PacketAVX2d &A, const PacketAVX2d &B) { return _mm256_and_pd(A.v, B.v); }
+
+		// Picks A where Mask is set, B everywhere else
+		static PacketAVX2d Select(const PacketAVX2d &Mask, const PacketAVX2d &A, const PacketAVX2d &B)
+		{
+			return _mm256_blendv_pd(B.v, A.v, Mask.v);
+		}
+	};
+
+	typedef Vector3Packet<PacketAVX2f> Vector3x8f;
+	typedef Vector3Packet<PacketAVX2d> Vector3x4d;
+};
+
+#endif // HADRON_ARCH_X86
+
+#endif // HADRON_PACKET_AVX2_HPP
\ No newline at end of file
@@ -0,0 +1,142 @@
+#ifndef HADRON_PACKET_SSE2_HPP
+#define HADRON_PACKET_SSE2_HPP
+
+#include "../core/cpu.hpp"
+
+#if defined(HADRON_ARCH_X86)
+
+#include <string.h>
+#include <emmintrin.h>
+
+#include "vector3packet.hpp"
+
+namespace Hadron {
+	// 4 floats in one SSE register
+	class PacketSSE2f
+	{
+	public:
+		typedef float Scalar;
+		enum { WIDTH = 4 };
+
+		__m128 v;
+
+		// Constructors
+		PacketSSE2f() { }
+		PacketSSE2f(__m128 V): v(V) { }
+		explicit PacketSSE2f(float S): v(_mm_set1_ps(S)) { }
+
+		// Loading and storing, neither needs to be aligned
+		static PacketSSE2f Load(const float *P) { return _mm_loadu_ps(P); }
+		void Store(float *P) const { _mm_storeu_ps(P, v); }
+
+		// Builds a lane mask from WIDTH bytes, lanes are set where the byte is non-zero
+		static PacketSSE2f LoadFlags(const unsigned char *P)
+		{
+			int bytes;
+			memcpy(&bytes, P, sizeof(bytes));
+
+			const __m128i zero = _mm_setzero_si128();
+			__m128i wide = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+			wide = _mm_unpacklo_epi16(wide, zero);
+
+			return _mm_castsi128_ps(_mm_cmpgt_epi32(wide, zero));
+		}
+
+		// Loads lane i from Base[Indices[i]], for WIDTH indices
+		// ^- SSE2 has no gather instruction, so it's done a lane at a time
+		static PacketSSE2f Gather(const float *Base, const int *Indices)
+		{
+			return _mm_setr_ps(Base[Indices[0]], Base[Indices[1]], Base[Indices[2]], Base[Indices[3]]);
+		}
+
+		// Operator overloads
+		PacketSSE2f operator+(const PacketSSE2f &P) const { return _mm_add_ps(v, P.v); }
+		PacketSSE2f operator-(const PacketSSE2f &P) const { return _mm_sub_ps(v, P.v); }
+		PacketSSE2f operator*(const PacketSSE2f &P) const { return _mm_mul_ps(v, P.v); }
+		PacketSSE2f operator/(const PacketSSE2f &P) const { return _mm_div_ps(v, P.v); }
+
+		void operator+=(const PacketSSE2f &P) { v = _mm_add_ps(v, P.v); }
+		void operator-=(const PacketSSE2f &P) { v = _mm_sub_ps(v, P.v); }
+		void operator*=(const PacketSSE2f &P) { v = _mm_mul_ps(v, P.v); }
+		void operator/=(const PacketSSE2f &P) { v = _mm_div_ps(v, P.v); }
+
+		// Lane-wise helpers
+		static PacketSSE2f Sqrt(const PacketSSE2f &P) { return _mm_sqrt_ps(P.v); }
+		static PacketSSE2f Greater(const PacketSSE2f &A, const PacketSSE2f &B) { return _mm_cmpgt_ps(A.v, B.v); }
+		static PacketSSE2f And(const PacketSSE2f &A, const PacketSSE2f &B) { return _mm_and_ps(A.v, B.v); }
+
+		// Picks A where Mask is set, B everywhere else
+		static PacketSSE2f Select(const PacketSSE2f &Mask, const PacketSSE2f &A, const PacketSSE2f &B)
+		{
+			return _mm_or_ps(_mm_and_ps(Mask.v, A.v), _mm_andnot_ps(Mask.v, B.v));
+		}
+	};
+
+	// 2 doubles in one SSE register
+	class PacketSSE2d
+	{
+	public:
+		typedef double Scalar;
+		enum { WIDTH = 2 };
+
+		__m128d v;
+
+		// Constructors
+		PacketSSE2d() { }
+		PacketSSE2d(__m128d V): v(V) { }
+		explicit PacketSSE2d(double S): v(_mm_set1_pd(S)) { }
+
+		// Loading and storing, neither needs to be aligned
+		static PacketSSE2d Load(const double *P) { return _mm_loadu_pd(P); }
+		void Store(double *P) const { _mm_storeu_pd(P, v); }
+
+		// Builds a lane mask from WIDTH bytes, lanes are set where the byte is non-zero
+		static PacketSSE2d LoadFlags(const unsigned char *P)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			__m128i wide = _mm_unpacklo_epi8(_mm_cvtsi32_si128(P[0] | (P[1] << 8)), zero);
+			wide = _mm_unpacklo_epi16(wide, zero);
+
+			// Spread each 32 bit flag over both halves of its 64 bit lane
+			wide = _mm_shuffle_epi32(wide, _MM_SHUFFLE(1, 1, 0, 0));
+
+			return _mm_castsi128_pd(_mm_cmpgt_epi32(wide, zero));
+		}
+
+		// Loads lane i from Base[Indices[i]], for WIDTH indices
+		// ^- SSE2 has no gather instruction, so it's done a lane at a time
+		static PacketSSE2d Gather(const double *Base, const int *Indices)
+		{
+			return _mm_setr_pd(Base[Indices[0]], Base[Indices[1]]);
+		}
+
+		// Operator overloads
+		PacketSSE2d operator+(const PacketSSE2d &P) const { return _mm_add_pd(v, P.v); }
+		PacketSSE2d operator-(const PacketSSE2d &P) const { return _mm_sub_pd(v, P.v); }
+		PacketSSE2d operator*(const PacketSSE2d &P) const { return _mm_mul_pd(v, P.v); }
+		PacketSSE2d operator/(const PacketSSE2d &P) const { return _mm_div_pd(v, P.v); }
+
+		void operator+=(const PacketSSE2d &P) { v = _mm_add_pd(v, P.v); }
+		void operator-=(const PacketSSE2d &P) { v = _mm_sub_pd(v, P.v); }
+		void operator*=(const PacketSSE2d &P) { v = _mm_mul_pd(v, P.v); }
+		void operator/=(const PacketSSE2d &P) { v = _mm_div_pd(v, P.v); }
+
+		// Lane-wise helpers
+		static PacketSSE2d Sqrt(const PacketSSE2d &P) { return _mm_sqrt_pd(P.v); }
+		static PacketSSE2d Greater(const PacketSSE2d &A, const PacketSSE2d &B) { return _mm_cmpgt_pd(A.v, B.v); }
+		static PacketSSE2d And(const PacketSSE2d &A, const PacketSSE2d &B) { return _mm_and_pd(A.v, B.v); }
+
+		// Picks A where Mask is set, B everywhere else
+		static PacketSSE2d Select(const PacketSSE2d &Mask, const PacketSSE2d &A, const PacketSSE2d &B)
+		{
+			return _mm_or_pd(_mm_and_pd(Mask.v, A.v), _mm_andnot_pd(Mask.v, B.v));
+		}
+	};
+
+	typedef Vector3Packet<PacketSSE2f> Vector3x4f;
+	typedef Vector3Packet<PacketSSE2d> Vector3x2d;
+};
+
+#endif // HADRON_ARCH_X86
+
+#endif // HADRON_PACKET_SSE2_HPP
\ No newline at end of file
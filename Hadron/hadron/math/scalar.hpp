@@ -0,0 +1,93 @@
+#ifndef HADRON_SCALAR_HPP
+#define HADRON_SCALAR_HPP
+
+#include <math.h>
+
+#include "../core/cpu.hpp"
+#include "../core/precision.hpp"
+
+#if defined(HADRON_ARCH_X86)
+	#include <emmintrin.h>
+#endif
+
+// constexpr where the compiler has it, Visual Studio only does from 2015
+#if defined(_MSC_VER) && _MSC_VER < 1900
+	#define HADRON_CONSTEXPR inline
+#else
+	#define HADRON_CONSTEXPR constexpr
+#endif
+
+// Fused multiply-adds round once instead of twice, but are only quick with hardware support
+// ^- Turned on automatically when the compiler's targeting FMA hardware (-mfma, -march=haswell, /arch:AVX2),
+//    or define HADRON_FMA to force it on
+#if !defined(HADRON_FMA) && (defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__)))
+	#define HADRON_FMA
+#endif
+
+// Define HADRON_FAST_RSQRT to normalise vectors with the hardware reciprocal square root estimate
+// ^- Refined with Newton-Raphson steps, it's accurate to within a few ulps of float but isn't correctly rounded,
+//    so results will differ slightly from builds without it
+// ^- Only worth it for float, for double the two refinement steps cost about as much as the sqrt and divide
+
+namespace Hadron {
+	// A * B + C
+	// ^- Fused into one rounding when HADRON_FMA is defined
+	inline float MultiplyAdd(float A, float B, float C)
+	{
+#if defined(HADRON_FMA)
+		return fmaf(A, B, C);
+#else
+		return (A * B) + C;
+#endif
+	}
+
+	inline double MultiplyAdd(double A, double B, double C)
+	{
+#if defined(HADRON_FMA)
+		return fma(A, B, C);
+#else
+		return (A * B) + C;
+#endif
+	}
+
+	// 1 / sqrt(X), done properly
+	inline float ReciprocalSqrt(float X)
+	{
+		return 1.0f / sqrtf(X);
+	}
+
+	inline double ReciprocalSqrt(double X)
+	{
+		return 1.0 / sqrt(X);
+	}
+
+	// 1 / sqrt(X) from the hardware estimate, then refined with Newton-Raphson steps
+	// ^- The estimate's good to about 12 bits and each step doubles that, so float takes one step and double two
+	//    (which still stops short of full double precision)
+	// ^- Falls back to ReciprocalSqrt off x86, X must be positive
+	inline float FastReciprocalSqrt(float X)
+	{
+#if defined(HADRON_ARCH_X86)
+		const float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(X)));
+		return estimate * (1.5f - (0.5f * X * estimate * estimate));
+#else
+		return ReciprocalSqrt(X);
+#endif
+	}
+
+	inline double FastReciprocalSqrt(double X)
+	{
+#if defined(HADRON_ARCH_X86)
+		// The estimate's only done in float
+		if(X < (double)FLT_MIN || X > (double)FLT_MAX) return ReciprocalSqrt(X);
+
+		double estimate = (double)_mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss((float)X)));
+		estimate = estimate * (1.5 - (0.5 * X * estimate * estimate));
+		return estimate * (1.5 - (0.5 * X * estimate * estimate));
+#else
+		return ReciprocalSqrt(X);
+#endif
+	}
+};
+
+#endif // HADRON_SCALAR_HPP
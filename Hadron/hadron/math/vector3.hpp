@@ -4,8 +4,13 @@
 #include <math.h>
 
 #include "../core/precision.hpp"
+#include "scalar.hpp"
 
 namespace Hadron {
+	// A plain 3 component vector
+	// ^- Everything returns by value and nothing's user-declared but the constructors, so it's trivially copyable
+	//    and the compiler's free to keep the components in registers
+	// ^- Scalars are the vector's own T, so float vectors never round trip through double
 	template<typename T>
 	class Vector3
 	{
@@ -24,39 +29,58 @@ namespace Hadron {
 		static const Vector3<T> ZERO;
 
 		// Constructors
-		Vector3();
-		Vector3(const Vector3<T> &Vec);
-		Vector3(T X, T Y, T Z);
+		HADRON_CONSTEXPR Vector3();
+		HADRON_CONSTEXPR Vector3(T X, T Y, T Z);
 
 		// Operator overloads
-		void operator=(const Vector3<T> &Vec);
+		HADRON_CONSTEXPR Vector3<T> operator+(const Vector3<T> &Vec) const;
+		HADRON_CONSTEXPR Vector3<T> operator-(const Vector3<T> &Vec) const;
+		HADRON_CONSTEXPR Vector3<T> operator-() const;
 
-		const Vector3<T> operator+(const Vector3<T> &Vec) const;
-		const Vector3<T> operator-(const Vector3<T> &Vec) const;
+		HADRON_CONSTEXPR Vector3<T> operator*(T Scalar) const;
+		HADRON_CONSTEXPR Vector3<T> operator/(T Scalar) const;
 
-		const Vector3<T> operator*(real Scalar) const;
-		const Vector3<T> operator/(real Scalar) const;
+		Vector3<T> &operator+=(const Vector3<T> &Vec);
+		Vector3<T> &operator-=(const Vector3<T> &Vec);
 
-		void operator+=(const Vector3<T> &Vec);
-		void operator-=(const Vector3<T> &Vec);
-
-		void operator*=(real Scalar);
-		void operator/=(real Scalar);
+		Vector3<T> &operator*=(T Scalar);
+		Vector3<T> &operator/=(T Scalar);
 
 		// Getters
 		T Length() const;
-		T LengthSquared() const;
-		real Dot(const Vector3<T> &Vec) const;
-		const Vector3<T> &Cross(const Vector3<T> &Vec) const;
-		const Vector3<T> &Normalised() const;
+		HADRON_CONSTEXPR T LengthSquared() const;
+		HADRON_CONSTEXPR T Dot(const Vector3<T> &Vec) const;
+		HADRON_CONSTEXPR Vector3<T> Cross(const Vector3<T> &Vec) const;
+
+		// Returns the unit vector, or zero for a zero length vector
+		Vector3<T> Normalised() const;
+
+		// Same as Normalised, but hands back the length it worked out along the way
+		// ^- Saves the second sqrt when a caller needs both, like springs and drag do
+		Vector3<T> NormalisedAndLength(T &Length) const;
 
 		// Setters
-		void AddScaledVector(const Vector3<T> &Vec, real Scale);
-		
+		// ^- this += Vec * Scale, as multiply-adds
+		void AddScaledVector(const Vector3<T> &Vec, T Scale);
+
 		// Methods
 		void Clear();
 	};
 
+	// Scalar on the left
+	template<typename T>
+	HADRON_CONSTEXPR Vector3<T> operator*(T Scalar, const Vector3<T> &Vec)
+	{
+		return Vec * Scalar;
+	}
+
+	// A * B + C per component, fused when HADRON_FMA is defined
+	template<typename T>
+	inline Vector3<T> MultiplyAdd(const Vector3<T> &A, T B, const Vector3<T> &C)
+	{
+		return Vector3<T>(MultiplyAdd(A.x, B, C.x), MultiplyAdd(A.y, B, C.y), MultiplyAdd(A.z, B, C.z));
+	}
+
 	template<typename T>
 	const Vector3<T> Vector3<T>::GRAVITY = Vector3<T>((T)0.0, (T)-9.81, (T)0.0);
 
@@ -77,118 +101,111 @@ namespace Hadron {
 
 	// Default constructor
 	template<typename T>
-	Vector3<T>::Vector3():
+	HADRON_CONSTEXPR Vector3<T>::Vector3():
 	x((T)0),
 	y((T)0),
 	z((T)0)
 	{ }
 
-	// Copy constructor
-	template<typename T>
-	Vector3<T>::Vector3(const Vector3<T> &Vec):
-	x(Vec.x),
-	y(Vec.y),
-	z(Vec.z)
-	{ }
-
 	// Basic initialisation constructor
 	template<typename T>
-	Vector3<T>::Vector3(T X, T Y, T Z):
+	HADRON_CONSTEXPR Vector3<T>::Vector3(T X, T Y, T Z):
 	x(X),
 	y(Y),
 	z(Z)
 	{ }
 
-	// Assignment operator
 	template<typename T>
-	void Vector3<T>::operator=(const Vector3<T> &Vec)
+	HADRON_CONSTEXPR Vector3<T> Vector3<T>::operator+(const Vector3<T> &Vec) const
 	{
-		x = Vec.x;
-		y = Vec.y;
-		z = Vec.z;
+		return Vector3<T>(x + Vec.x, y + Vec.y, z + Vec.z);
 	}
 
 	template<typename T>
-	const Vector3<T> Vector3<T>::operator+(const Vector3<T> &Vec) const
+	HADRON_CONSTEXPR Vector3<T> Vector3<T>::operator-(const Vector3<T> &Vec) const
 	{
-		return Vector3<T>(x + Vec.x, y + Vec.y, z + Vec.z);
+		return Vector3<T>(x - Vec.x, y - Vec.y, z - Vec.z);
 	}
 
 	template<typename T>
-	const Vector3<T> Vector3<T>::operator-(const Vector3<T> &Vec) const
+	HADRON_CONSTEXPR Vector3<T> Vector3<T>::operator-() const
 	{
-		return Vector3<T>(x - Vec.x, y - Vec.y, z - Vec.z);
+		return Vector3<T>(-x, -y, -z);
 	}
 
 	template<typename T>
-	const Vector3<T> Vector3<T>::operator*(real Scalar) const
+	HADRON_CONSTEXPR Vector3<T> Vector3<T>::operator*(T Scalar) const
 	{
 		return Vector3<T>(x * Scalar, y * Scalar, z * Scalar);
 	}
 
 	template<typename T>
-	const Vector3<T> Vector3<T>::operator/(real Scalar) const
+	HADRON_CONSTEXPR Vector3<T> Vector3<T>::operator/(T Scalar) const
 	{
 		return Vector3<T>(x / Scalar, y / Scalar, z / Scalar);
 	}
 
 	template<typename T>
-	void Vector3<T>::operator+=(const Vector3<T> &Vec)
+	Vector3<T> &Vector3<T>::operator+=(const Vector3<T> &Vec)
 	{
 		x += Vec.x;
 		y += Vec.y;
 		z += Vec.z;
+		return *this;
 	}
 
 	template<typename T>
-	void Vector3<T>::operator-=(const Vector3<T> &Vec)
+	Vector3<T> &Vector3<T>::operator-=(const Vector3<T> &Vec)
 	{
 		x -= Vec.x;
 		y -= Vec.y;
 		z -= Vec.z;
+		return *this;
 	}
 
 	template<typename T>
-	void Vector3<T>::operator*=(real Scalar)
+	Vector3<T> &Vector3<T>::operator*=(T Scalar)
 	{
 		x *= Scalar;
 		y *= Scalar;
 		z *= Scalar;
+		return *this;
 	}
 
 	template<typename T>
-	void Vector3<T>::operator/=(real Scalar)
+	Vector3<T> &Vector3<T>::operator/=(T Scalar)
 	{
 		x /= Scalar;
 		y /= Scalar;
 		z /= Scalar;
+		return *this;
 	}
 
 	// Returns the magnitude of the vector
 	template<typename T>
 	T Vector3<T>::Length() const
 	{
-		return (T)sqrt((x * x) + (y * y) + (z * z));
+		return (T)sqrt(LengthSquared());
 	}
 
 	// Returns the magnitude^2 of the vector
 	// ^- Cuts out the call to sqrt(), meaning it's a bit faster
 	template<typename T>
-	T Vector3<T>::LengthSquared() const
+	HADRON_CONSTEXPR T Vector3<T>::LengthSquared() const
 	{
 		return (x * x) + (y * y) + (z * z);
 	}
 
 	// Returns the dot product of our vector with another
 	template<typename T>
-	real Vector3<T>::Dot(const Vector3<T> &Vec) const
+	HADRON_CONSTEXPR T Vector3<T>::Dot(const Vector3<T> &Vec) const
 	{
-		return (real)((x * Vec.x) + (y * Vec.y) + (z * Vec.z));
+		return (x * Vec.x) + (y * Vec.y) + (z * Vec.z);
 	}
 
 	// Returns the cross product of our vector with another
 	template<typename T>
-	const Vector3<T> &Vector3<T>::Cross(const Vector3<T> &Vec) const
+	HADRON_CONSTEXPR Vector3<T> Vector3<T>::Cross(const Vector3<T> &Vec) const
 	{
 		return Vector3<T>(
 			y * Vec.z - z * Vec.y,
@@ -197,20 +214,40 @@ namespace Hadron {
 		);
 	}
 
-	// Returns the unit vector of our vector
 	template<typename T>
-	const Vector3<T> &Vector3<T>::Normalised() const
+	Vector3<T> Vector3<T>::Normalised() const
+	{
+		T length;
+		return NormalisedAndLength(length);
+	}
+
+	// One sqrt and one divide, rather than a divide per component
+	// ^- With HADRON_FAST_RSQRT the divide and sqrt are both swapped for the refined estimate
+	template<typename T>
+	Vector3<T> Vector3<T>::NormalisedAndLength(T &Length) const
 	{
-		real len = Length();
-		if(len == 0) return Vector3<T>::ZERO;
-		
-		return Vector3<T>(x / len, y / len, z / len);
+		const T lengthSq = LengthSquared();
+		if(lengthSq <= (T)0.0)
+		{
+			Length = (T)0.0;
+			return Vector3<T>::ZERO;
+		}
+
+#if defined(HADRON_FAST_RSQRT)
+		const T inverse = FastReciprocalSqrt(lengthSq);
+		Length = lengthSq * inverse;
+#else
+		Length = (T)sqrt(lengthSq);
+		const T inverse = (T)1.0 / Length;
+#endif
+
+		return Vector3<T>(x * inverse, y * inverse, z * inverse);
 	}
 
 	template<typename T>
-	void Vector3<T>::AddScaledVector(const Vector3<T> &Vec, real Scale)
+	void Vector3<T>::AddScaledVector(const Vector3<T> &Vec, T Scale)
 	{
-		(*this) += Vec * Scale;
+		(*this) = MultiplyAdd(Vec, Scale, *this);
 	}
 
 	template<typename T>
@@ -0,0 +1,245 @@
+#ifndef HADRON_VECTOR3PACKET_HPP
+#define HADRON_VECTOR3PACKET_HPP
+
+namespace Hadron {
+	// A Vector3 for several particles at once
+	// ^- Each component holds one lane per particle, P::WIDTH of them, so one operation works on all lanes
+	// ^- P is one of the packet types, see packet_sse2.hpp and packet_avx2.hpp
+	// ^- Loads and stores go straight to and from structure of arrays storage, like ParticleWorld's
+	template<typename P>
+	class Vector3Packet
+	{
+	private:
+
+	public:
+		typedef typename P::Scalar T;
+
+		// Data members
+		P x, y, z;
+
+		// Constructors
+		Vector3Packet();
+		Vector3Packet(const Vector3Packet<P> &Vec);
+		Vector3Packet(const P &X, const P &Y, const P &Z);
+		Vector3Packet(T X, T Y, T Z);
+
+		// Loads and stores lanes [0, WIDTH) from separate x, y and z arrays
+		static Vector3Packet<P> Load(const T *X, const T *Y, const T *Z);
+		void Store(T *X, T *Y, T *Z) const;
+
+		// Loads lane i from the x y z triple starting at XYZ[Indices[i]], for vectors stored interleaved
+		static Vector3Packet<P> Gather(const T *XYZ, const int *Indices);
+
+		// Picks A's lanes where Mask is set, B's everywhere else
+		static Vector3Packet<P> Select(const P &Mask, const Vector3Packet<P> &A, const Vector3Packet<P> &B);
+
+		// Operator overloads
+		void operator=(const Vector3Packet<P> &Vec);
+
+		const Vector3Packet<P> operator+(const Vector3Packet<P> &Vec) const;
+		const Vector3Packet<P> operator-(const Vector3Packet<P> &Vec) const;
+
+		const Vector3Packet<P> operator*(const P &Scalar) const;
+		const Vector3Packet<P> operator/(const P &Scalar) const;
+
+		void operator+=(const Vector3Packet<P> &Vec);
+		void operator-=(const Vector3Packet<P> &Vec);
+
+		void operator*=(const P &Scalar);
+		void operator/=(const P &Scalar);
+
+		// Getters
+		P Length() const;
+		P LengthSquared() const;
+		P Dot(const Vector3Packet<P> &Vec) const;
+		Vector3Packet<P> Cross(const Vector3Packet<P> &Vec) const;
+		Vector3Packet<P> Normalised() const;
+
+		// Setters
+		void AddScaledVector(const Vector3Packet<P> &Vec, const P &Scale);
+
+		// Methods
+		void Clear();
+	};
+
+	// Default constructor
+	template<typename P>
+	Vector3Packet<P>::Vector3Packet():
+	x((T)0),
+	y((T)0),
+	z((T)0)
+	{ }
+
+	// Copy constructor
+	template<typename P>
+	Vector3Packet<P>::Vector3Packet(const Vector3Packet<P> &Vec):
+	x(Vec.x),
+	y(Vec.y),
+	z(Vec.z)
+	{ }
+
+	// Basic initialisation constructor
+	template<typename P>
+	Vector3Packet<P>::Vector3Packet(const P &X, const P &Y, const P &Z):
+	x(X),
+	y(Y),
+	z(Z)
+	{ }
+
+	// Broadcasts the same vector into every lane
+	template<typename P>
+	Vector3Packet<P>::Vector3Packet(T X, T Y, T Z):
+	x(X),
+	y(Y),
+	z(Z)
+	{ }
+
+	template<typename P>
+	Vector3Packet<P> Vector3Packet<P>::Load(const T *X, const T *Y, const T *Z)
+	{
+		return Vector3Packet<P>(P::Load(X), P::Load(Y), P::Load(Z));
+	}
+
+	template<typename P>
+	Vector3Packet<P> Vector3Packet<P>::Gather(const T *XYZ, const int *Indices)
+	{
+		return Vector3Packet<P>(P::Gather(XYZ, Indices), P::Gather(XYZ + 1, Indices), P::Gather(XYZ + 2, Indices));
+	}
+
+	template<typename P>
+	void Vector3Packet<P>::Store(T *X, T *Y, T *Z) const
+	{
+		x.Store(X);
+		y.Store(Y);
+		z.Store(Z);
+	}
+
+	template<typename P>
+	Vector3Packet<P> Vector3Packet<P>::Select(const P &Mask, const Vector3Packet<P> &A, const Vector3Packet<P> &B)
+	{
+		return Vector3Packet<P>(P::Select(Mask, A.x, B.x), P::Select(Mask, A.y, B.y), P::Select(Mask, A.z, B.z));
+	}
+
+	// Assignment operator
+	template<typename P>
+	void Vector3Packet<P>::operator=(const Vector3Packet<P> &Vec)
+	{
+		x = Vec.x;
+		y = Vec.y;
+		z = Vec.z;
+	}
+
+	template<typename P>
+	const Vector3Packet<P> Vector3Packet<P>::operator+(const Vector3Packet<P> &Vec) const
+	{
+		return Vector3Packet<P>(x + Vec.x, y + Vec.y, z + Vec.z);
+	}
+
+	template<typename P>
+	const Vector3Packet<P> Vector3Packet<P>::operator-(const Vector3Packet<P> &Vec) const
+	{
+		return Vector3Packet<P>(x - Vec.x, y - Vec.y, z - Vec.z);
+	}
+
+	template<typename P>
+	const Vector3Packet<P> Vector3Packet<P>::operator*(const P &Scalar) const
+	{
+		return Vector3Packet<P>(x * Scalar, y * Scalar, z * Scalar);
+	}
+
+	template<typename P>
+	const Vector3Packet<P> Vector3Packet<P>::operator/(const P &Scalar) const
+	{
+		return Vector3Packet<P>(x / Scalar, y / Scalar, z / Scalar);
+	}
+
+	template<typename P>
+	void Vector3Packet<P>::operator+=(const Vector3Packet<P> &Vec)
+	{
+		x += Vec.x;
+		y += Vec.y;
+		z += Vec.z;
+	}
+
+	template<typename P>
+	void Vector3Packet<P>::operator-=(const Vector3Packet<P> &Vec)
+	{
+		x -= Vec.x;
+		y -= Vec.y;
+		z -= Vec.z;
+	}
+
+	template<typename P>
+	void Vector3Packet<P>::operator*=(const P &Scalar)
+	{
+		x *= Scalar;
+		y *= Scalar;
+		z *= Scalar;
+	}
+
+	template<typename P>
+	void Vector3Packet<P>::operator/=(const P &Scalar)
+	{
+		x /= Scalar;
+		y /= Scalar;
+		z /= Scalar;
+	}
+
+	// Returns the magnitude of each lane's vector
+	template<typename P>
+	P Vector3Packet<P>::Length() const
+	{
+		return P::Sqrt(LengthSquared());
+	}
+
+	// Returns the magnitude^2 of each lane's vector
+	template<typename P>
+	P Vector3Packet<P>::LengthSquared() const
+	{
+		return (x * x) + (y * y) + (z * z);
+	}
+
+	// Returns the dot product of each lane with the other vector's lane
+	template<typename P>
+	P Vector3Packet<P>::Dot(const Vector3Packet<P> &Vec) const
+	{
+		return (x * Vec.x) + (y * Vec.y) + (z * Vec.z);
+	}
+
+	// Returns the cross product of each lane with the other vector's lane
+	template<typename P>
+	Vector3Packet<P> Vector3Packet<P>::Cross(const Vector3Packet<P> &Vec) const
+	{
+		return Vector3Packet<P>(
+			y * Vec.z - z * Vec.y,
+			z * Vec.x - x * Vec.z,
+			x * Vec.y - y * Vec.x
+		);
+	}
+
+	// Returns the unit vector of each lane
+	// ^- Lanes with zero length come out as zero, same as Vector3::Normalised
+	template<typename P>
+	Vector3Packet<P> Vector3Packet<P>::Normalised() const
+	{
+		const P zero((T)0);
+		const P len = Length();
+		const P nonZero = P::Greater(len, zero);
+
+		return Select(nonZero, (*this) / len, Vector3Packet<P>());
+	}
+
+	template<typename P>
+	void Vector3Packet<P>::AddScaledVector(const Vector3Packet<P> &Vec, const P &Scale)
+	{
+		(*this) += Vec * Scale;
+	}
+
+	template<typename P>
+	void Vector3Packet<P>::Clear()
+	{
+		x = y = z = P((T)0);
+	}
+};
+
+#endif // HADRON_VECTOR3PACKET_HPP
\ No newline at end of file
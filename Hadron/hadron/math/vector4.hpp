@@ -0,0 +1,235 @@
+#ifndef HADRON_VECTOR4_HPP
+#define HADRON_VECTOR4_HPP
+
+#include <math.h>
+
+#include "../core/precision.hpp"
+#include "scalar.hpp"
+#include "vector3.hpp"
+
+// 16 byte alignment, spelt however the compiler wants it
+#if defined(_MSC_VER)
+	#define HADRON_ALIGN16 __declspec(align(16))
+#else
+	#define HADRON_ALIGN16 __attribute__((aligned(16)))
+#endif
+
+namespace Hadron {
+	// A Vector3 padded out to 4 components, and 16 byte aligned
+	// ^- A whole float vector fits one SSE register and a double one two, so arrays of them can be loaded and
+	//    stored with aligned moves and the compiler can vectorise the arithmetic without any shuffling
+	// ^- w is padding as far as the 3D operations are concerned, it's carried along by +, -, * and / but left out
+	//    of lengths, dot products and normalisation, so keep it 0 for plain vectors
+	template<typename T>
+	class HADRON_ALIGN16 Vector4
+	{
+	private:
+
+	public:
+		// Data members
+		T x, y, z, w;
+
+		// Constructors
+		HADRON_CONSTEXPR Vector4();
+		HADRON_CONSTEXPR Vector4(T X, T Y, T Z, T W);
+
+		// Pads a Vector3 out with W
+		explicit HADRON_CONSTEXPR Vector4(const Vector3<T> &Vec, T W = (T)0.0);
+
+		// Drops w
+		HADRON_CONSTEXPR Vector3<T> ToVector3() const;
+
+		// Operator overloads
+		HADRON_CONSTEXPR Vector4<T> operator+(const Vector4<T> &Vec) const;
+		HADRON_CONSTEXPR Vector4<T> operator-(const Vector4<T> &Vec) const;
+		HADRON_CONSTEXPR Vector4<T> operator-() const;
+
+		HADRON_CONSTEXPR Vector4<T> operator*(T Scalar) const;
+		HADRON_CONSTEXPR Vector4<T> operator/(T Scalar) const;
+
+		Vector4<T> &operator+=(const Vector4<T> &Vec);
+		Vector4<T> &operator-=(const Vector4<T> &Vec);
+
+		Vector4<T> &operator*=(T Scalar);
+		Vector4<T> &operator/=(T Scalar);
+
+		// Getters, over x, y and z only
+		T Length() const;
+		HADRON_CONSTEXPR T LengthSquared() const;
+		HADRON_CONSTEXPR T Dot(const Vector4<T> &Vec) const;
+		HADRON_CONSTEXPR Vector4<T> Cross(const Vector4<T> &Vec) const;
+		Vector4<T> Normalised() const;
+		Vector4<T> NormalisedAndLength(T &Length) const;
+
+		// Setters
+		void AddScaledVector(const Vector4<T> &Vec, T Scale);
+
+		// Methods
+		void Clear();
+	};
+
+	// A * B + C per component, fused when HADRON_FMA is defined
+	template<typename T>
+	inline Vector4<T> MultiplyAdd(const Vector4<T> &A, T B, const Vector4<T> &C)
+	{
+		return Vector4<T>(MultiplyAdd(A.x, B, C.x), MultiplyAdd(A.y, B, C.y), MultiplyAdd(A.z, B, C.z), MultiplyAdd(A.w, B, C.w));
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T>::Vector4():
+	x((T)0),
+	y((T)0),
+	z((T)0),
+	w((T)0)
+	{ }
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T>::Vector4(T X, T Y, T Z, T W):
+	x(X),
+	y(Y),
+	z(Z),
+	w(W)
+	{ }
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T>::Vector4(const Vector3<T> &Vec, T W):
+	x(Vec.x),
+	y(Vec.y),
+	z(Vec.z),
+	w(W)
+	{ }
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector3<T> Vector4<T>::ToVector3() const
+	{
+		return Vector3<T>(x, y, z);
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T> Vector4<T>::operator+(const Vector4<T> &Vec) const
+	{
+		return Vector4<T>(x + Vec.x, y + Vec.y, z + Vec.z, w + Vec.w);
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T> Vector4<T>::operator-(const Vector4<T> &Vec) const
+	{
+		return Vector4<T>(x - Vec.x, y - Vec.y, z - Vec.z, w - Vec.w);
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T> Vector4<T>::operator-() const
+	{
+		return Vector4<T>(-x, -y, -z, -w);
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T> Vector4<T>::operator*(T Scalar) const
+	{
+		return Vector4<T>(x * Scalar, y * Scalar, z * Scalar, w * Scalar);
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T> Vector4<T>::operator/(T Scalar) const
+	{
+		return Vector4<T>(x / Scalar, y / Scalar, z / Scalar, w / Scalar);
+	}
+
+	template<typename T>
+	Vector4<T> &Vector4<T>::operator+=(const Vector4<T> &Vec)
+	{
+		x += Vec.x;
+		y += Vec.y;
+		z += Vec.z;
+		w += Vec.w;
+		return *this;
+	}
+
+	template<typename T>
+	Vector4<T> &Vector4<T>::operator-=(const Vector4<T> &Vec)
+	{
+		x -= Vec.x;
+		y -= Vec.y;
+		z -= Vec.z;
+		w -= Vec.w;
+		return *this;
+	}
+
+	template<typename T>
+	Vector4<T> &Vector4<T>::operator*=(T Scalar)
+	{
+		x *= Scalar;
+		y *= Scalar;
+		z *= Scalar;
+		w *= Scalar;
+		return *this;
+	}
+
+	template<typename T>
+	Vector4<T> &Vector4<T>::operator/=(T Scalar)
+	{
+		x /= Scalar;
+		y /= Scalar;
+		z /= Scalar;
+		w /= Scalar;
+		return *this;
+	}
+
+	template<typename T>
+	T Vector4<T>::Length() const
+	{
+		return (T)sqrt(LengthSquared());
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR T Vector4<T>::LengthSquared() const
+	{
+		return (x * x) + (y * y) + (z * z);
+	}
+
+	template<typename T>
+	HADRON_CONSTEXPR T Vector4<T>::Dot(const Vector4<T> &Vec) const
+	{
+		return (x * Vec.x) + (y * Vec.y) + (z * Vec.z);
+	}
+
+	// w comes out as 0
+	template<typename T>
+	HADRON_CONSTEXPR Vector4<T> Vector4<T>::Cross(const Vector4<T> &Vec) const
+	{
+		return Vector4<T>(
+			y * Vec.z - z * Vec.y,
+			z * Vec.x - x * Vec.z,
+			x * Vec.y - y * Vec.x,
+			(T)0.0
+		);
+	}
+
+	template<typename T>
+	Vector4<T> Vector4<T>::Normalised() const
+	{
+		T length;
+		return NormalisedAndLength(length);
+	}
+
+	// Same as Vector3's, w is kept as it is
+	template<typename T>
+	Vector4<T> Vector4<T>::NormalisedAndLength(T &Length) const
+	{
+		return Vector4<T>(ToVector3().NormalisedAndLength(Length), w);
+	}
+
+	template<typename T>
+	void Vector4<T>::AddScaledVector(const Vector4<T> &Vec, T Scale)
+	{
+		(*this) = MultiplyAdd(Vec, Scale, *this);
+	}
+
+	template<typename T>
+	void Vector4<T>::Clear()
+	{
+		(*this) = Vector4<T>();
+	}
+};
+
+#endif // HADRON_VECTOR4_HPP
\ No newline at end of file
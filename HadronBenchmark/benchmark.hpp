@@ -0,0 +1,54 @@
+#ifndef HADRON_BENCHMARK_HPP
+#define HADRON_BENCHMARK_HPP
+
+#include <hadron/hadron.hpp>
+
+// Convenience
+using Hadron::real;
+
+// Wall clock time in milliseconds
+double Now();
+
+// Restarts the random sequence
+// ^- The generator's our own rather than rand(), so a seed gives the same scene on every platform
+void SeedRandom(unsigned int Seed);
+
+// Uniform random number in [Min, Max)
+real Random(real Min, real Max);
+
+// A reproducible scene that the runner can step and time
+// ^- The same count and seed always build the same scene, whatever the thread count
+class Scenario
+{
+public:
+	virtual ~Scenario() { }
+
+	// Name it's picked by on the command line
+	virtual const char *GetName() const = 0;
+
+	// Builds the scene with roughly Count particles, running on Pool (NULL runs everything serially)
+	// ^- Can be called again to rebuild it from scratch
+	virtual void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool) = 0;
+
+	// Advances the scene by one step of dT
+	virtual void Step(real dT) = 0;
+
+	// Number of particles actually built, some scenes round Count to fit their shape
+	virtual unsigned int GetParticleCount() const = 0;
+
+	// Sum of every particle's coordinates
+	// ^- The parallel paths are deterministic, so this should match across thread counts for a given seed
+	virtual double GetChecksum() const = 0;
+};
+
+// Every scenario's name, in the order they're run
+extern const char *const SCENARIO_NAMES[];
+extern const unsigned int SCENARIO_COUNT;
+
+// Creates the scenario with the given name, or returns NULL if there isn't one
+Scenario *CreateScenario(const char *Name);
+
+// The one off comparisons (Barnes-Hut accuracy, integrator drift, implicit springs and so on), printed as tables
+void RunStudies(Hadron::ThreadPool &Pool);
+
+#endif // HADRON_BENCHMARK_HPP
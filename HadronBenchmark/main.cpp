@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// Scenario runner
+// ^- Runs every chosen scenario for each particle count and thread count, and prints one row per run as a
+//    table, CSV or JSON
+// ^- Usage: HadronBenchmark [--scenario a,b,...] [--counts n,...] [--threads n,...] [--steps n] [--warmup n]
+//                           [--seed n] [--dt seconds] [--format table|csv|json] [--profile trace.json] [--list]
+//                           [--studies]
+// ^- --profile turns on the built in profiler, printing a per-phase summary of each run to stderr and writing a
+//    Chrome trace of everything at the end
+
+namespace {
+	// State of the random sequence, xorshift32
+	unsigned int randomState = 1;
+
+	enum Format
+	{
+		FORMAT_TABLE,
+		FORMAT_CSV,
+		FORMAT_JSON
+	};
+
+	struct Options
+	{
+		std::vector<std::string> scenarios;
+		std::vector<unsigned int> counts;
+		std::vector<unsigned int> threads;
+		unsigned int steps;
+		unsigned int warmup;
+		unsigned int seed;
+		real dT;
+		Format format;
+		bool studies;
+
+		// Where to write the Chrome trace, NULL if we're not profiling
+		const char *profilePath;
+	};
+
+	// One timed run of one scenario
+	struct Result
+	{
+		const char *scenario;
+		unsigned int particles;
+		unsigned int threads;
+		unsigned int steps;
+		double ms;
+		double checksum;
+	};
+
+	// Splits a comma separated list of numbers, returns false if any of them aren't positive
+	bool parseCounts(const char *Text, std::vector<unsigned int> &Out)
+	{
+		Out.clear();
+		while(*Text)
+		{
+			char *end;
+			const unsigned long value = strtoul(Text, &end, 10);
+			if(end == Text || value == 0) return false;
+
+			Out.push_back((unsigned int)value);
+			Text = (*end == ',') ? end + 1 : end;
+			if(*end != ',' && *end != '\0') return false;
+		}
+
+		return !Out.empty();
+	}
+
+	void parseNames(const char *Text, std::vector<std::string> &Out)
+	{
+		Out.clear();
+		const char *start = Text;
+		for(const char *c = Text; ; c++)
+		{
+			if(*c == ',' || *c == '\0')
+			{
+				if(c > start) Out.push_back(std::string(start, c));
+				if(*c == '\0') break;
+				start = c + 1;
+			}
+		}
+	}
+
+	void printUsage()
+	{
+		printf("usage: HadronBenchmark [--scenario a,b,...] [--counts n,...] [--threads n,...] [--steps n] [--warmup n]\n");
+		printf("                       [--seed n] [--dt seconds] [--format table|csv|json] [--profile trace.json] [--list]\n");
+		printf("                       [--studies]\n");
+	}
+
+	// Fills in the defaults, then anything given on the command line
+	// ^- Returns false if the arguments don't make sense
+	bool parseOptions(int argc, char *argv[], Options &Opts)
+	{
+		for(unsigned int i = 0; i < SCENARIO_COUNT; i++)
+		{
+			Opts.scenarios.push_back(SCENARIO_NAMES[i]);
+		}
+
+		Opts.counts.push_back(1000);
+		Opts.counts.push_back(10000);
+		Opts.counts.push_back(100000);
+
+		// Powers of two up to however many cores there are, plus the core count itself
+		const unsigned int cores = std::max(1u, (unsigned int)std::thread::hardware_concurrency());
+		for(unsigned int t = 1; t < cores; t *= 2)
+		{
+			Opts.threads.push_back(t);
+		}
+		Opts.threads.push_back(cores);
+
+		Opts.steps = 100;
+		Opts.warmup = 10;
+		Opts.seed = 1234;
+		Opts.dT = (real)(1.0 / 60.0);
+		Opts.format = FORMAT_TABLE;
+		Opts.studies = false;
+		Opts.profilePath = NULL;
+
+		for(int i = 1; i < argc; i++)
+		{
+			const char *arg = argv[i];
+			const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+			if(strcmp(arg, "--studies") == 0)
+			{
+				Opts.studies = true;
+				continue;
+			}
+
+			if(strcmp(arg, "--list") == 0)
+			{
+				for(unsigned int s = 0; s < SCENARIO_COUNT; s++)
+				{
+					printf("%s\n", SCENARIO_NAMES[s]);
+				}
+				exit(0);
+			}
+
+			// Everything else takes a value
+			if(value == NULL) return false;
+			i++;
+
+			if(strcmp(arg, "--scenario") == 0) parseNames(value, Opts.scenarios);
+			else if(strcmp(arg, "--counts") == 0) { if(!parseCounts(value, Opts.counts)) return false; }
+			else if(strcmp(arg, "--threads") == 0) { if(!parseCounts(value, Opts.threads)) return false; }
+			else if(strcmp(arg, "--steps") == 0) Opts.steps = (unsigned int)strtoul(value, NULL, 10);
+			else if(strcmp(arg, "--warmup") == 0) Opts.warmup = (unsigned int)strtoul(value, NULL, 10);
+			else if(strcmp(arg, "--seed") == 0) Opts.seed = (unsigned int)strtoul(value, NULL, 10);
+			else if(strcmp(arg, "--dt") == 0) Opts.dT = (real)atof(value);
+			else if(strcmp(arg, "--profile") == 0) Opts.profilePath = value;
+			else if(strcmp(arg, "--format") == 0)
+			{
+				if(strcmp(value, "table") == 0) Opts.format = FORMAT_TABLE;
+				else if(strcmp(value, "csv") == 0) Opts.format = FORMAT_CSV;
+				else if(strcmp(value, "json") == 0) Opts.format = FORMAT_JSON;
+				else return false;
+			}
+			else return false;
+		}
+
+		return Opts.steps > 0 && Opts.dT > (real)0.0 && !Opts.scenarios.empty();
+	}
+
+	// Builds the scenario, steps it through the warm up, then times the rest
+	Result run(Scenario &S, unsigned int Count, unsigned int Threads, Hadron::ThreadPool *Pool, const Options &Opts)
+	{
+		S.Setup(Count, Opts.seed, Pool);
+
+		// Each step's a profiler frame, the summary only holds as many as the timed steps so the warm up drops out
+		for(unsigned int i = 0; i < Opts.warmup; i++)
+		{
+			S.Step(Opts.dT);
+			Hadron::EndProfileFrame();
+		}
+
+		const double start = Now();
+		for(unsigned int i = 0; i < Opts.steps; i++)
+		{
+			S.Step(Opts.dT);
+			Hadron::EndProfileFrame();
+		}
+
+		Result r;
+		r.scenario = S.GetName();
+		r.particles = S.GetParticleCount();
+		r.threads = Threads;
+		r.steps = Opts.steps;
+		r.ms = Now() - start;
+		r.checksum = S.GetChecksum();
+
+		if(Opts.profilePath != NULL)
+		{
+			fprintf(stderr, "\n%s, %u particles, %u threads\n", r.scenario, r.particles, r.threads);
+			Hadron::WriteProfileSummary(stderr);
+		}
+
+		return r;
+	}
+
+	// Prints a result, Baseline is the same scenario and count on the first thread count in the list
+	// ^- Speedup and efficiency are against that, so list 1 first to get true scaling curves
+	void print(const Result &R, const Result &Baseline, Format F, bool First)
+	{
+		const double particleSteps = (double)R.particles * (double)R.steps;
+		const double nsPerParticleStep = R.ms * 1.0e6 / particleSteps;
+		const double throughput = particleSteps / (R.ms * 1.0e-3);
+		const double speedup = Baseline.ms / R.ms;
+		const double efficiency = speedup * (double)Baseline.threads / (double)R.threads;
+
+		switch(F)
+		{
+		case FORMAT_TABLE:
+			if(First)
+			{
+				printf("%-22s %10s %8s %8s %12s %14s %14s %8s %8s %16s\n", "scenario", "particles", "threads", "steps",
+					"ms", "ns/particle", "particles/s", "speedup", "eff", "checksum");
+			}
+			printf("%-22s %10u %8u %8u %12.3f %14.3f %14.4e %8.2f %8.2f %16.9e\n", R.scenario, R.particles, R.threads, R.steps,
+				R.ms, nsPerParticleStep, throughput, speedup, efficiency, R.checksum);
+			break;
+
+		case FORMAT_CSV:
+			if(First)
+			{
+				printf("scenario,particles,threads,steps,ms,ns_per_particle_step,particle_steps_per_second,speedup,efficiency,checksum\n");
+			}
+			printf("%s,%u,%u,%u,%.6f,%.6f,%.6e,%.6f,%.6f,%.17g\n", R.scenario, R.particles, R.threads, R.steps,
+				R.ms, nsPerParticleStep, throughput, speedup, efficiency, R.checksum);
+			break;
+
+		case FORMAT_JSON:
+			printf("%s  {\"scenario\": \"%s\", \"particles\": %u, \"threads\": %u, \"steps\": %u, \"ms\": %.6f, "
+				"\"ns_per_particle_step\": %.6f, \"particle_steps_per_second\": %.6e, \"speedup\": %.6f, \"efficiency\": %.6f, "
+				"\"checksum\": %.17g}", First ? "" : ",\n", R.scenario, R.particles, R.threads, R.steps, R.ms,
+				nsPerParticleStep, throughput, speedup, efficiency, R.checksum);
+			break;
+		}
+
+		fflush(stdout);
+	}
+}
+
+double Now()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SeedRandom(unsigned int Seed)
+{
+	// Xorshift gets stuck on 0
+	randomState = Seed ? Seed : 0x9E3779B9;
+}
+
+real Random(real Min, real Max)
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+
+	return Min + (Max - Min) * (real)((double)randomState / 4294967296.0);
+}
+
+int main(int argc, char *argv[])
+{
+	Options opts;
+	if(!parseOptions(argc, argv, opts))
+	{
+		printUsage();
+		return 1;
+	}
+
+	if(opts.studies)
+	{
+		Hadron::ThreadPool pool(*std::max_element(opts.threads.begin(), opts.threads.end()));
+		RunStudies(pool);
+		return 0;
+	}
+
+	// Check every name before spending any time running things
+	std::vector<Scenario *> scenarios;
+	for(unsigned int s = 0; s < opts.scenarios.size(); s++)
+	{
+		Scenario *scenario = CreateScenario(opts.scenarios[s].c_str());
+		if(scenario == NULL)
+		{
+			fprintf(stderr, "unknown scenario '%s', --list shows them all\n", opts.scenarios[s].c_str());
+			for(unsigned int i = 0; i < scenarios.size(); i++)
+			{
+				delete scenarios[i];
+			}
+			return 1;
+		}
+
+		scenarios.push_back(scenario);
+	}
+
+	if(opts.profilePath != NULL)
+	{
+		Hadron::SetProfileHistory(opts.steps);
+		Hadron::StartProfileCapture();
+		Hadron::SetProfilingEnabled(true);
+	}
+
+	if(opts.format == FORMAT_JSON) printf("[\n");
+
+	// One pool per thread count, 1 thread runs the serial paths without a pool at all
+	std::vector<Hadron::ThreadPool *> pools(opts.threads.size(), (Hadron::ThreadPool *)NULL);
+	for(unsigned int t = 0; t < opts.threads.size(); t++)
+	{
+		if(opts.threads[t] > 1) pools[t] = new Hadron::ThreadPool(opts.threads[t]);
+	}
+
+	// Thread counts vary fastest, so each scaling curve comes out in one block
+	bool first = true;
+	for(unsigned int s = 0; s < scenarios.size(); s++)
+	{
+		for(unsigned int c = 0; c < opts.counts.size(); c++)
+		{
+			Result baseline = Result();
+			for(unsigned int t = 0; t < opts.threads.size(); t++)
+			{
+				const Result r = run(*scenarios[s], opts.counts[c], opts.threads[t], pools[t], opts);
+				if(t == 0) baseline = r;
+
+				print(r, baseline, opts.format, first);
+				first = false;
+			}
+		}
+
+		delete scenarios[s];
+	}
+
+	for(unsigned int t = 0; t < pools.size(); t++)
+	{
+		delete pools[t];
+	}
+
+	if(opts.format == FORMAT_JSON) printf("\n]\n");
+
+	if(opts.profilePath != NULL && !Hadron::WriteChromeTrace(opts.profilePath))
+	{
+		fprintf(stderr, "couldn't write the trace to '%s'\n", opts.profilePath);
+		return 1;
+	}
+
+	return 0;
+}
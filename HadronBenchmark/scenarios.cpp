@@ -0,0 +1,812 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "benchmark.hpp"
+
+namespace {
+	// Base for the scenes that keep their particles in a ParticleForceRegistry
+	// ^- Each step applies every registered force and updates the registered particles, as the demos do
+	class RegistryScenario : public Scenario
+	{
+	protected:
+		std::vector<Hadron::Particle> particles;
+		Hadron::ParticleForceRegistry registry;
+
+		// Creates Count live particles scattered through a cube of the given half width, then registers their forces
+		// ^- The particles mustn't move in memory once they're registered, so they're all made up front
+		void spawn(unsigned int Count, real HalfWidth)
+		{
+			registry.Clear();
+			particles.assign(Count, Hadron::Particle());
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				particles[i].SetPosition(Random(-HalfWidth, HalfWidth), Random(-HalfWidth, HalfWidth), Random(-HalfWidth, HalfWidth));
+				particles[i].SetMass(Random((real)1.0, (real)10.0));
+				particles[i].SetAlive(true);
+			}
+		}
+
+	public:
+		void Step(real dT)
+		{
+			registry.ApplyForces(dT);
+			registry.Update(dT);
+		}
+
+		unsigned int GetParticleCount() const
+		{
+			return (unsigned int)particles.size();
+		}
+
+		double GetChecksum() const
+		{
+			double sum = 0.0;
+			for(unsigned int i = 0; i < particles.size(); i++)
+			{
+				sum += (double)particles[i].GetX() + (double)particles[i].GetY() + (double)particles[i].GetZ();
+			}
+
+			return sum;
+		}
+	};
+
+	// Particles orbiting a single ParticleGravitation point
+	class GravitationScenario : public RegistryScenario
+	{
+	private:
+		Hadron::ParticleGravitation gravitation;
+
+	public:
+		const char *GetName() const { return "gravitation"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			SeedRandom(Seed);
+			spawn(Count, (real)50.0);
+			registry.SetThreadPool(Pool);
+			gravitation.SetGravityPosition((real)0.0, (real)0.0, (real)0.0);
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				// Roughly circular orbits, the point pulls with 100 / r so that's a speed of about 10
+				Hadron::Particle &p = particles[i];
+				const Hadron::Vector3<real> radial = p.GetPosition();
+				p.SetVelocity(radial.Cross(Hadron::Vector3<real>::UP).Normalised() * Random((real)8.0, (real)12.0));
+				p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+
+				registry.Add(&p, &gravitation);
+			}
+		}
+	};
+
+	// A cloud of particles thrown in random directions, slowed by drag as they fall
+	class DragScenario : public RegistryScenario
+	{
+	private:
+		Hadron::ParticleDrag drag;
+
+	public:
+		DragScenario():
+		drag((real)0.1, (real)0.01)
+		{ }
+
+		const char *GetName() const { return "drag"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			SeedRandom(Seed);
+			spawn(Count, (real)50.0);
+			registry.SetThreadPool(Pool);
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				particles[i].SetVelocity(Random((real)-20.0, (real)20.0), Random((real)0.0, (real)40.0), Random((real)-20.0, (real)20.0));
+				registry.Add(&particles[i], &drag);
+			}
+		}
+	};
+
+	// Chains of particles hanging from a fixed top link, each link joined by a ParticleSpring in both directions
+	class SpringChainScenario : public RegistryScenario
+	{
+	private:
+		static const unsigned int CHAIN_LENGTH = 32;
+
+		std::vector<Hadron::ParticleSpring> springs;
+
+	public:
+		const char *GetName() const { return "spring-chain"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			// Whole chains only
+			Count = (Count + CHAIN_LENGTH - 1) / CHAIN_LENGTH * CHAIN_LENGTH;
+
+			SeedRandom(Seed);
+			spawn(Count, (real)50.0);
+			registry.SetThreadPool(Pool);
+
+			springs.assign(Count * 2, Hadron::ParticleSpring());
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				Hadron::Particle &p = particles[i];
+				const unsigned int link = i % CHAIN_LENGTH;
+
+				// Hang each chain straight down from wherever its top link landed
+				if(link == 0)
+				{
+					p.SetMass((real)0.0);
+					p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+					continue;
+				}
+
+				const Hadron::Vector3<real> above = particles[i - 1].GetPosition();
+				p.SetPosition(above.x + Random((real)-0.1, (real)0.1), above.y - (real)1.0, above.z + Random((real)-0.1, (real)0.1));
+
+				springs[i * 2] = Hadron::ParticleSpring(&particles[i - 1], (real)50.0, (real)1.0);
+				springs[i * 2 + 1] = Hadron::ParticleSpring(&p, (real)50.0, (real)1.0);
+				registry.Add(&p, &springs[i * 2]);
+				registry.Add(&particles[i - 1], &springs[i * 2 + 1]);
+			}
+		}
+	};
+
+	// The same chains, solved an island (one chain) at a time
+	// ^- Each spring's its own generator, so this is the case where splitting up by island rather than by slot
+	//    range saves each thread from looking through every other chain's groups
+	class SpringChainIslandScenario : public SpringChainScenario
+	{
+	public:
+		const char *GetName() const { return "spring-chain-islands"; }
+
+		void Step(real dT)
+		{
+			registry.SolveIslands(dT);
+		}
+	};
+
+	// A cloud of loose particles under drag, with a sixteenth of them in short, very stiff hanging chains
+	// ^- The chains need about 9 substeps a frame to stay stable, the rest need 1
+	// ^- With MultiRate only the chains' islands are substepped, otherwise every island takes as many substeps as
+	//    the stiffest one, as it would with a single global step
+	template<bool MultiRate>
+	class StiffChainScenario : public RegistryScenario
+	{
+	private:
+		static const unsigned int CHAIN_LENGTH = 16;
+
+		Hadron::ParticleDrag drag;
+		std::vector<Hadron::ParticleSpring> springs;
+
+	public:
+		StiffChainScenario():
+		drag((real)0.1, (real)0.01)
+		{ }
+
+		const char *GetName() const { return MultiRate ? "stiff-chains-multirate" : "stiff-chains"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			SeedRandom(Seed);
+			spawn(Count, (real)50.0);
+			registry.SetThreadPool(Pool);
+
+			const unsigned int chained = Count / 16 / CHAIN_LENGTH * CHAIN_LENGTH;
+			springs.assign(chained * 2, Hadron::ParticleSpring());
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				Hadron::Particle &p = particles[i];
+
+				if(i >= chained)
+				{
+					p.SetVelocity(Random((real)-20.0, (real)20.0), Random((real)0.0, (real)40.0), Random((real)-20.0, (real)20.0));
+					registry.Add(&p, &drag);
+					continue;
+				}
+
+				const unsigned int link = i % CHAIN_LENGTH;
+				if(link == 0)
+				{
+					p.SetMass((real)0.0);
+					p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+					continue;
+				}
+
+				const Hadron::Vector3<real> above = particles[i - 1].GetPosition();
+				p.SetPosition(above.x + Random((real)-0.1, (real)0.1), above.y - (real)1.0, above.z + Random((real)-0.1, (real)0.1));
+				p.SetMass((real)1.0);
+				p.SetDamping((real)0.5);
+
+				springs[i * 2] = Hadron::ParticleSpring(&particles[i - 1], (real)500.0, (real)1.0);
+				springs[i * 2 + 1] = Hadron::ParticleSpring(&p, (real)500.0, (real)1.0);
+				registry.Add(&p, &springs[i * 2]);
+				registry.Add(&particles[i - 1], &springs[i * 2 + 1]);
+			}
+		}
+
+		void Step(real dT)
+		{
+			if(MultiRate)
+			{
+				registry.SolveIslandsMultiRate(dT);
+				return;
+			}
+
+			unsigned int substeps = 1;
+			for(unsigned int i = 0; i < registry.GetIslandCount(); i++)
+			{
+				substeps = std::max(substeps, registry.GetIslandSubsteps(i, dT));
+			}
+
+			for(unsigned int s = 0; s < substeps; s++)
+			{
+				registry.SolveIslands(dT / (real)substeps);
+			}
+		}
+	};
+
+	// Gravitation and drag on every particle, with ParticleSprings joining them in pairs
+	// ^- Three generator types in one registry, so the grouping and scheduling all get exercised
+	class MixedScenario : public RegistryScenario
+	{
+	private:
+		Hadron::ParticleGravitation gravitation;
+		Hadron::ParticleDrag drag;
+		std::vector<Hadron::ParticleSpring> springs;
+
+	public:
+		MixedScenario():
+		drag((real)0.01, (real)0.001)
+		{ }
+
+		const char *GetName() const { return "mixed"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			SeedRandom(Seed);
+			spawn(Count, (real)50.0);
+			registry.SetThreadPool(Pool);
+			gravitation.SetGravityPosition((real)0.0, (real)0.0, (real)0.0);
+
+			springs.assign(Count, Hadron::ParticleSpring());
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				Hadron::Particle &p = particles[i];
+				p.SetVelocity(Random((real)-10.0, (real)10.0), Random((real)-10.0, (real)10.0), Random((real)-10.0, (real)10.0));
+				p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+
+				registry.Add(&p, &gravitation);
+				registry.Add(&p, &drag);
+
+				// Each particle is tied to its partner, the odd one out at the end goes without
+				const unsigned int partner = i ^ 1;
+				if(partner < Count)
+				{
+					springs[i] = Hadron::ParticleSpring(&particles[partner], (real)10.0, (real)2.0);
+					registry.Add(&p, &springs[i]);
+				}
+			}
+		}
+	};
+
+	// A square sheet of cloth hanging from one edge, in a ParticleWorld with a SpringNetwork
+	// ^- Forces come from the network, and the world's integrated in ranges split over the pool
+	class ClothScenario : public Scenario
+	{
+	private:
+		Hadron::ParticleWorld world;
+		Hadron::SpringNetwork network;
+		Hadron::ThreadPool *pool;
+
+	public:
+		ClothScenario():
+		pool(NULL)
+		{ }
+
+		const char *GetName() const { return "cloth"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			unsigned int side = (unsigned int)(sqrt((double)Count) + 0.5);
+			if(side < 2) side = 2;
+
+			SeedRandom(Seed);
+			world.Clear();
+			network.Clear();
+			world.Reserve(side * side);
+			network.SetThreadPool(Pool);
+			pool = Pool;
+
+			for(unsigned int y = 0; y < side; y++)
+			{
+				for(unsigned int x = 0; x < side; x++)
+				{
+					Hadron::ParticleWorld::ParticleView p = world.Get(world.Add());
+					p.SetPosition((real)x + Random((real)-0.1, (real)0.1), (real)0.0, (real)y + Random((real)-0.1, (real)0.1));
+					p.SetAlive(true);
+
+					if(y == 0)
+					{
+						p.SetMass((real)0.0);
+						p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+					}
+					else
+					{
+						p.SetMass((real)1.0);
+					}
+				}
+			}
+
+			const real diagonal = (real)sqrt((real)2.0);
+			for(unsigned int y = 0; y < side; y++)
+			{
+				for(unsigned int x = 0; x < side; x++)
+				{
+					const unsigned int i = y * side + x;
+					if(x + 1 < side) network.Add(i, i + 1, (real)100.0, (real)1.0, (real)0.5);
+					if(y + 1 < side) network.Add(i, i + side, (real)100.0, (real)1.0, (real)0.5);
+					if(x + 1 < side && y + 1 < side) network.Add(i, i + side + 1, (real)100.0, diagonal, (real)0.5);
+				}
+			}
+		}
+
+		void Step(real dT)
+		{
+			world.ClearForces();
+			network.ApplyForces(world, dT);
+
+			world.PrepareStep(dT);
+			Hadron::ParallelFor(pool, 0, world.GetCount(), [&](unsigned int Begin, unsigned int End)
+			{
+				world.Step(Begin, End, dT);
+			});
+		}
+
+		unsigned int GetParticleCount() const
+		{
+			return world.GetCount();
+		}
+
+		double GetChecksum() const
+		{
+			const real *x = world.GetPositionsX(), *y = world.GetPositionsY(), *z = world.GetPositionsZ();
+
+			double sum = 0.0;
+			for(unsigned int i = 0; i < world.GetCount(); i++)
+			{
+				sum += (double)x[i] + (double)y[i] + (double)z[i];
+			}
+
+			return sum;
+		}
+	};
+
+	// The cloth scene with its springs swapped for XPBD distance constraints, stepped at whatever dT the runner uses
+	// ^- The same few iterations whatever the step, so it's the constraint projection being timed
+	class ConstraintClothScenario : public Scenario
+	{
+	private:
+		Hadron::ParticleWorld world;
+		Hadron::ParticleConstraintSolver solver;
+
+	public:
+		const char *GetName() const { return "cloth-xpbd"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			unsigned int side = (unsigned int)(sqrt((double)Count) + 0.5);
+			if(side < 2) side = 2;
+
+			SeedRandom(Seed);
+			world.Clear();
+			solver.Clear();
+			world.Reserve(side * side);
+			solver.SetThreadPool(Pool);
+			solver.SetSubsteps(4);
+			solver.SetIterations(2);
+
+			for(unsigned int y = 0; y < side; y++)
+			{
+				for(unsigned int x = 0; x < side; x++)
+				{
+					Hadron::ParticleWorld::ParticleView p = world.Get(world.Add());
+					p.SetPosition((real)x + Random((real)-0.1, (real)0.1), (real)0.0, (real)y + Random((real)-0.1, (real)0.1));
+					p.SetAlive(true);
+
+					if(y == 0)
+					{
+						p.SetMass((real)0.0);
+						p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+					}
+					else
+					{
+						p.SetMass((real)1.0);
+					}
+				}
+			}
+
+			// A little compliance, so it's cloth rather than chain mail
+			const real diagonal = (real)sqrt((real)2.0);
+			for(unsigned int y = 0; y < side; y++)
+			{
+				for(unsigned int x = 0; x < side; x++)
+				{
+					const unsigned int i = y * side + x;
+					if(x + 1 < side) solver.AddDistance(i, i + 1, (real)1.0, (real)1e-4);
+					if(y + 1 < side) solver.AddDistance(i, i + side, (real)1.0, (real)1e-4);
+					if(x + 1 < side && y + 1 < side) solver.AddDistance(i, i + side + 1, diagonal, (real)1e-4);
+				}
+			}
+		}
+
+		void Step(real dT)
+		{
+			solver.Step(world, dT);
+		}
+
+		unsigned int GetParticleCount() const
+		{
+			return world.GetCount();
+		}
+
+		double GetChecksum() const
+		{
+			const real *x = world.GetPositionsX(), *y = world.GetPositionsY(), *z = world.GetPositionsZ();
+
+			double sum = 0.0;
+			for(unsigned int i = 0; i < world.GetCount(); i++)
+			{
+				sum += (double)x[i] + (double)y[i] + (double)z[i];
+			}
+
+			return sum;
+		}
+	};
+
+	// Debris dropped onto the ground and left to settle, the timed steps are of the settled pile
+	// ^- With Sleeping the resting particles fall asleep, so comparing the two shows what sleeping saves
+	// ^- Only ground contacts, the particles pass through each other, so it's the step and not the broadphase
+	//    being timed
+	template<bool Sleeping>
+	class DebrisScenario : public Scenario
+	{
+	private:
+		Hadron::ParticleWorld world;
+		Hadron::ParticleContactResolver resolver;
+		std::vector<Hadron::ParticleContact> contacts;
+		Hadron::ThreadPool *pool;
+
+		static const unsigned int SETTLE_STEPS = 300;
+
+	public:
+		DebrisScenario():
+		pool(NULL)
+		{ }
+
+		const char *GetName() const { return Sleeping ? "debris-sleeping" : "debris"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			SeedRandom(Seed);
+			world.Clear();
+			world.Reserve(Count);
+			resolver.SetThreadPool(Pool);
+			pool = Pool;
+
+			world.SetSleepThresholds((real)0.05, (real)0.5, Sleeping ? 30 : 0);
+
+			// Straight down, so nothing keeps sliding about once it's landed
+			const real spread = (real)sqrt((double)Count);
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				Hadron::ParticleWorld::ParticleView p = world.Get(world.Add());
+				p.SetPosition(Random(-spread, spread), Random((real)1.0, (real)20.0), Random(-spread, spread));
+				p.SetVelocity((real)0.0, Random((real)-5.0, (real)5.0), (real)0.0);
+				p.SetMass(Random((real)1.0, (real)5.0));
+				p.SetAlive(true);
+			}
+
+			for(unsigned int i = 0; i < SETTLE_STEPS; i++)
+			{
+				Step((real)(1.0 / 60.0));
+			}
+		}
+
+		void Step(real dT)
+		{
+			world.PrepareStep(dT);
+			Hadron::ParallelFor(pool, 0, world.GetCount(), [&](unsigned int Begin, unsigned int End)
+			{
+				world.Step(Begin, End, dT);
+			});
+
+			contacts.clear();
+			Hadron::GeneratePlaneContacts(world, Hadron::Vector3<real>::UP, (real)0.0, (real)0.5, (real)0.3, contacts);
+			resolver.Resolve(world, contacts, dT);
+		}
+
+		unsigned int GetParticleCount() const
+		{
+			return world.GetCount();
+		}
+
+		double GetChecksum() const
+		{
+			const real *x = world.GetPositionsX(), *y = world.GetPositionsY(), *z = world.GetPositionsZ();
+
+			double sum = 0.0;
+			for(unsigned int i = 0; i < world.GetCount(); i++)
+			{
+				sum += (double)x[i] + (double)y[i] + (double)z[i];
+			}
+
+			return sum;
+		}
+	};
+
+	// A dam break, a block of liquid let go at one end of a tank twice its length
+	// ^- Stepped at a fixed substep small enough for the liquid's speed of sound, as many times as fits in dT
+	// ^- The liquid's worked out on the pool, the integrator itself runs on the calling thread
+	class FluidScenario : public Scenario
+	{
+	private:
+		Hadron::ParticleWorld world;
+		Hadron::ParticleFluid fluid;
+		Hadron::ParticleContactResolver resolver;
+		std::vector<Hadron::ParticleContact> contacts;
+		Hadron::ThreadPool *pool;
+		real length, width;
+
+		static const real SPACING;
+		static const real SUBSTEP;
+
+	public:
+		FluidScenario():
+		pool(NULL),
+		length((real)0.0),
+		width((real)0.0)
+		{ }
+
+		const char *GetName() const { return "fluid"; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			// Twice as long and wide as it is deep
+			unsigned int side = (unsigned int)(pow(2.0 * (double)Count, 1.0 / 3.0) + 0.5);
+			if(side < 2) side = 2;
+			const unsigned int depth = std::max(side / 2, 1u);
+
+			SeedRandom(Seed);
+			world.Clear();
+			world.Reserve(side * side * depth);
+			fluid.SetThreadPool(Pool);
+			resolver.SetThreadPool(Pool);
+			pool = Pool;
+
+			length = (real)(2 * side) * SPACING;
+			width = (real)side * SPACING;
+
+			fluid.SetRadius(SPACING * (real)2.0);
+			fluid.SetParticleMass((real)1000.0 * SPACING * SPACING * SPACING);
+			fluid.SetStiffness((real)400.0);
+			fluid.SetViscosity((real)20.0);
+
+			// Jittered a little so the collapse isn't perfectly symmetric
+			for(unsigned int y = 0; y < depth; y++)
+			{
+				for(unsigned int z = 0; z < side; z++)
+				{
+					for(unsigned int x = 0; x < side; x++)
+					{
+						Hadron::ParticleWorld::ParticleView p = world.Get(world.Add());
+						p.SetPosition(((real)x + (real)0.5 + Random((real)-0.05, (real)0.05)) * SPACING, ((real)y + (real)0.5) * SPACING,
+							((real)z + (real)0.5 + Random((real)-0.05, (real)0.05)) * SPACING);
+						p.SetMass(fluid.GetParticleMass());
+						p.SetAlive(true);
+					}
+				}
+			}
+
+			// Rest density is what the particles in the middle of the block start at, so the block starts at rest
+			const unsigned int middle = ((depth / 2) * side + (side / 2)) * side + (side / 2);
+			world.ClearForces();
+			fluid.SetRestDensity((real)1.0);
+			fluid.ApplyForces(world, SUBSTEP);
+			fluid.SetRestDensity(fluid.GetDensity(middle));
+			world.ClearForces();
+		}
+
+		void Step(real dT)
+		{
+			const unsigned int substeps = std::max((unsigned int)ceil(dT / SUBSTEP), 1u);
+			const real substep = dT / (real)substeps;
+
+			for(unsigned int i = 0; i < substeps; i++)
+			{
+				world.Step<Hadron::SymplecticEuler>(substep, [this, substep](Hadron::ParticleWorld &W)
+				{
+					fluid.ApplyForces(W, substep);
+				});
+
+				// Floor and four walls
+				const real radius = SPACING * (real)0.5;
+				contacts.clear();
+				Hadron::GeneratePlaneContacts(world, Hadron::Vector3<real>::UP, (real)0.0, radius, (real)0.0, contacts);
+				Hadron::GeneratePlaneContacts(world, Hadron::Vector3<real>((real)1.0, (real)0.0, (real)0.0), (real)0.0, radius, (real)0.0, contacts);
+				Hadron::GeneratePlaneContacts(world, Hadron::Vector3<real>((real)-1.0, (real)0.0, (real)0.0), -length, radius, (real)0.0, contacts);
+				Hadron::GeneratePlaneContacts(world, Hadron::Vector3<real>((real)0.0, (real)0.0, (real)1.0), (real)0.0, radius, (real)0.0, contacts);
+				Hadron::GeneratePlaneContacts(world, Hadron::Vector3<real>((real)0.0, (real)0.0, (real)-1.0), -width, radius, (real)0.0, contacts);
+				resolver.Resolve(world, contacts, substep);
+			}
+		}
+
+		unsigned int GetParticleCount() const
+		{
+			return world.GetCount();
+		}
+
+		double GetChecksum() const
+		{
+			const real *x = world.GetPositionsX(), *y = world.GetPositionsY(), *z = world.GetPositionsZ();
+
+			double sum = 0.0;
+			for(unsigned int i = 0; i < world.GetCount(); i++)
+			{
+				sum += (double)x[i] + (double)y[i] + (double)z[i];
+			}
+
+			return sum;
+		}
+	};
+
+	// Particles 5 cm apart, with the smoothing radius at twice that
+	const real FluidScenario::SPACING = (real)0.05;
+
+	// Comfortably inside 0.4 * radius / sqrt(stiffness)
+	const real FluidScenario::SUBSTEP = (real)(1.0 / 600.0);
+
+	// The gravitation scene again, but in a world of the given precision and stepped with the given integrator policy
+	// ^- Comparing these against each other and against "gravitation" shows what the layout, precision and scheme cost
+	// ^- Forces are summed in the world's ForceScalar, so the mixed world keeps double forces over float state
+	// ^- The forces are worked out on the pool, the integrator itself runs on the calling thread
+	template<typename World, typename Integrator>
+	class WorldGravitationScenario : public Scenario
+	{
+	private:
+		const char *name;
+		World world;
+		Hadron::ThreadPool *pool;
+
+	public:
+		WorldGravitationScenario(const char *Name):
+		name(Name),
+		pool(NULL)
+		{ }
+
+		const char *GetName() const { return name; }
+
+		void Setup(unsigned int Count, unsigned int Seed, Hadron::ThreadPool *Pool)
+		{
+			SeedRandom(Seed);
+			world.Clear();
+			world.Reserve(Count);
+			pool = Pool;
+
+			// Same draws in the same order as GravitationScenario, so both scenes start identically
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				typename World::ParticleView p = world.Get(world.Add());
+				p.SetPosition(Random((real)-50.0, (real)50.0), Random((real)-50.0, (real)50.0), Random((real)-50.0, (real)50.0));
+				p.SetMass(Random((real)1.0, (real)10.0));
+				p.SetAlive(true);
+			}
+
+			for(unsigned int i = 0; i < Count; i++)
+			{
+				typename World::ParticleView p = world.Get(i);
+				p.SetVelocity(p.GetPosition().Cross(Hadron::Vector3<typename World::Scalar>::UP).Normalised() * Random((real)8.0, (real)12.0));
+				p.SetAcceleration(Hadron::Vector3<typename World::Scalar>::ZERO);
+			}
+		}
+
+		void Step(real dT)
+		{
+			Hadron::ThreadPool *const forcePool = pool;
+
+			world.template Step<Integrator>(dT, [forcePool](World &W)
+			{
+				typedef typename World::Scalar T;
+				typedef typename World::ForceScalar F;
+
+				const T *x = W.GetPositionsX(), *y = W.GetPositionsY(), *z = W.GetPositionsZ();
+				const T *inverseMass = W.GetInverseMasses();
+				F *fx = W.GetForcesX(), *fy = W.GetForcesY(), *fz = W.GetForcesZ();
+
+				// Same pull as ParticleGravitation, F = -100 * m * d / r^2
+				Hadron::ParallelFor(forcePool, 0, W.GetCount(), [&](unsigned int Begin, unsigned int End)
+				{
+					for(unsigned int i = Begin; i < End; i++)
+					{
+						const F radiusSquared = ((F)x[i] * x[i]) + ((F)y[i] * y[i]) + ((F)z[i] * z[i]);
+						if(radiusSquared <= (F)0.0) continue;
+
+						const F force = -(F)100.0 / (inverseMass[i] * radiusSquared);
+						fx[i] += x[i] * force;
+						fy[i] += y[i] * force;
+						fz[i] += z[i] * force;
+					}
+				});
+			});
+		}
+
+		unsigned int GetParticleCount() const
+		{
+			return world.GetCount();
+		}
+
+		double GetChecksum() const
+		{
+			const typename World::Scalar *x = world.GetPositionsX(), *y = world.GetPositionsY(), *z = world.GetPositionsZ();
+
+			double sum = 0.0;
+			for(unsigned int i = 0; i < world.GetCount(); i++)
+			{
+				sum += (double)x[i] + (double)y[i] + (double)z[i];
+			}
+
+			return sum;
+		}
+	};
+}
+
+const char *const SCENARIO_NAMES[] =
+{
+	"gravitation",
+	"drag",
+	"spring-chain",
+	"spring-chain-islands",
+	"stiff-chains",
+	"stiff-chains-multirate",
+	"mixed",
+	"cloth",
+	"cloth-xpbd",
+	"debris",
+	"debris-sleeping",
+	"fluid",
+	"world-symplectic",
+	"world-verlet",
+	"world-rk4",
+	"world-symplectic-float",
+	"world-symplectic-mixed"
+};
+
+const unsigned int SCENARIO_COUNT = sizeof(SCENARIO_NAMES) / sizeof(SCENARIO_NAMES[0]);
+
+Scenario *CreateScenario(const char *Name)
+{
+	if(strcmp(Name, "gravitation") == 0) return new GravitationScenario();
+	if(strcmp(Name, "drag") == 0) return new DragScenario();
+	if(strcmp(Name, "spring-chain") == 0) return new SpringChainScenario();
+	if(strcmp(Name, "spring-chain-islands") == 0) return new SpringChainIslandScenario();
+	if(strcmp(Name, "stiff-chains") == 0) return new StiffChainScenario<false>();
+	if(strcmp(Name, "stiff-chains-multirate") == 0) return new StiffChainScenario<true>();
+	if(strcmp(Name, "mixed") == 0) return new MixedScenario();
+	if(strcmp(Name, "cloth") == 0) return new ClothScenario();
+	if(strcmp(Name, "cloth-xpbd") == 0) return new ConstraintClothScenario();
+	if(strcmp(Name, "debris") == 0) return new DebrisScenario<false>();
+	if(strcmp(Name, "debris-sleeping") == 0) return new DebrisScenario<true>();
+	if(strcmp(Name, "fluid") == 0) return new FluidScenario();
+	if(strcmp(Name, "world-symplectic") == 0) return new WorldGravitationScenario<Hadron::ParticleWorld, Hadron::SymplecticEuler>(Name);
+	if(strcmp(Name, "world-verlet") == 0) return new WorldGravitationScenario<Hadron::ParticleWorld, Hadron::VelocityVerlet>(Name);
+	if(strcmp(Name, "world-rk4") == 0) return new WorldGravitationScenario<Hadron::ParticleWorld, Hadron::RungeKutta4>(Name);
+	if(strcmp(Name, "world-symplectic-float") == 0) return new WorldGravitationScenario<Hadron::ParticleWorldFloat, Hadron::SymplecticEuler>(Name);
+	if(strcmp(Name, "world-symplectic-mixed") == 0) return new WorldGravitationScenario<Hadron::ParticleWorldMixed, Hadron::SymplecticEuler>(Name);
+
+	return NULL;
+}
@@ -0,0 +1,1643 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// Stops everything if a check doesn't hold, so a broken build can't scroll past in the middle of the tables
+void Require(bool Condition, const char *Check, const char *What)
+{
+	if(Condition) return;
+
+	fprintf(stderr, "FAILED %s: %s\n", Check, What);
+	exit(EXIT_FAILURE);
+}
+
+// Reads back the force each particle has accumulated, by integrating a single second from rest
+// ^- Gravity's switched off and damping is ~1, so v = F / m
+void ReadForces(std::vector<Hadron::Particle> &Particles, std::vector<Hadron::Vector3<real> > &Forces)
+{
+	Forces.resize(Particles.size());
+	for(unsigned int i = 0; i < Particles.size(); i++)
+	{
+		Hadron::Particle &p = Particles[i];
+		const Hadron::Vector3<real> position = p.GetPosition();
+
+		p.SetVelocity(Hadron::Vector3<real>::ZERO);
+		p.Update((real)1.0);
+		Forces[i] = p.GetVelocity() * p.GetMass() / (real)pow((real)0.9999, (real)1.0);
+
+		p.SetPosition(position);
+		p.SetVelocity(Hadron::Vector3<real>::ZERO);
+	}
+}
+
+// Barnes-Hut against brute force, for a range of body counts and opening angles
+// ^- Reports time per evaluation and the RMS force error relative to the exact answer
+void BenchmarkNBody(Hadron::ThreadPool &Pool)
+{
+	const unsigned int COUNTS[] = { 1000, 4000, 16000 };
+	const real THETAS[] = { (real)0.3, (real)0.5, (real)0.7, (real)1.0 };
+
+	printf("nbody (threads = %u)\n", Pool.GetThreadCount());
+	printf("%8s %6s %12s %12s %8s %12s\n", "bodies", "theta", "tree ms", "brute ms", "speedup", "rms error");
+
+	for(unsigned int c = 0; c < sizeof(COUNTS) / sizeof(COUNTS[0]); c++)
+	{
+		const unsigned int count = COUNTS[c];
+
+		// Same cloud every run
+		SeedRandom(1234);
+
+		std::vector<Hadron::Particle> particles(count);
+		Hadron::NBodyGravitation gravitation((real)1.0, (real)0.5, (real)0.01);
+		gravitation.SetThreadPool(&Pool);
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			particles[i].SetPosition(Random((real)-50.0, (real)50.0), Random((real)-50.0, (real)50.0), Random((real)-50.0, (real)50.0));
+			particles[i].SetAcceleration(Hadron::Vector3<real>::ZERO);
+			particles[i].SetMass(Random((real)1.0, (real)10.0));
+			particles[i].SetAlive(true);
+
+			gravitation.Add(&particles[i]);
+		}
+
+		std::vector<Hadron::Vector3<real> > exact, approx;
+
+		double start = Now();
+		gravitation.ApplyForcesBruteForce((real)0.0);
+		const double bruteTime = Now() - start;
+		ReadForces(particles, exact);
+
+		for(unsigned int t = 0; t < sizeof(THETAS) / sizeof(THETAS[0]); t++)
+		{
+			gravitation.SetOpeningAngle(THETAS[t]);
+
+			start = Now();
+			gravitation.ApplyForces((real)0.0);
+			const double treeTime = Now() - start;
+			ReadForces(particles, approx);
+
+			real errorSq = (real)0.0, normSq = (real)0.0;
+			for(unsigned int i = 0; i < count; i++)
+			{
+				errorSq += (approx[i] - exact[i]).LengthSquared();
+				normSq += exact[i].LengthSquared();
+			}
+
+			printf("%8u %6.2f %12.3f %12.3f %8.2f %12.3e\n", count, (double)THETAS[t], treeTime, bruteTime,
+				bruteTime / treeTime, (double)sqrt(errorSq / normSq));
+		}
+	}
+}
+
+// Spring network force evaluation on a square sheet of cloth, serial and on the pool
+// ^- Each particle has springs to its neighbours along the grid and diagonally
+void BenchmarkSprings(Hadron::ThreadPool &Pool)
+{
+	const unsigned int SIDES[] = { 128, 256, 512 };
+	const unsigned int RUNS = 10;
+
+	printf("springs (threads = %u)\n", Pool.GetThreadCount());
+	printf("%10s %10s %12s %12s %8s\n", "particles", "springs", "serial ms", "pool ms", "speedup");
+
+	for(unsigned int c = 0; c < sizeof(SIDES) / sizeof(SIDES[0]); c++)
+	{
+		const unsigned int side = SIDES[c];
+
+		SeedRandom(1234);
+
+		Hadron::ParticleWorld world;
+		Hadron::SpringNetwork network;
+		world.Reserve(side * side);
+
+		for(unsigned int y = 0; y < side; y++)
+		{
+			for(unsigned int x = 0; x < side; x++)
+			{
+				Hadron::ParticleWorld::ParticleView p = world.Get(world.Add());
+				p.SetPosition((real)x + Random((real)-0.1, (real)0.1), (real)y + Random((real)-0.1, (real)0.1), (real)0.0);
+				p.SetMass((real)1.0);
+				p.SetAlive(true);
+			}
+		}
+
+		const real diagonal = (real)sqrt((real)2.0);
+		for(unsigned int y = 0; y < side; y++)
+		{
+			for(unsigned int x = 0; x < side; x++)
+			{
+				const unsigned int i = y * side + x;
+				if(x + 1 < side) network.Add(i, i + 1, (real)100.0, (real)1.0, (real)0.5);
+				if(y + 1 < side) network.Add(i, i + side, (real)100.0, (real)1.0, (real)0.5);
+				if(x + 1 < side && y + 1 < side) network.Add(i, i + side + 1, (real)100.0, diagonal, (real)0.5);
+			}
+		}
+
+		// First call builds the adjacency, keep it out of the timings
+		network.ApplyForces(world, (real)0.01);
+
+		double start = Now();
+		for(unsigned int r = 0; r < RUNS; r++)
+		{
+			world.ClearForces();
+			network.ApplyForces(world, (real)0.01);
+		}
+		const double serialTime = (Now() - start) / RUNS;
+
+		network.SetThreadPool(&Pool);
+
+		start = Now();
+		for(unsigned int r = 0; r < RUNS; r++)
+		{
+			world.ClearForces();
+			network.ApplyForces(world, (real)0.01);
+		}
+		const double poolTime = (Now() - start) / RUNS;
+
+		printf("%10u %10u %12.3f %12.3f %8.2f\n", world.GetCount(), network.GetCount(), serialTime, poolTime, serialTime / poolTime);
+	}
+}
+
+// Hash grid build and pair search over a uniform cloud, serial and on the pool
+// ^- About one particle per cell, pairs within half a cell
+void BenchmarkHashGrid(Hadron::ThreadPool &Pool)
+{
+	const unsigned int COUNTS[] = { 10000, 100000, 1000000 };
+
+	printf("hash grid (threads = %u)\n", Pool.GetThreadCount());
+	printf("%10s %12s %12s %12s %12s %10s\n", "particles", "build ms", "pool ms", "pairs ms", "pool ms", "pairs");
+
+	for(unsigned int c = 0; c < sizeof(COUNTS) / sizeof(COUNTS[0]); c++)
+	{
+		const unsigned int count = COUNTS[c];
+		const real extent = (real)pow((real)count, (real)(1.0 / 3.0));
+
+		SeedRandom(1234);
+
+		std::vector<real> x(count), y(count), z(count);
+		for(unsigned int i = 0; i < count; i++)
+		{
+			x[i] = Random((real)0.0, extent);
+			y[i] = Random((real)0.0, extent);
+			z[i] = Random((real)0.0, extent);
+		}
+
+		Hadron::ParticleHashGrid grid((real)1.0);
+		std::vector<Hadron::ParticleHashGrid::Pair> pairs;
+
+		// Warm up, so the grid's storage is already allocated
+		grid.Build(&x[0], &y[0], &z[0], NULL, count);
+
+		double timings[4];
+		for(unsigned int pass = 0; pass < 2; pass++)
+		{
+			grid.SetThreadPool(pass == 0 ? NULL : &Pool);
+
+			double start = Now();
+			grid.Build(&x[0], &y[0], &z[0], NULL, count);
+			timings[pass * 2] = Now() - start;
+
+			start = Now();
+			grid.FindPairs((real)0.5, pairs);
+			timings[pass * 2 + 1] = Now() - start;
+		}
+
+		printf("%10u %12.3f %12.3f %12.3f %12.3f %10u\n", count, timings[0], timings[2], timings[1], timings[3], (unsigned int)pairs.size());
+	}
+}
+
+// Contact resolution for a loose heap of spheres resting on a floor, serial and on the pool
+// ^- Contacts come from the hash grid each frame, only the resolve is timed
+void BenchmarkContacts(Hadron::ThreadPool &Pool)
+{
+	const unsigned int COUNTS[] = { 10000, 50000, 100000 };
+	const unsigned int FRAMES = 20;
+	const real RADIUS = (real)0.5;
+	const real DT = (real)(1.0 / 60.0);
+
+	printf("contacts (threads = %u)\n", Pool.GetThreadCount());
+	printf("%10s %10s %10s %12s %12s %8s\n", "particles", "contacts", "islands", "serial ms", "pool ms", "speedup");
+
+	for(unsigned int c = 0; c < sizeof(COUNTS) / sizeof(COUNTS[0]); c++)
+	{
+		const unsigned int count = COUNTS[c];
+		const real extent = (real)sqrt((real)count) * (real)0.25;
+
+		Hadron::ParticleWorld worlds[2];
+		Hadron::ParticleContactResolver resolvers[2];
+		Hadron::ParticleHashGrid grid(RADIUS * (real)2.0);
+		resolvers[1].SetThreadPool(&Pool);
+
+		for(unsigned int w = 0; w < 2; w++)
+		{
+			SeedRandom(1234);
+
+			worlds[w].Reserve(count);
+			for(unsigned int i = 0; i < count; i++)
+			{
+				Hadron::ParticleWorld::ParticleView p = worlds[w].Get(worlds[w].Add());
+				p.SetPosition(Random(-extent, extent), Random(RADIUS, (real)4.0), Random(-extent, extent));
+				p.SetMass(Random((real)1.0, (real)3.0));
+				p.SetAlive(true);
+			}
+		}
+
+		std::vector<Hadron::ParticleHashGrid::Pair> pairs;
+		std::vector<Hadron::ParticleContact> contacts;
+		double timings[2] = { 0.0, 0.0 };
+		unsigned int contactCount = 0, islandCount = 0;
+
+		for(unsigned int f = 0; f < FRAMES; f++)
+		{
+			for(unsigned int w = 0; w < 2; w++)
+			{
+				worlds[w].ClearForces();
+				worlds[w].Step(DT);
+
+				contacts.clear();
+				grid.Build(worlds[w]);
+				grid.FindPairs(RADIUS * (real)2.0, pairs);
+				Hadron::GeneratePlaneContacts(worlds[w], Hadron::Vector3<real>::UP, (real)0.0, RADIUS, (real)0.2, contacts);
+				Hadron::GenerateSphereContacts(worlds[w], pairs, RADIUS, (real)0.2, contacts);
+
+				const double start = Now();
+				resolvers[w].Resolve(worlds[w], contacts, DT);
+				timings[w] += Now() - start;
+			}
+
+			contactCount += (unsigned int)contacts.size();
+			islandCount += resolvers[1].GetIslandCount();
+		}
+
+		printf("%10u %10u %10u %12.3f %12.3f %8.2f\n", count, contactCount / FRAMES, islandCount / FRAMES,
+			timings[0] / FRAMES, timings[1] / FRAMES, timings[0] / timings[1]);
+	}
+}
+
+// Pulls every particle towards a unit mass at the origin, for the orbit scenario
+void ApplyCentralGravity(Hadron::ParticleWorld &World)
+{
+	const real *x = World.GetPositionsX(), *y = World.GetPositionsY(), *z = World.GetPositionsZ();
+	real *fx = World.GetForcesX(), *fy = World.GetForcesY(), *fz = World.GetForcesZ();
+
+	for(unsigned int i = 0; i < World.GetCount(); i++)
+	{
+		const real distanceSq = (x[i] * x[i]) + (y[i] * y[i]) + (z[i] * z[i]);
+		const real scale = -World.Get(i).GetMass() / (distanceSq * (real)sqrt(distanceSq));
+
+		fx[i] += x[i] * scale;
+		fy[i] += y[i] * scale;
+		fz[i] += z[i] * scale;
+	}
+}
+
+// Total kinetic and potential energy of the orbit scenario
+real OrbitEnergy(Hadron::ParticleWorld &World)
+{
+	real energy = (real)0.0;
+	for(unsigned int i = 0; i < World.GetCount(); i++)
+	{
+		Hadron::ParticleWorld::ParticleView p = World.Get(i);
+		energy += p.GetKineticEnergy() - p.GetMass() / p.GetPosition().Length();
+	}
+
+	return energy;
+}
+
+// Runs the orbit scenario with one integrator and step size, and prints its cost and energy drift
+template<typename Integrator>
+void BenchmarkIntegrator(const char *Name, real dT)
+{
+	const unsigned int COUNT = 1000;
+	const real DURATION = (real)20.0;
+
+	// Same eccentric orbits every run, with no damping so energy should be conserved exactly
+	SeedRandom(1234);
+
+	Hadron::ParticleWorld world;
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		const real radius = Random((real)1.0, (real)3.0);
+		const real angle = Random((real)0.0, (real)6.2831853);
+
+		Hadron::ParticleWorld::ParticleView p = world.Get(world.Add());
+		p.SetPosition(radius * (real)cos(angle), radius * (real)sin(angle), (real)0.0);
+		p.SetVelocity(Hadron::Vector3<real>(-(real)sin(angle), (real)cos(angle), (real)0.0) * (Random((real)0.8, (real)1.2) / (real)sqrt(radius)));
+		p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+		p.SetDamping((real)1.0);
+		p.SetMass(Random((real)1.0, (real)10.0));
+		p.SetAlive(true);
+	}
+
+	const real startEnergy = OrbitEnergy(world);
+	const unsigned int steps = (unsigned int)(DURATION / dT + (real)0.5);
+
+	const double start = Now();
+	for(unsigned int s = 0; s < steps; s++)
+	{
+		world.Step<Integrator>(dT, ApplyCentralGravity);
+	}
+	const double time = Now() - start;
+
+	printf("%18s %8.4f %8u %12.3f %12.3e\n", Name, (double)dT, steps * Integrator::EVALUATIONS, time,
+		(double)real_abs((OrbitEnergy(world) - startEnergy) / startEnergy));
+}
+
+// Energy drift against cost for each integrator over a range of step sizes
+// ^- The scheme to pick is the cheapest one that stays under the drift a scene can tolerate
+void BenchmarkIntegrators()
+{
+	const real STEPS[] = { (real)0.04, (real)0.02, (real)0.01, (real)0.005 };
+
+	printf("integrators\n");
+	printf("%18s %8s %8s %12s %12s\n", "integrator", "dt", "evals", "ms", "drift");
+
+	for(unsigned int i = 0; i < sizeof(STEPS) / sizeof(STEPS[0]); i++)
+	{
+		BenchmarkIntegrator<Hadron::ExplicitEuler>("explicit euler", STEPS[i]);
+		BenchmarkIntegrator<Hadron::SymplecticEuler>("symplectic euler", STEPS[i]);
+		BenchmarkIntegrator<Hadron::VelocityVerlet>("velocity verlet", STEPS[i]);
+		BenchmarkIntegrator<Hadron::RungeKutta4>("runge-kutta 4", STEPS[i]);
+	}
+}
+
+// Builds a hanging sheet of stiff cloth, pinned along one edge
+void MakeStiffCloth(Hadron::ParticleWorld &World, Hadron::SpringNetwork &Network, unsigned int Side)
+{
+	const real SPACING = (real)0.1;
+	const real STIFFNESS = (real)10000.0;
+
+	World.Clear();
+	Network.Clear();
+
+	for(unsigned int y = 0; y < Side; y++)
+	{
+		for(unsigned int x = 0; x < Side; x++)
+		{
+			Hadron::ParticleWorld::ParticleView p = World.Get(World.Add());
+			p.SetPosition((real)x * SPACING, (real)0.0, (real)y * SPACING);
+			p.SetDamping((real)1.0);
+			p.SetAlive(true);
+
+			// The pinned edge is as good as infinitely heavy, and doesn't fall
+			if(y == 0)
+			{
+				p.SetMass((real)0.0);
+				p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+			}
+			else
+			{
+				p.SetMass((real)0.01);
+			}
+		}
+	}
+
+	for(unsigned int y = 0; y < Side; y++)
+	{
+		for(unsigned int x = 0; x < Side; x++)
+		{
+			const unsigned int i = y * Side + x;
+			if(x + 1 < Side) Network.Add(i, i + 1, STIFFNESS, SPACING, (real)0.1);
+			if(y + 1 < Side) Network.Add(i, i + Side, STIFFNESS, SPACING, (real)0.1);
+			if(x + 1 < Side && y + 1 < Side) Network.Add(i, i + Side + 1, STIFFNESS, SPACING * (real)sqrt((real)2.0), (real)0.1);
+		}
+	}
+}
+
+// Fastest speed in the world, or infinity if anything's blown up
+real MaxSpeed(Hadron::ParticleWorld &World)
+{
+	real fastest = (real)0.0;
+	for(unsigned int i = 0; i < World.GetCount(); i++)
+	{
+		const real speed = World.Get(i).GetVelocity().Length();
+		if(!(speed <= fastest)) fastest = (speed == speed) ? speed : (real)HUGE_VAL;
+	}
+
+	return fastest;
+}
+
+// A stiff cloth simulated for a second, explicitly at a small step and implicitly at much larger ones
+void BenchmarkImplicitSprings(Hadron::ThreadPool &Pool)
+{
+	const unsigned int SIDE = 32;
+	const real EXPLICIT_STEPS[] = { (real)(1.0 / 2400.0), (real)(1.0 / 600.0) };
+	const real IMPLICIT_STEPS[] = { (real)(1.0 / 240.0), (real)(1.0 / 120.0), (real)(1.0 / 60.0) };
+
+	printf("stiff springs (threads = %u)\n", Pool.GetThreadCount());
+	printf("%18s %10s %12s %12s %12s\n", "integrator", "dt", "ms", "max speed", "cg iters");
+
+	Hadron::ParticleWorld world;
+	Hadron::SpringNetwork network;
+
+	for(unsigned int i = 0; i < sizeof(EXPLICIT_STEPS) / sizeof(EXPLICIT_STEPS[0]); i++)
+	{
+		const real dT = EXPLICIT_STEPS[i];
+		MakeStiffCloth(world, network, SIDE);
+
+		const double start = Now();
+		for(unsigned int s = 0; s < (unsigned int)((real)1.0 / dT + (real)0.5); s++)
+		{
+			network.ApplyForces(world, dT);
+			world.Step<Hadron::SymplecticEuler>(dT, [](Hadron::ParticleWorld &) { });
+		}
+
+		printf("%18s %10.6f %12.3f %12.3f %12s\n", "symplectic euler", (double)dT, Now() - start, (double)MaxSpeed(world), "-");
+	}
+
+	for(unsigned int i = 0; i < sizeof(IMPLICIT_STEPS) / sizeof(IMPLICIT_STEPS[0]); i++)
+	{
+		const real dT = IMPLICIT_STEPS[i];
+		MakeStiffCloth(world, network, SIDE);
+
+		Hadron::ImplicitSpringSolver solver;
+		solver.SetThreadPool(&Pool);
+		solver.SetMaxIterations(100);
+		solver.SetTolerance((real)1e-3);
+
+		const unsigned int steps = (unsigned int)((real)1.0 / dT + (real)0.5);
+		unsigned int iterations = 0;
+
+		const double start = Now();
+		for(unsigned int s = 0; s < steps; s++)
+		{
+			solver.Step(world, network, dT);
+			iterations += solver.GetLastIterations();
+		}
+
+		printf("%18s %10.6f %12.3f %12.3f %12.1f\n", "implicit euler", (double)dT, Now() - start, (double)MaxSpeed(world),
+			(double)iterations / steps);
+	}
+}
+
+// Largest relative stretch of any spring in the network
+real MaxStretch(const Hadron::ParticleWorld &World, const Hadron::SpringNetwork &Network)
+{
+	const real *x = World.GetPositionsX(), *y = World.GetPositionsY(), *z = World.GetPositionsZ();
+
+	real stretch = (real)0.0;
+	for(unsigned int s = 0; s < Network.GetCount(); s++)
+	{
+		const unsigned int a = Network.GetParticleA(s), b = Network.GetParticleB(s);
+		const real dx = x[a] - x[b], dy = y[a] - y[b], dz = z[a] - z[b];
+		const real length = (real)sqrt((dx * dx) + (dy * dy) + (dz * dz));
+
+		stretch = std::max(stretch, real_abs(length - Network.GetRestLength(s)) / Network.GetRestLength(s));
+	}
+
+	return stretch;
+}
+
+// The stiff cloth again, as explicit springs at a small step against XPBD rods in the same places at the frame rate
+// ^- Reports the time to simulate a second and how far the worst rod or spring ends up from its rest length
+void BenchmarkConstraints(Hadron::ThreadPool &Pool)
+{
+	const unsigned int SIDE = 32;
+	const real FRAME = (real)(1.0 / 60.0);
+	const unsigned int SUBSTEPS[] = { 1, 4, 10, 20 };
+	const unsigned int ITERATIONS[] = { 10, 2, 1, 1 };
+
+	printf("xpbd constraints (threads = %u)\n", Pool.GetThreadCount());
+	printf("%18s %10s %10s %10s %12s %12s %10s\n", "integrator", "dt", "substeps", "iters", "ms", "max stretch", "colours");
+
+	Hadron::ParticleWorld world;
+	Hadron::SpringNetwork network;
+
+	{
+		const real dT = (real)(1.0 / 2400.0);
+		MakeStiffCloth(world, network, SIDE);
+
+		const double start = Now();
+		for(unsigned int s = 0; s < 2400; s++)
+		{
+			network.ApplyForces(world, dT);
+			world.Step<Hadron::SymplecticEuler>(dT, [](Hadron::ParticleWorld &) { });
+		}
+
+		printf("%18s %10.6f %10s %10s %12.3f %12.3e %10s\n", "springs", (double)dT, "-", "-", Now() - start,
+			(double)MaxStretch(world, network), "-");
+	}
+
+	for(unsigned int i = 0; i < sizeof(SUBSTEPS) / sizeof(SUBSTEPS[0]); i++)
+	{
+		MakeStiffCloth(world, network, SIDE);
+
+		Hadron::ParticleConstraintSolver solver;
+		solver.SetThreadPool(&Pool);
+		solver.SetSubsteps(SUBSTEPS[i]);
+		solver.SetIterations(ITERATIONS[i]);
+		for(unsigned int s = 0; s < network.GetCount(); s++)
+		{
+			solver.AddRod(network.GetParticleA(s), network.GetParticleB(s), network.GetRestLength(s));
+		}
+
+		const double start = Now();
+		for(unsigned int s = 0; s < 60; s++)
+		{
+			solver.Step(world, FRAME);
+		}
+
+		printf("%18s %10.6f %10u %10u %12.3f %12.3e %10u\n", "xpbd rods", (double)FRAME, SUBSTEPS[i], ITERATIONS[i],
+			Now() - start, (double)MaxStretch(world, network), solver.GetColourCount());
+	}
+}
+
+// Cost of recording a cloth's trajectory, against stepping it without recording
+// ^- Record only copies the frame, so the overhead's mostly down to whether the writer thread keeps up
+void BenchmarkRecorder(Hadron::ThreadPool &Pool)
+{
+	const unsigned int SIDE = 128;
+	const unsigned int STEPS = 240;
+	const unsigned int INTERVALS[] = { 0, 1, 4 };
+	const real dT = (real)(1.0 / 2400.0);
+	const char *PATH = "hadron_recording.tmp";
+
+	printf("trajectory recording (%u particles, threads = %u)\n", SIDE * SIDE, Pool.GetThreadCount());
+	printf("%12s %12s %12s %12s %12s %10s\n", "record every", "ms/step", "overhead %", "MB", "ratio", "stalls");
+
+	Hadron::ParticleWorld world;
+	Hadron::SpringNetwork network;
+	network.SetThreadPool(&Pool);
+
+	double baseline = 0.0;
+	for(unsigned int i = 0; i < sizeof(INTERVALS) / sizeof(INTERVALS[0]); i++)
+	{
+		const unsigned int interval = INTERVALS[i];
+		MakeStiffCloth(world, network, SIDE);
+
+		Hadron::ParticleRecorder recorder;
+		if(interval > 0) recorder.Open(PATH, (real)1e-4, (real)1e-3);
+
+		const double start = Now();
+		for(unsigned int s = 0; s < STEPS; s++)
+		{
+			network.ApplyForces(world, dT);
+			world.Step<Hadron::SymplecticEuler>(dT, [](Hadron::ParticleWorld &) { });
+			if(interval > 0 && s % interval == 0) recorder.Record(world);
+		}
+		const double elapsed = (Now() - start) / STEPS;
+
+		if(interval == 0)
+		{
+			baseline = elapsed;
+			printf("%12s %12.3f %12s %12s %12s %10s\n", "-", elapsed, "-", "-", "-", "-");
+			continue;
+		}
+
+		// Closing waits for the writer to catch up, which isn't counted
+		const unsigned int frames = recorder.GetFrameCount();
+		const unsigned int stalls = recorder.GetStallCount();
+		recorder.Close();
+
+		Hadron::MappedFile file;
+		file.Open(PATH);
+		const double bytes = (double)file.GetSize();
+		const double raw = (double)frames * world.GetCount() * 6 * sizeof(real);
+		file.Close();
+		remove(PATH);
+
+		printf("%12u %12.3f %12.1f %12.2f %12.1f %10u\n", interval, elapsed, 100.0 * (elapsed - baseline) / baseline,
+			bytes / (1024.0 * 1024.0), raw / bytes, stalls);
+	}
+}
+
+// Several analytic attractors against the same attractors baked into one force field
+// ^- Reports time per particle for each and the field's RMS force error relative to the analytic answer, and
+//    what a full bake and a local rebake cost
+void BenchmarkForceField(Hadron::ThreadPool &Pool)
+{
+	const unsigned int COUNT = 65536;
+	const unsigned int SOURCES[] = { 1, 4, 16 };
+	const unsigned int NODES = 81;
+	const real EXTENT = (real)10.0;
+	const unsigned int REPEATS = 10;
+
+	printf("force field (%u particles, %u^3 nodes, threads = %u)\n", COUNT, NODES, Pool.GetThreadCount());
+	printf("%8s %14s %14s %12s %12s %12s %10s\n", "sources", "analytic ns", "field ns", "rms error", "bake ms",
+		"rebake ms", "nodes");
+
+	SeedRandom(5);
+	std::vector<Hadron::Particle> particles(COUNT);
+	std::vector<Hadron::Particle *> pointers(COUNT);
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		particles[i].SetPosition(Random(-EXTENT, EXTENT), Random(-EXTENT, EXTENT), Random(-EXTENT, EXTENT));
+		particles[i].SetMass(Random((real)0.5, (real)2.0));
+		particles[i].SetAlive(true);
+		pointers[i] = &particles[i];
+	}
+
+	Hadron::ParticleForceField field;
+	field.SetThreadPool(&Pool);
+
+	for(unsigned int c = 0; c < sizeof(SOURCES) / sizeof(SOURCES[0]); c++)
+	{
+		// Attractors sit outside the particles, so the inverse square stays smooth enough to sample
+		std::vector<Hadron::ParticleGravitation> sources(SOURCES[c]);
+		for(unsigned int s = 0; s < sources.size(); s++)
+		{
+			const Hadron::Vector3<real> direction =
+				Hadron::Vector3<real>(Random((real)-1.0, (real)1.0), Random((real)-1.0, (real)1.0), Random((real)-1.0, (real)1.0)).Normalised();
+			sources[s].SetGravityPosition(direction * (EXTENT * (real)2.0));
+		}
+
+		double start = Now();
+		for(unsigned int r = 0; r < REPEATS; r++)
+		{
+			for(unsigned int i = 0; i < COUNT; i++) particles[i].ClearAccumulator();
+			for(unsigned int s = 0; s < sources.size(); s++) sources[s].ApplyForceBatch(&pointers[0], COUNT, (real)0.0);
+		}
+		const double analytic = (Now() - start) * 1e6 / ((double)REPEATS * COUNT);
+
+		std::vector<Hadron::Vector3<real> > exact(COUNT);
+		for(unsigned int i = 0; i < COUNT; i++) exact[i] = particles[i].GetForceAccumulator();
+
+		field.ClearSources();
+		field.Resize(Hadron::Vector3<real>(-EXTENT, -EXTENT, -EXTENT), (real)2.0 * EXTENT / (real)(NODES - 1), NODES, NODES, NODES);
+		for(unsigned int s = 0; s < sources.size(); s++) field.AddSource(&sources[s]);
+
+		start = Now();
+		field.Rebake();
+		const double bake = Now() - start;
+
+		start = Now();
+		for(unsigned int r = 0; r < REPEATS; r++)
+		{
+			for(unsigned int i = 0; i < COUNT; i++) particles[i].ClearAccumulator();
+			field.ApplyForceBatch(&pointers[0], COUNT, (real)0.0);
+		}
+		const double sampled = (Now() - start) * 1e6 / ((double)REPEATS * COUNT);
+
+		double errorSquared = 0.0, exactSquared = 0.0;
+		for(unsigned int i = 0; i < COUNT; i++)
+		{
+			errorSquared += (double)(particles[i].GetForceAccumulator() - exact[i]).LengthSquared();
+			exactSquared += (double)exact[i].LengthSquared();
+		}
+
+		// A source moving a little only needs the bricks around it baking again
+		field.MarkDirty(Hadron::Vector3<real>((real)-1.0, (real)-1.0, (real)-1.0), Hadron::Vector3<real>((real)1.0, (real)1.0, (real)1.0));
+		start = Now();
+		const unsigned int rebaked = field.Rebake();
+		const double rebake = Now() - start;
+
+		printf("%8u %14.2f %14.2f %12.3e %12.3f %12.3f %10u\n", SOURCES[c], analytic, sampled, sqrt(errorSquared / exactSquared),
+			bake, rebake, rebaked);
+	}
+
+	// Sampling alone on each instruction set, through the last field built above
+	const Hadron::SimdLevel supported = Hadron::GetSupportedSimdLevel();
+	const char *LEVELS[] = { "scalar", "sse2", "avx2" };
+	std::vector<real> x(COUNT), y(COUNT), z(COUNT), outX(COUNT), outY(COUNT), outZ(COUNT);
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		x[i] = particles[i].GetX();
+		y[i] = particles[i].GetY();
+		z[i] = particles[i].GetZ();
+	}
+
+	printf("%8s %14s\n", "simd", "sample ns");
+	for(unsigned int level = Hadron::SIMD_SCALAR; level <= (unsigned int)supported; level++)
+	{
+		Hadron::SetSimdLevel((Hadron::SimdLevel)level);
+
+		const double start = Now();
+		for(unsigned int r = 0; r < REPEATS; r++) field.Sample(&x[0], &y[0], &z[0], COUNT, &outX[0], &outY[0], &outZ[0]);
+		printf("%8s %14.2f\n", LEVELS[level], (Now() - start) * 1e6 / ((double)REPEATS * COUNT));
+	}
+
+	Hadron::SetSimdLevel(supported);
+}
+
+// A soft block of springs with its particles added in random order, stepped before and after a Morton sort
+// ^- Forces are checked against the shuffled world's, which they should match exactly as each particle still sums
+//    its springs in the same order
+void BenchmarkMortonSort(Hadron::ThreadPool &Pool)
+{
+	const unsigned int SIDES[] = { 32, 64, 96 };
+	const unsigned int STEPS = 10;
+	const real dT = (real)0.001;
+
+	printf("morton sort (threads = %u)\n", Pool.GetThreadCount());
+	printf("%10s %10s %12s %12s %8s %12s %12s\n", "particles", "springs", "shuffled ms", "sorted ms", "speedup", "sort ms",
+		"force diff");
+
+	for(unsigned int c = 0; c < sizeof(SIDES) / sizeof(SIDES[0]); c++)
+	{
+		const unsigned int side = SIDES[c];
+		const unsigned int count = side * side * side;
+
+		// Where each lattice point ends up in the world
+		SeedRandom(1234);
+		std::vector<unsigned int> slot(count);
+		for(unsigned int i = 0; i < count; i++) slot[i] = i;
+		for(unsigned int i = count - 1; i > 0; i--)
+		{
+			const unsigned int j = std::min((unsigned int)Random((real)0.0, (real)(i + 1)), i);
+			std::swap(slot[i], slot[j]);
+		}
+
+		Hadron::ParticleWorld world;
+		Hadron::SpringNetwork network;
+		world.Resize(count);
+		network.SetThreadPool(&Pool);
+		world.AddRemapListener(&network);
+
+		for(unsigned int z = 0; z < side; z++)
+		{
+			for(unsigned int y = 0; y < side; y++)
+			{
+				for(unsigned int x = 0; x < side; x++)
+				{
+					const unsigned int i = slot[(z * side + y) * side + x];
+					Hadron::ParticleWorld::ParticleView p = world.Get(i);
+					p.SetPosition((real)x + Random((real)-0.1, (real)0.1), (real)y + Random((real)-0.1, (real)0.1),
+						(real)z + Random((real)-0.1, (real)0.1));
+					p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+					p.SetAlive(true);
+
+					if(x + 1 < side) network.Add(i, slot[(z * side + y) * side + x + 1], (real)100.0, (real)1.0, (real)0.5);
+					if(y + 1 < side) network.Add(i, slot[(z * side + y + 1) * side + x], (real)100.0, (real)1.0, (real)0.5);
+					if(z + 1 < side) network.Add(i, slot[((z + 1) * side + y) * side + x], (real)100.0, (real)1.0, (real)0.5);
+				}
+			}
+		}
+
+		Hadron::ParticleMortonSort sorter;
+		sorter.SetThreadPool(&Pool);
+
+		std::vector<real> forces(count * 3);
+		real difference = (real)0.0;
+		double timings[2];
+		double sortTime = 0.0;
+
+		for(unsigned int pass = 0; pass < 2; pass++)
+		{
+			if(pass == 1)
+			{
+				const double start = Now();
+				sorter.Sort(world);
+				sortTime = Now() - start;
+			}
+
+			// Forces at the starting positions, the first call also builds the adjacency
+			world.ClearForces();
+			network.ApplyForces(world, dT);
+
+			const unsigned int *order = sorter.GetOrder();
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(pass == 0)
+				{
+					forces[i * 3] = world.GetForcesX()[i];
+					forces[i * 3 + 1] = world.GetForcesY()[i];
+					forces[i * 3 + 2] = world.GetForcesZ()[i];
+					continue;
+				}
+
+				const unsigned int was = order[i];
+				difference = std::max(difference, real_abs(world.GetForcesX()[i] - forces[was * 3]));
+				difference = std::max(difference, real_abs(world.GetForcesY()[i] - forces[was * 3 + 1]));
+				difference = std::max(difference, real_abs(world.GetForcesZ()[i] - forces[was * 3 + 2]));
+			}
+
+			world.ClearForces();
+
+			// Stepped on a copy, so the sorted pass starts from the same state
+			Hadron::ParticleWorld stepped = world;
+
+			const double start = Now();
+			for(unsigned int s = 0; s < STEPS; s++)
+			{
+				network.ApplyForces(stepped, dT);
+				stepped.Step(dT);
+				stepped.ClearForces();
+			}
+			timings[pass] = (Now() - start) / STEPS;
+		}
+
+		world.RemoveRemapListener(&network);
+		printf("%10u %10u %12.3f %12.3f %8.2f %12.3f %12.3e\n", count, network.GetCount(), timings[0], timings[1],
+			timings[0] / timings[1], sortTime, (double)difference);
+	}
+}
+
+// A compressed block of liquid stepped as Particles through a registry, serially and on the pool, and in a world
+// ^- Prepare works the forces out once a step and the registry only hands them out, so every path should end up
+//    with exactly the same positions
+void BenchmarkFluidRegistry(Hadron::ThreadPool &Pool)
+{
+	const unsigned int SIDE = 16;
+	const unsigned int STEPS = 20;
+	const real SPACING = (real)0.05;
+	const real dT = (real)(1.0 / 600.0);
+
+	printf("fluid registry (%u particles, threads = %u)\n", SIDE * SIDE * SIDE, Pool.GetThreadCount());
+	printf("%18s %12s %14s\n", "path", "ms", "max diff");
+
+	// Packed a little closer than it rests at, so pressure pushes it apart
+	SeedRandom(77);
+	std::vector<Hadron::Vector3<real> > start;
+	for(unsigned int z = 0; z < SIDE; z++)
+	{
+		for(unsigned int y = 0; y < SIDE; y++)
+		{
+			for(unsigned int x = 0; x < SIDE; x++)
+			{
+				start.push_back(Hadron::Vector3<real>((real)x, (real)y, (real)z) * (SPACING * (real)0.8) +
+					Hadron::Vector3<real>(Random((real)-0.002, (real)0.002), Random((real)-0.002, (real)0.002), Random((real)-0.002, (real)0.002)));
+			}
+		}
+	}
+
+	const unsigned int count = (unsigned int)start.size();
+	std::vector<Hadron::Vector3<real> > reference(count);
+
+	for(unsigned int path = 0; path < 3; path++)
+	{
+		Hadron::ParticleFluid fluid;
+		fluid.SetRadius(SPACING * (real)2.0);
+		fluid.SetParticleMass((real)1000.0 * SPACING * SPACING * SPACING);
+
+		std::vector<Hadron::Vector3<real> > result(count);
+		double time = 0.0;
+
+		if(path < 2)
+		{
+			std::vector<Hadron::Particle> particles(count);
+			std::vector<Hadron::Particle *> pointers(count);
+			Hadron::ParticleForceRegistry registry;
+			registry.SetThreadPool(path == 1 ? &Pool : NULL);
+			fluid.SetThreadPool(path == 1 ? &Pool : NULL);
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				particles[i].SetPosition(start[i]);
+				particles[i].SetAcceleration(Hadron::Vector3<real>::ZERO);
+				particles[i].SetMass(fluid.GetParticleMass());
+				particles[i].SetAlive(true);
+				pointers[i] = &particles[i];
+				registry.Add(pointers[i], &fluid);
+			}
+
+			const double begin = Now();
+			for(unsigned int s = 0; s < STEPS; s++)
+			{
+				fluid.Prepare(&pointers[0], count);
+				registry.Step<Hadron::SymplecticEuler>(dT);
+			}
+			time = Now() - begin;
+
+			for(unsigned int i = 0; i < count; i++) result[i] = particles[i].GetPosition();
+		}
+		else
+		{
+			Hadron::ParticleWorld world;
+			world.Resize(count);
+			for(unsigned int i = 0; i < count; i++)
+			{
+				Hadron::ParticleWorld::ParticleView p = world.Get(i);
+				p.SetPosition(start[i]);
+				p.SetAcceleration(Hadron::Vector3<real>::ZERO);
+				p.SetMass(fluid.GetParticleMass());
+				p.SetAlive(true);
+			}
+
+			const double begin = Now();
+			for(unsigned int s = 0; s < STEPS; s++)
+			{
+				world.Step<Hadron::SymplecticEuler>(dT, [&](Hadron::ParticleWorld &World) { fluid.ApplyForces(World, dT); });
+			}
+			time = Now() - begin;
+
+			for(unsigned int i = 0; i < count; i++) result[i] = world.Get(i).GetPosition();
+		}
+
+		if(path == 0) reference = result;
+
+		real difference = (real)0.0;
+		for(unsigned int i = 0; i < count; i++)
+		{
+			difference = std::max(difference, (result[i] - reference[i]).Length());
+		}
+
+		const char *NAMES[] = { "registry serial", "registry pool", "world" };
+		printf("%18s %12.3f %14.3e\n", NAMES[path], time, (double)difference);
+	}
+}
+
+// Spawning, killing and the order of the live list, with particles tagged by their x coordinate
+// ^- KillIf is checked against the same swap-remove done by hand on a list of tags
+void CheckParticlePool()
+{
+	const unsigned int CAPACITY = 8;
+	const char *CHECK = "particle pool";
+
+	Hadron::ParticlePool pool(CAPACITY);
+
+	Hadron::Particle *spawned[CAPACITY];
+	Require(pool.Spawn(CAPACITY + 4, spawned) == CAPACITY, CHECK, "spawning past capacity didn't stop at capacity");
+	Require(pool.Spawn() == NULL, CHECK, "a full pool spawned a particle");
+	Require(pool.GetLiveCount() == CAPACITY, CHECK, "live count doesn't match what was spawned");
+
+	for(unsigned int i = 0; i < CAPACITY; i++)
+	{
+		Require(pool.GetLive()[i] == spawned[i], CHECK, "live list isn't in spawn order");
+		Require(spawned[i]->IsAlive() && pool.IsLive(spawned[i]), CHECK, "spawned particle isn't live");
+		spawned[i]->SetX((real)i);
+	}
+
+	// Killing one moves the last live particle into its place
+	std::vector<int> expected;
+	for(unsigned int i = 0; i < CAPACITY; i++) expected.push_back((int)i);
+
+	pool.Kill(spawned[2]);
+	expected[2] = expected.back();
+	expected.pop_back();
+
+	pool.Kill(spawned[2]);
+	Hadron::Particle outsider;
+	pool.Kill(&outsider);
+	Require(pool.GetLiveCount() == expected.size(), CHECK, "killing a dead or foreign particle changed the pool");
+	Require(!spawned[2]->IsAlive() && !pool.IsLive(spawned[2]), CHECK, "killed particle is still live");
+
+	// KillIf walks backwards, so whatever's swapped into a gap has already been looked at
+	const unsigned int killed = pool.KillIf([](const Hadron::Particle &P) { return (int)P.GetX() % 2 == 1; });
+	unsigned int expectedKilled = 0;
+	for(unsigned int i = (unsigned int)expected.size(); i > 0; i--)
+	{
+		if(expected[i - 1] % 2 != 1) continue;
+
+		expected[i - 1] = expected.back();
+		expected.pop_back();
+		expectedKilled++;
+	}
+
+	Require(killed == expectedKilled, CHECK, "KillIf returned the wrong count");
+	Require(pool.GetLiveCount() == expected.size(), CHECK, "KillIf left the wrong number of particles");
+	for(unsigned int i = 0; i < expected.size(); i++)
+	{
+		Require((int)pool.GetLive()[i]->GetX() == expected[i], CHECK, "KillIf left the live list in the wrong order");
+	}
+
+	for(unsigned int i = 0; i < CAPACITY; i++)
+	{
+		const bool odd = (i % 2 == 1);
+		Require(pool.IsLive(spawned[i]) == (!odd && i != 2), CHECK, "IsLive disagrees with what was killed");
+	}
+
+	// The last slot freed is the first one reused, fresh and at the end of the live list
+	Hadron::Particle *reused = pool.Spawn();
+	Require(reused == spawned[1], CHECK, "spawn didn't reuse the last freed slot");
+	Require(reused->GetX() == (real)0.0 && reused->IsAlive(), CHECK, "reused particle wasn't reset");
+	Require(pool.GetLive()[pool.GetLiveCount() - 1] == reused, CHECK, "respawned particle isn't at the end");
+
+	pool.Clear();
+	Require(pool.GetLiveCount() == 0 && !pool.IsLive(spawned[0]), CHECK, "Clear left particles live");
+	Require(pool.Spawn() == spawned[0], CHECK, "Clear didn't hand out the lowest slot first");
+
+	printf("particle pool checks passed\n");
+}
+
+// The step cap, the alpha left over, and blending positions through a world reorder and a pool's live list changing
+void CheckFixedTimestep()
+{
+	const real STEP = (real)(1.0 / 60.0);
+	const unsigned int MAX_STEPS = 5;
+	const char *CHECK = "fixed timestep";
+
+	// Every bit of frame time is either stepped, still in the accumulator, or dropped by the cap
+	Hadron::FixedTimestep stepper(STEP, MAX_STEPS);
+	SeedRandom(9);
+
+	double total = 0.0, stepped = 0.0;
+	for(unsigned int f = 0; f < 2000; f++)
+	{
+		// Mostly normal frames with the odd hitch well past the cap
+		const real frameTime = (f % 97 == 0) ? Random((real)0.2, (real)1.0) : Random((real)0.0, (real)0.05);
+		const unsigned int steps = stepper.Advance(frameTime);
+
+		total += frameTime;
+		stepped += steps * (double)STEP;
+
+		Require(steps <= MAX_STEPS, CHECK, "Advance ran more steps than the cap");
+		Require(stepper.GetAlpha() >= (real)0.0 && stepper.GetAlpha() < (real)1.0, CHECK, "alpha is outside [0, 1)");
+		if(frameTime >= STEP * (MAX_STEPS + 1)) Require(steps == MAX_STEPS, CHECK, "a hitch didn't run the full cap");
+	}
+
+	const double accounted = stepped + stepper.GetAlpha() * (double)STEP + stepper.GetDroppedTime();
+	Require(fabs(accounted - total) < 1e-3 * total, CHECK, "frame time went missing between the steps, alpha and dropped time");
+
+	const real alpha = stepper.GetAlpha();
+	Require(stepper.Advance((real)0.0) == 0 && stepper.Advance((real)-1.0) == 0, CHECK, "an empty frame ran steps");
+	Require(stepper.GetAlpha() == alpha, CHECK, "an empty frame moved alpha");
+
+	stepper.Reset();
+	Require(stepper.GetAlpha() == (real)0.0 && stepper.GetDroppedTime() == (real)0.0, CHECK, "Reset left time behind");
+
+	// World blended halfway through a reorder, with a particle added since the capture
+	Hadron::ParticleWorld world;
+	Hadron::ParticleInterpolation interpolation;
+	world.AddRemapListener(&interpolation);
+
+	const unsigned int COUNT = 16;
+	world.Resize(COUNT);
+	for(unsigned int i = 0; i < COUNT; i++) world.Get(i).SetPosition((real)i, (real)0.0, (real)0.0);
+	interpolation.Capture(world);
+
+	for(unsigned int i = 0; i < COUNT; i++) world.Get(i).SetY((real)2.0);
+
+	// Reversing the world has to carry the captured positions along with their particles
+	std::vector<unsigned int> reverse(COUNT);
+	for(unsigned int i = 0; i < COUNT; i++) reverse[i] = COUNT - 1 - i;
+	world.Reorder(&reverse[0]);
+
+	const unsigned int added = world.Add();
+	world.Get(added).SetPosition((real)-1.0, (real)-1.0, (real)-1.0);
+	interpolation.Interpolate(world, (real)0.5);
+
+	Require(interpolation.GetCount() == COUNT + 1, CHECK, "interpolation didn't cover the whole world");
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		const Hadron::Vector3<real> p = interpolation.GetPosition(i);
+		Require(p.x == (real)(COUNT - 1 - i) && p.y == (real)1.0, CHECK,
+			"reordered world wasn't blended between its own positions");
+	}
+	Require(interpolation.GetPosition(added).y == (real)-1.0, CHECK, "particle added after the capture was blended");
+
+	world.RemoveRemapListener(&interpolation);
+
+	// Pool, where killing reorders the live list and the blend is only right once it's captured again
+	Hadron::ParticlePool pool(COUNT);
+	Hadron::Particle *spawned[COUNT];
+	pool.Spawn(COUNT, spawned);
+	for(unsigned int i = 0; i < COUNT; i++) spawned[i]->SetPosition((real)i, (real)0.0, (real)0.0);
+
+	interpolation.Clear();
+	interpolation.Capture(pool.GetLive(), pool.GetLiveCount());
+
+	pool.KillIf([](const Hadron::Particle &P) { return (int)P.GetX() % 3 == 0; });
+	interpolation.Capture(pool.GetLive(), pool.GetLiveCount());
+
+	for(unsigned int i = 0; i < pool.GetLiveCount(); i++) pool.GetLive()[i]->SetY((real)1.0);
+	interpolation.Interpolate(pool.GetLive(), pool.GetLiveCount(), (real)0.25);
+
+	Require(interpolation.GetCount() == pool.GetLiveCount(), CHECK, "interpolation didn't cover the live list");
+	for(unsigned int i = 0; i < pool.GetLiveCount(); i++)
+	{
+		const Hadron::Vector3<real> p = interpolation.GetPosition(i);
+		Require(p.x == pool.GetLive()[i]->GetX() && p.y == (real)0.25, CHECK,
+			"blend after re-capturing the changed live list is off");
+	}
+
+	printf("fixed timestep checks passed\n");
+}
+
+// Field by field comparison of a restored world against the one that was saved, at the restored world's precision
+template<typename T, typename F>
+void RequireSameWorld(const Hadron::ParticleWorld &Saved, const Hadron::BasicParticleWorld<T, F> &Restored,
+	const char *Check)
+{
+	const unsigned int count = Saved.GetCount();
+	Require(Restored.GetCount() == count, Check, "restored world has the wrong particle count");
+
+	const real *saved[] = { Saved.GetPositionsX(), Saved.GetPositionsY(), Saved.GetPositionsZ(), Saved.GetVelocitiesX(),
+		Saved.GetVelocitiesY(), Saved.GetVelocitiesZ(), Saved.GetAccelerationsX(), Saved.GetAccelerationsY(),
+		Saved.GetAccelerationsZ(), Saved.GetDampings(), Saved.GetInverseMasses() };
+	const T *restored[] = { Restored.GetPositionsX(), Restored.GetPositionsY(), Restored.GetPositionsZ(),
+		Restored.GetVelocitiesX(), Restored.GetVelocitiesY(), Restored.GetVelocitiesZ(), Restored.GetAccelerationsX(),
+		Restored.GetAccelerationsY(), Restored.GetAccelerationsZ(), Restored.GetDampings(), Restored.GetInverseMasses() };
+	const real *savedForces[] = { Saved.GetForcesX(), Saved.GetForcesY(), Saved.GetForcesZ() };
+	const F *restoredForces[] = { Restored.GetForcesX(), Restored.GetForcesY(), Restored.GetForcesZ() };
+
+	// Converting on restore has to round exactly the way a cast does
+	for(unsigned int i = 0; i < count; i++)
+	{
+		for(unsigned int f = 0; f < sizeof(saved) / sizeof(saved[0]); f++)
+		{
+			Require(restored[f][i] == (T)saved[f][i], Check, "a restored field doesn't match the saved one");
+		}
+
+		for(unsigned int f = 0; f < 3; f++)
+		{
+			Require(restoredForces[f][i] == (F)savedForces[f][i], Check, "a restored force doesn't match the saved one");
+		}
+
+		Require(Restored.GetAliveFlags()[i] == Saved.GetAliveFlags()[i], Check, "a restored alive flag doesn't match");
+	}
+}
+
+// Saves a world and its springs, restores them at both precisions and compares everything, then checks a snapshot
+// with a spring off the end of the world is turned away without touching what it was restoring into
+void CheckSnapshot()
+{
+	const unsigned int COUNT = 257;
+	const unsigned int SPRINGS = 300;
+	const char *PATH = "hadron_snapshot.tmp";
+	const char *CHECK = "snapshot";
+
+	SeedRandom(16);
+
+	Hadron::ParticleWorld world;
+	world.Resize(COUNT);
+
+	std::vector<real> dampings(COUNT), inverseMasses(COUNT);
+	std::vector<unsigned char> alive(COUNT);
+	real *fields[] = { world.GetPositionsX(), world.GetPositionsY(), world.GetPositionsZ(), world.GetVelocitiesX(),
+		world.GetVelocitiesY(), world.GetVelocitiesZ(), world.GetAccelerationsX(), world.GetAccelerationsY(),
+		world.GetAccelerationsZ(), world.GetForcesX(), world.GetForcesY(), world.GetForcesZ() };
+
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		// Values that aren't exact in a float, so the float restore really has to convert
+		for(unsigned int f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+		{
+			fields[f][i] = Random((real)-100.0, (real)100.0) / (real)3.0;
+		}
+
+		dampings[i] = Random((real)0.9, (real)1.0);
+		inverseMasses[i] = (i % 17 == 0) ? (real)0.0 : Random((real)0.1, (real)10.0);
+		alive[i] = (i % 5 != 0);
+	}
+
+	world.SetDampings(&dampings[0]);
+	world.SetInverseMasses(&inverseMasses[0]);
+	world.SetAliveFlags(&alive[0]);
+
+	Hadron::SpringNetwork network;
+	for(unsigned int s = 0; s < SPRINGS; s++)
+	{
+		network.Add(s % COUNT, (s * 7 + 1) % COUNT, Random((real)10.0, (real)1000.0), Random((real)0.1, (real)2.0),
+			Random((real)0.0, (real)1.0));
+	}
+
+	Require(Hadron::ParticleSnapshot::Save(PATH, world, &network), CHECK, "saving failed");
+
+	Hadron::ParticleSnapshot snapshot;
+	Require(snapshot.Open(PATH), CHECK, "the saved snapshot didn't open");
+	Require(snapshot.GetParticleCount() == COUNT && snapshot.GetSpringCount() == SPRINGS, CHECK,
+		"the snapshot's counts don't match what was saved");
+
+	Hadron::ParticleWorldFloat worldFloat;
+	Hadron::ParticleWorldDouble worldDouble;
+	Hadron::SpringNetwork networkFloat, networkDouble;
+	Require(snapshot.Restore(worldFloat, &networkFloat), CHECK, "restoring into a float world failed");
+	Require(snapshot.Restore(worldDouble, &networkDouble), CHECK, "restoring into a double world failed");
+	snapshot.Close();
+
+	RequireSameWorld(world, worldFloat, CHECK);
+	RequireSameWorld(world, worldDouble, CHECK);
+
+	const Hadron::SpringNetwork *restoredNetworks[] = { &networkFloat, &networkDouble };
+	for(unsigned int n = 0; n < 2; n++)
+	{
+		const Hadron::SpringNetwork &restored = *restoredNetworks[n];
+		Require(restored.GetCount() == SPRINGS, CHECK, "restored network has the wrong spring count");
+
+		for(unsigned int s = 0; s < SPRINGS; s++)
+		{
+			const bool same = restored.GetParticleA(s) == network.GetParticleA(s) &&
+				restored.GetParticleB(s) == network.GetParticleB(s) && restored.GetStiffness(s) == network.GetStiffness(s) &&
+				restored.GetRestLength(s) == network.GetRestLength(s) && restored.GetDamping(s) == network.GetDamping(s);
+			Require(same, CHECK, "a restored spring doesn't match the saved one");
+		}
+	}
+
+	// The same snapshot with one spring ending a particle past the end of the world
+	std::vector<unsigned int> badEnds(network.GetParticlesB(), network.GetParticlesB() + SPRINGS);
+	badEnds[SPRINGS / 2] = COUNT;
+
+	Hadron::ParticleSnapshotWriter writer;
+	writer.AddWorld(world);
+	writer.AddSprings(network);
+	writer.AddBlock(Hadron::SNAPSHOT_BLOCK_SPRING_B, sizeof(unsigned int), SPRINGS, &badEnds[0]);
+	Require(writer.Write(PATH), CHECK, "writing the bad snapshot failed");
+
+	Hadron::ParticleWorldDouble untouched;
+	untouched.Resize(3);
+	untouched.Get(1).SetX(5.0);
+	Hadron::SpringNetwork untouchedNetwork;
+	untouchedNetwork.Add(0, 2, (real)1.0, (real)1.0, (real)0.0);
+
+	Require(snapshot.Open(PATH), CHECK, "the bad snapshot didn't open");
+	Require(!snapshot.Restore(untouched, &untouchedNetwork), CHECK, "a spring past the end of the world was restored");
+	Require(untouched.GetCount() == 3 && untouched.GetPositionsX()[1] == 5.0, CHECK, "a failed restore changed the world");
+	Require(untouchedNetwork.GetCount() == 1 && untouchedNetwork.GetParticleB(0) == 2, CHECK,
+		"a failed restore changed the springs");
+
+	// Without a network to restore into, the springs aren't looked at and the world's fine
+	Require(snapshot.Restore(untouched), CHECK, "the world in the bad snapshot wasn't restored on its own");
+	RequireSameWorld(world, untouched, CHECK);
+	snapshot.Close();
+
+	remove(PATH);
+
+	printf("snapshot checks passed\n");
+}
+
+// Checks every frame of an open recording against the frames that went into it, in order and then jumping about
+// ^- Each decoded value has to be within half a quantisation step of the recorded one, plus the rounding of
+//    storing the result in a real
+void RequireRecordedFrames(Hadron::ParticleRecording &Recording, const std::vector<std::vector<real> > &Frames,
+	unsigned int FrameCount, const char *Check)
+{
+	Require(Recording.GetFrameCount() == FrameCount, Check, "recording has the wrong number of frames");
+
+	std::vector<unsigned int> order;
+	for(unsigned int f = 0; f < FrameCount; f++) order.push_back(f);
+
+	// Backwards makes every read a seek to the start of a chunk, and the shuffle lands anywhere
+	for(unsigned int f = FrameCount; f > 0; f--) order.push_back(f - 1);
+	for(unsigned int f = 0; f < FrameCount; f++) order.push_back((unsigned int)Random((real)0.0, (real)FrameCount));
+
+	const double steps[2] = { (double)Recording.GetPositionStep(), (double)Recording.GetVelocityStep() };
+	Hadron::ParticleWorld world;
+
+	for(unsigned int r = 0; r < order.size(); r++)
+	{
+		const unsigned int frame = order[r];
+		Require(Recording.ReadFrame(frame, world), Check, "a frame in range didn't decode");
+
+		const unsigned int count = world.GetCount();
+		const real *decoded[6] = { world.GetPositionsX(), world.GetPositionsY(), world.GetPositionsZ(),
+			world.GetVelocitiesX(), world.GetVelocitiesY(), world.GetVelocitiesZ() };
+		const real *recorded = &Frames[frame][0];
+
+		for(unsigned int c = 0; c < 6; c++)
+		{
+			for(unsigned int i = 0; i < count; i++)
+			{
+				const double value = (double)recorded[c * count + i];
+				const double bound = steps[c / 3] * 0.5 + fabs(value) * Hadron::ScalarTraits<real>::Epsilon() * 2.0;
+				Require(fabs((double)decoded[c][i] - value) <= bound, Check, "a decoded value is off by more than half a step");
+			}
+		}
+	}
+
+	Require(!Recording.ReadFrame(FrameCount, world), Check, "a frame past the end decoded");
+}
+
+// Copies the first Size bytes of one file to another, for faking a recording that never got closed
+bool CopyPrefix(const char *From, const char *To, unsigned long long Size)
+{
+	Hadron::MappedFile source;
+	if(!source.Open(From) || Size > source.GetSize()) return false;
+
+	FILE *file = fopen(To, "wb");
+	if(file == NULL) return false;
+
+	const bool written = fwrite(source.GetData(), 1, (size_t)Size, file) == Size;
+	return (fclose(file) == 0) && written;
+}
+
+// Records a cloth falling, then reads every frame back, from the finished file and from two cut short the way a
+// crash would leave them
+void CheckRecorder()
+{
+	const unsigned int SIDE = 24;
+	const unsigned int FRAMES = 200;
+	const unsigned int FRAMES_PER_CHUNK = 64;
+	const real dT = (real)(1.0 / 2400.0);
+	const char *PATH = "hadron_recording.tmp";
+	const char *CUT_PATH = "hadron_recording_cut.tmp";
+	const char *CHECK = "recorder";
+
+	SeedRandom(17);
+
+	Hadron::ParticleWorld world;
+	Hadron::SpringNetwork network;
+	MakeStiffCloth(world, network, SIDE);
+
+	const unsigned int count = world.GetCount();
+	const real *fields[6] = { world.GetPositionsX(), world.GetPositionsY(), world.GetPositionsZ(),
+		world.GetVelocitiesX(), world.GetVelocitiesY(), world.GetVelocitiesZ() };
+
+	Hadron::ParticleRecorder recorder;
+	Require(recorder.Open(PATH, (real)1e-4, (real)1e-3, FRAMES_PER_CHUNK), CHECK, "couldn't open the recording");
+
+	std::vector<std::vector<real> > frames(FRAMES);
+	for(unsigned int f = 0; f < FRAMES; f++)
+	{
+		network.ApplyForces(world, dT);
+		world.Step<Hadron::SymplecticEuler>(dT, [](Hadron::ParticleWorld &) { });
+
+		frames[f].resize(count * 6);
+		for(unsigned int c = 0; c < 6; c++) std::copy(fields[c], fields[c] + count, &frames[f][c * count]);
+
+		Require(recorder.Record(world), CHECK, "recording a frame failed");
+	}
+
+	Require(recorder.Close(), CHECK, "closing the recording failed");
+
+	Hadron::ParticleRecording recording;
+	Require(recording.Open(PATH), CHECK, "the finished recording didn't open");
+	Require(recording.GetParticleCount() == count, CHECK, "recording has the wrong particle count");
+	Require(recording.GetChunkCount() == (FRAMES + FRAMES_PER_CHUNK - 1) / FRAMES_PER_CHUNK, CHECK,
+		"recording has the wrong number of chunks");
+	RequireRecordedFrames(recording, frames, FRAMES, CHECK);
+	recording.Close();
+
+	Hadron::MappedFile file;
+	Require(file.Open(PATH), CHECK, "couldn't map the recording");
+	const unsigned long long size = file.GetSize();
+	file.Close();
+
+	// Losing the end of the index means walking the chunks, which are all still there
+	Require(CopyPrefix(PATH, CUT_PATH, size - 1), CHECK, "couldn't write the cut recording");
+	Require(recording.Open(CUT_PATH), CHECK, "a recording without its index didn't open");
+	RequireRecordedFrames(recording, frames, FRAMES, CHECK);
+	recording.Close();
+
+	// Cut part way through, everything up to the last whole chunk is still there
+	Require(CopyPrefix(PATH, CUT_PATH, size * 2 / 3), CHECK, "couldn't write the cut recording");
+	Require(recording.Open(CUT_PATH), CHECK, "a recording cut short didn't open");
+
+	const unsigned int recovered = recording.GetFrameCount();
+	Require(recovered > 0 && recovered < FRAMES && recovered % FRAMES_PER_CHUNK == 0, CHECK,
+		"a recording cut short didn't recover whole chunks");
+	RequireRecordedFrames(recording, frames, recovered, CHECK);
+	recording.Close();
+
+	remove(PATH);
+	remove(CUT_PATH);
+
+	printf("recorder checks passed (%u of %u frames recovered from a cut recording)\n", recovered, FRAMES);
+}
+
+// Every instruction set has to sample a field exactly the same, inside, on the far faces, outside and at NaN
+void CheckForceFieldSampling()
+{
+	const unsigned int COUNT = 1003;
+	const char *CHECK = "force field sampling";
+
+	SeedRandom(22);
+
+	// Odd sizes, so no row lines up with a packet
+	Hadron::ParticleForceField field;
+	field.Resize(Hadron::Vector3<real>((real)-1.0, (real)-2.0, (real)-3.0), (real)0.5, 13, 7, 9);
+	for(unsigned int z = 0; z < 9; z++)
+	{
+		for(unsigned int y = 0; y < 7; y++)
+		{
+			for(unsigned int x = 0; x < 13; x++)
+			{
+				field.SetValue(x, y, z, Hadron::Vector3<real>(Random((real)-1.0, (real)1.0), Random((real)-1.0, (real)1.0),
+					Random((real)-1.0, (real)1.0)));
+			}
+		}
+	}
+
+	const real maxX = (real)-1.0 + (real)6.0, maxY = (real)-2.0 + (real)3.0, maxZ = (real)-3.0 + (real)4.0;
+	std::vector<real> x(COUNT), y(COUNT), z(COUNT);
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		x[i] = Random((real)-1.5, maxX + (real)0.5);
+		y[i] = Random((real)-2.5, maxY + (real)0.5);
+		z[i] = Random((real)-3.5, maxZ + (real)0.5);
+
+		if(i % 7 == 0) x[i] = maxX;
+		if(i % 11 == 0) y[i] = maxY;
+		if(i % 13 == 0) z[i] = (real)-3.0;
+		if(i % 101 == 0) y[i] = (real)NAN;
+	}
+
+	const Hadron::SimdLevel supported = Hadron::GetSupportedSimdLevel();
+	std::vector<real> reference[3];
+
+	for(unsigned int level = Hadron::SIMD_SCALAR; level <= (unsigned int)supported; level++)
+	{
+		Hadron::SetSimdLevel((Hadron::SimdLevel)level);
+
+		std::vector<real> out[3];
+		for(unsigned int c = 0; c < 3; c++) out[c].assign(COUNT, (real)1234.0);
+		field.Sample(&x[0], &y[0], &z[0], COUNT, &out[0][0], &out[1][0], &out[2][0]);
+
+		if(level == Hadron::SIMD_SCALAR)
+		{
+			for(unsigned int c = 0; c < 3; c++) reference[c] = out[c];
+			continue;
+		}
+
+		for(unsigned int c = 0; c < 3; c++)
+		{
+			Require(memcmp(&out[c][0], &reference[c][0], COUNT * sizeof(real)) == 0, CHECK,
+				"a packet kernel sampled differently from the scalar one");
+		}
+	}
+
+	Hadron::SetSimdLevel(supported);
+
+	// And the scalar kernel against the single point sampler, which should agree with itself
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		const Hadron::Vector3<real> single = field.Sample(Hadron::Vector3<real>(x[i], y[i], z[i]));
+		Require(single.x == reference[0][i] && single.y == reference[1][i] && single.z == reference[2][i], CHECK,
+			"sampling one point differs from sampling a batch");
+
+		const bool outside = !(x[i] >= (real)-1.0 && x[i] <= maxX && y[i] >= (real)-2.0 && y[i] <= maxY &&
+			z[i] >= (real)-3.0 && z[i] <= maxZ);
+		if(outside) Require(single.x == (real)0.0 && single.y == (real)0.0, CHECK, "a point outside the grid got a force");
+	}
+
+	printf("force field sampling checks passed\n");
+}
+
+// Writes Data to Path, for handing Load files that have been tampered with
+bool WriteBytes(const char *Path, const std::vector<unsigned char> &Data)
+{
+	FILE *file = fopen(Path, "wb");
+	if(file == NULL) return false;
+
+	const bool written = Data.empty() || fwrite(&Data[0], 1, Data.size(), file) == Data.size();
+	return (fclose(file) == 0) && written;
+}
+
+// Saving and loading a force field, then loading files whose header doesn't match what's in them
+// ^- Every bad file has to be turned away with the field left exactly as it was
+void CheckForceFieldFiles()
+{
+	const char *PATH = "hadron_field.tmp";
+	const char *BAD_PATH = "hadron_field_bad.tmp";
+	const char *CHECK = "force field files";
+
+	// Where the sizes sit in the header, after the magic, version, byte order, element size and mode
+	const unsigned int SIZES_OFFSET = 24;
+
+	SeedRandom(23);
+
+	Hadron::ParticleForceField field;
+	field.Resize(Hadron::Vector3<real>((real)1.0, (real)2.0, (real)3.0), (real)0.25, 5, 4, 3);
+	field.SetMode(Hadron::ParticleForceField::FIELD_FORCE);
+	field.SetDrag((real)0.5);
+	for(unsigned int z = 0; z < 3; z++)
+	{
+		for(unsigned int y = 0; y < 4; y++)
+		{
+			for(unsigned int x = 0; x < 5; x++)
+			{
+				field.SetValue(x, y, z, Hadron::Vector3<real>(Random((real)-1.0, (real)1.0), Random((real)-1.0, (real)1.0),
+					Random((real)-1.0, (real)1.0)));
+			}
+		}
+	}
+
+	Require(field.Save(PATH), CHECK, "saving failed");
+
+	Hadron::ParticleForceField loaded;
+	Require(loaded.Load(PATH), CHECK, "loading what was just saved failed");
+	Require(loaded.GetSizeX() == 5 && loaded.GetSizeY() == 4 && loaded.GetSizeZ() == 3 && loaded.GetSpacing() == (real)0.25 &&
+		loaded.GetMode() == Hadron::ParticleForceField::FIELD_FORCE && loaded.GetDrag() == (real)0.5, CHECK,
+		"the loaded field's layout doesn't match the saved one");
+	Require(memcmp(loaded.GetValues(), field.GetValues(), 5 * 4 * 3 * 3 * sizeof(real)) == 0, CHECK,
+		"the loaded values don't match the saved ones");
+
+	std::vector<unsigned char> saved;
+	{
+		Hadron::MappedFile file;
+		Require(file.Open(PATH), CHECK, "couldn't map the saved field");
+		saved.assign(file.GetData(), file.GetData() + file.GetSize());
+	}
+
+	// Sizes that overflow on the way to a byte count, too big for the file, too small for it, and under 2
+	const unsigned int BAD_SIZES[][3] = {
+		{ 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+		{ 0x80000000, 0x80000000, 4 },
+		{ 0x55555556, 3, 2 },
+		{ 5, 4, 4 },
+		{ 5, 3, 3 },
+		{ 60, 1, 1 }
+	};
+
+	for(unsigned int b = 0; b < sizeof(BAD_SIZES) / sizeof(BAD_SIZES[0]); b++)
+	{
+		std::vector<unsigned char> bad = saved;
+		memcpy(&bad[SIZES_OFFSET], BAD_SIZES[b], sizeof(BAD_SIZES[b]));
+		Require(WriteBytes(BAD_PATH, bad), CHECK, "couldn't write a bad field");
+
+		Require(!loaded.Load(BAD_PATH), CHECK, "a field whose sizes don't match its file was loaded");
+		Require(loaded.GetSizeX() == 5 && memcmp(loaded.GetValues(), field.GetValues(), 5 * 4 * 3 * 3 * sizeof(real)) == 0,
+			CHECK, "a failed load changed the field");
+	}
+
+	// A byte short, a node short, and only part of the header
+	const size_t LENGTHS[] = { saved.size() - 1, saved.size() - 3 * sizeof(real), SIZES_OFFSET + 4 };
+	for(unsigned int l = 0; l < sizeof(LENGTHS) / sizeof(LENGTHS[0]); l++)
+	{
+		Require(WriteBytes(BAD_PATH, std::vector<unsigned char>(saved.begin(), saved.begin() + LENGTHS[l])), CHECK,
+			"couldn't write a cut field");
+		Require(!loaded.Load(BAD_PATH), CHECK, "a cut field was loaded");
+	}
+
+	std::vector<unsigned char> longer = saved;
+	longer.push_back(0);
+	Require(WriteBytes(BAD_PATH, longer), CHECK, "couldn't write a long field");
+	Require(!loaded.Load(BAD_PATH), CHECK, "a field with bytes left over was loaded");
+	Require(memcmp(loaded.GetValues(), field.GetValues(), 5 * 4 * 3 * 3 * sizeof(real)) == 0, CHECK,
+		"a failed load changed the field");
+
+	remove(PATH);
+	remove(BAD_PATH);
+
+	printf("force field file checks passed\n");
+}
+
+// Fluid density and force sums on every packet kernel the CPU has, against the scalar one bit for bit
+void CheckFluidSums()
+{
+	const unsigned int COUNT = 1003;
+	const real SPACING = (real)0.05;
+	const char *CHECK = "fluid sums";
+
+	SeedRandom(23);
+
+	// A rough ball packed a little tight, with a few particles sat right on top of others
+	std::vector<Hadron::Vector3<real> > position(COUNT), velocity(COUNT);
+	for(unsigned int i = 0; i < COUNT; i++)
+	{
+		position[i] = Hadron::Vector3<real>(Random((real)-0.25, (real)0.25), Random((real)-0.25, (real)0.25),
+			Random((real)-0.25, (real)0.25));
+		velocity[i] = Hadron::Vector3<real>(Random((real)-1.0, (real)1.0), Random((real)-1.0, (real)1.0),
+			Random((real)-1.0, (real)1.0));
+
+		if(i % 97 == 1) position[i] = position[i - 1];
+	}
+
+	const Hadron::SimdLevel supported = Hadron::GetSupportedSimdLevel();
+	std::vector<real> reference;
+
+	for(unsigned int level = Hadron::SIMD_SCALAR; level <= (unsigned int)supported; level++)
+	{
+		Hadron::SetSimdLevel((Hadron::SimdLevel)level);
+
+		Hadron::ParticleFluid fluid;
+		fluid.SetRadius(SPACING * (real)2.0);
+		fluid.SetParticleMass((real)1000.0 * SPACING * SPACING * SPACING);
+
+		std::vector<Hadron::Particle> particles(COUNT);
+		std::vector<Hadron::Particle *> pointers(COUNT);
+		for(unsigned int i = 0; i < COUNT; i++)
+		{
+			particles[i].SetPosition(position[i]);
+			particles[i].SetVelocity(velocity[i]);
+			particles[i].SetMass(fluid.GetParticleMass());
+			particles[i].SetAlive(true);
+			pointers[i] = &particles[i];
+		}
+
+		fluid.Prepare(&pointers[0], COUNT);
+		fluid.ApplyForceBatch(&pointers[0], COUNT, (real)0.0);
+
+		std::vector<real> result;
+		for(unsigned int i = 0; i < COUNT; i++)
+		{
+			const Hadron::Vector3<real> &force = particles[i].GetForceAccumulator();
+			result.push_back(fluid.GetDensity(i));
+			result.push_back(fluid.GetPressure(i));
+			result.push_back(force.x);
+			result.push_back(force.y);
+			result.push_back(force.z);
+		}
+
+		if(level == Hadron::SIMD_SCALAR)
+		{
+			Require(fluid.GetNeighbourCount() > COUNT, CHECK, "the particles were too spread out to have neighbours");
+			reference = result;
+			continue;
+		}
+
+		Require(memcmp(&result[0], &reference[0], result.size() * sizeof(real)) == 0, CHECK,
+			"a packet kernel summed differently from the scalar one");
+	}
+
+	Hadron::SetSimdLevel(supported);
+
+	printf("fluid sum checks passed\n");
+}
+
+void RunStudies(Hadron::ThreadPool &Pool)
+{
+	CheckParticlePool();
+	CheckFixedTimestep();
+	CheckSnapshot();
+	CheckRecorder();
+	CheckForceFieldSampling();
+	CheckForceFieldFiles();
+	CheckFluidSums();
+
+	BenchmarkNBody(Pool);
+	BenchmarkSprings(Pool);
+	BenchmarkHashGrid(Pool);
+	BenchmarkContacts(Pool);
+	BenchmarkIntegrators();
+	BenchmarkImplicitSprings(Pool);
+	BenchmarkConstraints(Pool);
+	BenchmarkRecorder(Pool);
+	BenchmarkForceField(Pool);
+	BenchmarkFluidRegistry(Pool);
+	BenchmarkMortonSort(Pool);
+}
@@ -125,18 +125,16 @@ int main()
 	const GLfloat LIGHT_POS[3] = { 0.0f, 0.0f, 0.0f };
 	glLightfv(GL_LIGHT0, GL_POSITION, LIGHT_POS);
 
+	// Only the live particles ever get touched, however big the pool is
 	const int MAX_PARTICLES = 1000;
-	Hadron::Particle particle[MAX_PARTICLES];
+	Hadron::ParticlePool particles(MAX_PARTICLES);
 
 	Hadron::ParticleGravitation gravitor;
 	gravitor.SetGravityPosition((real)0.0, (real)0.0, (real)0.0);
 
-	Hadron::ParticleForceRegistry registry;
-
-	for(int i = 0; i < MAX_PARTICLES; i++)
-	{
-		registry.Add(&particle[i], &gravitor);
-	}
+	// 60 steps a second, and never more than 5 of them in one frame
+	Hadron::FixedTimestep stepper;
+	Hadron::ParticleInterpolation interpolation;
 
 	GLuint LIST_CUBE = MakeCubeList();
 
@@ -144,6 +142,9 @@ int main()
 
 	while(window.IsOpened())
 	{
+		// Set when particles are spawned or killed, which shuffles the live list
+		bool liveChanged = false;
+
 		sf::Event e;
 		while(window.GetEvent(e))
 		{
@@ -156,12 +157,19 @@ int main()
 			case(sf::Event::KeyPressed):
 				if(e.Key.Code == sf::Key::Space)
 				{
-					int index = sf::Randomizer::Random(0, MAX_PARTICLES - 1);
-					particle[index].SetPosition(Hadron::Vector3<real>(rand(-10.0f, 10.0f), rand(-10.0f, 10.0f), rand(-10.0f, 10.0f)));
-					particle[index].SetVelocity(Hadron::Vector3<real>(rand(-30.0f, 30.0f), rand(-30.0f, 30.0f), rand(-30.0f, 30.0f)));
-					particle[index].SetAcceleration(Hadron::Vector3<real>::ZERO);
-					particle[index].SetMass((real)1.0);
-					particle[index].SetAlive(true);
+					// Recycle a random particle once the pool's full
+					Hadron::Particle *p = particles.Spawn();
+					if(p == NULL)
+					{
+						particles.Kill(particles.GetLive()[sf::Randomizer::Random(0, (int)particles.GetLiveCount() - 1)]);
+						p = particles.Spawn();
+					}
+
+					p->SetPosition(Hadron::Vector3<real>(rand(-10.0f, 10.0f), rand(-10.0f, 10.0f), rand(-10.0f, 10.0f)));
+					p->SetVelocity(Hadron::Vector3<real>(rand(-30.0f, 30.0f), rand(-30.0f, 30.0f), rand(-30.0f, 30.0f)));
+					p->SetAcceleration(Hadron::Vector3<real>::ZERO);
+					p->SetMass((real)1.0);
+					liveChanged = true;
 				}
 			}
 		}
@@ -169,12 +177,23 @@ int main()
 		double frameTime = window.GetFrameTime();
 		time += frameTime;
 
-		registry.ApplyForces(frameTime);
-		for(int i = 0; i < MAX_PARTICLES; i++)
+		// The capture was taken against the old live list, so it no longer lines up with the particles
+		// ^- Snap everything to where it is now, frames with a step capture again before it anyway
+		if(liveChanged) interpolation.Capture(particles.GetLive(), particles.GetLiveCount());
+
+		// Step the physics at a fixed rate, however fast we're rendering
+		const unsigned int steps = stepper.Advance((real)frameTime);
+		for(unsigned int s = 0; s < steps; s++)
 		{
-			particle[i].Update((real)frameTime);
+			// Where things were before the last step, to blend from
+			if(s == steps - 1) interpolation.Capture(particles.GetLive(), particles.GetLiveCount());
+
+			particles.ApplyForce(gravitor, stepper.GetStep());
+			particles.Update(stepper.GetStep());
 		}
 
+		interpolation.Interpolate(particles.GetLive(), particles.GetLiveCount(), stepper.GetAlpha());
+
 		window.Clear();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -185,11 +204,12 @@ int main()
 		glTranslatef(0.0f, 0.0, -50.0f);
 		glRotatef(time * 30.0f, 0.0f, 1.0f, 0.0f);
 
-		for(int i = 0; i < MAX_PARTICLES; i++)
+		for(unsigned int i = 0; i < interpolation.GetCount(); i++)
 		{
 			glPushMatrix();
 
-			glTranslatef(particle[i].GetX(), particle[i].GetY(), particle[i].GetZ());
+			const Hadron::Vector3<real> position = interpolation.GetPosition(i);
+			glTranslatef(position.x, position.y, position.z);
 
 			glCallList(LIST_CUBE);
 
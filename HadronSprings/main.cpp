@@ -148,6 +148,11 @@ int main()
 	//registry.Add(&b, &bSpring);
 	registry.Add(&a, &drag);
 
+	// 120 steps a second, and never more than 8 of them in one frame
+	Hadron::FixedTimestep stepper((real)(1.0 / 120.0), 8);
+	Hadron::ParticleInterpolation interpolation;
+	Hadron::Particle *bodies[2] = { &a, &b };
+
 	GLuint LIST_CUBE = MakeCubeList();
 
 	double time = 0.0;
@@ -171,18 +176,32 @@ int main()
 		double frameTime = window.GetFrameTime();
 		time += frameTime;
 
-		registry.ApplyForces(frameTime);
-		a.Update(frameTime);
-		b.Update(frameTime);
+		// Step the physics at a fixed rate, however fast we're rendering
+		const unsigned int steps = stepper.Advance((real)frameTime);
+		for(unsigned int i = 0; i < steps; i++)
+		{
+			const real dT = stepper.GetStep();
+
+			// Where things were before the last step, to blend from
+			if(i == steps - 1) interpolation.Capture(bodies, 2);
 
-		if(a.GetY() < (real)-30.0) a.SetVelocityY(abs(a.GetVelocity().y * -0.9));
-		if(b.GetY() < (real)-30.0) b.SetVelocityY(abs(b.GetVelocity().y * -0.9));
+			registry.ApplyForces(dT);
+			a.Update(dT);
+			b.Update(dT);
 
-		if(a.GetX() < (real)-30.0 || a.GetX() > (real)30.0) a.SetVelocityX(a.GetVelocity().x * -0.9);
-		if(b.GetX() < (real)-30.0 || b.GetX() > (real)30.0) b.SetVelocityX(b.GetVelocity().x * -0.9);
+			if(a.GetY() < (real)-30.0) a.SetVelocityY(abs(a.GetVelocity().y * -0.9));
+			if(b.GetY() < (real)-30.0) b.SetVelocityY(abs(b.GetVelocity().y * -0.9));
+
+			if(a.GetX() < (real)-30.0 || a.GetX() > (real)30.0) a.SetVelocityX(a.GetVelocity().x * -0.9);
+			if(b.GetX() < (real)-30.0 || b.GetX() > (real)30.0) b.SetVelocityX(b.GetVelocity().x * -0.9);
+
+			if(a.GetZ() < (real)-30.0 || a.GetZ() > (real)30.0) a.SetVelocityZ(a.GetVelocity().z * -0.9);
+			if(b.GetZ() < (real)-30.0 || b.GetZ() > (real)30.0) b.SetVelocityZ(b.GetVelocity().z * -0.9);
+		}
 
-		if(a.GetZ() < (real)-30.0 || a.GetZ() > (real)30.0) a.SetVelocityZ(a.GetVelocity().z * -0.9);
-		if(b.GetZ() < (real)-30.0 || b.GetZ() > (real)30.0) b.SetVelocityZ(b.GetVelocity().z * -0.9);
+		interpolation.Interpolate(bodies, 2, stepper.GetAlpha());
+		const Hadron::Vector3<real> aPos = interpolation.GetPosition(0);
+		const Hadron::Vector3<real> bPos = interpolation.GetPosition(1);
 
 		window.Clear();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -201,20 +220,20 @@ int main()
 		glEnd();
 
 		glPushMatrix();
-		glTranslatef(a.GetX(), a.GetY(), a.GetZ());
+		glTranslatef(aPos.x, aPos.y, aPos.z);
 		glCallList(LIST_CUBE);
 		glPopMatrix();
 
 		glPushMatrix();
-		glTranslatef(b.GetX(), b.GetY(), b.GetZ());
+		glTranslatef(bPos.x, bPos.y, bPos.z);
 		glCallList(LIST_CUBE);
 		glPopMatrix();
 
 		glDisable(GL_LIGHTING);
 		glColor3f(0.5f, 1.0f, 0.0f);
 		glBegin(GL_LINES);
-		glVertex3f(a.GetX(), a.GetY(), a.GetZ());
-		glVertex3f(b.GetX(), b.GetY(), b.GetZ());
+		glVertex3f(aPos.x, aPos.y, aPos.z);
+		glVertex3f(bPos.x, bPos.y, bPos.z);
 		glEnd();
 		glEnable(GL_LIGHTING);
 